@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "Bench.hpp"
+#include <algorithm>
+
+namespace bench {
+
+Runner::Runner(Options const &options)
+	: options_(options), flushBuffer_(options.flushBytes)
+{
+}
+
+std::vector<std::size_t>
+Runner::counts() const
+{
+	std::vector<std::size_t> counts;
+	for (std::size_t n = 1; n <= options_.maxCount; n *= 10) {
+		counts.push_back(n);
+		if (n > options_.maxCount/10)
+			break;
+	}
+	return counts;
+}
+
+bool
+Runner::selected(Result const &path) const
+{
+	auto const name = path.api + "/" + path.model + "/" + path.type + "/" + path.direction;
+	return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+}
+
+void
+Runner::flush()
+{
+	/* Writing, not just reading, also pushes out dirty lines of the output. */
+	for (std::size_t i = 0; i < flushBuffer_.size(); i += 64)
+		++flushBuffer_[i];
+	clobber(flushBuffer_.data());
+}
+
+double
+median(std::vector<double> samples)
+{
+	auto const mid = samples.begin() + samples.size()/2;
+	std::nth_element(samples.begin(), mid, samples.end());
+	return *mid;
+}
+
+void
+writeCSV(std::FILE * const out, std::vector<Result> const &results, char const * const simd)
+{
+	std::fprintf(out, "api,model,type,direction,count,cache,simd,calls,ns_per_point,points_per_sec\n");
+	for (auto const &r : results) {
+		std::fprintf(out, "%s,%s,%s,%s,%zu,%s,%s,%zu,%.4f,%.6g\n",
+			     r.api.c_str(), r.model.c_str(), r.type.c_str(), r.direction.c_str(),
+			     r.count, r.cache.c_str(), simd, r.calls, r.nsPerPoint, 1e9/r.nsPerPoint);
+	}
+}
+
+void
+writeJSON(std::FILE * const out, std::vector<Result> const &results, char const * const simd)
+{
+	std::fprintf(out, "{\n  \"simd\": \"%s\",\n  \"results\": [", simd);
+	auto first = true;
+	for (auto const &r : results) {
+		std::fprintf(out, "%s\n    {\"api\": \"%s\", \"model\": \"%s\", \"type\": \"%s\", "
+			     "\"direction\": \"%s\", \"count\": %zu, \"cache\": \"%s\", \"calls\": %zu, "
+			     "\"ns_per_point\": %.4f, \"points_per_sec\": %.6g}",
+			     first ? "" : ",", r.api.c_str(), r.model.c_str(), r.type.c_str(),
+			     r.direction.c_str(), r.count, r.cache.c_str(), r.calls,
+			     r.nsPerPoint, 1e9/r.nsPerPoint);
+		first = false;
+	}
+	std::fprintf(out, "\n  ]\n}\n");
+}
+
+} // !namespace bench
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_bench_Bench_hpp
+#define terra_bench_Bench_hpp
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * @brief Command line settings shared by all benchmarks.
+ */
+struct Options {
+	std::size_t maxCount = 10000000;	/**< Largest batch size, in points. */
+	double minTime = 0.1;			/**< Seconds spent per measurement. */
+	std::size_t flushBytes = 64u << 20;	/**< Bytes written to evict the caches. */
+	std::string filter;			/**< Only run names containing this. */
+};
+
+/**
+ * @brief One measurement: a conversion path at a batch size and cache state.
+ */
+struct Result {
+	std::string api;	/**< Single, InPlace, SoA, AoS, Strided, SoATwoPass for geodToENU
+				     or ecefToTransverseMercator, SoAThreePass for
+				     datumTransform, SoAScaled for radians plus a pass to
+				     or from degrees, fixed point or tile offsets,
+				     SoAOneToMany for geodesics from one point, or
+				     SoATrajectory for points along a track. */
+	std::string model;	/**< Reference body or frame, e.g. Sphere or LocalFrame. */
+	std::string type;	/**< float or double, as stored; MixedEllipsoid computes in double. */
+	std::string direction;	/**< The function, e.g. geodToECEF. */
+	std::string cache;	/**< warm or cold. */
+	std::size_t count;	/**< Points per call. */
+	std::size_t calls;	/**< Calls timed. */
+	double nsPerPoint;	/**< Median over the samples. */
+};
+
+/**
+ * @brief Times conversion calls and collects the results.
+ */
+class Runner {
+public:
+	explicit Runner(Options const &options);
+
+	/**
+	 * @brief The batch sizes to run: 1, 10, 100, ... up to maxCount.
+	 */
+	std::vector<std::size_t> counts() const;
+
+	/**
+	 * @brief Whether the filter selects the path named api/model/type/direction.
+	 */
+	bool selected(Result const &path) const;
+
+	/**
+	 * @brief Time fn, which converts path.count points per call, once with
+	 *	warm caches and once with the caches flushed before every call.
+	 */
+	template<typename Fn>
+	void measure(Result path, Fn &&fn);
+
+	std::vector<Result> const &results() const { return results_; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void flush();
+
+	Options options_;
+	std::vector<unsigned char> flushBuffer_;
+	std::vector<Result> results_;
+};
+
+/**
+ * @brief Keep the compiler from dropping stores the benchmark never reads.
+ */
+inline
+void
+clobber(void const * const p)
+{
+#if defined(__GNUC__)
+	__asm__ __volatile__("" : : "g"(p) : "memory");
+#else
+	static void const * volatile sink;
+	sink = p;
+#endif
+}
+
+/**
+ * @brief Write the results as CSV, one measurement per line after a header.
+ */
+void writeCSV(std::FILE *out, std::vector<Result> const &results, char const *simd);
+
+/**
+ * @brief Write the results as a JSON object with a "results" array.
+ */
+void writeJSON(std::FILE *out, std::vector<Result> const &results, char const *simd);
+
+double median(std::vector<double> samples);
+
+template<typename Fn>
+void
+Runner::measure(Result path, Fn &&fn)
+{
+	if (!selected(path))
+		return;
+
+	auto const seconds = [](Clock::duration const d) {
+		return std::chrono::duration<double>(d).count();
+	};
+
+	/* Warm: repeat the call often enough that the clock's own cost vanishes. */
+	fn();
+	auto const t0 = Clock::now();
+	fn();
+	auto const once = seconds(Clock::now() - t0);
+	auto const inner = once > 1e-5 ? std::size_t(1) : std::size_t(1e-5/(once > 1e-9 ? once : 1e-9)) + 1;
+
+	std::vector<double> samples;
+	auto spent = 0.0;
+	do {
+		auto const start = Clock::now();
+		for (auto i = std::size_t(0); i < inner; ++i)
+			fn();
+		auto const elapsed = seconds(Clock::now() - start);
+		samples.push_back(elapsed*1e9/double(inner*path.count));
+		spent += elapsed;
+	} while (spent < options_.minTime || samples.size() < 3);
+	path.cache = "warm";
+	path.calls = samples.size()*inner;
+	path.nsPerPoint = median(samples);
+	results_.push_back(path);
+
+	/* Cold: each call starts from memory, so only one call per sample. */
+	samples.clear();
+	spent = 0.0;
+	do {
+		flush();
+		auto const start = Clock::now();
+		fn();
+		auto const elapsed = seconds(Clock::now() - start);
+		samples.push_back(elapsed*1e9/double(path.count));
+		spent += elapsed;
+	} while ((spent < options_.minTime && samples.size() < 25) || samples.size() < 3);
+	path.cache = "cold";
+	path.calls = samples.size();
+	path.nsPerPoint = median(samples);
+	results_.push_back(path);
+}
+
+/**
+ * @brief Benchmark the single, in-place, SoA, AoS and strided conversion paths, exact and
+ *	approximate, the local frame transforms, degrees, fixed point and tile offsets
+ *	against absolute radians, datum transformations, the geodesic problems, the
+ *	Transverse and Web Mercator projections, slippy map tiles, tracks, ecefToGeod
+ *	iterated to a tolerance and the spatial index.
+ */
+void benchConversions(Runner &runner);
+
+} // !namespace bench
+
+#endif // !terra_bench_Bench_hpp
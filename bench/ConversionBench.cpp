@@ -0,0 +1,898 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "Bench.hpp"
+#include <terra/Approximate.hpp>
+#include <terra/Degrees.hpp>
+#include <terra/Fixed.hpp>
+#include <terra/Geodesic.hpp>
+#include <terra/Helmert.hpp>
+#include <terra/LocalFrame.hpp>
+#include <terra/SpatialIndex.hpp>
+#include <terra/Strided.hpp>
+#include <terra/Tile.hpp>
+#include <terra/TransverseMercator.hpp>
+#include <terra/WebMercator.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace bench {
+
+namespace {
+
+template<typename T>
+struct Precision {
+};
+template<>
+struct Precision<float> {
+	static constexpr char const *str = "float";
+};
+template<>
+struct Precision<double> {
+	static constexpr char const *str = "double";
+};
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+struct GeodToECEF {
+	static constexpr char const *name = "geodToECEF";
+
+	template<typename Coord, typename Model>
+	static void single(Coord *to, Coord const &from, Model const model)
+	{
+		terra::geodToECEF(to, from, model);
+	}
+
+	template<typename Coord, typename Model>
+	static void inPlace(Coord *coord, Model const model)
+	{
+		terra::geodToECEF(coord, model);
+	}
+
+	template<typename Coord, typename Model>
+	static void soa(Coord *to, Coord const &from, std::size_t const n, Model const model)
+	{
+		terra::geodToECEFSoA(to, from, n, model);
+	}
+
+	template<typename Coord, typename Coord2, typename Model>
+	static void aos(Coord *to, Coord2 const &from, std::size_t const n, Model const model)
+	{
+		terra::geodToECEFAoS(to, from, n, model);
+	}
+
+	template<typename T, typename U, typename Model>
+	static void strided(terra::Strided<T> *to, terra::Strided<U> const &from, std::size_t const n, Model const model)
+	{
+		terra::geodToECEFStrided(to, from, n, model);
+	}
+};
+
+struct ECEFToGeod {
+	static constexpr char const *name = "ecefToGeod";
+
+	template<typename Coord, typename Model>
+	static void single(Coord *to, Coord const &from, Model const model)
+	{
+		terra::ecefToGeod(to, from, model);
+	}
+
+	template<typename Coord, typename Model>
+	static void inPlace(Coord *coord, Model const model)
+	{
+		terra::ecefToGeod(coord, model);
+	}
+
+	template<typename Coord, typename Model>
+	static void soa(Coord *to, Coord const &from, std::size_t const n, Model const model)
+	{
+		terra::ecefToGeodSoA(to, from, n, model);
+	}
+
+	template<typename Coord, typename Coord2, typename Model>
+	static void aos(Coord *to, Coord2 const &from, std::size_t const n, Model const model)
+	{
+		terra::ecefToGeodAoS(to, from, n, model);
+	}
+
+	template<typename T, typename U, typename Model>
+	static void strided(terra::Strided<T> *to, terra::Strided<U> const &from, std::size_t const n, Model const model)
+	{
+		terra::ecefToGeodStrided(to, from, n, model);
+	}
+};
+
+struct ECEFToENU {
+	static constexpr char const *name = "ecefToENU";
+
+	template<typename Coord, typename Frame>
+	static void single(Coord *to, Coord const &from, Frame const &frame)
+	{
+		terra::ecefToENU(to, from, frame);
+	}
+
+	template<typename Coord, typename Frame>
+	static void inPlace(Coord *coord, Frame const &frame)
+	{
+		terra::ecefToENU(coord, frame);
+	}
+
+	template<typename Coord, typename Frame>
+	static void soa(Coord *to, Coord const &from, std::size_t const n, Frame const &frame)
+	{
+		terra::ecefToENUSoA(to, from, n, frame);
+	}
+
+	template<typename Coord, typename Coord2, typename Frame>
+	static void aos(Coord *to, Coord2 const &from, std::size_t const n, Frame const &frame)
+	{
+		terra::ecefToENUAoS(to, from, n, frame);
+	}
+};
+
+struct ENUToECEF {
+	static constexpr char const *name = "enuToECEF";
+
+	template<typename Coord, typename Frame>
+	static void single(Coord *to, Coord const &from, Frame const &frame)
+	{
+		terra::enuToECEF(to, from, frame);
+	}
+
+	template<typename Coord, typename Frame>
+	static void inPlace(Coord *coord, Frame const &frame)
+	{
+		terra::enuToECEF(coord, frame);
+	}
+
+	template<typename Coord, typename Frame>
+	static void soa(Coord *to, Coord const &from, std::size_t const n, Frame const &frame)
+	{
+		terra::enuToECEFSoA(to, from, n, frame);
+	}
+
+	template<typename Coord, typename Coord2, typename Frame>
+	static void aos(Coord *to, Coord2 const &from, std::size_t const n, Frame const &frame)
+	{
+		terra::enuToECEFAoS(to, from, n, frame);
+	}
+};
+
+/* A local frame and the body of the geodetic coordinates, for the fused paths. */
+template<typename T, typename Model>
+struct FramedModel {
+	terra::LocalFrame<T> frame;
+	Model model;
+};
+
+struct GeodToENU {
+	static constexpr char const *name = "geodToENU";
+
+	template<typename Coord, typename Framed>
+	static void single(Coord *to, Coord const &from, Framed const &framed)
+	{
+		terra::geodToENU(to, from, framed.frame, framed.model);
+	}
+
+	template<typename Coord, typename Framed>
+	static void inPlace(Coord *coord, Framed const &framed)
+	{
+		terra::geodToENU(coord, framed.frame, framed.model);
+	}
+
+	template<typename Coord, typename Framed>
+	static void soa(Coord *to, Coord const &from, std::size_t const n, Framed const &framed)
+	{
+		terra::geodToENUSoA(to, from, n, framed.frame, framed.model);
+	}
+
+	template<typename Coord, typename Coord2, typename Framed>
+	static void aos(Coord *to, Coord2 const &from, std::size_t const n, Framed const &framed)
+	{
+		terra::geodToENUAoS(to, from, n, framed.frame, framed.model);
+	}
+};
+
+struct ENUToGeod {
+	static constexpr char const *name = "enuToGeod";
+
+	template<typename Coord, typename Framed>
+	static void single(Coord *to, Coord const &from, Framed const &framed)
+	{
+		terra::enuToGeod(to, from, framed.frame, framed.model);
+	}
+
+	template<typename Coord, typename Framed>
+	static void inPlace(Coord *coord, Framed const &framed)
+	{
+		terra::enuToGeod(coord, framed.frame, framed.model);
+	}
+
+	template<typename Coord, typename Framed>
+	static void soa(Coord *to, Coord const &from, std::size_t const n, Framed const &framed)
+	{
+		terra::enuToGeodSoA(to, from, n, framed.frame, framed.model);
+	}
+
+	template<typename Coord, typename Coord2, typename Framed>
+	static void aos(Coord *to, Coord2 const &from, std::size_t const n, Framed const &framed)
+	{
+		terra::enuToGeodAoS(to, from, n, framed.frame, framed.model);
+	}
+};
+
+/*
+ * Runs every path of one direction over n points of input, given as rows of
+ * three coordinates.
+ */
+template<typename Direction, typename T, typename Model>
+void
+benchDirection(
+	Runner &runner,
+	Model const model,
+	char const * const modelName,
+	std::vector<T> const &input,
+	std::size_t const n)
+{
+	using Row = T[3];
+	auto const in = reinterpret_cast<Row const *>(input.data());
+	std::vector<T> output(n*3);
+	auto out = reinterpret_cast<Row *>(output.data());
+
+	Result path = { "", modelName, Precision<T>::str, Direction::name, "", n, 0, 0.0 };
+
+	path.api = "Single";
+	runner.measure(path, [&] {
+		for (std::size_t i = 0; i < n; ++i)
+			Direction::single(&out[i], in[i], model);
+		clobber(out);
+	});
+
+	/*
+	 * Converting in place turns the buffer into the other kind of coordinate,
+	 * so every call starts by copying the input back; the copy is timed too.
+	 */
+	path.api = "InPlace";
+	runner.measure(path, [&] {
+		std::copy(input.begin(), input.end(), output.begin());
+		for (std::size_t i = 0; i < n; ++i)
+			Direction::inPlace(&out[i], model);
+		clobber(out);
+	});
+
+	path.api = "AoS";
+	runner.measure(path, [&] {
+		Direction::aos(&out, in, n, model);
+		clobber(out);
+	});
+
+	path.api = "SoA";
+	if (!runner.selected(path))
+		return;
+	std::vector<T> x(n), y(n), z(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		x[i] = in[i][0];
+		y[i] = in[i][1];
+		z[i] = in[i][2];
+	}
+	CoordSoA<T> const from = { x.data(), y.data(), z.data() };
+	CoordSoA<T> to = { &output[0], &output[n], &output[2*n] };
+	runner.measure(path, [&] {
+		Direction::soa(&to, from, n, model);
+		clobber(to.x);
+	});
+}
+
+/*
+ * The strided path of a direction, over records of four components: the
+ * coordinate and a fourth standing in for other fields.
+ */
+template<typename Direction, typename T, typename Model>
+void
+benchStrided(
+	Runner &runner,
+	Model const model,
+	char const * const modelName,
+	std::vector<T> const &input,
+	std::size_t const n)
+{
+	Result path = { "Strided", modelName, Precision<T>::str, Direction::name, "", n, 0, 0.0 };
+	if (!runner.selected(path))
+		return;
+
+	std::vector<T> records(n*4), converted(n*4);
+	for (std::size_t i = 0; i < n; ++i)
+		std::copy(&input[3*i], &input[3*i] + 3, &records[4*i]);
+	auto const from = terra::strided<T const>(records.data(), 4*sizeof(T));
+	auto to = terra::strided(converted.data(), 4*sizeof(T));
+	runner.measure(path, [&] {
+		Direction::strided(&to, from, n, model);
+		clobber(to.x);
+	});
+}
+
+template<typename T, typename Model>
+void
+benchModel(Runner &runner, Model const model, char const * const modelName, std::size_t const n)
+{
+	/* Points spread evenly over the globe, from below sea level to a few km up. */
+	std::vector<T> geod(n*3);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		geod[3*i + 0] = T((2.0*u - 1.0)*3.141592653589793);
+		geod[3*i + 1] = T(std::asin(2.0*v - 1.0));
+		geod[3*i + 2] = T(w*10000.0 - 500.0);
+	}
+	std::vector<T> ecef(n*3);
+	auto ecefRows = reinterpret_cast<T(*)[3]>(ecef.data());
+	terra::geodToECEFAoS(&ecefRows, reinterpret_cast<T const(*)[3]>(geod.data()), n, model);
+
+	benchDirection<GeodToECEF>(runner, model, modelName, geod, n);
+	benchDirection<ECEFToGeod>(runner, model, modelName, ecef, n);
+	benchStrided<GeodToECEF>(runner, model, modelName, geod, n);
+	benchStrided<ECEFToGeod>(runner, model, modelName, ecef, n);
+}
+
+/*
+ * The local frame transforms, around an origin in the middle of the points,
+ * and the fused geodetic ones next to the two passes through ECEF they replace.
+ */
+template<typename T>
+void
+benchFrame(Runner &runner, std::size_t const n)
+{
+	terra::WGS84<T> const model;
+	terra::LocalFrame<T> const frame(T(0.2), T(0.9), T(100), model);
+	FramedModel<T, terra::WGS84<T>> const framed = { frame, model };
+	std::vector<T> enu(n*3);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		enu[3*i + 0] = T((2.0*u - 1.0)*100000.0);
+		enu[3*i + 1] = T((2.0*v - 1.0)*100000.0);
+		enu[3*i + 2] = T(w*10000.0 - 500.0);
+	}
+	std::vector<T> ecef(n*3), geod(n*3);
+	auto ecefRows = reinterpret_cast<T(*)[3]>(ecef.data());
+	auto geodRows = reinterpret_cast<T(*)[3]>(geod.data());
+	terra::enuToECEFAoS(&ecefRows, reinterpret_cast<T const(*)[3]>(enu.data()), n, frame);
+	terra::ecefToGeodAoS(&geodRows, ecefRows, n, model);
+
+	benchDirection<ECEFToENU>(runner, frame, "LocalFrame", ecef, n);
+	benchDirection<ENUToECEF>(runner, frame, "LocalFrame", enu, n);
+	benchDirection<GeodToENU>(runner, framed, "LocalFrame", geod, n);
+	benchDirection<ENUToGeod>(runner, framed, "LocalFrame", enu, n);
+
+	Result path = { "SoATwoPass", "LocalFrame", Precision<T>::str, GeodToENU::name, "", n, 0, 0.0 };
+	if (!runner.selected(path))
+		return;
+	std::vector<T> x(n), y(n), z(n), e(n), nn(n), u(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		x[i] = geodRows[i][0];
+		y[i] = geodRows[i][1];
+		z[i] = geodRows[i][2];
+	}
+	CoordSoA<T> const from = { x.data(), y.data(), z.data() };
+	CoordSoA<T> tmp = { &ecef[0], &ecef[n], &ecef[2*n] };
+	CoordSoA<T> to = { e.data(), nn.data(), u.data() };
+	runner.measure(path, [&] {
+		terra::geodToECEFSoA(&tmp, from, n, model);
+		terra::ecefToENUSoA(&to, tmp, n, frame);
+		clobber(to.x);
+	});
+}
+
+/*
+ * The Degrees<> conversions in SoA form, next to the radian ones with the
+ * scaling pass over the angles they replace.
+ */
+template<typename T>
+void
+benchDegrees(Runner &runner, std::size_t const n)
+{
+	terra::WGS84<T> const model;
+	auto const degrees = terra::degrees(model);
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n), a(n), b(n), c(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = T((2.0*u - 1.0)*180.0);
+		lat[i] = T(std::asin(2.0*v - 1.0)*57.29577951308232);
+		alt[i] = T(w*10000.0 - 500.0);
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> out = { a.data(), b.data(), c.data() };
+	terra::geodToECEFSoA(&ecef, geod, n, degrees);
+
+	runner.measure({ "SoA", "DegreesEllipsoid", Precision<T>::str, GeodToECEF::name, "", n, 0, 0.0 }, [&] {
+		terra::geodToECEFSoA(&out, geod, n, degrees);
+		clobber(out.x);
+	});
+	runner.measure({ "SoAScaled", "DegreesEllipsoid", Precision<T>::str, GeodToECEF::name, "", n, 0, 0.0 }, [&] {
+		for (std::size_t i = 0; i < n; ++i) {
+			out.x[i] = lon[i]*T(0.017453292519943295);
+			out.y[i] = lat[i]*T(0.017453292519943295);
+		}
+		CoordSoA<T> const scaled = { out.x, out.y, alt.data() };
+		terra::geodToECEFSoA(&out, scaled, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoA", "DegreesEllipsoid", Precision<T>::str, ECEFToGeod::name, "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, degrees);
+		clobber(out.x);
+	});
+	runner.measure({ "SoAScaled", "DegreesEllipsoid", Precision<T>::str, ECEFToGeod::name, "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, model);
+		for (std::size_t i = 0; i < n; ++i) {
+			out.x[i] *= T(57.29577951308232);
+			out.y[i] *= T(57.29577951308232);
+		}
+		clobber(out.x);
+	});
+}
+
+/*
+ * The fixed-point conversions in SoA form, next to the radian ones with the
+ * pass expanding or encoding the integers they replace.
+ */
+template<typename T>
+void
+benchFixed(Runner &runner, std::size_t const n)
+{
+	terra::WGS84<T> const model;
+	std::vector<std::int32_t> lon(n), lat(n), alt(n), ilon(n), ilat(n), ialt(n);
+	std::vector<T> x(n), y(n), z(n), a(n), b(n), c(n), d(n), e(n), f(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = std::int32_t((2.0*u - 1.0)*1.8e9);
+		lat[i] = std::int32_t(std::asin(2.0*v - 1.0)*57.29577951308232*1e7);
+		alt[i] = std::int32_t(w*1e7 - 5e5);
+	}
+	CoordSoA<std::int32_t> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<std::int32_t> fixed = { ilon.data(), ilat.data(), ialt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> out = { a.data(), b.data(), c.data() };
+	CoordSoA<T> scaled = { d.data(), e.data(), f.data() };
+	terra::geodFixedToECEFSoA(&ecef, geod, n, model);
+
+	runner.measure({ "SoA", "FixedEllipsoid", Precision<T>::str, GeodToECEF::name, "", n, 0, 0.0 }, [&] {
+		terra::geodFixedToECEFSoA(&out, geod, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoAScaled", "FixedEllipsoid", Precision<T>::str, GeodToECEF::name, "", n, 0, 0.0 }, [&] {
+		for (std::size_t i = 0; i < n; ++i) {
+			scaled.x[i] = T(double(lon[i])*1.7453292519943295e-09);
+			scaled.y[i] = T(double(lat[i])*1.7453292519943295e-09);
+			scaled.z[i] = T(double(alt[i])*1e-3);
+		}
+		terra::geodToECEFSoA(&out, scaled, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoA", "FixedEllipsoid", Precision<T>::str, ECEFToGeod::name, "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodFixedSoA(&fixed, ecef, n, model);
+		clobber(fixed.x);
+	});
+	runner.measure({ "SoAScaled", "FixedEllipsoid", Precision<T>::str, ECEFToGeod::name, "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, model);
+		for (std::size_t i = 0; i < n; ++i) {
+			fixed.x[i] = std::int32_t(std::lrint(double(out.x[i])*572957795.1308232));
+			fixed.y[i] = std::int32_t(std::lrint(double(out.y[i])*572957795.1308232));
+			fixed.z[i] = std::int32_t(std::lrint(double(out.z[i])*1e3));
+		}
+		clobber(fixed.x);
+	});
+}
+
+/*
+ * Millimetre offsets from a tile centre in int32, next to the absolute SoA
+ * conversions with the pass taking and quantizing the offsets they replace.
+ */
+template<typename T>
+void
+benchTile(Runner &runner, std::size_t const n)
+{
+	terra::WGS84<T> const model;
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n), a(n), b(n), c(n);
+	std::vector<std::int32_t> ix(n), iy(n), iz(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = T(0.2 + u*1e-3);
+		lat[i] = T(0.8 + v*1e-3);
+		alt[i] = T(w*1000.0);
+	}
+	T centre[3] = { T(0.2), T(0.8), T(0) };
+	terra::geodToECEF(&centre, model);
+	auto const tile = terra::tile(centre[0], centre[1], centre[2], T(0.001));
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> out = { a.data(), b.data(), c.data() };
+	CoordSoA<std::int32_t> offsets = { ix.data(), iy.data(), iz.data() };
+	terra::geodToECEFTileSoA(&offsets, geod, n, tile, model);
+
+	runner.measure({ "SoA", "TileEllipsoid", Precision<T>::str, GeodToECEF::name, "", n, 0, 0.0 }, [&] {
+		terra::geodToECEFTileSoA(&offsets, geod, n, tile, model);
+		clobber(offsets.x);
+	});
+	runner.measure({ "SoAScaled", "TileEllipsoid", Precision<T>::str, GeodToECEF::name, "", n, 0, 0.0 }, [&] {
+		terra::geodToECEFSoA(&ecef, geod, n, model);
+		for (std::size_t i = 0; i < n; ++i) {
+			offsets.x[i] = std::int32_t(std::lrint((ecef.x[i] - centre[0])*T(1000)));
+			offsets.y[i] = std::int32_t(std::lrint((ecef.y[i] - centre[1])*T(1000)));
+			offsets.z[i] = std::int32_t(std::lrint((ecef.z[i] - centre[2])*T(1000)));
+		}
+		clobber(offsets.x);
+	});
+	runner.measure({ "SoA", "TileEllipsoid", Precision<T>::str, ECEFToGeod::name, "", n, 0, 0.0 }, [&] {
+		terra::ecefTileToGeodSoA(&out, offsets, n, tile, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoAScaled", "TileEllipsoid", Precision<T>::str, ECEFToGeod::name, "", n, 0, 0.0 }, [&] {
+		for (std::size_t i = 0; i < n; ++i) {
+			ecef.x[i] = centre[0] + T(offsets.x[i])*T(0.001);
+			ecef.y[i] = centre[1] + T(offsets.y[i])*T(0.001);
+			ecef.z[i] = centre[2] + T(offsets.z[i])*T(0.001);
+		}
+		terra::ecefToGeodSoA(&out, ecef, n, model);
+		clobber(out.x);
+	});
+}
+
+/*
+ * The geodesic problems in SoA form, between points up to about 115 degrees of
+ * longitude apart, as for matching routes, on the sphere and the ellipsoid;
+ * the distances alone and from one point to many, as for proximity checks.
+ */
+template<typename T, typename Model>
+void
+benchGeodesic(Runner &runner, Model const model, char const * const modelName, std::size_t const n)
+{
+	std::vector<T> lon1(n), lat1(n), lon2(n), lat2(n), alt(n), s(n), a1(n), a2(n), a(n), b(n), c(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		auto const d = std::fmod(double(i)*0.4142135623730950, 1.0);
+		lon1[i] = T((2.0*u - 1.0)*3.141592653589793);
+		lat1[i] = T(std::asin(2.0*v - 1.0));
+		lon2[i] = T(std::remainder(double(lon1[i]) + (2.0*d - 1.0)*2.0, 6.283185307179586));
+		lat2[i] = T(std::asin(2.0*w - 1.0));
+	}
+	T const point[3] = { T(0.2), T(0.8), T(0) };
+	CoordSoA<T> const from = { lon1.data(), lat1.data(), alt.data() };
+	CoordSoA<T> const to = { lon2.data(), lat2.data(), alt.data() };
+	CoordSoA<T> geodesic = { s.data(), a1.data(), a2.data() };
+	CoordSoA<T> out = { a.data(), b.data(), c.data() };
+	terra::geodesicInverseSoA(&geodesic, from, to, n, model);
+
+	runner.measure({ "SoA", modelName, Precision<T>::str, "geodesicInverse", "", n, 0, 0.0 }, [&] {
+		terra::geodesicInverseSoA(&geodesic, from, to, n, model);
+		clobber(geodesic.x);
+	});
+	runner.measure({ "SoA", modelName, Precision<T>::str, "geodesicDistance", "", n, 0, 0.0 }, [&] {
+		terra::geodesicDistanceSoA(out.x, from, to, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoAOneToMany", modelName, Precision<T>::str, "geodesicDistance", "", n, 0, 0.0 }, [&] {
+		terra::geodesicDistanceOneToManySoA(out.x, point, to, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoA", modelName, Precision<T>::str, "geodesicDirect", "", n, 0, 0.0 }, [&] {
+		terra::geodesicDirectSoA(&out, from, geodesic, n, model);
+		clobber(out.x);
+	});
+}
+
+/*
+ * The fused datum transformation, ETRS89 to OSGB36, next to the three passes
+ * through ECEF it replaces.
+ */
+template<typename T>
+void
+benchDatum(Runner &runner, std::size_t const n)
+{
+	terra::GRS80<T> const from;
+	terra::Ellipsoid<T> const to(T(6377563.396), T(6356256.909));
+	terra::Helmert<T> const helmert(T(-446.448), T(125.157), T(-542.060), T(-0.1502), T(-0.2470), T(-0.8421),
+					T(20.4894));
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n), a(n), b(n), c(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		lon[i] = T(-0.1 + 0.05*std::fmod(double(i)*0.6180339887498949, 1.0));
+		lat[i] = T(0.9 + 0.05*std::fmod(double(i)*0.7548776662466927, 1.0));
+		alt[i] = T(100.0*std::fmod(double(i)*0.5698402909980532, 1.0));
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> shifted = { a.data(), b.data(), c.data() };
+	CoordSoA<T> out = { a.data(), b.data(), c.data() };
+
+	runner.measure({ "SoA", "Datum", Precision<T>::str, "datumTransform", "", n, 0, 0.0 }, [&] {
+		terra::datumTransformSoA(&out, geod, n, helmert, from, to);
+		clobber(out.x);
+	});
+	runner.measure({ "SoAThreePass", "Datum", Precision<T>::str, "datumTransform", "", n, 0, 0.0 }, [&] {
+		terra::geodToECEFSoA(&ecef, geod, n, from);
+		terra::helmertSoA(&shifted, ecef, n, helmert);
+		terra::ecefToGeodSoA(&ecef, shifted, n, to);
+		clobber(ecef.x);
+	});
+}
+
+/*
+ * UTM zone 33 both ways over the width of the zone, and from ECEF in one pass
+ * next to ecefToGeod followed by the projection.
+ */
+template<typename T>
+void
+benchTransverseMercator(Runner &runner, std::size_t const n)
+{
+	auto const model = terra::WGS84<T>();
+	auto const projection = terra::utm(33, true, model);
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n), a(n), b(n), c(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		lon[i] = T(0.21 + 0.1*std::fmod(double(i)*0.6180339887498949, 1.0));
+		lat[i] = T(1.4*std::fmod(double(i)*0.7548776662466927, 1.0));
+		alt[i] = T(100.0*std::fmod(double(i)*0.5698402909980532, 1.0));
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> grid = { a.data(), b.data(), c.data() };
+	CoordSoA<T> out = { lon.data(), lat.data(), alt.data() };
+	terra::geodToECEFSoA(&ecef, geod, n, model);
+	terra::geodToTransverseMercatorSoA(&grid, geod, n, projection, model);
+
+	runner.measure({ "SoA", "TransverseMercator", Precision<T>::str, "geodToTransverseMercator", "", n, 0, 0.0 }, [&] {
+		terra::geodToTransverseMercatorSoA(&grid, geod, n, projection, model);
+		clobber(grid.x);
+	});
+	runner.measure({ "SoA", "TransverseMercator", Precision<T>::str, "transverseMercatorToGeod", "", n, 0, 0.0 }, [&] {
+		terra::transverseMercatorToGeodSoA(&out, grid, n, projection, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoA", "TransverseMercator", Precision<T>::str, "ecefToTransverseMercator", "", n, 0, 0.0 }, [&] {
+		terra::ecefToTransverseMercatorSoA(&grid, ecef, n, projection, model);
+		clobber(grid.x);
+	});
+	runner.measure({ "SoATwoPass", "TransverseMercator", Precision<T>::str, "ecefToTransverseMercator", "", n, 0,
+			 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, model);
+		terra::geodToTransverseMercatorSoA(&grid, out, n, projection, model);
+		clobber(grid.x);
+	});
+}
+
+/*
+ * Bowring iterated to a tolerance, over the SoA and AoS paths, next to one and
+ * three fixed steps, from below sea level out to geostationary orbit.
+ */
+template<typename T>
+void
+benchTolerance(Runner &runner, std::size_t const n)
+{
+	auto const model = terra::WGS84<T>();
+	terra::BowringTolerance const algorithm(std::is_same<T, float>::value ? 1e-7 : 1e-12);
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = T((2.0*std::fmod(double(i)*0.6180339887498949, 1.0) - 1.0)*3.141592653589793);
+		lat[i] = T(std::asin(2.0*std::fmod(double(i)*0.7548776662466927, 1.0) - 1.0));
+		alt[i] = T(w*w*w*35786000.0 - 500.0);
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> out = { lon.data(), lat.data(), alt.data() };
+	terra::geodToECEFSoA(&ecef, geod, n, model);
+	std::vector<T> rows(3*n), back(3*n);
+	for (std::size_t i = 0; i < n; ++i) {
+		rows[3*i + 0] = x[i];
+		rows[3*i + 1] = y[i];
+		rows[3*i + 2] = z[i];
+	}
+	auto const from = reinterpret_cast<T const(*)[3]>(rows.data());
+	auto to = reinterpret_cast<T(*)[3]>(back.data());
+
+	runner.measure({ "SoA", "Ellipsoid", Precision<T>::str, "ecefToGeodBowring", "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoA", "Ellipsoid", Precision<T>::str, "ecefToGeodBowringIterative3", "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA<terra::BowringIterative<3>>(&out, ecef, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoA", "Ellipsoid", Precision<T>::str, "ecefToGeodBowringTolerance", "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, model, algorithm);
+		clobber(out.x);
+	});
+	runner.measure({ "AoS", "Ellipsoid", Precision<T>::str, "ecefToGeodBowringTolerance", "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodAoS(&to, from, n, model, algorithm);
+		clobber(to);
+	});
+}
+
+/*
+ * A track sampled every 6 m, as an aircraft logged at 40 Hz, converted along
+ * the track next to the same points converted independently.
+ */
+template<typename T>
+void
+benchTrajectory(Runner &runner, std::size_t const n)
+{
+	auto const model = terra::WGS84<T>();
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		lon[i] = T(0.3 + 1e-6*std::fmod(double(i), 1e6));
+		lat[i] = T(1.0 + 0.5e-6*std::fmod(double(i), 1e6));
+		alt[i] = T(10000.0 + 0.01*std::fmod(double(i), 1e6));
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	CoordSoA<T> out = { lon.data(), lat.data(), alt.data() };
+	terra::geodToECEFSoA(&ecef, geod, n, model);
+
+	runner.measure({ "SoA", "Ellipsoid", Precision<T>::str, "ecefToGeodTrajectory", "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodSoA(&out, ecef, n, model);
+		clobber(out.x);
+	});
+	runner.measure({ "SoATrajectory", "Ellipsoid", Precision<T>::str, "ecefToGeodTrajectory", "", n, 0, 0.0 }, [&] {
+		terra::ecefToGeodTrajectorySoA(&out, ecef, n, model);
+		clobber(out.x);
+	});
+}
+
+/*
+ * Web Mercator both ways over the map, and straight to tiles and pixels at
+ * zoom 16, next to single calls projecting to metres.
+ */
+template<typename T>
+void
+benchWebMercator(Runner &runner, std::size_t const n)
+{
+	terra::Sphere<T> const sphere(T(6378137));
+	std::vector<T> lon(n), lat(n), alt(n), a(n), b(n), c(n);
+	std::vector<std::uint32_t> tx(n), ty(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		lon[i] = T((2.0*std::fmod(double(i)*0.6180339887498949, 1.0) - 1.0)*3.141592653589793);
+		lat[i] = T((2.0*std::fmod(double(i)*0.7548776662466927, 1.0) - 1.0)*1.48);
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> mercator = { a.data(), b.data(), c.data() };
+	CoordSoA<T> out = { lon.data(), lat.data(), alt.data() };
+	struct {
+		std::uint32_t *x, *y;
+	} index = { tx.data(), ty.data() };
+	struct {
+		T *x, *y;
+	} pixel = { a.data(), b.data() };
+	terra::geodToWebMercatorSoA(&mercator, geod, n, sphere);
+
+	runner.measure({ "SoA", "WebMercator", Precision<T>::str, "geodToWebMercator", "", n, 0, 0.0 }, [&] {
+		terra::geodToWebMercatorSoA(&mercator, geod, n, sphere);
+		clobber(mercator.x);
+	});
+	runner.measure({ "SoA", "WebMercator", Precision<T>::str, "webMercatorToGeod", "", n, 0, 0.0 }, [&] {
+		terra::webMercatorToGeodSoA(&out, mercator, n, sphere);
+		clobber(out.x);
+	});
+	runner.measure({ "Single", "WebMercator", Precision<T>::str, "geodToWebMercator", "", n, 0, 0.0 }, [&] {
+		for (std::size_t i = 0; i < n; ++i) {
+			T coord[3] = { lon[i], lat[i], alt[i] };
+			terra::geodToWebMercator(&coord, sphere);
+			a[i] = coord[0];
+			b[i] = coord[1];
+		}
+		clobber(a.data());
+	});
+	runner.measure({ "SoA", "WebMercator", Precision<T>::str, "geodToWebMercatorTile", "", n, 0, 0.0 }, [&] {
+		terra::geodToWebMercatorTileSoA(&index, &pixel, geod, n, 16, sphere);
+		clobber(index.x);
+	});
+}
+
+/*
+ * The spatial index on one thread: building it from geodetic points spread
+ * over a 60 km square, then a radius and a k-nearest query around every one.
+ */
+template<typename T>
+void
+benchSpatialIndex(Runner &runner, std::size_t const n)
+{
+	constexpr std::size_t k = 8;
+	std::vector<T> lon(n), lat(n), alt(n), x(n), y(n), z(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		lon[i] = T(0.3 + 0.01*std::fmod(double(i)*0.6180339887498949, 1.0));
+		lat[i] = T(1.0 + 0.01*std::fmod(double(i)*0.7548776662466927, 1.0));
+	}
+	auto const model = terra::WGS84<T>();
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	terra::geodToECEFSoA(&ecef, geod, n, model);
+
+	terra::SerialExecutor serial;
+	terra::SpatialIndex<T> index;
+	std::vector<std::size_t> offsets, found, nearest(n*k);
+	runner.measure({ "SoA", "SpatialIndex", Precision<T>::str, "indexBuild", "", n, 0, 0.0 }, [&] {
+		index.build(serial, geod, n, model);
+		clobber(&index);
+	});
+	runner.measure({ "SoA", "SpatialIndex", Precision<T>::str, "indexRadius", "", n, 0, 0.0 }, [&] {
+		index.radiusSoA(serial, ecef, n, T(200), &offsets, &found);
+		clobber(found.data());
+	});
+	runner.measure({ "SoA", "SpatialIndex", Precision<T>::str, "indexNearest", "", n, 0, 0.0 }, [&] {
+		index.nearestSoA(serial, ecef, n, k, nearest.data(), static_cast<T *>(nullptr));
+		clobber(nearest.data());
+	});
+}
+
+} // !namespace
+
+void
+benchConversions(Runner &runner)
+{
+	for (auto const n : runner.counts()) {
+		benchModel<float>(runner, terra::Sphere<float>(6371000.0f), "Sphere", n);
+		benchModel<float>(runner, terra::Ellipsoid<float>(6378137.0f, 6356752.314245f), "Ellipsoid", n);
+		benchModel<float>(runner, terra::approximate(terra::Sphere<float>(6371000.0f)), "ApproximateSphere", n);
+		benchModel<float>(runner, terra::approximate(terra::Ellipsoid<float>(6378137.0f, 6356752.314245f)),
+				  "ApproximateEllipsoid", n);
+		benchModel<double>(runner, terra::Sphere<double>(6371000.0), "Sphere", n);
+		benchModel<double>(runner, terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid", n);
+		benchModel<float>(runner, terra::Ellipsoid<double>(6378137.0, 6356752.314245), "MixedEllipsoid", n);
+		benchFrame<float>(runner, n);
+		benchFrame<double>(runner, n);
+		benchDegrees<float>(runner, n);
+		benchDegrees<double>(runner, n);
+		benchFixed<float>(runner, n);
+		benchFixed<double>(runner, n);
+		benchTile<float>(runner, n);
+		benchTile<double>(runner, n);
+		benchGeodesic<float>(runner, terra::Sphere<float>(6371000.0f), "Sphere", n);
+		benchGeodesic<double>(runner, terra::Sphere<double>(6371000.0), "Sphere", n);
+		benchGeodesic<float>(runner, terra::WGS84<float>(), "Ellipsoid", n);
+		benchGeodesic<double>(runner, terra::WGS84<double>(), "Ellipsoid", n);
+		benchDatum<float>(runner, n);
+		benchDatum<double>(runner, n);
+		benchTransverseMercator<float>(runner, n);
+		benchTransverseMercator<double>(runner, n);
+		benchWebMercator<float>(runner, n);
+		benchWebMercator<double>(runner, n);
+		benchTrajectory<float>(runner, n);
+		benchTrajectory<double>(runner, n);
+		benchTolerance<float>(runner, n);
+		benchTolerance<double>(runner, n);
+		if (n <= 1000000) {
+			benchSpatialIndex<float>(runner, n);
+			benchSpatialIndex<double>(runner, n);
+		}
+	}
+}
+
+} // !namespace bench
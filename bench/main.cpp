@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "Bench.hpp"
+#include <terra/Dispatch.hpp>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+void
+usage(char const * const argv0)
+{
+	std::fprintf(stderr,
+		     "usage: %s [options]\n"
+		     "  --format=csv|json   output format (default csv)\n"
+		     "  --output=FILE       write to FILE instead of stdout\n"
+		     "  --max-count=N       largest batch size, in points (default 10000000)\n"
+		     "  --min-time=SECONDS  time spent per measurement (default 0.1)\n"
+		     "  --flush-mb=N        MiB written to flush the caches (default 64)\n"
+		     "  --filter=TEXT       only run paths whose api/model/type/direction contains TEXT\n"
+		     "  --simd=LEVEL        run at scalar, SSE2, SSE4.2, AVX2 or AVX-512 (default detected)\n",
+		     argv0);
+}
+
+char const *
+value(char const * const arg, char const * const option)
+{
+	auto const len = std::strlen(option);
+	if (std::strncmp(arg, option, len) == 0 && arg[len] == '=')
+		return arg + len + 1;
+	return nullptr;
+}
+
+} // !namespace
+
+int
+main(int argc, char **argv)
+{
+	bench::Options options;
+	auto json = false;
+	char const *output = nullptr;
+
+	for (auto i = 1; i < argc; ++i) {
+		char const *v;
+		if ((v = value(argv[i], "--format")) && (!std::strcmp(v, "csv") || !std::strcmp(v, "json"))) {
+			json = !std::strcmp(v, "json");
+		} else if ((v = value(argv[i], "--output"))) {
+			output = v;
+		} else if ((v = value(argv[i], "--max-count")) && std::strtoull(v, nullptr, 10) > 0) {
+			options.maxCount = std::strtoull(v, nullptr, 10);
+		} else if ((v = value(argv[i], "--min-time"))) {
+			options.minTime = std::strtod(v, nullptr);
+		} else if ((v = value(argv[i], "--flush-mb"))) {
+			options.flushBytes = std::size_t(std::strtoull(v, nullptr, 10)) << 20;
+		} else if ((v = value(argv[i], "--filter"))) {
+			options.filter = v;
+		} else if ((v = value(argv[i], "--simd"))) {
+			auto found = false;
+			for (auto l = 0; l <= int(terra::SimdLevel::AVX512); ++l) {
+				if (!std::strcmp(v, terra::simdLevelName(terra::SimdLevel(l)))) {
+					auto const level = terra::SimdLevel(l);
+					if (terra::setSimdLevel(level) != level) {
+						std::fprintf(stderr, "%s: %s is not supported here\n", argv[0], v);
+						return EXIT_FAILURE;
+					}
+					found = true;
+				}
+			}
+			if (!found) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	bench::Runner runner(options);
+	bench::benchConversions(runner);
+
+	auto const out = output ? std::fopen(output, "w") : stdout;
+	if (!out) {
+		std::fprintf(stderr, "%s: cannot open %s\n", argv[0], output);
+		return EXIT_FAILURE;
+	}
+	auto const simd = terra::simdLevelName(terra::simdLevel());
+	if (json)
+		bench::writeJSON(out, runner.results(), simd);
+	else
+		bench::writeCSV(out, runner.results(), simd);
+	if (out != stdout)
+		std::fclose(out);
+	return EXIT_SUCCESS;
+}
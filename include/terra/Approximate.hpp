@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Approximate_hpp
+#define terra_Approximate_hpp
+
+#include <terra/Degrees.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief A float reference body whose conversions use a shorter polynomial
+ *	and argument reduction for sin and cos and the hardware estimate of
+ *	1/sqrt(x), refined by one Newton step, instead of the exact float math.
+ *	Its atan2 is the octant polynomial the vector levels already use for the
+ *	exact math, so there only sincos and 1/sqrt change; the single point
+ *	functions also trade libm's atan2 for it.
+ *	Pass it wherever the wrapped body is accepted: the single, SoA, AoS and
+ *	parallel functions all pick the approximations up from its type.
+ * Maximum errors against an exact conversion in double, over the whole globe
+ * and altitudes from -500 m to 100 km, at every instruction set level:
+ *
+ *	                        exact float   Approximate
+ *	Sphere geodToECEF       1.2 m         1.7 m
+ *	Sphere ecefToGeod       2.5e-7 rad    2.5e-7 rad
+ *	                        0.8 m alt.    0.8 m alt.
+ *	WGS84 geodToECEF        1.6 m         2.4 m
+ *	WGS84 ecefToGeod        2.5e-7 rad    2.5e-7 rad
+ *	                        1.4 m alt.    1.4 m alt.
+ *
+ * Float resolves no better than 0.5 m at the Earth's radius, so the cost is
+ * about half an ulp. The gain is largest on the single point functions, which
+ * no longer call into libm; on the vector levels, which already run
+ * polynomials, the SoA functions gain 1.02 to 1.31 times.
+ * Of the ecefToGeod algorithms only the default Bowring is approximated.
+ * @tparam Model Sphere<float>, PreparedEllipsoid<float> or
+ *	StaticEllipsoid<float, Axes> such as WGS84<float>.
+ */
+template<typename Model>
+struct Approximate : Model {
+	static_assert(std::is_same<typename Model::value_type, float>::value,
+		      "Approximate is for float reference bodies");
+	static_assert(!IsDegrees<Model>::value,
+		      "wrap Approximate<> in Degrees<>, not the other way round");
+
+	using Model::Model;
+	Approximate() = default;
+	explicit Approximate(Model const &model) noexcept : Model(model) {}
+};
+
+template<typename Model>
+struct IsEllipsoidModel<Approximate<Model>> : IsEllipsoidModel<Model> {};
+
+template<typename Model>
+struct IsSphere<Approximate<Model>> : IsSphere<Model> {};
+
+/**
+ * @brief Wrap a float reference body in Approximate.
+ * @param model Sphere<float>, PreparedEllipsoid<float> or StaticEllipsoid<float, Axes>.
+ */
+template<typename Model>
+inline
+Approximate<Model>
+approximate(Model const &model) noexcept;
+
+/**
+ * @brief Prepare a float ellipsoid and wrap it in Approximate.
+ */
+inline
+Approximate<PreparedEllipsoid<float>>
+approximate(Ellipsoid<float> const &ellipsoid) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/ApproximateImpl.hpp>
+
+#endif // !terra_Approximate_hpp
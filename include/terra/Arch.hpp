@@ -21,9 +21,61 @@
 #define TERRA_RESTRICT __restrict__
 #elif defined(__clang__)
 #define TERRA_RESTRICT __restrict__
-#elif defined(_MSC_VER__)
+#elif defined(_MSC_VER)
+#define TERRA_RESTRICT __restrict
 #else
 #define TERRA_RESTRICT
 #endif
 
+#define TERRA_PRAGMA(x) _Pragma(#x)
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TERRA_X86 1
+#endif
+
+/*
+ * On x86 with GCC, Clang or MSVC every instruction set below is compiled in,
+ * each kernel under its own target attribute, and the batch functions pick
+ * one at run time (see Dispatch.hpp). Define TERRA_NO_DISPATCH to compile
+ * only what the consumer's own flags (e.g. -mavx2 -mfma) enable.
+ */
+#if defined(TERRA_X86) && !defined(TERRA_NO_DISPATCH) && \
+	(defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define TERRA_SIMD_DISPATCH 1
+#endif
+
+#if defined(TERRA_SIMD_DISPATCH) || defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TERRA_SIMD_SSE2 1
+#endif
+#if defined(TERRA_SIMD_DISPATCH) || defined(__SSE4_2__)
+#define TERRA_SIMD_SSE42 1
+#endif
+#if defined(TERRA_SIMD_DISPATCH) || (defined(__AVX2__) && defined(__FMA__))
+#define TERRA_SIMD_AVX2 1
+#endif
+#if defined(TERRA_SIMD_DISPATCH) || defined(__AVX512F__)
+#define TERRA_SIMD_AVX512 1
+#endif
+
+/*
+ * Bracket code that may use a given instruction set. Only needed, and only
+ * expands to anything, when dispatching at run time with GCC or Clang.
+ */
+#if defined(TERRA_SIMD_DISPATCH) && defined(__clang__)
+#define TERRA_TARGET_BEGIN(isa) TERRA_PRAGMA(clang attribute push(__attribute__((target(isa))), apply_to = function))
+#define TERRA_TARGET_END() TERRA_PRAGMA(clang attribute pop)
+#elif defined(TERRA_SIMD_DISPATCH) && defined(__GNUC__)
+#define TERRA_TARGET_BEGIN(isa) TERRA_PRAGMA(GCC push_options) TERRA_PRAGMA(GCC target(isa))
+#define TERRA_TARGET_END() TERRA_PRAGMA(GCC pop_options)
+#else
+#define TERRA_TARGET_BEGIN(isa)
+#define TERRA_TARGET_END()
+#endif
+
+#define TERRA_TARGET_SSE2 "sse2"
+#define TERRA_TARGET_SSE42 "sse4.2"
+#define TERRA_TARGET_AVX2 "avx2,fma"
+#define TERRA_TARGET_AVX512 "avx512f,avx2,fma"
+
 #endif // !terra_Arch_hpp
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Degrees_hpp
+#define terra_Degrees_hpp
+
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief A reference body whose geodetic coordinates have longitude and
+ *	latitude in degrees rather than radians.
+ *	Pass it wherever the wrapped body is accepted: the single, SoA, AoS,
+ *	strided and parallel functions, and the local frames, all pick the unit
+ *	up from its type.
+ * The conversion to and from radians happens in registers, inside the
+ * kernels: sines and cosines reduce their argument by 90 degrees, which is
+ * exact, and arctangents are scaled on the way out. That saves the separate
+ * scaling pass over the arrays, and the reduction keeps longitudes accurate
+ * however many turns they are off the [-180, 180] range. Results match the
+ * radian conversions to within an ulp or two of the angles.
+ * @note: Wrap an Approximate<> body in Degrees<>, not the other way round.
+ * @tparam Model Sphere<T>, PreparedEllipsoid<T> or StaticEllipsoid<T, Axes>
+ *	such as WGS84<T>, possibly wrapped in Approximate<>.
+ */
+template<typename Model>
+struct Degrees : Model {
+	using Model::Model;
+	Degrees() = default;
+	explicit Degrees(Model const &model) noexcept : Model(model) {}
+};
+
+/**
+ * @brief True for Degrees<Model>.
+ */
+template<typename Model>
+struct IsDegrees : std::false_type {};
+template<typename Model>
+struct IsDegrees<Degrees<Model>> : std::true_type {};
+
+template<typename Model>
+struct IsEllipsoidModel<Degrees<Model>> : IsEllipsoidModel<Model> {};
+
+template<typename Model>
+struct IsSphere<Degrees<Model>> : IsSphere<Model> {};
+
+/**
+ * @brief Wrap a reference body in Degrees.
+ * @param model Sphere<T>, PreparedEllipsoid<T> or StaticEllipsoid<T, Axes>,
+ *	possibly wrapped in Approximate<>.
+ */
+template<typename Model>
+inline
+Degrees<Model>
+degrees(Model const &model) noexcept;
+
+/**
+ * @brief Prepare an ellipsoid and wrap it in Degrees.
+ */
+template<typename T>
+inline
+Degrees<PreparedEllipsoid<T>>
+degrees(Ellipsoid<T> const &ellipsoid) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/DegreesImpl.hpp>
+
+#endif // !terra_Degrees_hpp
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Dispatch_hpp
+#define terra_Dispatch_hpp
+
+#include <terra/Arch.hpp>
+
+namespace terra {
+
+/**
+ * @brief Instruction set levels the batch conversion functions can run at.
+ * Every level includes the ones before it.
+ */
+enum class SimdLevel {
+	Scalar = 0,	/**< Plain C++, no vector instructions. */
+	SSE2,		/**< 128-bit SSE2. */
+	SSE42,		/**< 128-bit SSE4.2. */
+	AVX2,		/**< 256-bit AVX2 and FMA. */
+	AVX512		/**< 512-bit AVX-512F. */
+};
+
+/**
+ * @brief Find the best instruction set level supported by both the CPU, the
+ *	operating system and the build.
+ * @note: Queries cpuid every time it is called; simdLevel() caches the result.
+ * @return The detected level.
+ */
+inline
+SimdLevel
+detectSimdLevel() noexcept;
+
+/**
+ * @brief Get the instruction set level the batch conversion functions
+ *	(the *SoA and *AoS functions) currently run at.
+ * @note: The first call detects the level, unless it has been set already.
+ * @return The current level.
+ */
+inline
+SimdLevel
+simdLevel() noexcept;
+
+/**
+ * @brief Make the batch conversion functions run at a given instruction set
+ *	level, typically to test or compare the kernels.
+ * @note: The level is clamped to what detectSimdLevel() reports, so it is
+ *	never possible to select instructions that the CPU cannot run.
+ * @param level The level to run at.
+ * @return The level actually selected.
+ */
+inline
+SimdLevel
+setSimdLevel(SimdLevel const level) noexcept;
+
+/**
+ * @brief Undo setSimdLevel(), going back to the detected level.
+ */
+inline
+void
+resetSimdLevel() noexcept;
+
+/**
+ * @brief Get a printable name for an instruction set level.
+ * @param level The level.
+ * @return A static string, e.g. "AVX2".
+ */
+inline
+char const *
+simdLevelName(SimdLevel const level) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/DispatchImpl.hpp>
+
+#endif // !terra_Dispatch_hpp
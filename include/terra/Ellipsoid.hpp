@@ -20,6 +20,8 @@
 #include <terra/Arch.hpp>
 #include <cmath>
 #include <cassert>
+#include <cstddef>
+#include <type_traits>
 
 namespace terra {
 
@@ -29,11 +31,212 @@ namespace terra {
  */
 template<typename T>
 struct Ellipsoid {
+	using value_type = T;
 	Ellipsoid(T const ma, T const mi) : semiMajor(ma), semiMinor(mi) {}
 	T semiMajor;	/**< The semi-major axis. */
 	T semiMinor;	/**< The semi-major axis. */
 };
 
+/**
+ * @brief Ellipsoid with its derived parameters computed once, up front.
+ * Preferable to Ellipsoid<T> when converting many single coordinates.
+ * @note: The members must be kept consistent; construct a new instance rather
+ *	than changing them.
+ * @tparam T floating-point type to be used (float or double).
+ */
+template<typename T>
+struct PreparedEllipsoid {
+	using value_type = T;
+	PreparedEllipsoid(T const ma, T const mi) noexcept;
+	explicit PreparedEllipsoid(Ellipsoid<T> const ellipsoid) noexcept;
+	T semiMajor;		/**< The semi-major axis, a. */
+	T semiMinor;		/**< The semi-minor axis, b. */
+	T semiMajorSq;		/**< a^2. */
+	T semiMinorSq;		/**< b^2. */
+	T eccentricitySq;	/**< First eccentricity squared, (a^2 - b^2)/a^2. */
+	T secondEccentricitySq;	/**< Second eccentricity squared, (a^2 - b^2)/b^2. */
+	T axisRatioSq;		/**< b^2/a^2. */
+};
+
+/**
+ * @brief Ellipsoid whose parameters are compile-time constants, letting the
+ *	compiler fold them into the conversions. Use through the aliases
+ *	below, e.g. WGS84<double>().
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Axes a struct with the static constexpr double members semiMajor
+ *	and semiMinor, see namespace axes.
+ */
+template<typename T, typename Axes>
+struct StaticEllipsoid {
+	using value_type = T;
+	static constexpr T semiMajor = T(Axes::semiMajor);
+	static constexpr T semiMinor = T(Axes::semiMinor);
+	static constexpr T semiMajorSq = T(Axes::semiMajor*Axes::semiMajor);
+	static constexpr T semiMinorSq = T(Axes::semiMinor*Axes::semiMinor);
+	static constexpr T eccentricitySq = T((Axes::semiMajor*Axes::semiMajor - Axes::semiMinor*Axes::semiMinor)/
+					      (Axes::semiMajor*Axes::semiMajor));
+	static constexpr T secondEccentricitySq = T((Axes::semiMajor*Axes::semiMajor - Axes::semiMinor*Axes::semiMinor)/
+						    (Axes::semiMinor*Axes::semiMinor));
+	static constexpr T axisRatioSq = T((Axes::semiMinor*Axes::semiMinor)/(Axes::semiMajor*Axes::semiMajor));
+
+	/** @brief The same ellipsoid as a run-time Ellipsoid<T>. */
+	operator Ellipsoid<T>() const noexcept { return Ellipsoid<T>(semiMajor, semiMinor); }
+};
+
+/**
+ * @brief Axes of common reference ellipsoids, in meters.
+ */
+namespace axes {
+
+struct WGS84 {
+	static constexpr double semiMajor = 6378137.0;
+	static constexpr double semiMinor = semiMajor*(1.0 - 1.0/298.257223563);
+};
+
+struct GRS80 {
+	static constexpr double semiMajor = 6378137.0;
+	static constexpr double semiMinor = semiMajor*(1.0 - 1.0/298.257222101);
+};
+
+struct WGS72 {
+	static constexpr double semiMajor = 6378135.0;
+	static constexpr double semiMinor = semiMajor*(1.0 - 1.0/298.26);
+};
+
+struct Clarke1866 {
+	static constexpr double semiMajor = 6378206.4;
+	static constexpr double semiMinor = 6356583.8;
+};
+
+struct International1924 {
+	static constexpr double semiMajor = 6378388.0;
+	static constexpr double semiMinor = semiMajor*(1.0 - 1.0/297.0);
+};
+
+struct Bessel1841 {
+	static constexpr double semiMajor = 6377397.155;
+	static constexpr double semiMinor = semiMajor*(1.0 - 1.0/299.1528128);
+};
+
+struct Airy1830 {
+	static constexpr double semiMajor = 6377563.396;
+	static constexpr double semiMinor = 6356256.909;
+};
+
+} // !namespace axes
+
+template<typename T> using WGS84 = StaticEllipsoid<T, axes::WGS84>;
+template<typename T> using GRS80 = StaticEllipsoid<T, axes::GRS80>;
+template<typename T> using WGS72 = StaticEllipsoid<T, axes::WGS72>;
+template<typename T> using Clarke1866 = StaticEllipsoid<T, axes::Clarke1866>;
+template<typename T> using International1924 = StaticEllipsoid<T, axes::International1924>;
+template<typename T> using Bessel1841 = StaticEllipsoid<T, axes::Bessel1841>;
+template<typename T> using Airy1830 = StaticEllipsoid<T, axes::Airy1830>;
+
+/**
+ * @brief True for the ellipsoid types with precomputed parameters,
+ *	PreparedEllipsoid<T> and StaticEllipsoid<T, Axes>, and for those wrapped
+ *	in Approximate<> or Degrees<>.
+ */
+template<typename Model>
+struct IsEllipsoidModel : std::false_type {};
+template<typename T>
+struct IsEllipsoidModel<PreparedEllipsoid<T>> : std::true_type {};
+template<typename T, typename Axes>
+struct IsEllipsoidModel<StaticEllipsoid<T, Axes>> : std::true_type {};
+
+/**
+ * @brief True for every ellipsoid type: Ellipsoid<T> and the ellipsoid models.
+ */
+template<typename Model>
+struct IsEllipsoid : IsEllipsoidModel<Model> {};
+template<typename T>
+struct IsEllipsoid<Ellipsoid<T>> : std::true_type {};
+
+/**
+ * @brief Algorithms for the ECEF to geodetic conversions on an ellipsoid,
+ *	picked by the first template argument, e.g.
+ *	ecefToGeod<Vermeille>(&geod, ecef, WGS84<double>()).
+ * Maximum errors in double on WGS84, over all latitudes and altitudes from
+ * -10 km to 36000 km (latitude error given as distance on the surface):
+ *	Bowring			latitude 5.4 cm (0.09 mm below 100 km), altitude 15 nm
+ *	BowringIterative<2>	latitude 1.5 nm, altitude 19 nm
+ *	BowringIterative<3>	latitude 1.5 nm, altitude 19 nm
+ *	Vermeille		latitude 1.8 nm, altitude 15 nm
+ *	Olson			latitude 2.3 nm, altitude 15 nm
+ *	BowringTolerance	latitude 35 nm, altitude 40 nm, with the default tolerance
+ */
+
+/**
+ * @brief One step of Bowring's method (1976). The default; exact enough for
+ *	anything near the surface, and the cheapest.
+ */
+struct Bowring {};
+
+/**
+ * @brief Bowring's method iterated, each step about tripling the correct digits.
+ * @tparam Iterations Number of steps, at least 1.
+ */
+template<unsigned Iterations>
+struct BowringIterative {};
+
+/**
+ * @brief Bowring's method iterated until the latitude error left is below a
+ *	tolerance, each point stopping on its own. The error after a step is
+ *	under 1/200 of the square of how far that step moved the latitude, so a
+ *	point stops once the square of its last move is below the tolerance,
+ *	rather than once a move itself is that small. A vector of points
+ *	steps until its slowest lane has converged, the others keeping their
+ *	results, so points far from the surface pay for the steps they need and
+ *	the rest for no more than BowringIterative<2>. The altitude is computed
+ *	without dividing by the cosine of the latitude, so it holds at the poles.
+ *	Default constructed, as when picked by the first template argument, it
+ *	converges to 1e-12 radians; the single, SoA and AoS functions also take
+ *	an instance with the caller's tolerance.
+ */
+struct BowringTolerance {
+	BowringTolerance() = default;
+
+	/**
+	 * @param tolerance The latitude error, in radians, left after the final
+	 *	step, the first to move the latitude by no more than its square
+	 *	root.
+	 *	Tolerances below the resolution of the floating-point type are
+	 *	raised to it.
+	 */
+	explicit BowringTolerance(double const tolerance) noexcept : tolerance(tolerance) {}
+
+	double tolerance = 1e-12;
+};
+
+/**
+ * @brief Vermeille's closed form (2002), exact to rounding at any altitude
+ *	but within ~43 km of the centre of the earth.
+ */
+struct Vermeille {};
+
+/**
+ * @brief Olson's method (1996): a series with one Newton correction and no
+ *	trigonometry besides the final atan2.
+ */
+struct Olson {};
+
+/**
+ * @brief True for the ECEF to geodetic algorithms above.
+ */
+template<typename Algorithm>
+struct IsEcefToGeodAlgorithm : std::false_type {};
+template<>
+struct IsEcefToGeodAlgorithm<Bowring> : std::true_type {};
+template<unsigned Iterations>
+struct IsEcefToGeodAlgorithm<BowringIterative<Iterations>> : std::true_type {};
+template<>
+struct IsEcefToGeodAlgorithm<Vermeille> : std::true_type {};
+template<>
+struct IsEcefToGeodAlgorithm<Olson> : std::true_type {};
+template<>
+struct IsEcefToGeodAlgorithm<BowringTolerance> : std::true_type {};
+
 /**
  * @brief Convert a geodetic coordinate to ECEF in place, using a reference ellipsoid.
  * @tparam T floating-point type to be used (float or double).
@@ -50,6 +253,17 @@ geodToECEF(
 	Coord * const coord,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters.
+ * @tparam Model PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEF(
+	Coord * const coord,
+	Model const ellipsoid) noexcept;
+
 /**
  * @brief Convert a geodetic coordinate to an ECEF coordinate using a reference ellipsoid.
  * @note: The two coordinates must not reference overlapping memory areas.
@@ -69,6 +283,18 @@ geodToECEF(
 	Coord const & TERRA_RESTRICT fromGeodetic,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters.
+ * @tparam Model PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Model const ellipsoid) noexcept;
+
 /**
  * @brief Convert an ECEF coordinate to geodetic in place, using a reference ellipsoid.
  * @tparam T floating-point type to be used (float or double).
@@ -85,6 +311,19 @@ ecefToGeod(
 	Coord * const coord,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters, or any
+ *	ellipsoid with a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille, Olson or BowringTolerance.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Algorithm = Bowring, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeod(
+	Coord * const coord,
+	Model const ellipsoid) noexcept;
+
 /**
  * @brief Convert an ECEF coordinate to a geodetic coordinate using a reference ellipsoid.
  * @note: The two coordinates must not reference overlapping memory areas.
@@ -104,9 +343,39 @@ ecefToGeod(
 	Coord const & TERRA_RESTRICT fromECEF,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters, or any
+ *	ellipsoid with a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille, Olson or BowringTolerance.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Algorithm = Bowring, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Model const ellipsoid) noexcept;
+
+/**
+ * @brief As above, with Bowring's method iterated to the given tolerance.
+ * @param algorithm The tolerance, see BowringTolerance.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Model const ellipsoid,
+	BowringTolerance const algorithm) noexcept;
+
 /**
  * @brief Convert a series, in SoA form, of geodetic coordinates to ECEF coordinates using a reference ellipsoid.
  * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
  * @tparam T floating-point type to be used (float or double).
  * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
  * @param toECEF Pointer to where the ECEF coordinates will be written.
@@ -120,12 +389,28 @@ void
 geodToECEFSoA(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters.
+ * @tparam Model PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
 /**
  * @brief Convert a series, in AoS form, of geodetic coordinates to ECEF coordinates using a reference ellipsoid.
  * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
  * @tparam T floating-point type to be used (float or double).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
  * @tparam Coord2 3-tuple type that can be accessed via operator[].
@@ -140,12 +425,28 @@ void
 geodToECEFAoS(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord2 const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters.
+ * @tparam Model PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
 /**
  * @brief Convert a series, in SoA form, of ECEF coordinates to geodetic coordinates using a reference ellipsoid.
  * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
  * @tparam T floating-point type to be used (float or double).
  * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
  * @param toGeodetic Pointer to where the geodetic coordinates will be written.
@@ -159,12 +460,79 @@ void
 ecefToGeodSoA(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord const & TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters, or any
+ *	ellipsoid with a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille, Olson or BowringTolerance.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Algorithm = Bowring, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
+/**
+ * @brief As above, with Bowring's method iterated to the given tolerance;
+ *	the lanes of a vector stop as they converge, the vector when all have.
+ * @param algorithm The tolerance, see BowringTolerance.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid,
+	BowringTolerance const algorithm) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of ECEF coordinates along a track,
+ *	such as INS or telemetry samples in time order, to geodetic coordinates.
+ * @note: Each point is solved from one converted in full a few points
+ *	earlier, with two Newton steps on the latitude and the angle between the
+ *	two for the longitude, instead of the full algorithm. Points within about
+ *	6 km of the last vector converted with Algorithm are stepped from it, to
+ *	within rounding of the same lane converted in full; a vector with a point
+ *	farther away, across a gap in the track or close to a pole, is converted
+ *	with Algorithm and seeds those after it. Any order is correct, if slower
+ *	than ecefToGeodSoA when scattered.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille or Olson, for the
+ *	points converted in full.
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes>
+ *	such as WGS84<T>, possibly wrapped in Approximate<> or Degrees<>.
+ * @param toGeodetic Pointer to where the geodetic coordinates will be written.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param fromECEF The ECEF coordinates to be converted, in track order.
+ * @param numCoords The number of coordinates.
+ * @param ellipsoid An instance of the reference ellipsoid.
+ */
+template<typename Algorithm = Bowring, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodTrajectorySoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
 /**
  * @brief Convert a series, in AoS form, of ECEF coordinates to geodetic coordinates using a reference ellipsoid.
  * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
  * @tparam T floating-point type to be used (float or double).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
  * @tparam Coord2 3-tuple type that can be accessed via operator[].
@@ -178,10 +546,40 @@ inline
 void
 ecefToGeodAoS(
 	Coord * const TERRA_RESTRICT toGeodetic,
-	Coord2 const * TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept;
 
+/**
+ * @brief As above, using an ellipsoid with precomputed parameters, or any
+ *	ellipsoid with a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille, Olson or BowringTolerance.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, or a StaticEllipsoid<T, Axes> such as WGS84<T>.
+ */
+template<typename Algorithm = Bowring, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
+/**
+ * @brief As above, with Bowring's method iterated to the given tolerance;
+ *	the lanes of a vector stop as they converge, the vector when all have.
+ * @param algorithm The tolerance, see BowringTolerance.
+ */
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid,
+	BowringTolerance const algorithm) noexcept;
+
 } // !namespace terra
 
 #include <terra/impl/EllipsoidImpl.hpp>
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Fixed_hpp
+#define terra_Fixed_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief Geodetic coordinates in fixed point, as OSM and most GNSS receivers
+ *	store them: longitude and latitude as std::int32_t in units of 1e-7
+ *	degrees, altitude as std::int32_t millimetres.
+ * The batch functions below read and write the integers directly, converting
+ * them in registers, so a coordinate takes 12 bytes of memory traffic rather
+ * than the 24 of double. Longitude and latitude are split into whole quarter
+ * turns and a remainder exactly, so float computation loses nothing to the
+ * 31 bits of the integers before its own rounding.
+ * Encoded values round to the nearest unit and saturate at the ends of the
+ * int32 range, i.e. altitudes beyond about +-2147 km; in float the upper end
+ * is 2147483520, the largest float below 2^31. NaN encodes as INT32_MIN,
+ * the lower end: never a longitude or latitude, and for an altitude the
+ * same as one more than 2147 km below the surface.
+ */
+namespace fixed {
+
+constexpr double degreesPerUnit = 1e-7;	/**< Longitude and latitude resolution. */
+constexpr double metersPerUnit = 1e-3;	/**< Altitude resolution. */
+
+} // !namespace fixed
+
+/**
+ * @brief Convert a series, in SoA form, of fixed-point geodetic coordinates to
+ *	ECEF coordinates.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp).
+ * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+ * @tparam FixedCoord a struct type with the arrays x, y, z of std::int32_t.
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> one (see Approximate.hpp); not Degrees<>, the unit
+ *	being fixed.
+ * @param toECEF Pointer to where the ECEF coordinates will be written.
+ * @param fromGeodetic The geodetic coordinates to be converted, see namespace
+ *	fixed. Accessed as: x=longitude, y=latitude, z=altitude.
+ * @param numCoords The number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename Coord, typename FixedCoord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodFixedToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	FixedCoord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of ECEF coordinates to fixed-point
+ *	geodetic coordinates using a reference sphere.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp).
+ * @tparam FixedCoord a struct type with the arrays x, y, z of std::int32_t.
+ * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
+ * @param toGeodetic Pointer to where the geodetic coordinates will be written,
+ *	see namespace fixed. Accessed as: x=longitude, y=latitude, z=altitude.
+ * @param fromECEF The ECEF coordinates to be converted.
+ * @param numCoords The number of coordinates.
+ * @param sphere An instance of the reference sphere.
+ */
+template<typename FixedCoord, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodFixedSoA(
+	FixedCoord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, using a reference ellipsoid and a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille or Olson.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, a StaticEllipsoid<T, Axes>
+ *	such as WGS84<T>, or an Approximate<> one (see Approximate.hpp).
+ */
+template<typename Algorithm = Bowring, typename FixedCoord, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodFixedSoA(
+	FixedCoord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/FixedImpl.hpp>
+
+#endif // !terra_Fixed_hpp
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Geodesic_hpp
+#define terra_Geodesic_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief Solve the inverse geodesic problem for a series, in SoA form, of pairs
+ *	of points on a reference body: the length of the shortest path between
+ *	them along the surface, and its azimuth at either end.
+ * @note: On a sphere the great circle, the distance by the haversine. On an
+ *	ellipsoid Vincenty's method (1975), iterated per lane until the longitude
+ *	on the auxiliary sphere converges; accurate to 0.5 mm in double and a few
+ *	metres in float. It fails to converge for some nearly antipodal pairs,
+ *	whose results are NaN.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). Lanes leave the iteration as they converge, so a
+ *	vector takes as many steps as its slowest lane, usually three to five.
+ * @tparam Geodesic a struct type with the arrays x, y, z for the results.
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> or Degrees<> one, in which the azimuths are degrees too.
+ * @param toGeodesic Pointer to where the results will be written, accessed as:
+ *	x=distance in metres, y=azimuth at from towards to, z=azimuth at to
+ *	back towards from. Azimuths are clockwise from north, within a half
+ *	turn either way.
+ * @param from The geodetic coordinates of the first points, the altitudes unused.
+ *	Accessed as: x=longitude, y=latitude.
+ * @param to The geodetic coordinates of the second points, as from.
+ * @param numCoords The number of pairs.
+ * @param model An instance of the reference body.
+ */
+template<typename Geodesic, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicInverseSoA(
+	Geodesic * const TERRA_RESTRICT toGeodesic,
+	Coord const & TERRA_RESTRICT from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief As above, from one point to each of a series: the start point is the
+ *	same for all, its sines and cosines computed once.
+ * @tparam Point 3-tuple type that can be accessed via operator[].
+ * @param from The geodetic coordinate of the start point, the altitude unused.
+ *	Indexed as: 0=longitude, 1=latitude.
+ */
+template<typename Geodesic, typename Point, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicInverseOneToManySoA(
+	Geodesic * const TERRA_RESTRICT toGeodesic,
+	Point const &from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief The distances of geodesicInverseSoA only, for proximity checks.
+ *	The azimuths are never computed.
+ * @tparam S float or double, as the arrays of Coord.
+ * @param toDistance Pointer to an array where the distances, in metres, will be written.
+ */
+template<typename S, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicDistanceSoA(
+	S * const TERRA_RESTRICT toDistance,
+	Coord const & TERRA_RESTRICT from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief The distances of geodesicInverseOneToManySoA only.
+ */
+template<typename S, typename Point, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicDistanceOneToManySoA(
+	S * const TERRA_RESTRICT toDistance,
+	Point const &from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Solve the direct geodesic problem for a series, in SoA form, of points
+ *	on a reference body: where the geodesic leaving each point at an azimuth
+ *	ends after a distance.
+ * @note: On a sphere a closed form. On an ellipsoid Vincenty's method (1975),
+ *	iterated per lane until the arc on the auxiliary sphere converges, in a
+ *	few steps short of the antipode.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp).
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Geodesic a struct type with the arrays x, y for the geodesics.
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> or Degrees<> one, in which the azimuths are degrees too.
+ * @param toGeodetic Pointer to where the end points will be written.
+ *	Accessed as: x=longitude, y=latitude, z=altitude, copied from fromGeodetic.
+ * @param fromGeodetic The geodetic coordinates of the start points.
+ *	Accessed as: x=longitude, y=latitude, z=altitude.
+ * @param geodesic The paths to follow, accessed as: x=distance in metres,
+ *	y=azimuth, clockwise from north; as written by geodesicInverseSoA.
+ * @param numCoords The number of points.
+ * @param model An instance of the reference body.
+ */
+template<typename Coord, typename Geodesic, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicDirectSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Geodesic const & TERRA_RESTRICT geodesic,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/GeodesicImpl.hpp>
+
+#endif // !terra_Geodesic_hpp
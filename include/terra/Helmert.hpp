@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Helmert_hpp
+#define terra_Helmert_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief Sign convention of the rotations of a Helmert transformation: as
+ *	rotations of the position vector (EPSG 1033, IERS), or of the
+ *	coordinate frame (EPSG 1032), which have the opposite sign.
+ */
+enum class HelmertConvention {
+	PositionVector,
+	CoordinateFrame
+};
+
+/**
+ * @brief A 7-parameter Helmert transformation between the ECEF coordinates
+ *	of two datums, in the usual small-angle form
+ *	x' = t + (1 + s)R x. The scaled rotation is computed once, on
+ *	construction, and kept less the identity, x' = x + t + L x, so that its
+ *	small entries keep their precision.
+ * @note: The members must be kept consistent; construct a new instance, or
+ *	use inverse(), rather than changing them.
+ * @tparam T floating-point type to be used (float or double).
+ */
+template<typename T>
+struct Helmert {
+	using value_type = T;
+
+	/**
+	 * @brief Set up the transformation from its published parameters.
+	 * @param tx Translation along x, metres; ty and tz likewise.
+	 * @param rx Rotation about x, arc-seconds; ry and rz likewise.
+	 * @param scale Scale difference, parts per million.
+	 * @param convention The sign convention the rotations are given in.
+	 */
+	Helmert(
+		T const tx,
+		T const ty,
+		T const tz,
+		T const rx,
+		T const ry,
+		T const rz,
+		T const scale,
+		HelmertConvention const convention = HelmertConvention::PositionVector) noexcept;
+
+	T translation[3];	/**< t, in metres. */
+	T linear[3][3];		/**< L, the scaled rotation less the identity. */
+};
+
+/**
+ * @brief The transformation undoing another, exactly rather than by negating
+ *	the parameters, so that a round trip returns the original coordinates.
+ */
+template<typename T>
+inline
+Helmert<T>
+inverse(Helmert<T> const &helmert) noexcept;
+
+/**
+ * @brief Transform an ECEF coordinate between datums in place.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @param coord Pointer to ECEF coordinate in the source datum that will be
+ *	overwritten by the one in the target datum. Indexed as: 0=x, 1=y, 2=z.
+ * @param helmert The transformation.
+ */
+template<typename T, typename Coord>
+inline
+void
+helmert(
+	Coord * const coord,
+	Helmert<T> const &helmert) noexcept;
+
+/**
+ * @brief Transform an ECEF coordinate between datums.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename T, typename Coord>
+inline
+void
+helmert(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Helmert<T> const &helmert) noexcept;
+
+/**
+ * @brief Transform a series, in SoA form, of ECEF coordinates between datums.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @param toECEF Pointer to where the ECEF coordinates in the target datum
+ *	will be written.
+ * @param fromECEF The ECEF coordinates in the source datum.
+ * @param numCoords Number of coordinates.
+ * @param helmert The transformation.
+ */
+template<typename T, typename Coord>
+inline
+void
+helmertSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Helmert<T> const &helmert) noexcept;
+
+/**
+ * @brief Transform a geodetic coordinate between datums in place: to ECEF on
+ *	the source body, through the Helmert transformation, and back to
+ *	geodetic on the target body.
+ * @tparam Algorithm for ellipsoid targets, see Bowring; ignored for spheres.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam From Sphere<T>, Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>,
+ *	possibly wrapped in Approximate<> or Degrees<>; To likewise.
+ * @param coord Pointer to geodetic coordinate in the source datum that will
+ *	be overwritten by the one in the target datum.
+ *	Indexed as: 0=longitude, 1=latitude, 2=altitude.
+ * @param helmert The transformation from the source to the target datum.
+ * @param from The reference body of the source datum.
+ * @param to The reference body of the target datum.
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename From, typename To>
+inline
+typename std::enable_if<(IsSphere<From>::value || IsEllipsoid<From>::value) &&
+			(IsSphere<To>::value || IsEllipsoid<To>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+datumTransform(
+	Coord * const coord,
+	Helmert<T> const &helmert,
+	From const from,
+	To const to) noexcept;
+
+/**
+ * @brief Transform a geodetic coordinate between datums.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename From, typename To>
+inline
+typename std::enable_if<(IsSphere<From>::value || IsEllipsoid<From>::value) &&
+			(IsSphere<To>::value || IsEllipsoid<To>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+datumTransform(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Helmert<T> const &helmert,
+	From const from,
+	To const to) noexcept;
+
+/**
+ * @brief Transform a series, in SoA form, of geodetic coordinates between
+ *	datums in one pass, the ECEF coordinates never leaving registers.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @note: In float the ECEF coordinates are rounded to about 0.5 m, more
+ *	than most datum shifts are known to; use a double transformation
+ *	and bodies, with float storage if need be.
+ * @tparam Algorithm for ellipsoid targets, see Bowring; ignored for spheres.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam From Sphere<T>, Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>,
+ *	possibly wrapped in Approximate<> or Degrees<>; To likewise.
+ * @param toGeodetic Pointer to where the geodetic coordinates in the target
+ *	datum will be written. Accessed as: x=longitude, y=latitude, z=altitude.
+ * @param fromGeodetic The geodetic coordinates in the source datum.
+ * @param numCoords Number of coordinates.
+ * @param helmert The transformation from the source to the target datum.
+ * @param from The reference body of the source datum.
+ * @param to The reference body of the target datum.
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename From, typename To>
+inline
+typename std::enable_if<(IsSphere<From>::value || IsEllipsoid<From>::value) &&
+			(IsSphere<To>::value || IsEllipsoid<To>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+datumTransformSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Helmert<T> const &helmert,
+	From const from,
+	To const to) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/HelmertImpl.hpp>
+
+#endif // !terra_Helmert_hpp
@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_LocalFrame_hpp
+#define terra_LocalFrame_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief A local tangent plane at a geodetic origin, for converting between
+ *	ECEF and East-North-Up or North-East-Down coordinates. The origin in
+ *	ECEF and the rotation into the plane are computed once, on construction.
+ * @note: The members must be kept consistent; construct a new instance rather
+ *	than changing them.
+ * @tparam T floating-point type to be used (float or double).
+ */
+template<typename T>
+struct LocalFrame {
+	using value_type = T;
+
+	/**
+	 * @brief Set up the frame at a geodetic origin.
+	 * @param lon Longitude of the origin, in radians, or degrees for a
+	 *	Degrees<> model.
+	 * @param lat Latitude of the origin, in the same unit.
+	 * @param alt Altitude of the origin.
+	 * @param model The reference body the origin is given on: a Sphere<T>,
+	 *	an Ellipsoid<T> or one of the ellipsoid models, possibly wrapped
+	 *	in Approximate<> or Degrees<>.
+	 */
+	template<typename Model>
+	LocalFrame(T const lon, T const lat, T const alt, Model const model) noexcept;
+
+	T origin[3];		/**< The origin, in ECEF. */
+	T rotation[3][3];	/**< Rows are the east, north and up unit vectors, in ECEF. */
+};
+
+/**
+ * @brief Convert an ECEF coordinate to East-North-Up in place.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @param coord Pointer to ECEF coordinate that will be overwritten by ENU
+ *	coordinate.
+ *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
+ *	ENU coordinate is indexed as: 0=east, 1=north, 2=up.
+ * @param frame The local frame.
+ */
+template<typename T, typename Coord>
+inline
+void
+ecefToENU(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert an ECEF coordinate to an East-North-Up coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @param toENU Pointer to where the ENU coordinate will be written.
+ *	ENU coordinate is indexed as: 0=east, 1=north, 2=up.
+ * @param fromECEF The ECEF coordinate to be converted.
+ *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
+ * @param frame The local frame.
+ */
+template<typename T, typename Coord>
+inline
+void
+ecefToENU(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromECEF,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert an East-North-Up coordinate to ECEF in place.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @param coord Pointer to ENU coordinate that will be overwritten by ECEF
+ *	coordinate.
+ *	ENU coordinate is indexed as: 0=east, 1=north, 2=up.
+ *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
+ * @param frame The local frame.
+ */
+template<typename T, typename Coord>
+inline
+void
+enuToECEF(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert an East-North-Up coordinate to an ECEF coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @param toECEF Pointer to where the ECEF coordinate will be written.
+ *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
+ * @param fromENU The ENU coordinate to be converted.
+ *	ENU coordinate is indexed as: 0=east, 1=north, 2=up.
+ * @param frame The local frame.
+ */
+template<typename T, typename Coord>
+inline
+void
+enuToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromENU,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert an ECEF coordinate to North-East-Down in place.
+ *	NED coordinate is indexed as: 0=north, 1=east, 2=down.
+ *	Otherwise as ecefToENU().
+ */
+template<typename T, typename Coord>
+inline
+void
+ecefToNED(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert an ECEF coordinate to a North-East-Down coordinate.
+ *	NED coordinate is indexed as: 0=north, 1=east, 2=down.
+ *	Otherwise as ecefToENU().
+ */
+template<typename T, typename Coord>
+inline
+void
+ecefToNED(
+	Coord * const TERRA_RESTRICT toNED,
+	Coord const & TERRA_RESTRICT fromECEF,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a North-East-Down coordinate to ECEF in place.
+ *	NED coordinate is indexed as: 0=north, 1=east, 2=down.
+ *	Otherwise as enuToECEF().
+ */
+template<typename T, typename Coord>
+inline
+void
+nedToECEF(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a North-East-Down coordinate to an ECEF coordinate.
+ *	NED coordinate is indexed as: 0=north, 1=east, 2=down.
+ *	Otherwise as enuToECEF().
+ */
+template<typename T, typename Coord>
+inline
+void
+nedToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromNED,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of ECEF coordinates to East-North-Up coordinates.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @param toENU Pointer to where the ENU coordinates will be written.
+ *	ENU coordinates are accessed as: x=east, y=north, z=up.
+ * @param fromECEF The ECEF coordinates to be converted.
+ * @param frame The local frame.
+ */
+template<typename T, typename Coord>
+inline
+void
+ecefToENUSoA(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of East-North-Up coordinates to ECEF coordinates.
+ *	Otherwise as ecefToENUSoA().
+ */
+template<typename T, typename Coord>
+inline
+void
+enuToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of ECEF coordinates to North-East-Down coordinates.
+ *	NED coordinates are accessed as: x=north, y=east, z=down.
+ *	Otherwise as ecefToENUSoA().
+ */
+template<typename T, typename Coord>
+inline
+void
+ecefToNEDSoA(
+	Coord * const TERRA_RESTRICT toNED,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of North-East-Down coordinates to ECEF coordinates.
+ *	Otherwise as ecefToNEDSoA().
+ */
+template<typename T, typename Coord>
+inline
+void
+nedToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromNED,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of ECEF coordinates to East-North-Up coordinates.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @param toENU Pointer to an array where the ENU coordinates will be written.
+ *	ENU coordinates are indexed as: 0=east, 1=north, 2=up.
+ * @param fromECEF Pointer to an array of ECEF coordinates to be converted.
+ * @param frame The local frame.
+ */
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+ecefToENUAoS(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of East-North-Up coordinates to ECEF coordinates.
+ *	Otherwise as ecefToENUAoS().
+ */
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+enuToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of ECEF coordinates to North-East-Down coordinates.
+ *	NED coordinates are indexed as: 0=north, 1=east, 2=down.
+ *	Otherwise as ecefToENUAoS().
+ */
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+ecefToNEDAoS(
+	Coord * const TERRA_RESTRICT toNED,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of North-East-Down coordinates to ECEF coordinates.
+ *	Otherwise as ecefToNEDAoS().
+ */
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+nedToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromNED,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept;
+
+/**
+ * @brief Convert a geodetic coordinate straight to East-North-Up in place,
+ *	without going through an ECEF buffer.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>.
+ * @param coord Pointer to geodetic coordinate that will be overwritten by ENU
+ *	coordinate.
+ *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
+ *	ENU coordinate is indexed as: 0=east, 1=north, 2=up.
+ * @param frame The local frame.
+ * @param model The reference body of the geodetic coordinate.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENU(
+	Coord * const coord,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a geodetic coordinate straight to an East-North-Up coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENU(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert an East-North-Up coordinate straight to geodetic in place,
+ *	without going through an ECEF buffer.
+ * @tparam Algorithm for ellipsoids, see Bowring; ignored for spheres.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>.
+ * @param coord Pointer to ENU coordinate that will be overwritten by geodetic
+ *	coordinate.
+ *	ENU coordinate is indexed as: 0=east, 1=north, 2=up.
+ *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
+ * @param frame The local frame.
+ * @param model The reference body of the geodetic coordinate.
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeod(
+	Coord * const coord,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert an East-North-Up coordinate straight to a geodetic coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromENU,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of geodetic coordinates to East-North-Up
+ *	coordinates in one pass, the ECEF coordinates never leaving registers.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Sphere<T>, Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>.
+ * @param toENU Pointer to where the ENU coordinates will be written.
+ *	ENU coordinates are accessed as: x=east, y=north, z=up.
+ * @param fromGeodetic The geodetic coordinates to be converted.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param frame The local frame.
+ * @param model The reference body of the geodetic coordinates.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENUSoA(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of East-North-Up coordinates to geodetic
+ *	coordinates in one pass.
+ * @tparam Algorithm for ellipsoids, see Bowring; ignored for spheres.
+ *	Otherwise as geodToENUSoA().
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of geodetic coordinates to East-North-Up
+ *	coordinates in one pass.
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
+ *	Otherwise as geodToENUSoA(), with coordinates indexed via operator[].
+ */
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENUAoS(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of East-North-Up coordinates to geodetic
+ *	coordinates in one pass.
+ * @tparam Algorithm for ellipsoids, see Bowring; ignored for spheres.
+ *	Otherwise as geodToENUAoS().
+ */
+template<typename Algorithm = Bowring, typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/LocalFrameImpl.hpp>
+
+#endif // !terra_LocalFrame_hpp
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Parallel_hpp
+#define terra_Parallel_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <terra/Transpose.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace terra {
+
+/**
+ * @brief Number of coordinates each task of the parallel batch functions
+ *	converts. Small enough for a task's input and output to stay in L2,
+ *	large enough that scheduling costs next to nothing.
+ */
+constexpr std::size_t parallelChunkSize = 8192;
+
+/**
+ * @brief Reusable pool of threads running parallel loops, balanced by work
+ *	stealing.
+ * The tasks of a loop are split evenly over the threads up front; a thread
+ * that runs out steals half of what remains of another thread's share. The
+ * thread calling run() takes part, so a pool of N threads starts N - 1.
+ * A ThreadPool is an executor for the parallel batch functions below. Any
+ * other type with a matching run() member, e.g. wrapping an existing thread
+ * pool, can be used instead.
+ */
+class ThreadPool {
+public:
+	/**
+	 * @brief Start the threads.
+	 * @param numThreads Number of threads, including the calling one;
+	 *	0 for std::thread::hardware_concurrency().
+	 */
+	explicit ThreadPool(unsigned const numThreads = 0);
+	~ThreadPool();
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	/**
+	 * @brief Run task(i) for every i in [0, numTasks), returning once all
+	 *	have run.
+	 * @note: Loops from different threads take turns. A loop started from
+	 *	within a task runs serially on that task's thread.
+	 * @tparam Task callable as task(std::size_t), which must not throw.
+	 * @param numTasks Number of tasks.
+	 * @param task The task.
+	 */
+	template<typename Task>
+	void run(std::size_t const numTasks, Task const &task) noexcept;
+
+	/** @brief Number of threads, including the one calling run(). */
+	unsigned size() const noexcept;
+
+	/** @brief A pool with one thread per hardware thread, started on first use. */
+	static ThreadPool &shared();
+
+private:
+	struct Range;
+
+	void work(unsigned const self) noexcept;
+	bool steal(unsigned const self) noexcept;
+	void loop(unsigned const self) noexcept;
+	static bool &insideTask() noexcept;
+
+	std::vector<std::unique_ptr<Range>> ranges_;
+	std::vector<std::thread> threads_;
+	std::mutex runMutex_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+	void (*invoke_)(void const *, std::size_t);
+	void const *task_;
+	unsigned long generation_;
+	unsigned pending_;
+	bool stop_;
+};
+
+/**
+ * @brief Executor running every task on the calling thread.
+ */
+struct SerialExecutor {
+	template<typename Task>
+	void run(std::size_t const numTasks, Task const &task) noexcept;
+};
+
+/**
+ * @brief Convert a series, in SoA form, of geodetic coordinates to ECEF
+ *	coordinates in parallel, parallelChunkSize coordinates per task.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, StaticEllipsoid<T, Axes>
+ *	or Sphere<T>.
+ * @param executor The executor running the tasks.
+ * @param toECEF Pointer to where the ECEF coordinates will be written.
+ * @param fromGeodetic The geodetic coordinates to be converted.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param numCoords Number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename Executor, typename Coord, typename Model>
+inline
+void
+geodToECEFSoA(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of geodetic coordinates to ECEF
+ *	coordinates in parallel, parallelChunkSize coordinates per task.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, StaticEllipsoid<T, Axes>
+ *	or Sphere<T>.
+ * @param executor The executor running the tasks.
+ * @param toECEF Pointer to an array where the ECEF coordinates will be written.
+ * @param fromGeodetic Pointer to an array of geodetic coordinates to be converted.
+ *	Geodetic coordinates are indexed as: 0=longitude, 1=latitude, 2=altitude.
+ * @param numCoords Number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename Executor, typename Coord, typename Coord2, typename Model>
+inline
+void
+geodToECEFAoS(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of ECEF coordinates to geodetic
+ *	coordinates in parallel, parallelChunkSize coordinates per task.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @tparam Algorithm for ellipsoids, see Bowring; ignored for spheres.
+ * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, StaticEllipsoid<T, Axes>
+ *	or Sphere<T>.
+ * @param executor The executor running the tasks.
+ * @param toGeodetic Pointer to where the geodetic coordinates will be written.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param fromECEF The ECEF coordinates to be converted.
+ * @param numCoords Number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename Algorithm = Bowring, typename Executor, typename Coord, typename Model>
+inline
+void
+ecefToGeodSoA(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in AoS form, of ECEF coordinates to geodetic
+ *	coordinates in parallel, parallelChunkSize coordinates per task.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @tparam Algorithm for ellipsoids, see Bowring; ignored for spheres.
+ * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, StaticEllipsoid<T, Axes>
+ *	or Sphere<T>.
+ * @param executor The executor running the tasks.
+ * @param toGeodetic Pointer to an array where the geodetic coordinates will be written.
+ *	Geodetic coordinates are indexed as: 0=longitude, 1=latitude, 2=altitude.
+ * @param fromECEF Pointer to an array of ECEF coordinates to be converted.
+ * @param numCoords Number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename Algorithm = Bowring, typename Executor, typename Coord, typename Coord2, typename Model>
+inline
+void
+ecefToGeodAoS(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/ParallelImpl.hpp>
+
+#endif // !terra_Parallel_hpp
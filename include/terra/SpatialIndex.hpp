@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_SpatialIndex_hpp
+#define terra_SpatialIndex_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Parallel.hpp>
+#include <terra/Sphere.hpp>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace terra {
+
+/**
+ * @brief Largest number of points in a leaf of a SpatialIndex. A leaf is
+ *	scanned vectorized rather than split further.
+ */
+constexpr std::size_t spatialIndexLeafSize = 32;
+
+/**
+ * @brief Implicit k-d tree over ECEF coordinates, answering radius and
+ *	k-nearest queries by straight-line (chord) distance.
+ * The points are stored in SoA form in tree order, each leaf a contiguous run
+ * of at most spatialIndexLeafSize of them. The tree has no child pointers: a
+ * node at depth d and position p covers the points [p*n/2^d, (p + 1)*n/2^d),
+ * split at the median of its widest axis, and only its bounding box is kept.
+ * Queries return the positions of the points in the input.
+ * @note: Chord and surface distance differ by under 1 mm up to 4 km on the
+ *	Earth; chordLength() converts the one to the other for longer radii.
+ * @note: A float index stores ECEF coordinates to about 0.5 m.
+ * @tparam T floating-point type of the coordinates (float or double).
+ */
+template<typename T>
+class SpatialIndex {
+public:
+	using value_type = T;
+
+	/**
+	 * @brief Build the index over a series, in SoA form, of geodetic
+	 *	coordinates, converting them to ECEF and sorting them into
+	 *	the tree in parallel. Replaces what was indexed before.
+	 * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+	 * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+	 * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+	 *	Approximate<> or Degrees<> one (see Approximate.hpp and Degrees.hpp).
+	 * @param executor The executor running the tasks.
+	 * @param fromGeodetic The geodetic coordinates to be indexed. Accessed as:
+	 *	x=longitude, y=latitude, z=altitude.
+	 * @param numCoords Number of coordinates.
+	 * @param model An instance of the reference body.
+	 */
+	template<typename Executor, typename Coord, typename Model>
+	typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+	build(
+		Executor &executor,
+		Coord const &fromGeodetic,
+		std::size_t const numCoords,
+		Model const model);
+
+	/**
+	 * @brief As above, for a series of ECEF coordinates.
+	 */
+	template<typename Executor, typename Coord>
+	void
+	buildECEF(
+		Executor &executor,
+		Coord const &fromECEF,
+		std::size_t const numCoords);
+
+	/** @brief Number of points indexed. */
+	std::size_t size() const noexcept;
+
+	/**
+	 * @brief Append the positions of the points within a chord distance
+	 *	of an ECEF coordinate, in no particular order.
+	 * @param ecef The ECEF coordinate queried around, metres.
+	 * @param chord Largest chord distance, metres.
+	 * @param indices Vector the positions are appended to.
+	 * @return The number of positions appended.
+	 */
+	std::size_t
+	radius(
+		T const (&ecef)[3],
+		T const chord,
+		std::vector<std::size_t> * const indices) const;
+
+	/**
+	 * @brief Find the k points nearest an ECEF coordinate.
+	 * @param ecef The ECEF coordinate queried around, metres.
+	 * @param k Number of points to find.
+	 * @param indices Pointer to k positions, written nearest first. Slots past
+	 *	the number of points indexed are set to std::size_t(-1).
+	 * @param chords Pointer to k chord distances, metres, matching indices,
+	 *	infinity past the number of points indexed; may be nullptr.
+	 * @return The number of points found, the lesser of k and size().
+	 */
+	std::size_t
+	nearest(
+		T const (&ecef)[3],
+		std::size_t const k,
+		std::size_t * const indices,
+		T * const chords) const;
+
+	/**
+	 * @brief Run radius() for a series, in SoA form, of ECEF coordinates in
+	 *	parallel. The queries are visited in tree order, so neighbouring
+	 *	ones share the nodes and leaves they walk while these are cached.
+	 * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+	 * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+	 * @param executor The executor running the tasks.
+	 * @param ecef The ECEF coordinates queried around, metres.
+	 * @param numQueries Number of coordinates.
+	 * @param chord Largest chord distance, metres.
+	 * @param offsets Resized to numQueries + 1; the positions found for query i
+	 *	are (*indices)[(*offsets)[i]] up to (*indices)[(*offsets)[i + 1]].
+	 * @param indices Resized to hold the positions found.
+	 */
+	template<typename Executor, typename Coord>
+	void
+	radiusSoA(
+		Executor &executor,
+		Coord const &ecef,
+		std::size_t const numQueries,
+		T const chord,
+		std::vector<std::size_t> * const offsets,
+		std::vector<std::size_t> * const indices) const;
+
+	/**
+	 * @brief Run nearest() for a series, in SoA form, of ECEF coordinates in
+	 *	parallel, visiting the queries in tree order as radiusSoA() does.
+	 * @tparam Executor ThreadPool, SerialExecutor or a type with the same run().
+	 * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+	 * @param executor The executor running the tasks.
+	 * @param ecef The ECEF coordinates queried around, metres.
+	 * @param numQueries Number of coordinates.
+	 * @param k Number of points to find per query.
+	 * @param indices Pointer to numQueries*k positions, k per query, as nearest().
+	 * @param chords Pointer to numQueries*k chord distances; may be nullptr.
+	 */
+	template<typename Executor, typename Coord>
+	void
+	nearestSoA(
+		Executor &executor,
+		Coord const &ecef,
+		std::size_t const numQueries,
+		std::size_t const k,
+		std::size_t * const indices,
+		T * const chords) const;
+
+private:
+	using Candidate = std::pair<T, std::size_t>;
+
+	template<typename Executor>
+	void buildTree(Executor &executor);
+	void boxDistances(T const (&q)[3], std::size_t const node, T * const nearest, T * const farthest) const noexcept;
+	void range(std::size_t const node, std::size_t const depth, std::size_t * const first,
+		   std::size_t * const last) const noexcept;
+	std::size_t leafOf(T const (&q)[3]) const noexcept;
+	template<typename Executor, typename Coord>
+	std::vector<std::size_t> treeOrder(Executor &executor, Coord const &ecef, std::size_t const numQueries) const;
+	std::size_t radius(T const (&q)[3], T const chord, std::vector<std::size_t> * const indices,
+			   T * const scratch) const;
+	std::size_t nearest(T const (&q)[3], std::size_t const k, std::size_t * const indices, T * const chords,
+			    std::vector<Candidate> * const heap, T * const scratch) const;
+
+	std::vector<T> x_, y_, z_;		/* Points in tree order. */
+	std::vector<std::size_t> index_;	/* Input position of each point. */
+	std::vector<T> bounds_;			/* Min x, y, z and max x, y, z per node. */
+	std::size_t depth_ = 0;			/* Depth of the leaves. */
+};
+
+/**
+ * @brief The chord distance spanned by a surface distance, for radius queries.
+ *	Exact on a sphere. On an ellipsoid the distance itself, as a chord is
+ *	never longer than the geodesic: the query then finds a superset, to
+ *	be filtered with geodesicDistanceOneToManySoA() (see Geodesic.hpp) if
+ *	the exact geodesic matters.
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> or Degrees<> one.
+ * @param distance Surface distance, metres.
+ * @param model An instance of the reference body.
+ */
+template<typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value, typename Model::value_type>::type
+chordLength(
+	typename Model::value_type const distance,
+	Model const &model) noexcept;
+
+template<typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value, typename Model::value_type>::type
+chordLength(
+	typename Model::value_type const distance,
+	Model const &model) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/SpatialIndexImpl.hpp>
+
+#endif // !terra_SpatialIndex_hpp
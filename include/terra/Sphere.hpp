@@ -20,6 +20,8 @@
 #include <terra/Arch.hpp>
 #include <cmath>
 #include <cassert>
+#include <cstddef>
+#include <type_traits>
 
 namespace terra {
 
@@ -29,20 +31,44 @@ namespace terra {
  */
 template<typename T>
 struct Sphere {
+	using value_type = T;
+
 	explicit Sphere(T const r) : radius(r) {}
 	T radius;	/**< The radius of the sphere. */
 };
 
+/**
+ * @brief True for the types accepted as a reference sphere: Sphere<T>, and
+ *	Approximate<Sphere<float>> once Approximate.hpp is included, either in
+ *	Degrees<> once Degrees.hpp is.
+ */
+template<typename Model>
+struct IsSphere : std::false_type {};
+template<typename T>
+struct IsSphere<Sphere<T>> : std::true_type {};
+
 /**
  * @brief Convert a geodetic coordinate to ECEF in place, using a reference sphere.
- * @tparam T floating-point type to be used (float or double).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param coord Pointer to geodetic coordinate that will be overwritten by ECEF
  *	coordinate.
  *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
  *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEF(
+	Coord * const coord,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, for Sphere<T> with T first, so that calls naming it, as in
+ *	geodToECEF<double>(&coord, sphere), compile as they always have.
+ * @tparam T floating-point type to be used (float or double).
+ */
 template<typename T, typename Coord>
 inline
 void
@@ -53,14 +79,25 @@ geodToECEF(
 /**
  * @brief Convert a geodetic coordinate to an ECEF coordinate using a reference sphere.
  * @note: The two coordinates must not reference overlapping memory areas.
- * @tparam T floating-point type to be used (float or double).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param toECEF Pointer to where the ECEF coordinate will be written.
  *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
  * @param fromGeodetic The geodetic coordinate to be converted.
  *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord>
 inline
 void
@@ -71,14 +108,24 @@ geodToECEF(
 
 /**
  * @brief Convert an ECEF coordinate to geodetic in place, using a reference sphere.
- * @tparam T floating-point type to be used (float or double).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param coord Pointer to ECEF coordinate that will be overwritten by geodetic
  *	coordinate.
  *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
  *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeod(
+	Coord * const coord,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord>
 inline
 void
@@ -89,14 +136,25 @@ ecefToGeod(
 /**
  * @brief Convert an ECEF coordinate to a geodetic coordinate using a reference sphere.
  * @note: The two coordinates must not reference overlapping memory areas.
- * @tparam T floating-point type to be used (float or double).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param toGeodetic Pointer to where the geodetic coordinate will be written.
  *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
  * @param fromECEF The ECEF coordinate to be converted.
  *	ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord>
 inline
 void
@@ -109,79 +167,139 @@ ecefToGeod(
 /**
  * @brief Convert a series, in SoA form, of geodetic coordinates to ECEF coordinates using a reference sphere.
  * @note: The two coordinates must not reference overlapping memory areas.
- * @tparam T floating-point type to be used (float or double).
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
  * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param toECEF Pointer to where the ECEF coordinates will be written.
  * @param fromGeodetic The geodetic coordinates to be converted.
  *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord>
 inline
 void
 geodToECEFSoA(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept;
 
 /**
  * @brief Convert a series, in AoS form, of geodetic coordinates to ECEF coordinates using a reference sphere.
  * @note: The two coordinates must not reference overlapping memory areas.
- * @tparam T floating-point type to be used (float or double).
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
  * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param toECEF Pointer to an array where the ECEF coordinates will be written.
  * @param fromGeodetic Pointer to an array of geodetic coordinates to be converted.
  *	Geodetic coordinates are indexed as: 0=longitude, 1=latitude, 2=altitude.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord, typename Coord2>
 inline
 void
 geodToECEFAoS(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord2 const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept;
 
 /**
  * @brief Convert a series, in SoA form, of ECEF coordinates to geodetic coordinates using a reference sphere.
  * @note: The two coordinates must not reference overlapping memory areas.
- * @tparam T floating-point type to be used (float or double).
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
  * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param toGeodetic Pointer to where the geodetic coordinates will be written.
  *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
  * @param fromECEF The ECEF coordinates to be converted.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord>
 inline
 void
 ecefToGeodSoA(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord const & TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept;
 
 /**
  * @brief Convert a series, in AoS form, of ECEF coordinates to geodetic coordinates using a reference sphere.
  * @note: The two coordinates must not reference overlapping memory areas.
- * @tparam T floating-point type to be used (float or double).
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
  * @tparam Coord 3-tuple type that can be accessed via operator[].
  * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
  * @param toGeodetic Pointer to an array where the geodetic coordinates will be written.
  *	Geodetic coordinates are indexed as: 0=longitude, 1=latitude, 2=altitude.
  * @param fromECEF Pointer to an array of ECEF coordinates to be converted.
  * @param sphere An instance of the reference sphere.
  */
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, with T first.
+ */
 template<typename T, typename Coord, typename Coord2>
 inline
 void
 ecefToGeodAoS(
 	Coord * const TERRA_RESTRICT toGeodetic,
-	Coord2 const * TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept;
 
 } // !namespace terra
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Strided_hpp
+#define terra_Strided_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief A series of coordinates stored inside records of any layout, such as
+ *	point cloud records carrying intensity or a timestamp next to the
+ *	position. The components of coordinate i are found stride bytes after
+ *	those of coordinate i - 1.
+ * @note: A stride of sizeof(T) makes x, y and z plain arrays, as in SoA form;
+ *	the batch functions then run the kernels on them directly.
+ * @tparam T floating-point type of the components (float or double), const
+ *	qualified for coordinates that are only read. It need not be the
+ *	model's type, which is the precision the conversions compute in.
+ */
+template<typename T>
+struct Strided {
+	using value_type = typename std::remove_const<T>::type;
+
+	T *x;			/**< First component of the first coordinate. */
+	T *y;			/**< Second component of the first coordinate. */
+	T *z;			/**< Third component of the first coordinate. */
+	std::ptrdiff_t stride;	/**< Bytes from one coordinate to the next. */
+};
+
+/**
+ * @brief Describe coordinates whose three components are adjacent in each
+ *	record, e.g. strided(&records[0].position[0], sizeof(records[0])).
+ * @param first The first component of the first coordinate.
+ * @param stride Bytes from one record to the next.
+ */
+template<typename T>
+inline
+Strided<T>
+strided(
+	T * const first,
+	std::ptrdiff_t const stride) noexcept;
+
+/**
+ * @brief Describe coordinates whose components lie anywhere in each record.
+ * @param x The first component of the first coordinate.
+ * @param y The second component of the first coordinate.
+ * @param z The third component of the first coordinate.
+ * @param stride Bytes from one record to the next.
+ */
+template<typename T>
+inline
+Strided<T>
+strided(
+	T * const x,
+	T * const y,
+	T * const z,
+	std::ptrdiff_t const stride) noexcept;
+
+/**
+ * @brief Convert a series of strided geodetic coordinates to ECEF in place.
+ * @note: Runs the vectorized SoA kernels on blocks gathered from the records.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> one (see Approximate.hpp).
+ * @param coords The geodetic coordinates that will be overwritten by ECEF ones.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param numCoords The number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToECEFStrided(
+	Strided<T> * const coords,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series of strided geodetic coordinates to ECEF coordinates.
+ * @note: The output must either be the input records or not overlap them.
+ * @note: Runs the vectorized SoA kernels directly when both strides are
+ *	sizeof(T) and the output is not the input, otherwise on blocks gathered
+ *	from the records.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam U T or T const.
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> one (see Approximate.hpp).
+ * @param toECEF Pointer to where the ECEF coordinates will be written.
+ * @param fromGeodetic The geodetic coordinates to be converted.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param numCoords The number of coordinates.
+ * @param model An instance of the reference body.
+ */
+template<typename T, typename U, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToECEFStrided(
+	Strided<T> * const toECEF,
+	Strided<U> const &fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series of strided ECEF coordinates to geodetic in place,
+ *	using a reference sphere.
+ * @note: Runs the vectorized SoA kernels on blocks gathered from the records.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
+ * @param coords The ECEF coordinates that will be overwritten by geodetic ones.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param numCoords The number of coordinates.
+ * @param sphere An instance of the reference sphere.
+ */
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const coords,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, using a reference ellipsoid and a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille or Olson.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, a StaticEllipsoid<T, Axes>
+ *	such as WGS84<T>, or an Approximate<> one (see Approximate.hpp).
+ */
+template<typename Algorithm = Bowring, typename T, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const coords,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
+/**
+ * @brief Convert a series of strided ECEF coordinates to geodetic coordinates
+ *	using a reference sphere.
+ * @note: The output must either be the input records or not overlap them.
+ * @note: Runs the vectorized SoA kernels directly when both strides are
+ *	sizeof(T) and the output is not the input, otherwise on blocks gathered
+ *	from the records.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam U T or T const.
+ * @tparam Model Sphere<T>, or Approximate<Sphere<float>> (see Approximate.hpp).
+ * @param toGeodetic Pointer to where the geodetic coordinates will be written.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param fromECEF The ECEF coordinates to be converted.
+ * @param numCoords The number of coordinates.
+ * @param sphere An instance of the reference sphere.
+ */
+template<typename T, typename U, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const toGeodetic,
+	Strided<U> const &fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, using a reference ellipsoid and a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille or Olson.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, a StaticEllipsoid<T, Axes>
+ *	such as WGS84<T>, or an Approximate<> one (see Approximate.hpp).
+ */
+template<typename Algorithm = Bowring, typename T, typename U, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const toGeodetic,
+	Strided<U> const &fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/StridedImpl.hpp>
+
+#endif // !terra_Strided_hpp
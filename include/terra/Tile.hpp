@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Tile_hpp
+#define terra_Tile_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief A tile of ECEF coordinates stored relative to its centre, as in
+ *	3D Tiles' RTC_CENTER, so that they fit in fewer bytes.
+ * An offset is stored as (ecef - centre)/scale: as is in float or double, or
+ * rounded to the nearest unit in std::int16_t or std::int32_t, saturating at
+ * the ends of their range; NaN stores as the least value, as for the lower
+ * end. For example a scale of 0.001 stores millimetres,
+ * reaching about +-2147 km in int32 and +-32 m in int16.
+ * @note: Offsets are computed in T, after the absolute coordinate; a double
+ *	model keeps millimetres whatever the offsets are stored in, a float
+ *	one rounds the absolute coordinate to about 0.5 m first.
+ * @tparam T floating-point type of the reference body (float or double).
+ */
+template<typename T>
+struct Tile {
+	using value_type = T;
+
+	T centre[3];	/**< ECEF coordinates of the origin of the offsets, metres. */
+	T scale;	/**< Metres per unit of the stored offsets. */
+};
+
+/**
+ * @brief Describe a tile centred on the ECEF coordinates (x, y, z).
+ * @param scale Metres per unit of the stored offsets, 1 for offsets in metres.
+ */
+template<typename T>
+inline
+Tile<T>
+tile(
+	T const x,
+	T const y,
+	T const z,
+	T const scale = T(1)) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of geodetic coordinates to ECEF
+ *	coordinates relative to a tile centre.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp).
+ * @tparam TileCoord a struct type with the arrays x, y, z of float, double,
+ *	std::int16_t or std::int32_t for the offsets.
+ * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+ * @tparam Model Sphere<T>, Ellipsoid<T>, one of the ellipsoid models, or an
+ *	Approximate<> or Degrees<> one (see Approximate.hpp and Degrees.hpp).
+ * @param toTile Pointer to where the offsets will be written.
+ * @param fromGeodetic The geodetic coordinates to be converted. Accessed as:
+ *	x=longitude, y=latitude, z=altitude.
+ * @param numCoords The number of coordinates.
+ * @param tile The centre and scale of the offsets.
+ * @param model An instance of the reference body.
+ */
+template<typename TileCoord, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToECEFTileSoA(
+	TileCoord * const TERRA_RESTRICT toTile,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Tile<typename Model::value_type> const &tile,
+	Model const model) noexcept;
+
+/**
+ * @brief Convert a series, in SoA form, of ECEF coordinates relative to a tile
+ *	centre to geodetic coordinates using a reference sphere.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp).
+ * @tparam Coord a struct type with the arrays x, y, z of T for the coordinates.
+ * @tparam TileCoord a struct type with the arrays x, y, z of float, double,
+ *	std::int16_t or std::int32_t for the offsets.
+ * @tparam Model Sphere<T>, or an Approximate<> or Degrees<> one.
+ * @param toGeodetic Pointer to where the geodetic coordinates will be written.
+ *	Accessed as: x=longitude, y=latitude, z=altitude.
+ * @param fromTile The offsets to be converted.
+ * @param numCoords The number of coordinates.
+ * @param tile The centre and scale of the offsets.
+ * @param sphere An instance of the reference sphere.
+ */
+template<typename Coord, typename TileCoord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefTileToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	TileCoord const & TERRA_RESTRICT fromTile,
+	std::size_t const numCoords,
+	Tile<typename Model::value_type> const &tile,
+	Model const sphere) noexcept;
+
+/**
+ * @brief As above, using a reference ellipsoid and a chosen algorithm.
+ * @tparam Algorithm Bowring, BowringIterative<N>, Vermeille or Olson.
+ * @tparam Model Ellipsoid<T>, PreparedEllipsoid<T>, a StaticEllipsoid<T, Axes>
+ *	such as WGS84<T>, or an Approximate<> or Degrees<> one.
+ */
+template<typename Algorithm = Bowring, typename Coord, typename TileCoord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefTileToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	TileCoord const & TERRA_RESTRICT fromTile,
+	std::size_t const numCoords,
+	Tile<typename Model::value_type> const &tile,
+	Model const ellipsoid) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/TileImpl.hpp>
+
+#endif // !terra_Tile_hpp
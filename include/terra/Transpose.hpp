@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_Transpose_hpp
+#define terra_Transpose_hpp
+
+#include <terra/Arch.hpp>
+#include <cassert>
+#include <cstddef>
+
+namespace terra {
+
+/**
+ * @brief Copy a series of coordinates from AoS form to SoA form.
+ * @note: The two series must not reference overlapping memory areas.
+ * @note: Packed 3-tuples, T[3] or std::array<T, 3> in a pointer, array or
+ *	std::vector, are transposed with vector shuffles, using the instruction
+ *	set level picked by simdLevel() (see Dispatch.hpp). Other 3-tuple types
+ *	are copied one element at a time.
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @param toSoA Pointer to where the coordinates will be written.
+ * @param fromAoS The coordinates to be copied.
+ * @param numCoords The number of coordinates.
+ */
+template<typename Coord, typename Coord2>
+inline
+void
+aosToSoA(
+	Coord * const TERRA_RESTRICT toSoA,
+	Coord2 const & TERRA_RESTRICT fromAoS,
+	std::size_t const numCoords) noexcept;
+
+/**
+ * @brief Copy a series of coordinates from SoA form to AoS form.
+ * @note: The two series must not reference overlapping memory areas.
+ * @note: Transposed with vector shuffles into packed 3-tuples, as for aosToSoA().
+ * @tparam Coord2 3-tuple type that can be accessed via operator[].
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @param toAoS Pointer to an array where the coordinates will be written.
+ * @param fromSoA The coordinates to be copied.
+ * @param numCoords The number of coordinates.
+ */
+template<typename Coord2, typename Coord>
+inline
+void
+soaToAoS(
+	Coord2 * const TERRA_RESTRICT toAoS,
+	Coord const & TERRA_RESTRICT fromSoA,
+	std::size_t const numCoords) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/TransposeImpl.hpp>
+
+#endif // !terra_Transpose_hpp
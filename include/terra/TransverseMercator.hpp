@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_TransverseMercator_hpp
+#define terra_TransverseMercator_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief A Transverse Mercator projection of an ellipsoid, for converting
+ *	between geodetic or ECEF coordinates and grid coordinates, such as UTM.
+ *	Krüger's series to sixth order in the third flattening, in Karney's
+ *	(2011) form, accurate to about 5 nm within 3900 km of the central
+ *	meridian. Its coefficients, and the sine and cosine of the central
+ *	meridian, are computed once, on construction.
+ * @note: The members must be kept consistent; construct a new instance rather
+ *	than changing them.
+ * @tparam T floating-point type to be used (float or double).
+ */
+template<typename T>
+struct TransverseMercator {
+	using value_type = T;
+
+	/**
+	 * @brief Set up the projection about a central meridian.
+	 * @param centralMeridian Longitude of the central meridian, in radians,
+	 *	or degrees for a Degrees<> model.
+	 * @param model The ellipsoid to project: an Ellipsoid<T> or one of the
+	 *	ellipsoid models, possibly wrapped in Approximate<> or Degrees<>.
+	 * @param scale Scale factor on the central meridian.
+	 * @param falseEasting Added to all eastings.
+	 * @param falseNorthing Added to all northings.
+	 */
+	template<typename Model>
+	TransverseMercator(
+		T const centralMeridian,
+		Model const model,
+		T const scale = T(1),
+		T const falseEasting = T(0),
+		T const falseNorthing = T(0)) noexcept;
+
+	T centralMeridian;	/**< In the unit of the model's longitudes. */
+	T sinCentral;		/**< sin(centralMeridian), for ECEF input. */
+	T cosCentral;		/**< cos(centralMeridian), for ECEF input. */
+	T scaledRadius;		/**< The rectifying radius times the scale factor. */
+	T falseEasting;		/**< Added to all eastings. */
+	T falseNorthing;	/**< Added to all northings. */
+	T eccentricity;		/**< First eccentricity, e. */
+	T alpha[6];		/**< Series from conformal to projected coordinates. */
+	T beta[6];		/**< Series from projected to conformal coordinates. */
+};
+
+/**
+ * @brief The Universal Transverse Mercator projection of a zone.
+ * @tparam Model Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>, possibly
+ *	wrapped in Approximate<> or Degrees<>.
+ * @param zone The zone, 1 to 60, centred on 6*zone - 183 degrees east.
+ * @param north True for the northern hemisphere, false for the southern,
+ *	whose northings are offset by 10000 km.
+ * @param model The ellipsoid to project.
+ */
+template<typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value, TransverseMercator<typename Model::value_type>>::type
+utm(
+	unsigned const zone,
+	bool const north,
+	Model const model) noexcept;
+
+/**
+ * @brief The UTM zone of a geodetic coordinate, with the exceptions for
+ *	southwest Norway and Svalbard.
+ * @param lon Longitude, in radians, or degrees for a Degrees<> model.
+ * @param lat Latitude, in the same unit.
+ * @param model The ellipsoid, for the unit of the angles.
+ */
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value, unsigned>::type
+utmZone(
+	T const lon,
+	T const lat,
+	Model const model) noexcept;
+
+/**
+ * @brief Project a geodetic coordinate in place.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>, possibly
+ *	wrapped in Approximate<> or Degrees<>; the one the projection was set
+ *	up with.
+ * @param coord Pointer to geodetic coordinate that will be overwritten by
+ *	grid coordinate.
+ *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
+ *	Grid coordinate is indexed as: 0=easting, 1=northing, 2=altitude.
+ * @param projection The projection.
+ * @param model The reference ellipsoid of the geodetic coordinate.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercator(
+	Coord * const coord,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project a geodetic coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercator(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Unproject a grid coordinate to geodetic in place. The longitude
+ *	comes back within a half turn of 0, also east of the antimeridian in
+ *	zone 60.
+ * @param coord Pointer to grid coordinate that will be overwritten by
+ *	geodetic coordinate.
+ *	Otherwise as geodToTransverseMercator().
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeod(
+	Coord * const coord,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Unproject a grid coordinate to a geodetic coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGrid,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project an ECEF coordinate in place, without going through its
+ *	longitude and latitude: the longitude from the central meridian is
+ *	rotated out of x and y, and the latitude taken from one step of
+ *	Bowring's method, both as sines and cosines only.
+ * @param coord Pointer to ECEF coordinate that will be overwritten by grid
+ *	coordinate. ECEF coordinate is indexed as: 0=x, 1=y, 2=z.
+ *	Otherwise as geodToTransverseMercator().
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercator(
+	Coord * const coord,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project an ECEF coordinate.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercator(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromECEF,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project a series, in SoA form, of geodetic coordinates.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @tparam T floating-point type to be used (float or double).
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Ellipsoid<T> or an ellipsoid model, e.g. WGS84<T>, possibly
+ *	wrapped in Approximate<> or Degrees<>.
+ * @param toGrid Pointer to where the grid coordinates will be written.
+ *	Grid coordinates are accessed as: x=easting, y=northing, z=altitude.
+ * @param fromGeodetic The geodetic coordinates to be projected.
+ *	Geodetic coordinates are accessed as: x=longitude, y=latitude, z=altitude.
+ * @param projection The projection.
+ * @param model The reference ellipsoid of the geodetic coordinates.
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercatorSoA(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Unproject a series, in SoA form, of grid coordinates to geodetic
+ *	coordinates. Otherwise as geodToTransverseMercatorSoA().
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGrid,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project a series, in SoA form, of ECEF coordinates in one pass,
+ *	as ecefToTransverseMercator(). Otherwise as geodToTransverseMercatorSoA().
+ */
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercatorSoA(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project a series, in AoS form, of geodetic coordinates.
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
+ *	Otherwise as geodToTransverseMercatorSoA(), with coordinates indexed via
+ *	operator[].
+ */
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercatorAoS(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Unproject a series, in AoS form, of grid coordinates to geodetic
+ *	coordinates. Otherwise as geodToTransverseMercatorAoS().
+ */
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromGrid,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+/**
+ * @brief Project a series, in AoS form, of ECEF coordinates in one pass.
+ *	Otherwise as geodToTransverseMercatorAoS().
+ */
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercatorAoS(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/TransverseMercatorImpl.hpp>
+
+#endif // !terra_TransverseMercator_hpp
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_WebMercator_hpp
+#define terra_WebMercator_hpp
+
+#include <terra/Arch.hpp>
+#include <terra/Sphere.hpp>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace terra {
+
+/**
+ * @brief Project a geodetic coordinate to spherical (Web) Mercator in place.
+ * @note: EPSG:3857 is the projection of Sphere<T>(6378137) applied to WGS 84
+ *	longitudes and latitudes. The poles project to infinity, or, as pi/2
+ *	rounds, to a y far beyond the edge of the map on their own side.
+ * @tparam Coord 3-tuple type that can be accessed via operator[].
+ * @tparam Model Sphere<T>, or an Approximate<> or Degrees<> one.
+ * @param coord Pointer to geodetic coordinate that will be overwritten by
+ *	projected coordinate.
+ *	Geodetic coordinate is indexed as: 0=longitude, 1=latitude, 2=altitude.
+ *	Projected coordinate is indexed as: 0=x, east, 1=y, north, in metres,
+ *	2=altitude.
+ * @param sphere An instance of the reference sphere.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercator(
+	Coord * const coord,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Project a geodetic coordinate to spherical Mercator.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercator(
+	Coord * const TERRA_RESTRICT toMercator,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Unproject a spherical Mercator coordinate to geodetic in place.
+ * @param coord Pointer to projected coordinate that will be overwritten by
+ *	geodetic coordinate. Otherwise as geodToWebMercator().
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeod(
+	Coord * const coord,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Unproject a spherical Mercator coordinate to geodetic.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ *	Otherwise as above.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromMercator,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Project a series, in SoA form, of geodetic coordinates to spherical
+ *	Mercator.
+ * @note: The two coordinates must not reference overlapping memory areas.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp). The arrays x, y, z hold float or double, converted to
+ *	and from T in registers, so storage and compute precision can differ.
+ * @tparam Coord a struct type with the arrays x, y, z for the coordinates.
+ * @tparam Model Sphere<T>, or an Approximate<> or Degrees<> one.
+ * @param toMercator Pointer to where the projected coordinates will be written.
+ *	Accessed as: x=x, y=y, z=altitude.
+ * @param fromGeodetic The geodetic coordinates to be projected.
+ *	Accessed as: x=longitude, y=latitude, z=altitude.
+ * @param numCoords The number of coordinates.
+ * @param sphere An instance of the reference sphere.
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorSoA(
+	Coord * const TERRA_RESTRICT toMercator,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Unproject a series, in SoA form, of spherical Mercator coordinates to
+ *	geodetic coordinates. Otherwise as geodToWebMercatorSoA().
+ */
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromMercator,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Project a series, in AoS form, of geodetic coordinates to spherical
+ *	Mercator.
+ * @note: Arrays of packed T[3] or std::array<T, 3> are transposed in registers
+ *	around the vectorized kernels; other 3-tuples run the SoA kernels on blocks
+ *	gathered from the arrays (see Transpose.hpp).
+ *	Otherwise as geodToWebMercatorSoA(), with coordinates indexed via
+ *	operator[].
+ */
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorAoS(
+	Coord * const TERRA_RESTRICT toMercator,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Unproject a series, in AoS form, of spherical Mercator coordinates to
+ *	geodetic coordinates. Otherwise as geodToWebMercatorAoS().
+ */
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromMercator,
+	std::size_t const numCoords,
+	Model const sphere) noexcept;
+
+/**
+ * @brief Find the slippy map tile, and the pixel within it, of a series, in
+ *	SoA form, of geodetic coordinates at a zoom level: the tile x counts
+ *	east from the antimeridian and y south from 85.0511 degrees north, in
+ *	2^zoom tiles of tileSize pixels either way, as for z/x/y tile URLs.
+ * @note: The Mercator y is never materialised in metres. Coordinates beyond
+ *	the map are clamped onto its edge: latitudes past 85.0511 degrees, and
+ *	longitudes past the antimeridian. Pixels are computed in T, and float
+ *	keeps them to within a pixel up to zoom 15 for 256 pixel tiles.
+ * @note: Runs vectorized, using the instruction set level picked by simdLevel()
+ *	(see Dispatch.hpp).
+ * @tparam TileIndex a struct type with the arrays x, y of an integer type,
+ *	such as std::uint32_t, for the tiles.
+ * @tparam Pixel a struct type with the arrays x, y of float or double for the
+ *	pixel offsets.
+ * @tparam Coord a struct type with the arrays x, y, z of float or double for
+ *	the coordinates.
+ * @tparam Model Sphere<T>, or an Approximate<> or Degrees<> one; the radius
+ *	is unused.
+ * @param toTile Pointer to where the tile indices will be written.
+ * @param toPixel Pointer to where the offsets within the tiles will be written,
+ *	x right and y down from the tile's top left corner, within [0, tileSize].
+ * @param fromGeodetic The geodetic coordinates, the altitudes unused.
+ *	Accessed as: x=longitude, y=latitude.
+ * @param numCoords The number of coordinates.
+ * @param zoom The zoom level, 0 to 30.
+ * @param sphere An instance of the reference sphere.
+ * @param tileSize The width and height of a tile, in pixels.
+ */
+template<typename TileIndex, typename Pixel, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorTileSoA(
+	TileIndex * const TERRA_RESTRICT toTile,
+	Pixel * const TERRA_RESTRICT toPixel,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	unsigned const zoom,
+	Model const sphere,
+	unsigned const tileSize = 256) noexcept;
+
+} // !namespace terra
+
+#include <terra/impl/WebMercatorImpl.hpp>
+
+#endif // !terra_WebMercator_hpp
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_ApproximateImpl_hpp
+#define terra_impl_ApproximateImpl_hpp
+
+namespace terra {
+
+template<typename Model>
+inline
+Approximate<Model>
+approximate(Model const &model) noexcept
+{
+	return Approximate<Model>(model);
+}
+
+inline
+Approximate<PreparedEllipsoid<float>>
+approximate(Ellipsoid<float> const &ellipsoid) noexcept
+{
+	return Approximate<PreparedEllipsoid<float>>(PreparedEllipsoid<float>(ellipsoid));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_ApproximateImpl_hpp
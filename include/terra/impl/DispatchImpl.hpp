@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_DispatchImpl_hpp
+#define terra_impl_DispatchImpl_hpp
+
+#include <atomic>
+#include <cstddef>
+
+#if defined(TERRA_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace terra {
+namespace simd {
+
+#if defined(TERRA_X86)
+inline
+void
+cpuid(unsigned * const regs, unsigned const leaf, unsigned const subleaf) noexcept
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+	for (auto i = 0; i < 4; ++i)
+		regs[i] = static_cast<unsigned>(r[i]);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/* Register state the OS saves on context switch (XCR0). */
+inline
+unsigned long long
+xgetbv() noexcept
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned lo, hi;
+	/* The xgetbv opcode, so that no -mxsave is needed. */
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0));
+	return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif // TERRA_X86
+
+inline
+SimdLevel
+cpuSimdLevel() noexcept
+{
+#if defined(TERRA_X86)
+	unsigned r[4];
+	cpuid(r, 0, 0);
+	auto const maxLeaf = r[0];
+	if (maxLeaf < 1)
+		return SimdLevel::Scalar;
+
+	cpuid(r, 1, 0);
+	auto const ecx1 = r[2];
+	auto const edx1 = r[3];
+	if (!(edx1 & (1u << 26)))
+		return SimdLevel::Scalar;
+	if (!(ecx1 & (1u << 19)) || !(ecx1 & (1u << 20)))
+		return SimdLevel::SSE2;
+
+	auto const osxsave = (ecx1 & (1u << 27)) != 0;
+	auto const avx = (ecx1 & (1u << 28)) != 0;
+	auto const fma = (ecx1 & (1u << 12)) != 0;
+	if (!osxsave || !avx || !fma || maxLeaf < 7)
+		return SimdLevel::SSE42;
+	auto const xcr0 = xgetbv();
+	if ((xcr0 & 0x6) != 0x6)
+		return SimdLevel::SSE42;
+
+	cpuid(r, 7, 0);
+	auto const ebx7 = r[1];
+	if (!(ebx7 & (1u << 5)))
+		return SimdLevel::SSE42;
+	/* AVX-512F, with opmask and the upper ZMM state enabled by the OS. */
+	if (!(ebx7 & (1u << 16)) || (xcr0 & 0xe6) != 0xe6)
+		return SimdLevel::AVX2;
+	return SimdLevel::AVX512;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+/* The highest level compiled in; lower ones missing fall back further down. */
+constexpr
+SimdLevel
+buildSimdLevel() noexcept
+{
+	return
+#if defined(TERRA_SIMD_AVX512)
+		SimdLevel::AVX512;
+#elif defined(TERRA_SIMD_AVX2)
+		SimdLevel::AVX2;
+#elif defined(TERRA_SIMD_SSE42)
+		SimdLevel::SSE42;
+#elif defined(TERRA_SIMD_SSE2)
+		SimdLevel::SSE2;
+#else
+		SimdLevel::Scalar;
+#endif
+}
+
+inline
+std::atomic<int> &
+levelState() noexcept
+{
+	/* Constant initialized, so no guard; -1 means not yet detected. */
+	static std::atomic<int> level(-1);
+	return level;
+}
+
+/* Index into a TERRA_SIMD_TABLE. */
+inline
+int
+levelIndex() noexcept
+{
+	auto level = levelState().load(std::memory_order_relaxed);
+	if (level < 0) {
+		auto const detected = static_cast<int>(detectSimdLevel());
+		if (levelState().compare_exchange_strong(level, detected, std::memory_order_relaxed))
+			level = detected;
+	}
+	return level;
+}
+
+} // !namespace simd
+
+inline
+SimdLevel
+detectSimdLevel() noexcept
+{
+	auto const cpu = simd::cpuSimdLevel();
+	auto const build = simd::buildSimdLevel();
+	return cpu < build ? cpu : build;
+}
+
+inline
+SimdLevel
+simdLevel() noexcept
+{
+	return static_cast<SimdLevel>(simd::levelIndex());
+}
+
+inline
+SimdLevel
+setSimdLevel(SimdLevel const level) noexcept
+{
+	auto const detected = detectSimdLevel();
+	auto const effective = level < detected ? level : detected;
+	simd::levelState().store(static_cast<int>(effective), std::memory_order_relaxed);
+	return effective;
+}
+
+inline
+void
+resetSimdLevel() noexcept
+{
+	simd::levelState().store(static_cast<int>(detectSimdLevel()), std::memory_order_relaxed);
+}
+
+inline
+char const *
+simdLevelName(SimdLevel const level) noexcept
+{
+	switch (level) {
+	case SimdLevel::Scalar: return "scalar";
+	case SimdLevel::SSE2: return "SSE2";
+	case SimdLevel::SSE42: return "SSE4.2";
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::AVX512: return "AVX-512";
+	}
+	return "unknown";
+}
+
+} // !namespace terra
+
+/*
+ * Define a static table, indexed by SimdLevel, of pointers to the same kernel
+ * in each instruction set namespace, e.g.
+ *	TERRA_SIMD_TABLE(Fn, table, geodToECEFSoA<T>);
+ *	table[simd::levelIndex()](...);
+ * Levels not compiled in fall back to the next one down.
+ */
+#define TERRA_SIMD_SLOT_SCALAR(...) &::terra::simd::scalar::__VA_ARGS__
+#if defined(TERRA_SIMD_SSE2)
+#define TERRA_SIMD_SLOT_SSE2(...) &::terra::simd::sse2::__VA_ARGS__
+#else
+#define TERRA_SIMD_SLOT_SSE2(...) TERRA_SIMD_SLOT_SCALAR(__VA_ARGS__)
+#endif
+#if defined(TERRA_SIMD_SSE42)
+#define TERRA_SIMD_SLOT_SSE42(...) &::terra::simd::sse42::__VA_ARGS__
+#else
+#define TERRA_SIMD_SLOT_SSE42(...) TERRA_SIMD_SLOT_SSE2(__VA_ARGS__)
+#endif
+#if defined(TERRA_SIMD_AVX2)
+#define TERRA_SIMD_SLOT_AVX2(...) &::terra::simd::avx2::__VA_ARGS__
+#else
+#define TERRA_SIMD_SLOT_AVX2(...) TERRA_SIMD_SLOT_SSE42(__VA_ARGS__)
+#endif
+#if defined(TERRA_SIMD_AVX512)
+#define TERRA_SIMD_SLOT_AVX512(...) &::terra::simd::avx512::__VA_ARGS__
+#else
+#define TERRA_SIMD_SLOT_AVX512(...) TERRA_SIMD_SLOT_AVX2(__VA_ARGS__)
+#endif
+
+#define TERRA_SIMD_TABLE(Fn, name, ...) \
+	static Fn const name[] = { \
+		TERRA_SIMD_SLOT_SCALAR(__VA_ARGS__), \
+		TERRA_SIMD_SLOT_SSE2(__VA_ARGS__), \
+		TERRA_SIMD_SLOT_SSE42(__VA_ARGS__), \
+		TERRA_SIMD_SLOT_AVX2(__VA_ARGS__), \
+		TERRA_SIMD_SLOT_AVX512(__VA_ARGS__) \
+	}
+
+#endif // !terra_impl_DispatchImpl_hpp
@@ -17,104 +17,188 @@
 #ifndef terra_impl_EllipsoidImpl_hpp
 #define terra_impl_EllipsoidImpl_hpp
 
+#include <terra/Dispatch.hpp>
+#include <terra/Transpose.hpp>
+#include <terra/impl/Simd.hpp>
+#include <limits>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/EllipsoidKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
 namespace terra {
 
-template<typename T, typename Coord>
+template<typename T>
 inline
-void
+PreparedEllipsoid<T>::PreparedEllipsoid(T const ma, T const mi) noexcept :
+	semiMajor(ma),
+	semiMinor(mi),
+	semiMajorSq(ma*ma),
+	semiMinorSq(mi*mi),
+	eccentricitySq((ma*ma - mi*mi)/(ma*ma)),
+	secondEccentricitySq((ma*ma - mi*mi)/(mi*mi)),
+	axisRatioSq((mi*mi)/(ma*ma))
+{
+}
+
+template<typename T>
+inline
+PreparedEllipsoid<T>::PreparedEllipsoid(Ellipsoid<T> const ellipsoid) noexcept :
+	PreparedEllipsoid(ellipsoid.semiMajor, ellipsoid.semiMinor)
+{
+}
+
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::semiMajor;
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::semiMinor;
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::semiMajorSq;
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::semiMinorSq;
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::eccentricitySq;
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::secondEccentricitySq;
+template<typename T, typename Axes> constexpr T StaticEllipsoid<T, Axes>::axisRatioSq;
+
+namespace detail {
+
+template<typename T>
+inline
+PreparedEllipsoid<T>
+prepare(Ellipsoid<T> const ellipsoid) noexcept
+{
+	return PreparedEllipsoid<T>(ellipsoid);
+}
+
+template<typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value, Model>::type
+prepare(Model const ellipsoid) noexcept
+{
+	return ellipsoid;
+}
+
+/* An ellipsoid and the tolerance of BowringTolerance, passed to the kernels as one. */
+template<typename Model>
+struct ToleranceModel {
+	Model ellipsoid;
+	BowringTolerance algorithm;
+};
+
+template<typename Model>
+inline
+auto
+toleranceModel(Model const ellipsoid, BowringTolerance const algorithm) noexcept
+	-> ToleranceModel<decltype(prepare(ellipsoid))>
+{
+	return ToleranceModel<decltype(prepare(ellipsoid))>{ prepare(ellipsoid), algorithm };
+}
+
+} // !namespace detail
+
+/*
+ * The single coordinate functions run the scalar instance of the per-point
+ * kernels in EllipsoidKernels.hpp, the same math as the batch functions.
+ */
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
 geodToECEF(
 	Coord * const coord,
-	Ellipsoid<T> const ellipsoid) noexcept
+	Model const ellipsoid) noexcept
 {
 	assert(coord && "coord is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-
-	auto const lon = (*coord)[0];
-	auto const lat = (*coord)[1];
-	auto const alt = (*coord)[2];
-	auto const sin_lon = std::sin(lon);
-	auto const cos_lon = std::cos(lon);
-	auto const sin_lat = std::sin(lat);
-	auto const cos_lat = std::cos(lat);
-	auto const Nphi = a2/(std::sqrt(a2*cos_lat*cos_lat + b2*sin_lat*sin_lat));
-	auto const Nphi_alt_cos_lat = (Nphi + alt)*cos_lat;
-	(*coord)[0] = Nphi_alt_cos_lat*cos_lon;
-	(*coord)[1] = Nphi_alt_cos_lat*sin_lon;
-	(*coord)[2] = ((b2/a2)*Nphi + alt)*sin_lat;
+	using T = typename Model::value_type;
+	T x, y, z;
+	simd::scalar::geodToECEF<T>(&x, &y, &z, T((*coord)[0]), T((*coord)[1]), (*coord)[2], ellipsoid);
+	(*coord)[0] = x;
+	(*coord)[1] = y;
+	(*coord)[2] = z;
 }
 
 template<typename T, typename Coord>
 inline
 void
+geodToECEF(
+	Coord * const coord,
+	Ellipsoid<T> const ellipsoid) noexcept
+{
+	geodToECEF(coord, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
 geodToECEF(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord const & TERRA_RESTRICT fromGeodetic,
-	Ellipsoid<T> const ellipsoid) noexcept
+	Model const ellipsoid) noexcept
 {
 	assert(toECEF && "toECEF is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-
-	auto const lon = fromGeodetic[0];
-	auto const lat = fromGeodetic[1];
-	auto const alt = fromGeodetic[2];
-	auto const sin_lon = std::sin(lon);
-	auto const cos_lon = std::cos(lon);
-	auto const sin_lat = std::sin(lat);
-	auto const cos_lat = std::cos(lat);
-	auto const Nphi = a2/(std::sqrt(a2*cos_lat*cos_lat + b2*sin_lat*sin_lat));
-	auto const Nphi_alt_cos_lat = (Nphi + alt)*cos_lat;
-	(*toECEF)[0] = Nphi_alt_cos_lat*cos_lon;
-	(*toECEF)[1] = Nphi_alt_cos_lat*sin_lon;
-	(*toECEF)[2] = ((b2/a2)*Nphi + alt)*sin_lat;
+	using T = typename Model::value_type;
+	T x, y, z;
+	simd::scalar::geodToECEF<T>(&x, &y, &z, T(fromGeodetic[0]), T(fromGeodetic[1]), fromGeodetic[2], ellipsoid);
+	(*toECEF)[0] = x;
+	(*toECEF)[1] = y;
+	(*toECEF)[2] = z;
 }
 
 template<typename T, typename Coord>
 inline
 void
+geodToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Ellipsoid<T> const ellipsoid) noexcept
+{
+	geodToECEF(toECEF, fromGeodetic, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Algorithm, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
 ecefToGeod(
 	Coord * const coord,
-	Ellipsoid<T> const ellipsoid) noexcept
+	Model const ellipsoid) noexcept
 {
 	assert(coord && "coord is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-	auto const e = std::sqrt((a2 - b2)/a2);
-	auto const e2 = e*e;
-	auto const ep = std::sqrt((a2 - b2)/b2);
-	auto const ep2 = ep*ep;
-
-	auto const x = (*coord)[0];
-	auto const y = (*coord)[1];
-	auto const z = (*coord)[2];
-
-	auto const p = std::sqrt(x*x + y*y);
-	auto const lon = std::atan2(y, x);
-	auto const theta = std::atan2(z*a, p*b);
-	auto const sin_theta = std::sin(theta);
-	auto const cos_theta = std::cos(theta);
-	auto const sin3_theta = sin_theta*sin_theta*sin_theta;
-	auto const cos3_theta = cos_theta*cos_theta*cos_theta;
-	auto const lat = std::atan2(z + ep2*b*sin3_theta, p - e2*a*cos3_theta);
-	auto const cos_lat = std::cos(lat);
-	auto const sin_lat = std::sin(lat);
-	auto const N = a/(std::sqrt(1.0 - e2*sin_lat*sin_lat));
-	auto const alt = (p/cos_lat) - N;
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::ecefToGeod(Algorithm(), &lon, &lat, &alt, T((*coord)[0]), T((*coord)[1]), T((*coord)[2]),
+				  detail::prepare(ellipsoid));
 	(*coord)[0] = lon;
 	(*coord)[1] = lat;
 	(*coord)[2] = alt;
 }
 
+template<typename T, typename Coord>
+inline
+void
+ecefToGeod(
+	Coord * const coord,
+	Ellipsoid<T> const ellipsoid) noexcept
+{
+	ecefToGeod(coord, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Algorithm, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Model const ellipsoid) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::ecefToGeod(Algorithm(), &lon, &lat, &alt, T(fromECEF[0]), T(fromECEF[1]), T(fromECEF[2]),
+				  detail::prepare(ellipsoid));
+	(*toGeodetic)[0] = lon;
+	(*toGeodetic)[1] = lat;
+	(*toGeodetic)[2] = alt;
+}
+
 template<typename T, typename Coord>
 inline
 void
@@ -122,69 +206,82 @@ ecefToGeod(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord const & TERRA_RESTRICT fromECEF,
 	Ellipsoid<T> const ellipsoid) noexcept
+{
+	ecefToGeod(toGeodetic, fromECEF, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Model const ellipsoid,
+	BowringTolerance const algorithm) noexcept
 {
 	assert(toGeodetic && "toGeodetic is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-	auto const e = std::sqrt((a2 - b2)/a2);
-	auto const e2 = e*e;
-	auto const ep = std::sqrt((a2 - b2)/b2);
-	auto const ep2 = ep*ep;
-
-	auto const x = fromECEF[0];
-	auto const y = fromECEF[1];
-	auto const z = fromECEF[2];
-
-	auto const p = std::sqrt(x*x + y*y);
-	auto const lon = std::atan2(y, x);
-	auto const theta = std::atan2(z*a, p*b);
-	auto const sin_theta = std::sin(theta);
-	auto const cos_theta = std::cos(theta);
-	auto const sin3_theta = sin_theta*sin_theta*sin_theta;
-	auto const cos3_theta = cos_theta*cos_theta*cos_theta;
-	auto const lat = std::atan2(z + ep2*b*sin3_theta, p - e2*a*cos3_theta);
-	auto const cos_lat = std::cos(lat);
-	auto const sin_lat = std::sin(lat);
-	auto const N = a/(std::sqrt(1.0 - e2*sin_lat*sin_lat));
-	auto const alt = (p/cos_lat) - N;
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::ecefToGeod(algorithm, &lon, &lat, &alt, T(fromECEF[0]), T(fromECEF[1]), T(fromECEF[2]),
+				  detail::prepare(ellipsoid));
 	(*toGeodetic)[0] = lon;
 	(*toGeodetic)[1] = lat;
 	(*toGeodetic)[2] = alt;
 }
 
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using T = typename Model::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToECEFSoA<T, Model, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toECEF->x[0], &toECEF->y[0], &toECEF->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, ellipsoid);
+}
+
 template<typename T, typename Coord>
 inline
 void
 geodToECEFSoA(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept
+{
+	geodToECEFSoA(toECEF, fromGeodetic, numCoords, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
 {
 	assert(toECEF && "toECEF is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const lon = fromGeodetic.x[i];
-		auto const lat = fromGeodetic.y[i];
-		auto const alt = fromGeodetic.z[i];
-		auto const sin_lon = std::sin(lon);
-		auto const cos_lon = std::cos(lon);
-		auto const sin_lat = std::sin(lat);
-		auto const cos_lat = std::cos(lat);
-		auto const Nphi = a2/(std::sqrt(a2*cos_lat*cos_lat + b2*sin_lat*sin_lat));
-		auto const Nphi_alt_cos_lat = (Nphi + alt)*cos_lat;
-		toECEF->x[i] = Nphi_alt_cos_lat*cos_lon;
-		toECEF->y[i] = Nphi_alt_cos_lat*sin_lon;
-		toECEF->z[i] = ((b2/a2)*Nphi + alt)*sin_lat;
-	}
+	using T = typename Model::value_type;
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToECEFSoA<T, Model>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, geodToECEFAoS<T, Model>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toECEF, fromGeodetic, numCoords, ellipsoid);
 }
 
 template<typename T, typename Coord, typename Coord2>
@@ -193,30 +290,33 @@ void
 geodToECEFAoS(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord2 const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept
 {
-	assert(toECEF && "toECEF is nullptr");
+	geodToECEFAoS(toECEF, fromGeodetic, numCoords, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Algorithm, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const lon = fromGeodetic[i][0];
-		auto const lat = fromGeodetic[i][1];
-		auto const alt = fromGeodetic[i][2];
-		auto const sin_lon = std::sin(lon);
-		auto const cos_lon = std::cos(lon);
-		auto const sin_lat = std::sin(lat);
-		auto const cos_lat = std::cos(lat);
-		auto const Nphi = a2/(std::sqrt(a2*cos_lat*cos_lat + b2*sin_lat*sin_lat));
-		auto const Nphi_alt_cos_lat = (Nphi + alt)*cos_lat;
-		(*toECEF)[i][0] = Nphi_alt_cos_lat*cos_lon;
-		(*toECEF)[i][1] = Nphi_alt_cos_lat*sin_lon;
-		(*toECEF)[i][2] = ((b2/a2)*Nphi + alt)*sin_lat;
-	}
+	using T = typename Model::value_type;
+	using Prepared = decltype(detail::prepare(ellipsoid));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodSoA<Algorithm, T, Prepared, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, detail::prepare(ellipsoid));
 }
 
 template<typename T, typename Coord>
@@ -225,42 +325,78 @@ void
 ecefToGeodSoA(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord const & TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept
+{
+	ecefToGeodSoA(toGeodetic, fromECEF, numCoords, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid,
+	BowringTolerance const algorithm) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using Tolerant = decltype(detail::toleranceModel(ellipsoid, algorithm));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Tolerant);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodToleranceSoA<T, Tolerant, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, detail::toleranceModel(ellipsoid, algorithm));
+}
+
+template<typename Algorithm, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodTrajectorySoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
 {
 	assert(toGeodetic && "toGeodetic is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-	auto const e = std::sqrt((a2 - b2)/a2);
-	auto const e2 = e*e;
-	auto const ep = std::sqrt((a2 - b2)/b2);
-	auto const ep2 = ep*ep;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const x = fromECEF.x[i];
-		auto const y = fromECEF.y[i];
-		auto const z = fromECEF.z[i];
-
-		auto const p = std::sqrt(x*x + y*y);
-		auto const lon = std::atan2(y, x);
-		auto const theta = std::atan2(z*a, p*b);
-		auto const sin_theta = std::sin(theta);
-		auto const cos_theta = std::cos(theta);
-		auto const sin3_theta = sin_theta*sin_theta*sin_theta;
-		auto const cos3_theta = cos_theta*cos_theta*cos_theta;
-		auto const lat = std::atan2(z + ep2*b*sin3_theta, p - e2*a*cos3_theta);
-		auto const cos_lat = std::cos(lat);
-		auto const sin_lat = std::sin(lat);
-		auto const N = a/(std::sqrt(1.0 - e2*sin_lat*sin_lat));
-		auto const alt = (p/cos_lat) - N;
-
-		toGeodetic->x[i] = lon;
-		toGeodetic->y[i] = lat;
-		toGeodetic->z[i] = alt;
-	}
+	using T = typename Model::value_type;
+	using Prepared = decltype(detail::prepare(ellipsoid));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodTrajectorySoA<Algorithm, T, Prepared, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, detail::prepare(ellipsoid));
+}
+
+template<typename Algorithm, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using Prepared = decltype(detail::prepare(ellipsoid));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodSoA<Algorithm, T, Prepared>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, ecefToGeodAoS<Algorithm, T, Prepared>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGeodetic, fromECEF, numCoords, detail::prepare(ellipsoid));
 }
 
 template<typename T, typename Coord, typename Coord2>
@@ -269,41 +405,33 @@ void
 ecefToGeodAoS(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord2 const & TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Ellipsoid<T> const ellipsoid) noexcept
+{
+	ecefToGeodAoS(toGeodetic, fromECEF, numCoords, PreparedEllipsoid<T>(ellipsoid));
+}
+
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid,
+	BowringTolerance const algorithm) noexcept
 {
 	assert(toGeodetic && "toGeodetic is nullptr");
 
-	auto const a = ellipsoid.semiMajor;
-	auto const a2 = a*a;
-	auto const b = ellipsoid.semiMinor;
-	auto const b2 = b*b;
-	auto const e = std::sqrt((a2 - b2)/a2);
-	auto const e2 = e*e;
-	auto const ep = std::sqrt((a2 - b2)/b2);
-	auto const ep2 = ep*ep;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const x = fromECEF[i][0];
-		auto const y = fromECEF[i][1];
-		auto const z = fromECEF[i][2];
-
-		auto const p = std::sqrt(x*x + y*y);
-		auto const lon = std::atan2(y, x);
-		auto const theta = std::atan2(z*a, p*b);
-		auto const sin_theta = std::sin(theta);
-		auto const cos_theta = std::cos(theta);
-		auto const sin3_theta = sin_theta*sin_theta*sin_theta;
-		auto const cos3_theta = cos_theta*cos_theta*cos_theta;
-		auto const lat = std::atan2(z + ep2*b*sin3_theta, p - e2*a*cos3_theta);
-		auto const cos_lat = std::cos(lat);
-		auto const sin_lat = std::sin(lat);
-		auto const N = a/(std::sqrt(1.0 - e2*sin_lat*sin_lat));
-		auto const alt = (p/cos_lat) - N;
-		(*toGeodetic)[i][0] = lon;
-		(*toGeodetic)[i][1] = lat;
-		(*toGeodetic)[i][2] = alt;
-	}
+	using T = typename Model::value_type;
+	using Tolerant = decltype(detail::toleranceModel(ellipsoid, algorithm));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Tolerant);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodToleranceSoA<T, Tolerant>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Tolerant);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, ecefToGeodToleranceAoS<T, Tolerant>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGeodetic, fromECEF, numCoords,
+			detail::toleranceModel(ellipsoid, algorithm));
 }
 
 } // !namespace terra
@@ -0,0 +1,736 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for Ellipsoid<T>, expanded into every instruction set
+ * namespace by SimdForEach.hpp. Coordinates are passed as separate component
+ * arrays, for the public SoA functions, which may hold another floating-point
+ * type S converted in registers, or as packed triples, for the AoS ones. The
+ * ellipsoid is a PreparedEllipsoid<T> or a StaticEllipsoid<T, Axes>,
+ * whose constants then fold into the code, either possibly wrapped in
+ * Approximate<> and Degrees<>. Angles go through the model's sincos and atan2,
+ * or through fromRadians(), which is where Degrees<> scales them; as for the
+ * sphere, geodToECEF also takes angles already reduced to a Quadrant<V>.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+template<typename V, typename Angle, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEF(
+	V * const x,
+	V * const y,
+	V * const z,
+	Angle const lon,
+	Angle const lat,
+	V const alt,
+	Model const &ellipsoid) noexcept
+{
+	auto const a2 = ellipsoid.semiMajorSq;
+	auto const b2 = ellipsoid.semiMinorSq;
+
+	V sin_lon, cos_lon, sin_lat, cos_lat;
+	sincos(lon, &sin_lon, &cos_lon, ellipsoid);
+	sincos(lat, &sin_lat, &cos_lat, ellipsoid);
+	auto const Nphi = divSqrt(V(a2), a2*cos_lat*cos_lat + b2*sin_lat*sin_lat, ellipsoid);
+	auto const Nphi_alt_cos_lat = (Nphi + alt)*cos_lat;
+	*x = Nphi_alt_cos_lat*cos_lon;
+	*y = Nphi_alt_cos_lat*sin_lon;
+	*z = (ellipsoid.axisRatioSq*Nphi + alt)*sin_lat;
+}
+
+/*
+ * Height above the ellipsoid of a point at distance p from the axis and z from
+ * the equator, given its latitude as an unnormalised pair s, c proportional to
+ * its sine and cosine.
+ * p*cos(lat) + z*sin(lat) - a^2/N equals p/cos(lat) - N, but is stationary in
+ * lat, so neither a small error in lat nor a small cos(lat) near the poles is
+ * amplified into the altitude. Normalising after the subtraction keeps the
+ * rounding of the normalisation out of the large terms that cancel.
+ */
+template<typename V, typename Model>
+inline
+V
+altitude(
+	V const p,
+	V const z,
+	V const s,
+	V const c,
+	Model const &ellipsoid) noexcept
+{
+	auto const r2 = s*s + c*c;
+	return (p*c + z*s - ellipsoid.semiMajor*sqrt(c*c + ellipsoid.axisRatioSq*(s*s)))*rsqrt(r2, ellipsoid);
+}
+
+/*
+ * Bowring: starting from the parametric latitude beta of the point itself,
+ * each step evaluates the latitude of the surface normal through the point at
+ * beta, then moves beta to that latitude. Sines and cosines are carried as
+ * unnormalised pairs, so the latitude comes out as num, den proportional to
+ * its sine and cosine, and only a caller wanting the angle needs an atan2.
+ */
+template<unsigned Iterations, typename V, typename Model>
+inline
+void
+bowring(
+	V * const num,
+	V * const den,
+	V const p,
+	V const z,
+	Model const &ellipsoid) noexcept
+{
+	static_assert(Iterations > 0, "BowringIterative needs at least one iteration");
+
+	auto const a = ellipsoid.semiMajor;
+	auto const b = ellipsoid.semiMinor;
+	auto const ep2b = ellipsoid.secondEccentricitySq*b;
+	auto const e2a = ellipsoid.eccentricitySq*a;
+
+	/* tan(beta) = a*z/(b*p) to start with, then (b/a)*tan(lat). */
+	auto sb = z*a;
+	auto cb = p*b;
+	for (auto i = 0u; i < Iterations; ++i) {
+		auto const inv_r = rsqrt(sb*sb + cb*cb, ellipsoid);
+		auto const sin_beta = sb*inv_r;
+		auto const cos_beta = cb*inv_r;
+		*num = z + ep2b*(sin_beta*sin_beta*sin_beta);
+		*den = p - e2a*(cos_beta*cos_beta*cos_beta);
+		sb = b*(*num);
+		cb = a*(*den);
+	}
+}
+
+template<unsigned Iterations, typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeod(
+	BowringIterative<Iterations>,
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &ellipsoid) noexcept
+{
+	auto const p = sqrt(x*x + y*y);
+	*lon = atan2(y, x, ellipsoid);
+
+	V num, den;
+	bowring<Iterations>(&num, &den, p, z, ellipsoid);
+	*lat = atan2(num, den, ellipsoid);
+	*alt = altitude(p, z, num, den, ellipsoid);
+}
+
+/* Steps before a lane is given up on; each about triples the correct digits. */
+constexpr unsigned maxBowringSteps = 8;
+
+/*
+ * Bowring, stepping until the error left is below tolerance. The error after
+ * a step is under 0.005 times the square of how far the step moved the
+ * parametric latitude, which moves within a third of a percent of the
+ * geodetic one, the first step included; later ones converge cubically. A
+ * lane is done once the square of its last move is below tolerance, a step
+ * earlier than waiting for a move that small. A lane that has converged keeps
+ * its num, den while the others step on, so its result does not depend on
+ * the points sharing its vector.
+ */
+template<typename V, typename Model>
+inline
+void
+bowring(
+	V * const num,
+	V * const den,
+	V const p,
+	V const z,
+	typename Model::value_type const tolerance,
+	Model const &ellipsoid) noexcept
+{
+	auto const a = ellipsoid.semiMajor;
+	auto const b = ellipsoid.semiMinor;
+	auto const ep2b = ellipsoid.secondEccentricitySq*b;
+	auto const e2a = ellipsoid.eccentricitySq*a;
+
+	auto sb = z*a;
+	auto cb = p*b;
+	auto inv_r = rsqrt(sb*sb + cb*cb, ellipsoid);
+	auto sin_beta = sb*inv_r;
+	auto cos_beta = cb*inv_r;
+	*num = z;
+	*den = p;
+	auto active = p == p;
+	for (auto i = 0u;;) {
+		*num = select(active, z + ep2b*(sin_beta*sin_beta*sin_beta), *num);
+		*den = select(active, p - e2a*(cos_beta*cos_beta*cos_beta), *den);
+		sb = b*(*num);
+		cb = a*(*den);
+		/* The sine of the move, squared, against the tolerance, without normalising. */
+		auto const r2 = sb*sb + cb*cb;
+		auto const cross = sb*cos_beta - cb*sin_beta;
+		active = active & (cross*cross > tolerance*r2);
+		if (!any(active) || ++i == maxBowringSteps)
+			break;
+		inv_r = rsqrt(r2, ellipsoid);
+		sin_beta = sb*inv_r;
+		cos_beta = cb*inv_r;
+	}
+}
+
+/*
+ * The tolerance is raised to a few ulps of the type, below which rounding
+ * would keep every lane stepping until maxBowringSteps.
+ */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeod(
+	BowringTolerance const algorithm,
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &ellipsoid) noexcept
+{
+	using T = typename Model::value_type;
+	auto const resolution = T(4)*std::numeric_limits<T>::epsilon();
+	auto const tolerance = T(algorithm.tolerance) > resolution ? T(algorithm.tolerance) : resolution;
+
+	auto const p = sqrt(x*x + y*y);
+	*lon = atan2(y, x, ellipsoid);
+
+	V num, den;
+	bowring(&num, &den, p, z, tolerance, ellipsoid);
+	*lat = atan2(num, den, ellipsoid);
+	*alt = altitude(p, z, num, den, ellipsoid);
+}
+
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeod(
+	Bowring,
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &ellipsoid) noexcept
+{
+	ecefToGeod(BowringIterative<1>(), lon, lat, alt, x, y, z, ellipsoid);
+}
+
+/*
+ * Vermeille (2002), "Direct transformation from geocentric coordinates to
+ * geodetic coordinates", J. Geodesy 76. Closed form through one cube root,
+ * valid outside the evolute, i.e. farther than ~43 km from the centre.
+ */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeod(
+	Vermeille,
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &ellipsoid) noexcept
+{
+	using T = typename Model::value_type;
+	auto const e2 = ellipsoid.eccentricitySq;
+	auto const e4 = e2*e2;
+	auto const inv_a2 = T(1)/ellipsoid.semiMajorSq;
+
+	auto const w2 = x*x + y*y;
+	auto const w = sqrt(w2);
+	*lon = fromRadians(atan2(y, x), ellipsoid);
+
+	auto const pp = w2*inv_a2;
+	auto const q = ((T(1) - e2)*inv_a2)*(z*z);
+	auto const r = (pp + q - e4)*(T(1)/T(6));
+	auto const s = e4*pp*q/(T(4)*r*r*r);
+	auto const t = cbrt(T(1) + s + sqrt(s*(T(2) + s)));
+	auto const u = r*(T(1) + t + T(1)/t);
+	auto const v = sqrt(u*u + e4*q);
+	auto const wv = e2*(u + v - q)/(T(2)*v);
+	auto const k = sqrt(u + v + wv*wv) - wv;
+	auto const D = k*w/(k + e2);
+	*lat = fromRadians(atan2(z, D), ellipsoid);
+	*alt = (k + e2 - T(1))/k*sqrt(D*D + z*z);
+}
+
+/*
+ * Olson (1996), "Converting Earth-centered, Earth-fixed coordinates to
+ * geodetic coordinates", IEEE Trans. Aerospace and Electronic Systems 32.
+ * A series for sin or cos of the latitude, whichever is better conditioned,
+ * and one Newton correction. Both branches are evaluated and blended.
+ */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeod(
+	Olson,
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &ellipsoid) noexcept
+{
+	using T = typename Model::value_type;
+	auto const a = ellipsoid.semiMajor;
+	auto const e2 = ellipsoid.eccentricitySq;
+	auto const a1 = a*e2;
+	auto const a2 = a1*a1;
+	auto const a3 = a1*e2/T(2);
+	auto const a4 = T(2.5)*a2;
+	auto const a5 = a1 + a3;
+	auto const a6 = T(1) - e2;
+
+	auto const zp = abs(z);
+	auto const w2 = x*x + y*y;
+	auto const w = sqrt(w2);
+	auto const r2 = w2 + z*z;
+	auto const r = sqrt(r2);
+	*lon = fromRadians(atan2(y, x), ellipsoid);
+
+	auto const s2 = z*z/r2;
+	auto const c2 = w2/r2;
+	auto const u0 = a2/r;
+	auto const v0 = a3 - a4/r;
+	auto const sa = (zp/r)*(T(1) + c2*(a1 + u0 + s2*v0)/r);
+	auto const cb = (w/r)*(T(1) - s2*(a5 - u0 - c2*v0)/r);
+	auto const steep = c2 > T(0.3);
+	auto const s = select(steep, sa, sqrt(max(T(1) - cb*cb, T(0))));
+	auto const c = select(steep, sqrt(max(T(1) - sa*sa, T(0))), cb);
+
+	auto const ss = s*s;
+	auto const g = T(1) - e2*ss;
+	auto const rg = a/sqrt(g);
+	auto const rf = a6*rg;
+	auto const u = w - rg*c;
+	auto const v = zp - rf*s;
+	auto const f = c*u + s*v;
+	auto const m = c*v - s*u;
+	auto const dlat = m/(rf/g + f);
+	auto const phi = atan2(s, c) + dlat;
+	*lat = fromRadians(select(z < T(0), -phi, phi), ellipsoid);
+	*alt = f + m*dlat/T(2);
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEFSoA(
+	S * const TERRA_RESTRICT x,
+	S * const TERRA_RESTRICT y,
+	S * const TERRA_RESTRICT z,
+	S const * const TERRA_RESTRICT lon,
+	S const * const TERRA_RESTRICT lat,
+	S const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vz;
+		geodToECEF(&vx, &vy, &vz, loadAs<T>(lon + i), loadAs<T>(lat + i), loadAs<T>(alt + i), ellipsoid);
+		storeAs(x + i, vx);
+		storeAs(y + i, vy);
+		storeAs(z + i, vz);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vx, vy, vz;
+		geodToECEF(&vx, &vy, &vz,
+			   loadPartialAs<T>(lon + i, rest), loadPartialAs<T>(lat + i, rest), loadPartialAs<T>(alt + i, rest),
+			   ellipsoid);
+		storePartialAs<T>(x + i, vx, rest);
+		storePartialAs<T>(y + i, vy, rest);
+		storePartialAs<T>(z + i, vz, rest);
+	}
+}
+
+template<typename Algorithm, typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeodSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt, loadAs<T>(x + i), loadAs<T>(y + i), loadAs<T>(z + i), ellipsoid);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt,
+			   loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest), loadPartialAs<T>(z + i, rest),
+			   ellipsoid);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+/*
+ * BowringTolerance with the caller's tolerance, which travels with the
+ * ellipsoid in model, as model.algorithm and model.ellipsoid, so the kernel
+ * has the signature the dispatch tables and runAoS expect.
+ */
+template<typename T, typename Model, typename S = T>
+inline
+void
+ecefToGeodToleranceSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		ecefToGeod(model.algorithm, &vlon, &vlat, &valt, loadAs<T>(x + i), loadAs<T>(y + i), loadAs<T>(z + i),
+			   model.ellipsoid);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		ecefToGeod(model.algorithm, &vlon, &vlat, &valt,
+			   loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest), loadPartialAs<T>(z + i, rest),
+			   model.ellipsoid);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+namespace trajectory {
+
+/*
+ * The largest step, in radians, taken from the last vector converted in full
+ * in either angle, about 6 km. One Newton step on the latitude leaves about
+ * 5e-3 of the square of the step, the next nothing, and the rotation of the
+ * sine and cosine between them a twenty-fourth of its fourth power.
+ */
+constexpr double maxStep = 1e-3;
+
+/*
+ * A point converted in full, which those near it are stepped from: its
+ * latitude's sine and cosine, and 1/W = 1/sqrt(1 - e^2 sin^2(lat)) with its
+ * first derivative and half its second in the latitude.
+ */
+template<typename V>
+struct Seed {
+	V x, y;
+	V lon, lat;
+	V sin_lat, cos_lat;
+	V inv_w, dinv_w, ddinv_w;
+};
+
+template<typename V, typename Model>
+inline
+Seed<V>
+seed(
+	V const x,
+	V const y,
+	V const lon,
+	V const lat,
+	Model const &ellipsoid) noexcept
+{
+	using T = typename Model::value_type;
+	auto const e2 = ellipsoid.eccentricitySq;
+
+	Seed<V> seed;
+	seed.x = x;
+	seed.y = y;
+	seed.lon = lon;
+	seed.lat = lat;
+	/* Normalised: the altitude of the points stepped from it scales with the norm. */
+	V sin_lat, cos_lat;
+	sincos(lat, &sin_lat, &cos_lat, ellipsoid);
+	auto const norm = rsqrt(sin_lat*sin_lat + cos_lat*cos_lat, ellipsoid);
+	auto const s = sin_lat*norm;
+	auto const c = cos_lat*norm;
+	seed.sin_lat = s;
+	seed.cos_lat = c;
+	auto const sc = s*c;
+	auto const c2s2 = c*c - s*s;
+	seed.inv_w = rsqrt(fma(V(-e2), s*s, V(T(1))), ellipsoid);
+	auto const inv_w2 = seed.inv_w*seed.inv_w;
+	auto const e2_inv_w3 = e2*(inv_w2*seed.inv_w);
+	seed.dinv_w = e2_inv_w3*sc;
+	seed.ddinv_w = T(0.5)*(e2_inv_w3*fma(3*e2*inv_w2, sc*sc, c2s2));
+	return seed;
+}
+
+/*
+ * One Newton step on the latitude of (p, z), from a nearby latitude with sine
+ * s, cosine c and 1/W given, in radians. The latitude is the zero of
+ * f = p s - z c - e^2 a s c/W, the cross product of the point with the surface
+ * normal; f' = p c + z s - e^2 a (c^2 - s^2 + e^2 s^4)/W^3.
+ */
+template<typename V, typename Model>
+inline
+V
+latitudeStep(
+	V const p,
+	V const z,
+	V const s,
+	V const c,
+	V const inv_w,
+	Model const &ellipsoid) noexcept
+{
+	auto const e2 = ellipsoid.eccentricitySq;
+	auto const e2a = e2*ellipsoid.semiMajor;
+
+	auto const s2 = s*s;
+	auto const f = p*s - z*c - e2a*(s*c*inv_w);
+	auto const df = p*c + z*s - e2a*(fma(V(e2), s2*s2, c*c - s2)*(inv_w*inv_w*inv_w));
+	return f/(-df);
+}
+
+/*
+ * A point near a seed: the longitude moves by the angle between the two in
+ * the equatorial plane, from its tangent, and the latitude by two Newton
+ * steps. The sine and cosine, rotated to third order by the first step, and
+ * 1/W, carried to second order, hold for the second, which leaves nothing of
+ * the first's error. With them normalised, the altitude is p c + z s - a W,
+ * stationary in the latitude as in altitude(); W enters it directly, so it is
+ * taken from the sine rather than carried. No sine, cosine or arc tangent is
+ * evaluated. Lanes whose steps are too long for the series are false in the
+ * returned mask.
+ */
+template<typename V, typename Model>
+inline
+auto
+ecefToGeodNear(
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Seed<V> const &seed,
+	Model const &ellipsoid) noexcept -> decltype(x < y)
+{
+	using T = typename Model::value_type;
+	auto const limit = V(T(maxStep));
+	auto const halfTurn = fromRadians(V(T(3.14159265358979323846)), ellipsoid);
+
+	auto const dot = seed.x*x + seed.y*y;
+	auto const t = (seed.x*y - seed.y*x)/dot;
+	auto const t2 = t*t;
+	auto const dlon = t*fma(t2, fma(t2, V(T(1.0/5)), V(T(-1.0/3))), V(T(1)));
+	auto l = seed.lon + fromRadians(dlon, ellipsoid);
+	l = select(l > halfTurn, l - (halfTurn + halfTurn), l);
+	*lon = select(l < -halfTurn, l + (halfTurn + halfTurn), l);
+
+	auto const p = sqrt(x*x + y*y);
+	auto const d = latitudeStep(p, z, seed.sin_lat, seed.cos_lat, seed.inv_w, ellipsoid);
+	auto const d2 = d*d;
+	auto const cos_d = fma(V(T(-0.5)), d2, V(T(1)));
+	auto const sin_d = d*fma(V(T(-1.0/6)), d2, V(T(1)));
+	auto const s = fma(seed.sin_lat, cos_d, seed.cos_lat*sin_d);
+	auto const c = fma(seed.cos_lat, cos_d, -(seed.sin_lat*sin_d));
+	auto const inv_w = fma(d, fma(d, seed.ddinv_w, seed.dinv_w), seed.inv_w);
+	*lat = seed.lat + fromRadians(d + latitudeStep(p, z, s, c, inv_w, ellipsoid), ellipsoid);
+	*alt = p*c + z*s - ellipsoid.semiMajor*sqrt(fma(V(-ellipsoid.eccentricitySq), s*s, V(T(1))));
+
+	return (dot > T(0)) & (abs(t) <= limit) & (abs(d) <= limit);
+}
+
+} // !namespace trajectory
+
+/*
+ * Points in order along a track: the first vector is converted with Algorithm,
+ * and each lane of the following ones starts from the same lane of it, until a
+ * vector has a lane out of reach; that one is converted in full and seeds the
+ * rest. Stepping from the seed rather than the previous vector leaves the
+ * vectors independent of each other, and the angles one addition away from a
+ * full conversion, so rounding never accumulates.
+ */
+template<typename Algorithm, typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeodTrajectorySoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	trajectory::Seed<V> seed;
+	auto seeded = false;
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		auto const vx = loadAs<T>(x + i);
+		auto const vy = loadAs<T>(y + i);
+		auto const vz = loadAs<T>(z + i);
+		V vlon, vlat, valt;
+		if (seeded && all(trajectory::ecefToGeodNear(&vlon, &vlat, &valt, vx, vy, vz, seed, ellipsoid))) {
+			storeAs(lon + i, vlon);
+			storeAs(lat + i, vlat);
+			storeAs(alt + i, valt);
+			continue;
+		}
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt, vx, vy, vz, ellipsoid);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+		seed = trajectory::seed(vx, vy, vlon, vlat, ellipsoid);
+		seeded = true;
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt,
+			   loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest), loadPartialAs<T>(z + i, rest),
+			   ellipsoid);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodToECEFAoS(
+	T * const TERRA_RESTRICT ecef,
+	T const * const TERRA_RESTRICT geodetic,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V lon, lat, alt, x, y, z;
+		loadu3(geodetic + 3*i, &lon, &lat, &alt);
+		geodToECEF(&x, &y, &z, lon, lat, alt, ellipsoid);
+		storeu3(ecef + 3*i, x, y, z);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V lon, lat, alt, x, y, z;
+		loadPartial3(geodetic + 3*i, rest, &lon, &lat, &alt);
+		geodToECEF(&x, &y, &z, lon, lat, alt, ellipsoid);
+		storePartial3(ecef + 3*i, rest, x, y, z);
+	}
+}
+
+template<typename Algorithm, typename T, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+ecefToGeodAoS(
+	T * const TERRA_RESTRICT geodetic,
+	T const * const TERRA_RESTRICT ecef,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V x, y, z, lon, lat, alt;
+		loadu3(ecef + 3*i, &x, &y, &z);
+		ecefToGeod(Algorithm(), &lon, &lat, &alt, x, y, z, ellipsoid);
+		storeu3(geodetic + 3*i, lon, lat, alt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V x, y, z, lon, lat, alt;
+		loadPartial3(ecef + 3*i, rest, &x, &y, &z);
+		ecefToGeod(Algorithm(), &lon, &lat, &alt, x, y, z, ellipsoid);
+		storePartial3(geodetic + 3*i, rest, lon, lat, alt);
+	}
+}
+
+template<typename T, typename Model>
+inline
+void
+ecefToGeodToleranceAoS(
+	T * const TERRA_RESTRICT geodetic,
+	T const * const TERRA_RESTRICT ecef,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V x, y, z, lon, lat, alt;
+		loadu3(ecef + 3*i, &x, &y, &z);
+		ecefToGeod(model.algorithm, &lon, &lat, &alt, x, y, z, model.ellipsoid);
+		storeu3(geodetic + 3*i, lon, lat, alt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V x, y, z, lon, lat, alt;
+		loadPartial3(ecef + 3*i, rest, &x, &y, &z);
+		ecefToGeod(model.algorithm, &lon, &lat, &alt, x, y, z, model.ellipsoid);
+		storePartial3(geodetic + 3*i, rest, lon, lat, alt);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_FixedImpl_hpp
+#define terra_impl_FixedImpl_hpp
+
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/impl/Simd.hpp>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/FixedKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+template<typename Coord, typename FixedCoord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodFixedToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	FixedCoord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	static_assert(!IsDegrees<Model>::value, "fixed-point coordinates have their own unit");
+	assert(toECEF && "toECEF is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using Fn = void (*)(T *, T *, T *, std::int32_t const *, std::int32_t const *, std::int32_t const *,
+			    std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodFixedToECEFSoA<T, Prepared>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toECEF->x[0], &toECEF->y[0], &toECEF->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, detail::prepare(model));
+}
+
+template<typename FixedCoord, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodFixedSoA(
+	FixedCoord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	static_assert(!IsDegrees<Model>::value, "fixed-point coordinates have their own unit");
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using Fn = void (*)(std::int32_t *, std::int32_t *, std::int32_t *, T const *, T const *, T const *,
+			    std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodFixedSoA<Bowring, T, Model>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, sphere);
+}
+
+template<typename Algorithm, typename FixedCoord, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodFixedSoA(
+	FixedCoord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	static_assert(!IsDegrees<Model>::value, "fixed-point coordinates have their own unit");
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Prepared = decltype(detail::prepare(ellipsoid));
+	using T = typename Prepared::value_type;
+	using Fn = void (*)(std::int32_t *, std::int32_t *, std::int32_t *, T const *, T const *, T const *,
+			    std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodFixedSoA<Algorithm, T, Prepared>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, detail::prepare(ellipsoid));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_FixedImpl_hpp
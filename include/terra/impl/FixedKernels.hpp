@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for geodetic coordinates in fixed point, expanded into every
+ * instruction set namespace by SimdForEach.hpp. The integers are decoded and
+ * encoded in registers around the sphere and ellipsoid per-point kernels.
+ * Angles come in already reduced: the whole number of 90 degree quadrants
+ * and the remainder are split off exactly from the integers, which float
+ * could not hold whole, and handed to sincos as a Quadrant<V>.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/* An angle of r radians plus q quarter turns, for |r| <= pi/4 and integral q. */
+template<typename V>
+struct Quadrant {
+	V r;
+	V q;
+};
+
+template<typename V, typename Model>
+inline
+void
+sincos(Quadrant<V> const x, V * const s, V * const c, Model const &model) noexcept
+{
+	sincosQuadrant(x.r, x.q, s, c, model);
+}
+
+namespace fixed {
+
+/* Units of 1e-7 degrees to radians, and back, as for Degrees<>. */
+template<typename V>
+inline
+V
+toRadians(V const hi, V const lo, float) noexcept
+{
+	return fma(hi, 1.7453292144864463e-09f, fma(lo, 1.7453292144864463e-09f, (hi + lo)*3.75078828363964e-17f));
+}
+
+template<typename V>
+inline
+V
+toRadians(V const hi, V const lo, double) noexcept
+{
+	return fma(hi, 1.7453292519943295e-09, fma(lo, 1.7453292519943295e-09, (hi + lo)*3.712570110175141e-26));
+}
+
+template<typename V>
+inline
+V
+fromRadians(V const x, float) noexcept
+{
+	return fma(x, 572957824.0f, x*-28.869176864624023f);
+}
+
+template<typename V>
+inline
+V
+fromRadians(V const x, double) noexcept
+{
+	return fma(x, 572957795.1308233, x*-4.58172845651402e-08);
+}
+
+/*
+ * hi - 900000000*q is exact even in float: both terms are multiples of 256
+ * and the difference is below 2^29. Only the conversion to radians rounds.
+ */
+template<typename T, typename V>
+inline
+Quadrant<V>
+angle(V const hi, V const lo) noexcept
+{
+	auto const q = round((hi + lo)*T(1.0/900000000.0));
+	return Quadrant<V>{ toRadians(fma(q, T(-900000000.0), hi), lo, T()), q };
+}
+
+template<typename T, typename V>
+inline
+V
+altitude(V const hi, V const lo) noexcept
+{
+	return fma(hi, T(0.001), lo*T(0.001));
+}
+
+/*
+ * Rounded to the nearest unit, saturating at the ends of the int32 range.
+ * NaN stays NaN in scalar, and storei() stores it as INT32_MIN; the vector
+ * max() returns its second operand for NaN, so they store INT32_MIN too.
+ */
+template<typename T, typename V>
+inline
+V
+units(V const x) noexcept
+{
+	auto const top = std::is_same<T, float>::value ? T(2147483520.0) : T(2147483647.0);
+	return min(max(round(x), V(T(-2147483648.0))), V(top));
+}
+
+template<typename T, typename V>
+inline
+void
+loadPartial(std::int32_t const * const p, std::size_t const n, V * const hi, V * const lo) noexcept
+{
+	std::int32_t buf[VecType<T>::width] = {};
+	std::memcpy(buf, p, n*sizeof *p);
+	loadi(buf, hi, lo);
+}
+
+template<typename T, typename V>
+inline
+void
+storePartial(std::int32_t * const p, V const v, std::size_t const n) noexcept
+{
+	std::int32_t buf[VecType<T>::width];
+	storei(buf, v);
+	std::memcpy(p, buf, n*sizeof *p);
+}
+
+} // !namespace fixed
+
+template<typename T, typename Model>
+inline
+void
+geodFixedToECEFSoA(
+	T * const TERRA_RESTRICT x,
+	T * const TERRA_RESTRICT y,
+	T * const TERRA_RESTRICT z,
+	std::int32_t const * const TERRA_RESTRICT lon,
+	std::int32_t const * const TERRA_RESTRICT lat,
+	std::int32_t const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V lonHi, lonLo, latHi, latLo, altHi, altLo, vx, vy, vz;
+		loadi(lon + i, &lonHi, &lonLo);
+		loadi(lat + i, &latHi, &latLo);
+		loadi(alt + i, &altHi, &altLo);
+		geodToECEF(&vx, &vy, &vz,
+			   fixed::angle<T>(lonHi, lonLo), fixed::angle<T>(latHi, latLo), fixed::altitude<T>(altHi, altLo),
+			   model);
+		storeu(x + i, vx);
+		storeu(y + i, vy);
+		storeu(z + i, vz);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V lonHi, lonLo, latHi, latLo, altHi, altLo, vx, vy, vz;
+		fixed::loadPartial<T>(lon + i, rest, &lonHi, &lonLo);
+		fixed::loadPartial<T>(lat + i, rest, &latHi, &latLo);
+		fixed::loadPartial<T>(alt + i, rest, &altHi, &altLo);
+		geodToECEF(&vx, &vy, &vz,
+			   fixed::angle<T>(lonHi, lonLo), fixed::angle<T>(latHi, latLo), fixed::altitude<T>(altHi, altLo),
+			   model);
+		storePartial(x + i, vx, rest);
+		storePartial(y + i, vy, rest);
+		storePartial(z + i, vz, rest);
+	}
+}
+
+template<typename Algorithm, typename T, typename Model>
+inline
+void
+ecefToGeodFixedSoA(
+	std::int32_t * const TERRA_RESTRICT lon,
+	std::int32_t * const TERRA_RESTRICT lat,
+	std::int32_t * const TERRA_RESTRICT alt,
+	T const * const TERRA_RESTRICT x,
+	T const * const TERRA_RESTRICT y,
+	T const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt, loadu(x + i), loadu(y + i), loadu(z + i), model);
+		storei(lon + i, fixed::units<T>(fixed::fromRadians(vlon, T())));
+		storei(lat + i, fixed::units<T>(fixed::fromRadians(vlat, T())));
+		storei(alt + i, fixed::units<T>(valt*T(1000)));
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt,
+			   loadPartial(x + i, rest), loadPartial(y + i, rest), loadPartial(z + i, rest),
+			   model);
+		fixed::storePartial<T>(lon + i, fixed::units<T>(fixed::fromRadians(vlon, T())), rest);
+		fixed::storePartial<T>(lat + i, fixed::units<T>(fixed::fromRadians(vlat, T())), rest);
+		fixed::storePartial<T>(alt + i, fixed::units<T>(valt*T(1000)), rest);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
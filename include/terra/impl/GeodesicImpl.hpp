@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_GeodesicImpl_hpp
+#define terra_impl_GeodesicImpl_hpp
+
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/impl/Simd.hpp>
+#include <limits>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/GeodesicKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+template<typename Geodesic, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicInverseSoA(
+	Geodesic * const TERRA_RESTRICT toGeodesic,
+	Coord const & TERRA_RESTRICT from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toGeodesic && "toGeodesic is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodesicInverseSoA<T, Prepared, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodesic->x[0], &toGeodesic->y[0], &toGeodesic->z[0],
+			&from.x[0], &from.y[0], &to.x[0], &to.y[0],
+			numCoords, detail::prepare(model));
+}
+
+template<typename Geodesic, typename Point, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicInverseOneToManySoA(
+	Geodesic * const TERRA_RESTRICT toGeodesic,
+	Point const &from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toGeodesic && "toGeodesic is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, T, T, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodesicInverseSoA<T, Prepared, S, T>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodesic->x[0], &toGeodesic->y[0], &toGeodesic->z[0],
+			T(from[0]), T(from[1]), &to.x[0], &to.y[0],
+			numCoords, detail::prepare(model));
+}
+
+template<typename S, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicDistanceSoA(
+	S * const TERRA_RESTRICT toDistance,
+	Coord const & TERRA_RESTRICT from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toDistance && "toDistance is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using Fn = void (*)(S *, S const *, S const *, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodesicDistanceSoA<T, Prepared, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			toDistance,
+			&from.x[0], &from.y[0], &to.x[0], &to.y[0],
+			numCoords, detail::prepare(model));
+}
+
+template<typename S, typename Point, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicDistanceOneToManySoA(
+	S * const TERRA_RESTRICT toDistance,
+	Point const &from,
+	Coord const & TERRA_RESTRICT to,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toDistance && "toDistance is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using Fn = void (*)(S *, T, T, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodesicDistanceSoA<T, Prepared, S, T>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			toDistance,
+			T(from[0]), T(from[1]), &to.x[0], &to.y[0],
+			numCoords, detail::prepare(model));
+}
+
+template<typename Coord, typename Geodesic, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodesicDirectSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Geodesic const & TERRA_RESTRICT geodesic,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, S const *, S const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodesicDirectSoA<T, Prepared, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			&geodesic.x[0], &geodesic.y[0],
+			numCoords, detail::prepare(model));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_GeodesicImpl_hpp
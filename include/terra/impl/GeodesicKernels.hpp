@@ -0,0 +1,516 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for the geodesic problems, expanded into every instruction set
+ * namespace by SimdForEach.hpp. On a sphere they are closed forms, the
+ * distance by the haversine. On an ellipsoid both are Vincenty's (1975)
+ * iterations on the auxiliary sphere. A lane leaves the iteration once its
+ * angle has converged: from then on it keeps the angle it converged at while
+ * the other lanes step on, and the vector leaves the loop when no lane is
+ * left. Every lane so gets exactly its own steps; the vector pays for its
+ * slowest lane only.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+namespace geodesic {
+
+/* Steps before a lane is given up on, nearly antipodal points taking hundreds. */
+constexpr unsigned maxIterations = 200;
+
+/* The change in the iterated angle, in radians, taken as converged. */
+template<typename T>
+inline
+constexpr T
+tolerance() noexcept
+{
+	return std::is_same<T, float>::value ? T(1e-6) : T(1e-12);
+}
+
+/*
+ * The reduced latitude U, tan(U) = (b/a)*tan(lat), as its sine and cosine,
+ * normalised from b*sin(lat) and a*cos(lat).
+ */
+template<typename V, typename Model>
+inline
+void
+reducedLatitude(V const lat, V * const sin_u, V * const cos_u, Model const &ellipsoid) noexcept
+{
+	auto const a = ellipsoid.semiMajor;
+	auto const b = ellipsoid.semiMinor;
+
+	V s, c;
+	sincos(lat, &s, &c, ellipsoid);
+	s = s*b;
+	c = c*a;
+	auto const inv_r = rsqrt(s*s + c*c, ellipsoid);
+	*sin_u = s*inv_r;
+	*cos_u = c*inv_r;
+}
+
+/* Vincenty's A and B, the series in u^2 = cos^2(alpha)*e'^2. */
+template<typename T, typename V>
+inline
+void
+series(V const u2, V * const A, V * const B) noexcept
+{
+	*A = fma(u2*T(1.0/16384.0), fma(u2, fma(u2, fma(u2, V(T(-175)), V(T(320))), V(T(-768))), V(T(4096))), V(T(1)));
+	*B = u2*T(1.0/1024.0)*fma(u2, fma(u2, fma(u2, V(T(-47)), V(T(74))), V(T(-128))), V(T(256)));
+}
+
+/* The difference between the arc on the auxiliary sphere and the scaled distance. */
+template<typename T, typename V>
+inline
+V
+deltaSigma(V const B, V const sin_sigma, V const cos_sigma, V const cos_2sigma_m) noexcept
+{
+	auto const c2 = cos_2sigma_m*cos_2sigma_m;
+	return B*sin_sigma*(cos_2sigma_m + B*T(0.25)*(cos_sigma*(T(2)*c2 - T(1)) -
+		B*T(1.0/6.0)*cos_2sigma_m*(T(4)*(sin_sigma*sin_sigma) - T(3))*(T(4)*c2 - T(3))));
+}
+
+/* The difference between the longitude on the ellipsoid and on the auxiliary sphere. */
+template<typename T, typename V>
+inline
+V
+deltaLambda(
+	T const f,
+	V const sin_alpha,
+	V const cos_sq_alpha,
+	V const sigma,
+	V const sin_sigma,
+	V const cos_sigma,
+	V const cos_2sigma_m) noexcept
+{
+	auto const C = f*T(1.0/16.0)*cos_sq_alpha*(T(4) + f*(T(4) - T(3)*cos_sq_alpha));
+	return (T(1) - C)*f*sin_alpha*(sigma + C*sin_sigma*(cos_2sigma_m + C*cos_sigma*(T(2)*(cos_2sigma_m*cos_2sigma_m) - T(1))));
+}
+
+/* x in radians, brought within a half turn either way. */
+template<typename T, typename V>
+inline
+V
+wrap(V const x) noexcept
+{
+	return fma(round(x*T(0.15915494309189533577)), V(T(-6.28318530717958647693)), x);
+}
+
+/*
+ * The start points of the lanes: from arrays, or the one point of a one-to-many
+ * call, broadcast.
+ */
+template<typename T, typename S>
+inline
+typename VecType<T>::type
+loadAt(S const * const p, std::size_t const i) noexcept
+{
+	return loadAs<T>(p + i);
+}
+
+template<typename T>
+inline
+typename VecType<T>::type
+loadAt(T const x, std::size_t) noexcept
+{
+	return typename VecType<T>::type(x);
+}
+
+/* The value to pad the missing lanes of a partial vector with. */
+template<typename T, typename S>
+inline
+T
+padding(S const * const) noexcept
+{
+	return T(0);
+}
+
+template<typename T>
+inline
+T
+padding(T const x) noexcept
+{
+	return x;
+}
+
+template<typename T, typename S>
+inline
+typename VecType<T>::type
+loadPartialAt(S const * const p, std::size_t const i, std::size_t const n) noexcept
+{
+	return loadPartialAs<T>(p + i, n);
+}
+
+template<typename T>
+inline
+typename VecType<T>::type
+loadPartialAt(T const x, std::size_t, std::size_t) noexcept
+{
+	return typename VecType<T>::type(x);
+}
+
+/* The first n lanes from the S at p, the rest fill. */
+template<typename T, typename S>
+inline
+typename VecType<T>::type
+loadPartialPadded(S const * const p, std::size_t const n, T const fill) noexcept
+{
+	S buf[VecType<T>::width];
+	for (auto &b : buf)
+		b = S(fill);
+	std::memcpy(buf, p, n*sizeof *p);
+	return loadAs<T>(buf);
+}
+
+} // !namespace geodesic
+
+/*
+ * The inverse problem: the distance between two points and the azimuths of the
+ * geodesic at both ends, each pointing towards the other point. Iterates on the
+ * longitude difference on the auxiliary sphere; lanes that do not converge get
+ * NaN.
+ */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodesicInverse(
+	V * const distance,
+	V * const azimuth1,
+	V * const azimuth2,
+	V const lon1,
+	V const lat1,
+	V const lon2,
+	V const lat2,
+	Model const &ellipsoid) noexcept
+{
+	using T = typename Model::value_type;
+	auto const &model = radians(ellipsoid);
+	auto const b = ellipsoid.semiMinor;
+	auto const f = T(1) - b/ellipsoid.semiMajor;
+	auto const ep2 = ellipsoid.secondEccentricitySq;
+
+	V sin_u1, cos_u1, sin_u2, cos_u2;
+	geodesic::reducedLatitude(lat1, &sin_u1, &cos_u1, ellipsoid);
+	geodesic::reducedLatitude(lat2, &sin_u2, &cos_u2, ellipsoid);
+	auto const sin_u1_sin_u2 = sin_u1*sin_u2;
+	auto const sin_u1_cos_u2 = sin_u1*cos_u2;
+	auto const cos_u1_sin_u2 = cos_u1*sin_u2;
+	auto const cos_u1_cos_u2 = cos_u1*cos_u2;
+	auto const L = geodesic::wrap<T>(toRadians(lon2 - lon1, ellipsoid));
+
+	auto lambda = L;
+	V sin_lambda, cos_lambda, sin_sigma, cos_sigma, sigma, cos_sq_alpha, cos_2sigma_m;
+	auto active = L == L;
+	for (auto i = 0u;;) {
+		sincos(lambda, &sin_lambda, &cos_lambda, model);
+		auto const p = cos_u2*sin_lambda;
+		auto const q = cos_u1_sin_u2 - sin_u1_cos_u2*cos_lambda;
+		sin_sigma = sqrt(p*p + q*q);
+		cos_sigma = sin_u1_sin_u2 + cos_u1_cos_u2*cos_lambda;
+		sigma = atan2(sin_sigma, cos_sigma, model);
+
+		/* Coincident points have no sigma to divide by, and equatorial lines no alpha. */
+		auto const sin_alpha = cos_u1_cos_u2*sin_lambda/select(sin_sigma > T(0), sin_sigma, V(T(1)));
+		cos_sq_alpha = T(1) - sin_alpha*sin_alpha;
+		auto const equatorial = cos_sq_alpha <= T(0);
+		cos_2sigma_m = select(equatorial, V(T(0)),
+				      cos_sigma - T(2)*sin_u1_sin_u2/select(equatorial, V(T(1)), cos_sq_alpha));
+		auto const next = L + geodesic::deltaLambda(f, sin_alpha, cos_sq_alpha, sigma, sin_sigma, cos_sigma,
+							    cos_2sigma_m);
+
+		active = active & (abs(next - lambda) > geodesic::tolerance<T>());
+		if (!any(active) || ++i == geodesic::maxIterations)
+			break;
+		lambda = select(active, next, lambda);
+	}
+
+	V A, B;
+	geodesic::series<T>(cos_sq_alpha*ep2, &A, &B);
+	auto const nan = V(std::numeric_limits<T>::quiet_NaN());
+	*distance = select(active, nan, b*A*(sigma - geodesic::deltaSigma<T>(B, sin_sigma, cos_sigma, cos_2sigma_m)));
+	*azimuth1 = select(active, nan,
+			   atan2(cos_u2*sin_lambda, cos_u1_sin_u2 - sin_u1_cos_u2*cos_lambda, ellipsoid));
+	*azimuth2 = select(active, nan,
+			   atan2(-cos_u1*sin_lambda, sin_u1_cos_u2 - cos_u1_sin_u2*cos_lambda, ellipsoid));
+}
+
+/*
+ * The direct problem: the point a distance along the geodesic leaving a point
+ * at an azimuth. Iterates on the arc on the auxiliary sphere, which converges
+ * within a few steps short of the antipode.
+ */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsEllipsoidModel<Model>::value>::type
+geodesicDirect(
+	V * const lon2,
+	V * const lat2,
+	V const lon1,
+	V const lat1,
+	V const distance,
+	V const azimuth,
+	Model const &ellipsoid) noexcept
+{
+	using T = typename Model::value_type;
+	auto const &model = radians(ellipsoid);
+	auto const b = ellipsoid.semiMinor;
+	auto const f = T(1) - b/ellipsoid.semiMajor;
+	auto const ep2 = ellipsoid.secondEccentricitySq;
+
+	V sin_u1, cos_u1, sin_alpha1, cos_alpha1;
+	geodesic::reducedLatitude(lat1, &sin_u1, &cos_u1, ellipsoid);
+	sincos(azimuth, &sin_alpha1, &cos_alpha1, ellipsoid);
+
+	/*
+	 * The arc sigma1 from the equator to the start, tan(sigma1) = tan(U1)/cos(alpha1),
+	 * is only needed doubled, as a sine and cosine: none along the equator.
+	 */
+	auto const p = sin_u1;
+	auto const q = cos_u1*cos_alpha1;
+	auto const r2 = p*p + q*q;
+	auto const along = r2 > T(0);
+	auto const inv_r2 = T(1)/select(along, r2, V(T(1)));
+	auto const sin_2sigma1 = select(along, T(2)*p*q*inv_r2, V(T(0)));
+	auto const cos_2sigma1 = select(along, (q*q - p*p)*inv_r2, V(T(1)));
+
+	auto const sin_alpha = cos_u1*sin_alpha1;
+	auto const cos_sq_alpha = T(1) - sin_alpha*sin_alpha;
+	V A, B;
+	geodesic::series<T>(cos_sq_alpha*ep2, &A, &B);
+	auto const sigma0 = distance/(b*A);
+
+	auto sigma = sigma0;
+	V sin_sigma, cos_sigma, cos_2sigma_m;
+	auto active = sigma == sigma;
+	for (auto i = 0u;;) {
+		sincos(sigma, &sin_sigma, &cos_sigma, model);
+		cos_2sigma_m = cos_2sigma1*cos_sigma - sin_2sigma1*sin_sigma;
+		auto const next = sigma0 + geodesic::deltaSigma<T>(B, sin_sigma, cos_sigma, cos_2sigma_m);
+
+		active = active & (abs(next - sigma) > geodesic::tolerance<T>());
+		if (!any(active) || ++i == geodesic::maxIterations)
+			break;
+		sigma = select(active, next, sigma);
+	}
+
+	auto const t = sin_u1*sin_sigma - cos_u1*cos_sigma*cos_alpha1;
+	auto const lambda = atan2(sin_sigma*sin_alpha1, cos_u1*cos_sigma - sin_u1*sin_sigma*cos_alpha1, model);
+	auto const L = lambda - geodesic::deltaLambda(f, sin_alpha, cos_sq_alpha, sigma, sin_sigma, cos_sigma, cos_2sigma_m);
+	auto const nan = V(std::numeric_limits<T>::quiet_NaN());
+	*lat2 = select(active, nan,
+		       atan2(sin_u1*cos_sigma + cos_u1*sin_sigma*cos_alpha1, (T(1) - f)*sqrt(sin_alpha*sin_alpha + t*t),
+			     ellipsoid));
+	*lon2 = select(active, nan, fromRadians(geodesic::wrap<T>(toRadians(lon1, ellipsoid) + L), ellipsoid));
+}
+
+/*
+ * The inverse problem on a sphere. The haversine keeps short distances exact,
+ * and the same half angles spare the azimuths the difference of two nearly
+ * equal products: cos(lat1)*sin(lat2) - sin(lat1)*cos(lat2)*cos(dlon) is
+ * sin(dlat) + 2*sin(lat1)*cos(lat2)*sin^2(dlon/2).
+ */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodesicInverse(
+	V * const distance,
+	V * const azimuth1,
+	V * const azimuth2,
+	V const lon1,
+	V const lat1,
+	V const lon2,
+	V const lat2,
+	Model const &sphere) noexcept
+{
+	using T = typename Model::value_type;
+	auto const &model = radians(sphere);
+	auto const r = sphere.radius;
+
+	V sin_lat1, cos_lat1, sin_lat2, cos_lat2, sin_hdlat, cos_hdlat, sin_hdlon, cos_hdlon;
+	sincos(lat1, &sin_lat1, &cos_lat1, sphere);
+	sincos(lat2, &sin_lat2, &cos_lat2, sphere);
+	sincos((lat2 - lat1)*T(0.5), &sin_hdlat, &cos_hdlat, sphere);
+	sincos((lon2 - lon1)*T(0.5), &sin_hdlon, &cos_hdlon, sphere);
+	auto const sin2_hdlon = sin_hdlon*sin_hdlon;
+	auto const h = min(fma(cos_lat1*cos_lat2, sin2_hdlon, sin_hdlat*sin_hdlat), V(T(1)));
+	*distance = T(2)*r*atan2(sqrt(h), sqrt(T(1) - h), model);
+
+	auto const sin_dlat = T(2)*sin_hdlat*cos_hdlat;
+	auto const sin_dlon = T(2)*sin_hdlon*cos_hdlon;
+	*azimuth1 = atan2(sin_dlon*cos_lat2, fma(T(2)*sin_lat1*cos_lat2, sin2_hdlon, sin_dlat), sphere);
+	*azimuth2 = atan2(-sin_dlon*cos_lat1, fma(T(2)*sin_lat2*cos_lat1, sin2_hdlon, -sin_dlat), sphere);
+}
+
+/* The direct problem on a sphere: the end point in the frame of the start, rotated. */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodesicDirect(
+	V * const lon2,
+	V * const lat2,
+	V const lon1,
+	V const lat1,
+	V const distance,
+	V const azimuth,
+	Model const &sphere) noexcept
+{
+	using T = typename Model::value_type;
+	auto const &model = radians(sphere);
+	auto const inv_r = T(1)/sphere.radius;
+
+	V sin_lat1, cos_lat1, sin_az, cos_az, sin_d, cos_d;
+	sincos(lat1, &sin_lat1, &cos_lat1, sphere);
+	sincos(azimuth, &sin_az, &cos_az, sphere);
+	sincos(distance*inv_r, &sin_d, &cos_d, model);
+
+	/* The end point as a unit vector: x towards the start's meridian, y east of it. */
+	auto const x = cos_lat1*cos_d - sin_lat1*sin_d*cos_az;
+	auto const y = sin_az*sin_d;
+	auto const z = sin_lat1*cos_d + cos_lat1*sin_d*cos_az;
+	*lat2 = atan2(z, sqrt(x*x + y*y), sphere);
+	*lon2 = fromRadians(geodesic::wrap<T>(toRadians(lon1, sphere) + atan2(y, x, model)), sphere);
+}
+
+/*
+ * The batch kernels take the start points as arrays, or as the one point of a
+ * one-to-many call: From is S const * or T. The missing lanes of the last
+ * vector are made coincident points, which need no iteration.
+ */
+template<typename T, typename Model, typename S = T, typename From = S const *>
+inline
+void
+geodesicInverseSoA(
+	S * const TERRA_RESTRICT distance,
+	S * const TERRA_RESTRICT azimuth1,
+	S * const TERRA_RESTRICT azimuth2,
+	From const lon1,
+	From const lat1,
+	S const * const TERRA_RESTRICT lon2,
+	S const * const TERRA_RESTRICT lat2,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vs, va1, va2;
+		geodesicInverse(&vs, &va1, &va2,
+				geodesic::loadAt<T>(lon1, i), geodesic::loadAt<T>(lat1, i),
+				loadAs<T>(lon2 + i), loadAs<T>(lat2 + i),
+				model);
+		storeAs(distance + i, vs);
+		storeAs(azimuth1 + i, va1);
+		storeAs(azimuth2 + i, va2);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vs, va1, va2;
+		geodesicInverse(&vs, &va1, &va2,
+				geodesic::loadPartialAt<T>(lon1, i, rest), geodesic::loadPartialAt<T>(lat1, i, rest),
+				geodesic::loadPartialPadded(lon2 + i, rest, geodesic::padding<T>(lon1)),
+				geodesic::loadPartialPadded(lat2 + i, rest, geodesic::padding<T>(lat1)),
+				model);
+		storePartialAs<T>(distance + i, vs, rest);
+		storePartialAs<T>(azimuth1 + i, va1, rest);
+		storePartialAs<T>(azimuth2 + i, va2, rest);
+	}
+}
+
+/* As above, the distances only; the azimuths are never computed. */
+template<typename T, typename Model, typename S = T, typename From = S const *>
+inline
+void
+geodesicDistanceSoA(
+	S * const TERRA_RESTRICT distance,
+	From const lon1,
+	From const lat1,
+	S const * const TERRA_RESTRICT lon2,
+	S const * const TERRA_RESTRICT lat2,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vs, va1, va2;
+		geodesicInverse(&vs, &va1, &va2,
+				geodesic::loadAt<T>(lon1, i), geodesic::loadAt<T>(lat1, i),
+				loadAs<T>(lon2 + i), loadAs<T>(lat2 + i),
+				model);
+		storeAs(distance + i, vs);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vs, va1, va2;
+		geodesicInverse(&vs, &va1, &va2,
+				geodesic::loadPartialAt<T>(lon1, i, rest), geodesic::loadPartialAt<T>(lat1, i, rest),
+				geodesic::loadPartialPadded(lon2 + i, rest, geodesic::padding<T>(lon1)),
+				geodesic::loadPartialPadded(lat2 + i, rest, geodesic::padding<T>(lat1)),
+				model);
+		storePartialAs<T>(distance + i, vs, rest);
+	}
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+void
+geodesicDirectSoA(
+	S * const TERRA_RESTRICT lon2,
+	S * const TERRA_RESTRICT lat2,
+	S * const TERRA_RESTRICT alt2,
+	S const * const TERRA_RESTRICT lon1,
+	S const * const TERRA_RESTRICT lat1,
+	S const * const TERRA_RESTRICT alt1,
+	S const * const TERRA_RESTRICT distance,
+	S const * const TERRA_RESTRICT azimuth,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat;
+		geodesicDirect(&vlon, &vlat,
+			       loadAs<T>(lon1 + i), loadAs<T>(lat1 + i), loadAs<T>(distance + i), loadAs<T>(azimuth + i),
+			       model);
+		storeAs(lon2 + i, vlon);
+		storeAs(lat2 + i, vlat);
+		storeAs(alt2 + i, loadAs<T>(alt1 + i));
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat;
+		geodesicDirect(&vlon, &vlat,
+			       loadPartialAs<T>(lon1 + i, rest), loadPartialAs<T>(lat1 + i, rest),
+			       loadPartialAs<T>(distance + i, rest), loadPartialAs<T>(azimuth + i, rest),
+			       model);
+		storePartialAs<T>(lon2 + i, vlon, rest);
+		storePartialAs<T>(lat2 + i, vlat, rest);
+		storePartialAs<T>(alt2 + i, loadPartialAs<T>(alt1 + i, rest), rest);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
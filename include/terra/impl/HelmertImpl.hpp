@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_HelmertImpl_hpp
+#define terra_impl_HelmertImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/impl/Simd.hpp>
+#include <type_traits>
+
+namespace terra {
+namespace detail {
+
+/* A transformation and the reference bodies on either side, passed as one. */
+template<typename T, typename From, typename To>
+struct DatumShift {
+	static_assert(std::is_same<typename From::value_type, T>::value &&
+		      std::is_same<typename To::value_type, T>::value,
+		      "the reference bodies must use the transformation's floating-point type");
+
+	Helmert<T> helmert;
+	From from;
+	To to;
+};
+
+template<typename T, typename From, typename To>
+inline
+auto
+datumShift(Helmert<T> const &helmert, From const from, To const to) noexcept
+	-> DatumShift<T, decltype(prepare(from)), decltype(prepare(to))>
+{
+	return DatumShift<T, decltype(prepare(from)), decltype(prepare(to))>{ helmert, prepare(from), prepare(to) };
+}
+
+} // !namespace detail
+} // !namespace terra
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/HelmertKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+template<typename T>
+inline
+Helmert<T>::Helmert(
+	T const tx,
+	T const ty,
+	T const tz,
+	T const rx,
+	T const ry,
+	T const rz,
+	T const scale,
+	HelmertConvention const convention) noexcept
+{
+	/* Arc-seconds to radians, with the sign of the position vector convention. */
+	auto const arcsec = (convention == HelmertConvention::PositionVector ? 1.0 : -1.0)*
+		3.14159265358979323846/(180.0*3600.0);
+	auto const s = double(scale)*1e-6;
+	auto const x = double(rx)*arcsec*(1.0 + s);
+	auto const y = double(ry)*arcsec*(1.0 + s);
+	auto const z = double(rz)*arcsec*(1.0 + s);
+
+	translation[0] = tx;
+	translation[1] = ty;
+	translation[2] = tz;
+	linear[0][0] = T(s);
+	linear[0][1] = T(-z);
+	linear[0][2] = T(y);
+	linear[1][0] = T(z);
+	linear[1][1] = T(s);
+	linear[1][2] = T(-x);
+	linear[2][0] = T(-y);
+	linear[2][1] = T(x);
+	linear[2][2] = T(s);
+}
+
+/*
+ * With M = I + L, the inverse is x = M^-1 (x' - t), so t^-1 = -M^-1 t and
+ * L^-1 = M^-1 - I = -M^-1 L, which keeps L^-1 as precise as L. M^-1 is the
+ * adjugate over the determinant, in long double.
+ */
+template<typename T>
+inline
+Helmert<T>
+inverse(Helmert<T> const &helmert) noexcept
+{
+	using L = long double;
+	L m[3][3];
+	for (auto i = 0; i < 3; ++i) {
+		for (auto j = 0; j < 3; ++j)
+			m[i][j] = L(helmert.linear[i][j]) + (i == j ? L(1) : L(0));
+	}
+	L adj[3][3];
+	for (auto i = 0; i < 3; ++i) {
+		for (auto j = 0; j < 3; ++j) {
+			auto const r0 = (j + 1)%3, r1 = (j + 2)%3, c0 = (i + 1)%3, c1 = (i + 2)%3;
+			adj[i][j] = m[r0][c0]*m[r1][c1] - m[r0][c1]*m[r1][c0];
+		}
+	}
+	auto const det = m[0][0]*adj[0][0] + m[0][1]*adj[1][0] + m[0][2]*adj[2][0];
+
+	Helmert<T> result(T(0), T(0), T(0), T(0), T(0), T(0), T(0));
+	for (auto i = 0; i < 3; ++i) {
+		L t = 0;
+		for (auto k = 0; k < 3; ++k)
+			t -= adj[i][k]*L(helmert.translation[k]);
+		result.translation[i] = T(t/det);
+		for (auto j = 0; j < 3; ++j) {
+			L l = 0;
+			for (auto k = 0; k < 3; ++k)
+				l -= adj[i][k]*L(helmert.linear[k][j]);
+			result.linear[i][j] = T(l/det);
+		}
+	}
+	return result;
+}
+
+/* The single coordinate functions run the scalar instance of the per-point kernels. */
+
+template<typename T, typename Coord>
+inline
+void
+helmert(
+	Coord * const coord,
+	Helmert<T> const &helmert) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T x, y, z;
+	simd::scalar::helmert<T>(&x, &y, &z, (*coord)[0], (*coord)[1], (*coord)[2], helmert);
+	(*coord)[0] = x;
+	(*coord)[1] = y;
+	(*coord)[2] = z;
+}
+
+template<typename T, typename Coord>
+inline
+void
+helmert(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Helmert<T> const &helmert) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	T x, y, z;
+	simd::scalar::helmert<T>(&x, &y, &z, fromECEF[0], fromECEF[1], fromECEF[2], helmert);
+	(*toECEF)[0] = x;
+	(*toECEF)[1] = y;
+	(*toECEF)[2] = z;
+}
+
+template<typename T, typename Coord>
+inline
+void
+helmertSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Helmert<T> const &helmert) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Helmert<T>);
+	TERRA_SIMD_TABLE(Fn, kernels, helmertSoA<T, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toECEF->x[0], &toECEF->y[0], &toECEF->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, helmert);
+}
+
+template<typename Algorithm, typename T, typename Coord, typename From, typename To>
+inline
+typename std::enable_if<(IsSphere<From>::value || IsEllipsoid<From>::value) &&
+			(IsSphere<To>::value || IsEllipsoid<To>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+datumTransform(
+	Coord * const coord,
+	Helmert<T> const &helmert,
+	From const from,
+	To const to) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T lon, lat, alt;
+	simd::scalar::datumTransform<Algorithm, T>(&lon, &lat, &alt, (*coord)[0], (*coord)[1], (*coord)[2],
+						   detail::datumShift(helmert, from, to));
+	(*coord)[0] = lon;
+	(*coord)[1] = lat;
+	(*coord)[2] = alt;
+}
+
+template<typename Algorithm, typename T, typename Coord, typename From, typename To>
+inline
+typename std::enable_if<(IsSphere<From>::value || IsEllipsoid<From>::value) &&
+			(IsSphere<To>::value || IsEllipsoid<To>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+datumTransform(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Helmert<T> const &helmert,
+	From const from,
+	To const to) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	T lon, lat, alt;
+	simd::scalar::datumTransform<Algorithm, T>(&lon, &lat, &alt, fromGeodetic[0], fromGeodetic[1], fromGeodetic[2],
+						   detail::datumShift(helmert, from, to));
+	(*toGeodetic)[0] = lon;
+	(*toGeodetic)[1] = lat;
+	(*toGeodetic)[2] = alt;
+}
+
+template<typename Algorithm, typename T, typename Coord, typename From, typename To>
+inline
+typename std::enable_if<(IsSphere<From>::value || IsEllipsoid<From>::value) &&
+			(IsSphere<To>::value || IsEllipsoid<To>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+datumTransformSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Helmert<T> const &helmert,
+	From const from,
+	To const to) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Shift = decltype(detail::datumShift(helmert, from, to));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Shift);
+	TERRA_SIMD_TABLE(Fn, kernels, datumTransformSoA<Algorithm, T, decltype(Shift::from), decltype(Shift::to), S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, detail::datumShift(helmert, from, to));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_HelmertImpl_hpp
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for Helmert<T>, expanded into every instruction set namespace
+ * by SimdForEach.hpp. The transformation is taken by value, so that its
+ * constants cannot alias the output arrays and stay in registers. The fused
+ * datum kernels chain the source body's geodToECEF, the transformation and
+ * the target body's ecefToGeod, keeping the ECEF coordinates in registers.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/* x' = x + t + L x, the small terms summed before the large one. */
+template<typename V, typename T>
+inline
+void
+helmert(
+	V * const x,
+	V * const y,
+	V * const z,
+	V const x0,
+	V const y0,
+	V const z0,
+	Helmert<T> const &helmert) noexcept
+{
+	auto const &l = helmert.linear;
+	*x = x0 + fma(x0, V(l[0][0]), fma(y0, V(l[0][1]), fma(z0, V(l[0][2]), V(helmert.translation[0]))));
+	*y = y0 + fma(x0, V(l[1][0]), fma(y0, V(l[1][1]), fma(z0, V(l[1][2]), V(helmert.translation[1]))));
+	*z = z0 + fma(x0, V(l[2][0]), fma(y0, V(l[2][1]), fma(z0, V(l[2][2]), V(helmert.translation[2]))));
+}
+
+template<typename T, typename S = T>
+inline
+void
+helmertSoA(
+	S * const TERRA_RESTRICT x,
+	S * const TERRA_RESTRICT y,
+	S * const TERRA_RESTRICT z,
+	S const * const TERRA_RESTRICT x0,
+	S const * const TERRA_RESTRICT y0,
+	S const * const TERRA_RESTRICT z0,
+	std::size_t const numCoords,
+	Helmert<T> const transformation) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vz;
+		helmert(&vx, &vy, &vz, loadAs<T>(x0 + i), loadAs<T>(y0 + i), loadAs<T>(z0 + i), transformation);
+		storeAs(x + i, vx);
+		storeAs(y + i, vy);
+		storeAs(z + i, vz);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vx, vy, vz;
+		helmert(&vx, &vy, &vz,
+			loadPartialAs<T>(x0 + i, rest), loadPartialAs<T>(y0 + i, rest), loadPartialAs<T>(z0 + i, rest),
+			transformation);
+		storePartialAs<T>(x + i, vx, rest);
+		storePartialAs<T>(y + i, vy, rest);
+		storePartialAs<T>(z + i, vz, rest);
+	}
+}
+
+template<typename Algorithm, typename V, typename T, typename From, typename To>
+inline
+void
+datumTransform(
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const lon0,
+	V const lat0,
+	V const alt0,
+	detail::DatumShift<T, From, To> const &shift) noexcept
+{
+	V x, y, z;
+	geodToECEF(&x, &y, &z, lon0, lat0, alt0, shift.from);
+	helmert(&x, &y, &z, x, y, z, shift.helmert);
+	ecefToGeod(Algorithm(), lon, lat, alt, x, y, z, shift.to);
+}
+
+template<typename Algorithm, typename T, typename From, typename To, typename S = T>
+inline
+void
+datumTransformSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT lon0,
+	S const * const TERRA_RESTRICT lat0,
+	S const * const TERRA_RESTRICT alt0,
+	std::size_t const numCoords,
+	detail::DatumShift<T, From, To> const shift) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		datumTransform<Algorithm>(&vlon, &vlat, &valt,
+					  loadAs<T>(lon0 + i), loadAs<T>(lat0 + i), loadAs<T>(alt0 + i), shift);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		datumTransform<Algorithm>(&vlon, &vlat, &valt,
+					  loadPartialAs<T>(lon0 + i, rest), loadPartialAs<T>(lat0 + i, rest),
+					  loadPartialAs<T>(alt0 + i, rest), shift);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,546 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_LocalFrameImpl_hpp
+#define terra_impl_LocalFrameImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/Transpose.hpp>
+#include <terra/impl/Simd.hpp>
+#include <cmath>
+#include <type_traits>
+
+namespace terra {
+namespace detail {
+
+/* A frame and the reference body of its geodetic coordinates, passed as one. */
+template<typename T, typename Model>
+struct FramedModel {
+	static_assert(std::is_same<typename Model::value_type, T>::value,
+		      "the reference body must use the frame's floating-point type");
+
+	LocalFrame<T> frame;
+	Model model;
+};
+
+template<typename T, typename Model>
+inline
+auto
+framedModel(LocalFrame<T> const &frame, Model const model) noexcept -> FramedModel<T, decltype(prepare(model))>
+{
+	return FramedModel<T, decltype(prepare(model))>{ frame, prepare(model) };
+}
+
+} // !namespace detail
+} // !namespace terra
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/LocalFrameKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+template<typename T>
+template<typename Model>
+inline
+LocalFrame<T>::LocalFrame(T const lon, T const lat, T const alt, Model const model) noexcept
+{
+	static_assert(std::is_same<typename Model::value_type, T>::value,
+		      "the reference body must use the frame's floating-point type");
+
+	T coord[3] = { lon, lat, alt };
+	geodToECEF(&coord, model);
+	origin[0] = coord[0];
+	origin[1] = coord[1];
+	origin[2] = coord[2];
+
+	/* Through the model, which knows whether lon and lat are in degrees. */
+	T sin_lon, cos_lon, sin_lat, cos_lat;
+	simd::scalar::sincos(lon, &sin_lon, &cos_lon, model);
+	simd::scalar::sincos(lat, &sin_lat, &cos_lat, model);
+	rotation[0][0] = -sin_lon;
+	rotation[0][1] = cos_lon;
+	rotation[0][2] = T(0);
+	rotation[1][0] = -sin_lat*cos_lon;
+	rotation[1][1] = -sin_lat*sin_lon;
+	rotation[1][2] = cos_lat;
+	rotation[2][0] = cos_lat*cos_lon;
+	rotation[2][1] = cos_lat*sin_lon;
+	rotation[2][2] = sin_lat;
+}
+
+namespace detail {
+
+/* The frame with its rows reordered to north, east and down. */
+template<typename T>
+inline
+LocalFrame<T>
+nedFrame(LocalFrame<T> const &frame) noexcept
+{
+	auto ned = frame;
+	for (auto j = 0; j < 3; ++j) {
+		ned.rotation[0][j] = frame.rotation[1][j];
+		ned.rotation[1][j] = frame.rotation[0][j];
+		ned.rotation[2][j] = -frame.rotation[2][j];
+	}
+	return ned;
+}
+
+} // !namespace detail
+
+/*
+ * The single coordinate functions run the scalar instance of the per-point
+ * kernels in LocalFrameKernels.hpp; NED is ENU with the axes swapped and up
+ * negated.
+ */
+
+template<typename T, typename Coord>
+inline
+void
+ecefToENU(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T e, n, u;
+	simd::scalar::ecefToLocal<T>(&e, &n, &u, (*coord)[0], (*coord)[1], (*coord)[2], frame);
+	(*coord)[0] = e;
+	(*coord)[1] = n;
+	(*coord)[2] = u;
+}
+
+template<typename T, typename Coord>
+inline
+void
+ecefToENU(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromECEF,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toENU && "toENU is nullptr");
+
+	T e, n, u;
+	simd::scalar::ecefToLocal<T>(&e, &n, &u, fromECEF[0], fromECEF[1], fromECEF[2], frame);
+	(*toENU)[0] = e;
+	(*toENU)[1] = n;
+	(*toENU)[2] = u;
+}
+
+template<typename T, typename Coord>
+inline
+void
+enuToECEF(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T x, y, z;
+	simd::scalar::localToECEF<T>(&x, &y, &z, (*coord)[0], (*coord)[1], (*coord)[2], frame);
+	(*coord)[0] = x;
+	(*coord)[1] = y;
+	(*coord)[2] = z;
+}
+
+template<typename T, typename Coord>
+inline
+void
+enuToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromENU,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	T x, y, z;
+	simd::scalar::localToECEF<T>(&x, &y, &z, fromENU[0], fromENU[1], fromENU[2], frame);
+	(*toECEF)[0] = x;
+	(*toECEF)[1] = y;
+	(*toECEF)[2] = z;
+}
+
+template<typename T, typename Coord>
+inline
+void
+ecefToNED(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T e, n, u;
+	simd::scalar::ecefToLocal<T>(&e, &n, &u, (*coord)[0], (*coord)[1], (*coord)[2], frame);
+	(*coord)[0] = n;
+	(*coord)[1] = e;
+	(*coord)[2] = -u;
+}
+
+template<typename T, typename Coord>
+inline
+void
+ecefToNED(
+	Coord * const TERRA_RESTRICT toNED,
+	Coord const & TERRA_RESTRICT fromECEF,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toNED && "toNED is nullptr");
+
+	T e, n, u;
+	simd::scalar::ecefToLocal<T>(&e, &n, &u, fromECEF[0], fromECEF[1], fromECEF[2], frame);
+	(*toNED)[0] = n;
+	(*toNED)[1] = e;
+	(*toNED)[2] = -u;
+}
+
+template<typename T, typename Coord>
+inline
+void
+nedToECEF(
+	Coord * const coord,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T x, y, z;
+	simd::scalar::localToECEF<T>(&x, &y, &z, (*coord)[1], (*coord)[0], -(*coord)[2], frame);
+	(*coord)[0] = x;
+	(*coord)[1] = y;
+	(*coord)[2] = z;
+}
+
+template<typename T, typename Coord>
+inline
+void
+nedToECEF(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromNED,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	T x, y, z;
+	simd::scalar::localToECEF<T>(&x, &y, &z, fromNED[1], fromNED[0], -fromNED[2], frame);
+	(*toECEF)[0] = x;
+	(*toECEF)[1] = y;
+	(*toECEF)[2] = z;
+}
+
+/*
+ * The batch functions run the same kernels for ENU and NED, the latter on a
+ * copy of the frame with the rotation rows reordered.
+ */
+
+template<typename T, typename Coord>
+inline
+void
+ecefToENUSoA(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toENU && "toENU is nullptr");
+
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, LocalFrame<T>);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToLocalSoA<T, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toENU->x[0], &toENU->y[0], &toENU->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, frame);
+}
+
+template<typename T, typename Coord>
+inline
+void
+enuToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, LocalFrame<T>);
+	TERRA_SIMD_TABLE(Fn, kernels, localToECEFSoA<T, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toECEF->x[0], &toECEF->y[0], &toECEF->z[0],
+			&fromENU.x[0], &fromENU.y[0], &fromENU.z[0],
+			numCoords, frame);
+}
+
+template<typename T, typename Coord>
+inline
+void
+ecefToNEDSoA(
+	Coord * const TERRA_RESTRICT toNED,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	ecefToENUSoA(toNED, fromECEF, numCoords, detail::nedFrame(frame));
+}
+
+template<typename T, typename Coord>
+inline
+void
+nedToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromNED,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	enuToECEFSoA(toECEF, fromNED, numCoords, detail::nedFrame(frame));
+}
+
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+ecefToENUAoS(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toENU && "toENU is nullptr");
+
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, LocalFrame<T>);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToLocalSoA<T>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, LocalFrame<T>);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, ecefToLocalAoS<T>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toENU, fromECEF, numCoords, frame);
+}
+
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+enuToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, LocalFrame<T>);
+	TERRA_SIMD_TABLE(Fn, kernels, localToECEFSoA<T>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, LocalFrame<T>);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, localToECEFAoS<T>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toECEF, fromENU, numCoords, frame);
+}
+
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+ecefToNEDAoS(
+	Coord * const TERRA_RESTRICT toNED,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	ecefToENUAoS(toNED, fromECEF, numCoords, detail::nedFrame(frame));
+}
+
+template<typename T, typename Coord, typename Coord2>
+inline
+void
+nedToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromNED,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame) noexcept
+{
+	enuToECEFAoS(toECEF, fromNED, numCoords, detail::nedFrame(frame));
+}
+
+/*
+ * The fused geodetic functions, like the single coordinate ones above, run the
+ * per-point kernels in scalar or through a dispatch table.
+ */
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENU(
+	Coord * const coord,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T e, n, u;
+	simd::scalar::geodToLocal<T>(&e, &n, &u, (*coord)[0], (*coord)[1], (*coord)[2], detail::framedModel(frame, model));
+	(*coord)[0] = e;
+	(*coord)[1] = n;
+	(*coord)[2] = u;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENU(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(toENU && "toENU is nullptr");
+
+	T e, n, u;
+	simd::scalar::geodToLocal<T>(&e, &n, &u, fromGeodetic[0], fromGeodetic[1], fromGeodetic[2],
+				     detail::framedModel(frame, model));
+	(*toENU)[0] = e;
+	(*toENU)[1] = n;
+	(*toENU)[2] = u;
+}
+
+template<typename Algorithm, typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeod(
+	Coord * const coord,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T lon, lat, alt;
+	simd::scalar::localToGeod<Algorithm, T>(&lon, &lat, &alt, (*coord)[0], (*coord)[1], (*coord)[2],
+						detail::framedModel(frame, model));
+	(*coord)[0] = lon;
+	(*coord)[1] = lat;
+	(*coord)[2] = alt;
+}
+
+template<typename Algorithm, typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromENU,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	T lon, lat, alt;
+	simd::scalar::localToGeod<Algorithm, T>(&lon, &lat, &alt, fromENU[0], fromENU[1], fromENU[2],
+						detail::framedModel(frame, model));
+	(*toGeodetic)[0] = lon;
+	(*toGeodetic)[1] = lat;
+	(*toGeodetic)[2] = alt;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENUSoA(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(toENU && "toENU is nullptr");
+
+	using Framed = decltype(detail::framedModel(frame, model));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Framed);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToLocalSoA<T, decltype(Framed::model), S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toENU->x[0], &toENU->y[0], &toENU->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, detail::framedModel(frame, model));
+}
+
+template<typename Algorithm, typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Framed = decltype(detail::framedModel(frame, model));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Framed);
+	TERRA_SIMD_TABLE(Fn, kernels, localToGeodSoA<Algorithm, T, decltype(Framed::model), S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromENU.x[0], &fromENU.y[0], &fromENU.z[0],
+			numCoords, detail::framedModel(frame, model));
+}
+
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToENUAoS(
+	Coord * const TERRA_RESTRICT toENU,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(toENU && "toENU is nullptr");
+
+	using Framed = decltype(detail::framedModel(frame, model));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Framed);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToLocalSoA<T, decltype(Framed::model)>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Framed);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, geodToLocalAoS<T, decltype(Framed::model)>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toENU, fromGeodetic, numCoords, detail::framedModel(frame, model));
+}
+
+template<typename Algorithm, typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<(IsSphere<Model>::value || IsEllipsoid<Model>::value) &&
+			IsEcefToGeodAlgorithm<Algorithm>::value>::type
+enuToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromENU,
+	std::size_t const numCoords,
+	LocalFrame<T> const &frame,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Framed = decltype(detail::framedModel(frame, model));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Framed);
+	TERRA_SIMD_TABLE(Fn, kernels, localToGeodSoA<Algorithm, T, decltype(Framed::model)>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Framed);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, localToGeodAoS<Algorithm, T, decltype(Framed::model)>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGeodetic, fromENU, numCoords, detail::framedModel(frame, model));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_LocalFrameImpl_hpp
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for LocalFrame<T>, expanded into every instruction set
+ * namespace by SimdForEach.hpp. The frame is taken by value, so that its
+ * constants cannot alias the output arrays and stay in registers. The fused
+ * geodetic kernels chain the per-point kernels of the reference body with the
+ * rotation, keeping the ECEF coordinates in registers. As for the bodies, the
+ * SoA kernels take arrays of another floating-point type S, converted in
+ * registers, and the AoS kernels take packed triples.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+template<typename V, typename T>
+inline
+void
+ecefToLocal(
+	V * const e,
+	V * const n,
+	V * const u,
+	V const x,
+	V const y,
+	V const z,
+	LocalFrame<T> const &frame) noexcept
+{
+	auto const &r = frame.rotation;
+	auto const dx = x - frame.origin[0];
+	auto const dy = y - frame.origin[1];
+	auto const dz = z - frame.origin[2];
+	*e = dx*r[0][0] + dy*r[0][1] + dz*r[0][2];
+	*n = dx*r[1][0] + dy*r[1][1] + dz*r[1][2];
+	*u = dx*r[2][0] + dy*r[2][1] + dz*r[2][2];
+}
+
+/* The inverse rotation is the transpose. */
+template<typename V, typename T>
+inline
+void
+localToECEF(
+	V * const x,
+	V * const y,
+	V * const z,
+	V const e,
+	V const n,
+	V const u,
+	LocalFrame<T> const &frame) noexcept
+{
+	auto const &r = frame.rotation;
+	*x = e*r[0][0] + n*r[1][0] + u*r[2][0] + frame.origin[0];
+	*y = e*r[0][1] + n*r[1][1] + u*r[2][1] + frame.origin[1];
+	*z = e*r[0][2] + n*r[1][2] + u*r[2][2] + frame.origin[2];
+}
+
+template<typename T, typename S = T>
+inline
+void
+ecefToLocalSoA(
+	S * const TERRA_RESTRICT e,
+	S * const TERRA_RESTRICT n,
+	S * const TERRA_RESTRICT u,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	LocalFrame<T> const frame) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V ve, vn, vu;
+		ecefToLocal(&ve, &vn, &vu, loadAs<T>(x + i), loadAs<T>(y + i), loadAs<T>(z + i), frame);
+		storeAs(e + i, ve);
+		storeAs(n + i, vn);
+		storeAs(u + i, vu);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V ve, vn, vu;
+		ecefToLocal(&ve, &vn, &vu,
+			    loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest), loadPartialAs<T>(z + i, rest),
+			    frame);
+		storePartialAs<T>(e + i, ve, rest);
+		storePartialAs<T>(n + i, vn, rest);
+		storePartialAs<T>(u + i, vu, rest);
+	}
+}
+
+template<typename T, typename S = T>
+inline
+void
+localToECEFSoA(
+	S * const TERRA_RESTRICT x,
+	S * const TERRA_RESTRICT y,
+	S * const TERRA_RESTRICT z,
+	S const * const TERRA_RESTRICT e,
+	S const * const TERRA_RESTRICT n,
+	S const * const TERRA_RESTRICT u,
+	std::size_t const numCoords,
+	LocalFrame<T> const frame) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vz;
+		localToECEF(&vx, &vy, &vz, loadAs<T>(e + i), loadAs<T>(n + i), loadAs<T>(u + i), frame);
+		storeAs(x + i, vx);
+		storeAs(y + i, vy);
+		storeAs(z + i, vz);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vx, vy, vz;
+		localToECEF(&vx, &vy, &vz,
+			    loadPartialAs<T>(e + i, rest), loadPartialAs<T>(n + i, rest), loadPartialAs<T>(u + i, rest),
+			    frame);
+		storePartialAs<T>(x + i, vx, rest);
+		storePartialAs<T>(y + i, vy, rest);
+		storePartialAs<T>(z + i, vz, rest);
+	}
+}
+
+template<typename V, typename T, typename Model>
+inline
+void
+geodToLocal(
+	V * const e,
+	V * const n,
+	V * const u,
+	V const lon,
+	V const lat,
+	V const alt,
+	detail::FramedModel<T, Model> const &fm) noexcept
+{
+	V x, y, z;
+	geodToECEF(&x, &y, &z, lon, lat, alt, fm.model);
+	ecefToLocal(e, n, u, x, y, z, fm.frame);
+}
+
+template<typename Algorithm, typename V, typename T, typename Model>
+inline
+void
+localToGeod(
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const e,
+	V const n,
+	V const u,
+	detail::FramedModel<T, Model> const &fm) noexcept
+{
+	V x, y, z;
+	localToECEF(&x, &y, &z, e, n, u, fm.frame);
+	ecefToGeod(Algorithm(), lon, lat, alt, x, y, z, fm.model);
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+void
+geodToLocalSoA(
+	S * const TERRA_RESTRICT e,
+	S * const TERRA_RESTRICT n,
+	S * const TERRA_RESTRICT u,
+	S const * const TERRA_RESTRICT lon,
+	S const * const TERRA_RESTRICT lat,
+	S const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	detail::FramedModel<T, Model> const fm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V ve, vn, vu;
+		geodToLocal(&ve, &vn, &vu, loadAs<T>(lon + i), loadAs<T>(lat + i), loadAs<T>(alt + i), fm);
+		storeAs(e + i, ve);
+		storeAs(n + i, vn);
+		storeAs(u + i, vu);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V ve, vn, vu;
+		geodToLocal(&ve, &vn, &vu,
+			    loadPartialAs<T>(lon + i, rest), loadPartialAs<T>(lat + i, rest), loadPartialAs<T>(alt + i, rest),
+			    fm);
+		storePartialAs<T>(e + i, ve, rest);
+		storePartialAs<T>(n + i, vn, rest);
+		storePartialAs<T>(u + i, vu, rest);
+	}
+}
+
+template<typename Algorithm, typename T, typename Model, typename S = T>
+inline
+void
+localToGeodSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT e,
+	S const * const TERRA_RESTRICT n,
+	S const * const TERRA_RESTRICT u,
+	std::size_t const numCoords,
+	detail::FramedModel<T, Model> const fm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		localToGeod<Algorithm>(&vlon, &vlat, &valt, loadAs<T>(e + i), loadAs<T>(n + i), loadAs<T>(u + i), fm);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		localToGeod<Algorithm>(&vlon, &vlat, &valt,
+				       loadPartialAs<T>(e + i, rest), loadPartialAs<T>(n + i, rest), loadPartialAs<T>(u + i, rest),
+				       fm);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+template<typename T>
+inline
+void
+ecefToLocalAoS(
+	T * const TERRA_RESTRICT local,
+	T const * const TERRA_RESTRICT ecef,
+	std::size_t const numCoords,
+	LocalFrame<T> const frame) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V x, y, z, e, n, u;
+		loadu3(ecef + 3*i, &x, &y, &z);
+		ecefToLocal(&e, &n, &u, x, y, z, frame);
+		storeu3(local + 3*i, e, n, u);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V x, y, z, e, n, u;
+		loadPartial3(ecef + 3*i, rest, &x, &y, &z);
+		ecefToLocal(&e, &n, &u, x, y, z, frame);
+		storePartial3(local + 3*i, rest, e, n, u);
+	}
+}
+
+template<typename T>
+inline
+void
+localToECEFAoS(
+	T * const TERRA_RESTRICT ecef,
+	T const * const TERRA_RESTRICT local,
+	std::size_t const numCoords,
+	LocalFrame<T> const frame) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V e, n, u, x, y, z;
+		loadu3(local + 3*i, &e, &n, &u);
+		localToECEF(&x, &y, &z, e, n, u, frame);
+		storeu3(ecef + 3*i, x, y, z);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V e, n, u, x, y, z;
+		loadPartial3(local + 3*i, rest, &e, &n, &u);
+		localToECEF(&x, &y, &z, e, n, u, frame);
+		storePartial3(ecef + 3*i, rest, x, y, z);
+	}
+}
+
+template<typename T, typename Model>
+inline
+void
+geodToLocalAoS(
+	T * const TERRA_RESTRICT local,
+	T const * const TERRA_RESTRICT geodetic,
+	std::size_t const numCoords,
+	detail::FramedModel<T, Model> const fm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V lon, lat, alt, e, n, u;
+		loadu3(geodetic + 3*i, &lon, &lat, &alt);
+		geodToLocal(&e, &n, &u, lon, lat, alt, fm);
+		storeu3(local + 3*i, e, n, u);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V lon, lat, alt, e, n, u;
+		loadPartial3(geodetic + 3*i, rest, &lon, &lat, &alt);
+		geodToLocal(&e, &n, &u, lon, lat, alt, fm);
+		storePartial3(local + 3*i, rest, e, n, u);
+	}
+}
+
+template<typename Algorithm, typename T, typename Model>
+inline
+void
+localToGeodAoS(
+	T * const TERRA_RESTRICT geodetic,
+	T const * const TERRA_RESTRICT local,
+	std::size_t const numCoords,
+	detail::FramedModel<T, Model> const fm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V e, n, u, lon, lat, alt;
+		loadu3(local + 3*i, &e, &n, &u);
+		localToGeod<Algorithm>(&lon, &lat, &alt, e, n, u, fm);
+		storeu3(geodetic + 3*i, lon, lat, alt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V e, n, u, lon, lat, alt;
+		loadPartial3(local + 3*i, rest, &e, &n, &u);
+		localToGeod<Algorithm>(&lon, &lat, &alt, e, n, u, fm);
+		storePartial3(geodetic + 3*i, rest, lon, lat, alt);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_ParallelImpl_hpp
+#define terra_impl_ParallelImpl_hpp
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+namespace terra {
+
+/* A thread's share of the loop, [begin, end), stolen from at the end. */
+struct ThreadPool::Range {
+	std::mutex mutex;
+	std::size_t begin = 0;
+	std::size_t end = 0;
+	char pad[64];	/* Keep neighbouring ranges off each other's cache line. */
+};
+
+inline
+ThreadPool::ThreadPool(unsigned const numThreads) :
+	invoke_(nullptr),
+	task_(nullptr),
+	generation_(0),
+	pending_(0),
+	stop_(false)
+{
+	auto n = numThreads ? numThreads : std::thread::hardware_concurrency();
+	if (n == 0)
+		n = 1;
+	for (auto i = 0u; i < n; ++i)
+		ranges_.emplace_back(new Range());
+	for (auto i = 1u; i < n; ++i)
+		threads_.emplace_back(&ThreadPool::loop, this, i);
+}
+
+inline
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (auto &thread : threads_)
+		thread.join();
+}
+
+template<typename Task>
+inline
+void
+ThreadPool::run(std::size_t const numTasks, Task const &task) noexcept
+{
+	if (numTasks == 0)
+		return;
+	if (threads_.empty() || numTasks == 1 || insideTask()) {
+		for (auto i = std::size_t(0); i < numTasks; ++i)
+			task(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> runLock(runMutex_);
+
+	auto const n = ranges_.size();
+	auto const share = numTasks/n;
+	auto const extra = numTasks%n;
+	auto begin = std::size_t(0);
+	for (auto i = std::size_t(0); i < n; ++i) {
+		auto const end = begin + share + (i < extra ? 1 : 0);
+		std::lock_guard<std::mutex> lock(ranges_[i]->mutex);
+		ranges_[i]->begin = begin;
+		ranges_[i]->end = end;
+		begin = end;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		invoke_ = [](void const * const t, std::size_t const i) {
+			(*static_cast<Task const *>(t))(i);
+		};
+		task_ = &task;
+		pending_ = static_cast<unsigned>(threads_.size());
+		++generation_;
+	}
+	wake_.notify_all();
+
+	insideTask() = true;
+	work(0);
+	insideTask() = false;
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+inline
+unsigned
+ThreadPool::size() const noexcept
+{
+	return static_cast<unsigned>(ranges_.size());
+}
+
+inline
+ThreadPool &
+ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+inline
+void
+ThreadPool::work(unsigned const self) noexcept
+{
+	auto &own = *ranges_[self];
+	for (;;) {
+		auto have = false;
+		auto i = std::size_t(0);
+		{
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (own.begin < own.end) {
+				i = own.begin++;
+				have = true;
+			}
+		}
+		if (have)
+			invoke_(task_, i);
+		else if (!steal(self))
+			return;
+	}
+}
+
+inline
+bool
+ThreadPool::steal(unsigned const self) noexcept
+{
+	auto const n = static_cast<unsigned>(ranges_.size());
+	for (auto k = 1u; k < n; ++k) {
+		auto &victim = *ranges_[(self + k)%n];
+		std::size_t begin, end;
+		{
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			auto const left = victim.end - victim.begin;
+			if (left == 0)
+				continue;
+			end = victim.end;
+			begin = end - (left + 1)/2;
+			victim.end = begin;
+		}
+		auto &own = *ranges_[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		own.begin = begin;
+		own.end = end;
+		return true;
+	}
+	return false;
+}
+
+inline
+void
+ThreadPool::loop(unsigned const self) noexcept
+{
+	insideTask() = true;
+	auto seen = 0ul;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+			if (stop_)
+				return;
+			seen = generation_;
+		}
+		work(self);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (--pending_ == 0)
+				done_.notify_one();
+		}
+	}
+}
+
+inline
+bool &
+ThreadPool::insideTask() noexcept
+{
+	static thread_local bool inside = false;
+	return inside;
+}
+
+template<typename Task>
+inline
+void
+SerialExecutor::run(std::size_t const numTasks, Task const &task) noexcept
+{
+	for (auto i = std::size_t(0); i < numTasks; ++i)
+		task(i);
+}
+
+namespace detail {
+
+/* A chunk of an SoA coordinate struct, as the SoA functions expect one. */
+template<typename T>
+struct SoAView {
+	T *x;
+	T *y;
+	T *z;
+};
+
+template<typename Coord>
+inline
+auto
+soaView(Coord const &coord, std::size_t const offset) noexcept
+	-> SoAView<typename std::remove_cv<typename std::remove_reference<decltype(coord.x[0])>::type>::type>
+{
+	using T = typename std::remove_cv<typename std::remove_reference<decltype(coord.x[0])>::type>::type;
+	return SoAView<T>{
+		const_cast<T *>(&coord.x[offset]),
+		const_cast<T *>(&coord.y[offset]),
+		const_cast<T *>(&coord.z[offset])
+	};
+}
+
+/* A chunk of an AoS coordinate array, as the AoS functions expect one. */
+template<typename Coord>
+struct AoSView {
+	auto operator[](std::size_t const i) const noexcept
+		-> decltype((*std::declval<Coord *>())[i])
+	{
+		return (*base)[offset + i];
+	}
+	Coord *base;
+	std::size_t offset;
+};
+
+/* A chunk of a packed array is packed too, so it keeps the shuffle kernels. */
+template<typename Coord, typename T>
+struct IsPackedAoS<AoSView<Coord>, T> : IsPackedAoS<typename std::remove_cv<Coord>::type, T> {};
+
+inline
+std::size_t
+numChunks(std::size_t const numCoords) noexcept
+{
+	return numCoords/parallelChunkSize + (numCoords%parallelChunkSize ? 1 : 0);
+}
+
+inline
+std::size_t
+chunkSize(std::size_t const chunk, std::size_t const numCoords) noexcept
+{
+	return std::min(parallelChunkSize, numCoords - chunk*parallelChunkSize);
+}
+
+/* Forward the algorithm to ellipsoids; spheres have just the one. */
+template<typename Algorithm, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	terra::ecefToGeodSoA<Algorithm>(toGeodetic, fromECEF, numCoords, model);
+}
+
+template<typename Algorithm, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	terra::ecefToGeodSoA(toGeodetic, fromECEF, numCoords, sphere);
+}
+
+template<typename Algorithm, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	terra::ecefToGeodAoS<Algorithm>(toGeodetic, fromECEF, numCoords, model);
+}
+
+template<typename Algorithm, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	terra::ecefToGeodAoS(toGeodetic, fromECEF, numCoords, sphere);
+}
+
+} // !namespace detail
+
+template<typename Executor, typename Coord, typename Model>
+inline
+void
+geodToECEFSoA(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	executor.run(detail::numChunks(numCoords), [&](std::size_t const chunk) {
+		auto const offset = chunk*parallelChunkSize;
+		auto to = detail::soaView(*toECEF, offset);
+		auto const from = detail::soaView(fromGeodetic, offset);
+		geodToECEFSoA(&to, from, detail::chunkSize(chunk, numCoords), model);
+	});
+}
+
+template<typename Executor, typename Coord, typename Coord2, typename Model>
+inline
+void
+geodToECEFAoS(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	executor.run(detail::numChunks(numCoords), [&](std::size_t const chunk) {
+		auto const offset = chunk*parallelChunkSize;
+		detail::AoSView<Coord> to{toECEF, offset};
+		detail::AoSView<Coord2 const> const from{&fromGeodetic, offset};
+		geodToECEFAoS(&to, from, detail::chunkSize(chunk, numCoords), model);
+	});
+}
+
+template<typename Algorithm, typename Executor, typename Coord, typename Model>
+inline
+void
+ecefToGeodSoA(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	executor.run(detail::numChunks(numCoords), [&](std::size_t const chunk) {
+		auto const offset = chunk*parallelChunkSize;
+		auto to = detail::soaView(*toGeodetic, offset);
+		auto const from = detail::soaView(fromECEF, offset);
+		detail::ecefToGeodSoA<Algorithm>(&to, from, detail::chunkSize(chunk, numCoords), model);
+	});
+}
+
+template<typename Algorithm, typename Executor, typename Coord, typename Coord2, typename Model>
+inline
+void
+ecefToGeodAoS(
+	Executor &executor,
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	executor.run(detail::numChunks(numCoords), [&](std::size_t const chunk) {
+		auto const offset = chunk*parallelChunkSize;
+		detail::AoSView<Coord> to{toGeodetic, offset};
+		detail::AoSView<Coord2 const> const from{&fromECEF, offset};
+		detail::ecefToGeodAoS<Algorithm>(&to, from, detail::chunkSize(chunk, numCoords), model);
+	});
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_ParallelImpl_hpp
@@ -0,0 +1,761 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_Simd_hpp
+#define terra_impl_Simd_hpp
+
+/*
+ * Thin vector types used by the batch kernels. Every instruction set gets its
+ * own namespace (scalar, sse2, sse42, avx2, avx512) exposing the same names:
+ * VecType<T> (with ::type, ::mask and ::width), arithmetic and comparison
+ * operators, select/any/all, loads and stores. Kernels are written once
+ * against these names and expanded into each namespace by SimdForEach.hpp.
+ */
+
+#include <terra/Arch.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#if defined(TERRA_SIMD_SSE2) || defined(TERRA_SIMD_SSE42) || \
+	defined(TERRA_SIMD_AVX2) || defined(TERRA_SIMD_AVX512)
+#include <immintrin.h>
+#endif
+
+namespace terra {
+
+/* Selects the approximate math in the kernels; see Approximate.hpp. */
+template<typename Model>
+struct Approximate;
+
+/* Selects angles in degrees in the kernels; see Degrees.hpp. */
+template<typename Model>
+struct Degrees;
+
+namespace simd {
+
+namespace scalar {
+
+template<typename T>
+struct VecType {
+	using type = T;
+	using mask = bool;
+	enum { width = 1 };
+};
+
+template<typename T>
+inline T loadu(T const * const p) noexcept { return *p; }
+template<typename T>
+inline void storeu(T * const p, T const v) noexcept { *p = v; }
+template<typename T>
+inline T loadPartial(T const * const p, std::size_t) noexcept { return *p; }
+template<typename T>
+inline void storePartial(T * const p, T const v, std::size_t) noexcept { *p = v; }
+template<typename T>
+inline void loadu3(T const * const p, T * const x, T * const y, T * const z) noexcept { *x = p[0]; *y = p[1]; *z = p[2]; }
+template<typename T>
+inline void storeu3(T * const p, T const x, T const y, T const z) noexcept { p[0] = x; p[1] = y; p[2] = z; }
+
+/* An int32 as its high and low 16 bits, each exact in T; lo is never negative. */
+template<typename T>
+inline
+void
+loadi(std::int32_t const * const p, T * const hi, T * const lo) noexcept
+{
+	auto const h = std::floor(double(*p)*(1.0/65536.0))*65536.0;
+	*hi = T(h);
+	*lo = T(double(*p) - h);
+}
+
+/* An integral value within the int32 range, as int32; NaN as INT32_MIN, as the vector conversions give it. */
+template<typename T>
+inline void storei(std::int32_t * const p, T const v) noexcept { *p = v == v ? static_cast<std::int32_t>(v) : INT32_MIN; }
+
+/* A value stored as S, float or double, in T, and back. */
+template<typename S, typename T>
+inline void loadConvert(S const * const p, T * const v) noexcept { *v = T(*p); }
+template<typename S, typename T>
+inline void storeConvert(S * const p, T const v) noexcept { *p = S(v); }
+
+inline bool any(bool const m) noexcept { return m; }
+inline bool all(bool const m) noexcept { return m; }
+inline float select(bool const m, float const a, float const b) noexcept { return m ? a : b; }
+inline double select(bool const m, double const a, double const b) noexcept { return m ? a : b; }
+
+inline float fma(float const a, float const b, float const c) noexcept { return a*b + c; }
+inline double fma(double const a, double const b, double const c) noexcept { return a*b + c; }
+inline float sqrt(float const a) noexcept { return std::sqrt(a); }
+inline double sqrt(double const a) noexcept { return std::sqrt(a); }
+inline float abs(float const a) noexcept { return std::abs(a); }
+inline double abs(double const a) noexcept { return std::abs(a); }
+inline float min(float const a, float const b) noexcept { return b < a ? b : a; }
+inline double min(double const a, double const b) noexcept { return b < a ? b : a; }
+inline float max(float const a, float const b) noexcept { return a < b ? b : a; }
+inline double max(double const a, double const b) noexcept { return a < b ? b : a; }
+inline float round(float const a) noexcept { return std::nearbyint(a); }
+inline double round(double const a) noexcept { return std::nearbyint(a); }
+inline float floor(float const a) noexcept { return std::floor(a); }
+inline double floor(double const a) noexcept { return std::floor(a); }
+
+inline
+void
+sincos(float const a, float * const s, float * const c) noexcept
+{
+	*s = std::sin(a);
+	*c = std::cos(a);
+}
+
+inline
+void
+sincos(double const a, double * const s, double * const c) noexcept
+{
+	*s = std::sin(a);
+	*c = std::cos(a);
+}
+
+/* sin and cos of r + q*pi/2, as the vector levels split them. */
+template<typename T>
+inline
+void
+sincosQuadrant(T const r, T const q, T * const s, T * const c) noexcept
+{
+	auto const sin_r = std::sin(r);
+	auto const cos_r = std::cos(r);
+	auto const m = q - T(4)*std::floor(q*T(0.25));
+	auto const swap = m == T(1) || m == T(3);
+	auto const sv = swap ? cos_r : sin_r;
+	auto const cv = swap ? sin_r : cos_r;
+	*s = m >= T(2) ? -sv : sv;
+	*c = m == T(1) || m == T(2) ? -cv : cv;
+}
+
+inline float atan2(float const y, float const x) noexcept { return std::atan2(y, x); }
+inline double atan2(double const y, double const x) noexcept { return std::atan2(y, x); }
+inline float rsqrt(float const a) noexcept { return 1.0f/std::sqrt(a); }
+inline double rsqrt(double const a) noexcept { return 1.0/std::sqrt(a); }
+inline float cbrt(float const a) noexcept { return std::cbrt(a); }
+inline double cbrt(double const a) noexcept { return std::cbrt(a); }
+inline float log(float const a) noexcept { return std::log(a); }
+inline double log(double const a) noexcept { return std::log(a); }
+inline float exp(float const a) noexcept { return std::exp(a); }
+inline double exp(double const a) noexcept { return std::exp(a); }
+inline float rsqrtEstimate(float const a) noexcept { return 1.0f/std::sqrt(a); }
+
+inline
+float
+frexp(float const a, float * const e) noexcept
+{
+	int i;
+	auto const m = std::frexp(a, &i);
+	*e = static_cast<float>(i);
+	return m;
+}
+
+inline
+double
+frexp(double const a, double * const e) noexcept
+{
+	int i;
+	auto const m = std::frexp(a, &i);
+	*e = static_cast<double>(i);
+	return m;
+}
+
+inline float ldexp(float const a, float const e) noexcept { return std::ldexp(a, static_cast<int>(e)); }
+inline double ldexp(double const a, double const e) noexcept { return std::ldexp(a, static_cast<int>(e)); }
+
+} // !namespace scalar
+
+} // !namespace simd
+} // !namespace terra
+
+#if defined(TERRA_SIMD_SSE2)
+TERRA_TARGET_BEGIN(TERRA_TARGET_SSE2)
+#define TERRA_SIMD_ISA sse2
+#define TERRA_SIMD_SSE41 0
+#include <terra/impl/SimdSSE.hpp>
+#undef TERRA_SIMD_SSE41
+#undef TERRA_SIMD_ISA
+TERRA_TARGET_END()
+#endif
+
+#if defined(TERRA_SIMD_SSE42)
+TERRA_TARGET_BEGIN(TERRA_TARGET_SSE42)
+#define TERRA_SIMD_ISA sse42
+#define TERRA_SIMD_SSE41 1
+#include <terra/impl/SimdSSE.hpp>
+#undef TERRA_SIMD_SSE41
+#undef TERRA_SIMD_ISA
+TERRA_TARGET_END()
+#endif
+
+#if defined(TERRA_SIMD_AVX2)
+TERRA_TARGET_BEGIN(TERRA_TARGET_AVX2)
+namespace terra {
+namespace simd {
+namespace avx2 {
+
+struct VecD {
+	VecD() = default;
+	VecD(__m256d const x) noexcept : v(x) {}
+	VecD(double const s) noexcept : v(_mm256_set1_pd(s)) {}
+	__m256d v;
+};
+
+struct MaskD {
+	__m256d v;
+};
+
+struct VecF {
+	VecF() = default;
+	VecF(__m256 const x) noexcept : v(x) {}
+	VecF(float const s) noexcept : v(_mm256_set1_ps(s)) {}
+	__m256 v;
+};
+
+struct MaskF {
+	__m256 v;
+};
+
+template<typename T>
+struct VecType;
+template<>
+struct VecType<double> {
+	using type = VecD;
+	using mask = MaskD;
+	enum { width = 4 };
+};
+template<>
+struct VecType<float> {
+	using type = VecF;
+	using mask = MaskF;
+	enum { width = 8 };
+};
+
+inline VecD operator+(VecD const a, VecD const b) noexcept { return _mm256_add_pd(a.v, b.v); }
+inline VecD operator-(VecD const a, VecD const b) noexcept { return _mm256_sub_pd(a.v, b.v); }
+inline VecD operator*(VecD const a, VecD const b) noexcept { return _mm256_mul_pd(a.v, b.v); }
+inline VecD operator/(VecD const a, VecD const b) noexcept { return _mm256_div_pd(a.v, b.v); }
+inline VecD operator-(VecD const a) noexcept { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+inline MaskD operator<(VecD const a, VecD const b) noexcept { return MaskD{_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+inline MaskD operator<=(VecD const a, VecD const b) noexcept { return MaskD{_mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ)}; }
+inline MaskD operator>(VecD const a, VecD const b) noexcept { return MaskD{_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+inline MaskD operator>=(VecD const a, VecD const b) noexcept { return MaskD{_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)}; }
+inline MaskD operator==(VecD const a, VecD const b) noexcept { return MaskD{_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+inline MaskD operator!=(VecD const a, VecD const b) noexcept { return MaskD{_mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ)}; }
+inline MaskD operator&(MaskD const a, MaskD const b) noexcept { return MaskD{_mm256_and_pd(a.v, b.v)}; }
+inline MaskD operator|(MaskD const a, MaskD const b) noexcept { return MaskD{_mm256_or_pd(a.v, b.v)}; }
+inline MaskD operator!(MaskD const a) noexcept { return MaskD{_mm256_xor_pd(a.v, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)))}; }
+inline bool any(MaskD const m) noexcept { return _mm256_movemask_pd(m.v) != 0; }
+inline bool all(MaskD const m) noexcept { return _mm256_movemask_pd(m.v) == 0xf; }
+inline VecD select(MaskD const m, VecD const a, VecD const b) noexcept { return _mm256_blendv_pd(b.v, a.v, m.v); }
+inline VecD fma(VecD const a, VecD const b, VecD const c) noexcept { return _mm256_fmadd_pd(a.v, b.v, c.v); }
+inline VecD sqrt(VecD const a) noexcept { return _mm256_sqrt_pd(a.v); }
+inline VecD abs(VecD const a) noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+inline VecD min(VecD const a, VecD const b) noexcept { return _mm256_min_pd(a.v, b.v); }
+inline VecD max(VecD const a, VecD const b) noexcept { return _mm256_max_pd(a.v, b.v); }
+inline VecD round(VecD const a) noexcept { return _mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecD floor(VecD const a) noexcept { return _mm256_floor_pd(a.v); }
+inline
+VecD
+frexp(VecD const a, VecD * const e) noexcept
+{
+	auto const bits = _mm256_castpd_si256(a.v);
+	auto const expMask = _mm256_set1_epi64x(0x7ff0000000000000ll);
+	auto const biased = _mm256_srli_epi64(_mm256_and_si256(bits, expMask), 52);
+	*e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(biased, _mm256_set1_epi64x(0x4330000000000000ll))),
+			   _mm256_set1_pd(4503599627370496.0 + 1022.0));
+	return _mm256_castsi256_pd(_mm256_or_si256(_mm256_andnot_si256(expMask, bits), _mm256_set1_epi64x(0x3fe0000000000000ll)));
+}
+
+inline
+VecD
+ldexp(VecD const a, VecD const e) noexcept
+{
+	auto const ei = _mm256_castpd_si256(_mm256_add_pd(e.v, _mm256_set1_pd(6755399441055744.0)));
+	return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(a.v), _mm256_slli_epi64(ei, 52)));
+}
+
+inline VecD loadu(double const * const p) noexcept { return _mm256_loadu_pd(p); }
+inline void storeu(double * const p, VecD const a) noexcept { _mm256_storeu_pd(p, a.v); }
+
+inline
+__m256i
+partialMaskD(std::size_t const n) noexcept
+{
+	return _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<long long>(n)), _mm256_setr_epi64x(0, 1, 2, 3));
+}
+
+inline VecD loadPartial(double const * const p, std::size_t const n) noexcept { return _mm256_maskload_pd(p, partialMaskD(n)); }
+inline void storePartial(double * const p, VecD const a, std::size_t const n) noexcept { _mm256_maskstore_pd(p, partialMaskD(n), a.v); }
+
+/*
+ * Four x, y, z triples from p, split into their components. Within each
+ * loaded vector the lanes holding one component never collide, so a blend
+ * of the three gathers them and a permute puts them in order.
+ */
+inline
+void
+loadu3(double const * const p, VecD * const x, VecD * const y, VecD * const z) noexcept
+{
+	auto const a = _mm256_loadu_pd(p);	/* x0 y0 z0 x1 */
+	auto const b = _mm256_loadu_pd(p + 4);	/* y1 z1 x2 y2 */
+	auto const c = _mm256_loadu_pd(p + 8);	/* z2 x3 y3 z3 */
+	*x = _mm256_permute4x64_pd(_mm256_blend_pd(_mm256_blend_pd(a, b, 0x4), c, 0x2), _MM_SHUFFLE(1, 2, 3, 0));
+	*y = _mm256_permute_pd(_mm256_blend_pd(_mm256_blend_pd(a, b, 0x9), c, 0x4), 0x5);
+	*z = _mm256_permute4x64_pd(_mm256_blend_pd(_mm256_blend_pd(a, b, 0x2), c, 0x9), _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+inline
+void
+storeu3(double * const p, VecD const x, VecD const y, VecD const z) noexcept
+{
+	auto const xs = _mm256_permute4x64_pd(x.v, _MM_SHUFFLE(1, 2, 3, 0));	/* x0 x3 x2 x1 */
+	auto const ys = _mm256_permute_pd(y.v, 0x5);				/* y1 y0 y3 y2 */
+	auto const zs = _mm256_permute4x64_pd(z.v, _MM_SHUFFLE(3, 0, 1, 2));	/* z2 z1 z0 z3 */
+	_mm256_storeu_pd(p, _mm256_blend_pd(_mm256_blend_pd(xs, ys, 0x2), zs, 0x4));
+	_mm256_storeu_pd(p + 4, _mm256_blend_pd(_mm256_blend_pd(ys, zs, 0x2), xs, 0x4));
+	_mm256_storeu_pd(p + 8, _mm256_blend_pd(_mm256_blend_pd(zs, xs, 0x2), ys, 0x4));
+}
+
+/* Four int32 as their high and low 16 bits, each exact in double. */
+inline
+void
+loadi(std::int32_t const * const p, VecD * const hi, VecD * const lo) noexcept
+{
+	auto const i = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+	auto const h = _mm_slli_epi32(_mm_srai_epi32(i, 16), 16);
+	*hi = _mm256_cvtepi32_pd(h);
+	*lo = _mm256_cvtepi32_pd(_mm_sub_epi32(i, h));
+}
+
+/* Integral values within the int32 range, as int32. */
+inline
+void
+storei(std::int32_t * const p, VecD const a) noexcept
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_cvtpd_epi32(a.v));
+}
+
+/* Doubles from floats, and back. */
+inline void loadConvert(double const * const p, VecD * const v) noexcept { *v = loadu(p); }
+inline void storeConvert(double * const p, VecD const a) noexcept { storeu(p, a); }
+inline void loadConvert(float const * const p, VecD * const v) noexcept { *v = _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+inline void storeConvert(float * const p, VecD const a) noexcept { _mm_storeu_ps(p, _mm256_cvtpd_ps(a.v)); }
+
+inline VecF operator+(VecF const a, VecF const b) noexcept { return _mm256_add_ps(a.v, b.v); }
+inline VecF operator-(VecF const a, VecF const b) noexcept { return _mm256_sub_ps(a.v, b.v); }
+inline VecF operator*(VecF const a, VecF const b) noexcept { return _mm256_mul_ps(a.v, b.v); }
+inline VecF operator/(VecF const a, VecF const b) noexcept { return _mm256_div_ps(a.v, b.v); }
+inline VecF operator-(VecF const a) noexcept { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+inline MaskF operator<(VecF const a, VecF const b) noexcept { return MaskF{_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline MaskF operator<=(VecF const a, VecF const b) noexcept { return MaskF{_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+inline MaskF operator>(VecF const a, VecF const b) noexcept { return MaskF{_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+inline MaskF operator>=(VecF const a, VecF const b) noexcept { return MaskF{_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+inline MaskF operator==(VecF const a, VecF const b) noexcept { return MaskF{_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)}; }
+inline MaskF operator!=(VecF const a, VecF const b) noexcept { return MaskF{_mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ)}; }
+inline MaskF operator&(MaskF const a, MaskF const b) noexcept { return MaskF{_mm256_and_ps(a.v, b.v)}; }
+inline MaskF operator|(MaskF const a, MaskF const b) noexcept { return MaskF{_mm256_or_ps(a.v, b.v)}; }
+inline MaskF operator!(MaskF const a) noexcept { return MaskF{_mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))}; }
+inline bool any(MaskF const m) noexcept { return _mm256_movemask_ps(m.v) != 0; }
+inline bool all(MaskF const m) noexcept { return _mm256_movemask_ps(m.v) == 0xff; }
+inline VecF select(MaskF const m, VecF const a, VecF const b) noexcept { return _mm256_blendv_ps(b.v, a.v, m.v); }
+inline VecF fma(VecF const a, VecF const b, VecF const c) noexcept { return _mm256_fmadd_ps(a.v, b.v, c.v); }
+inline VecF sqrt(VecF const a) noexcept { return _mm256_sqrt_ps(a.v); }
+inline VecF rsqrtEstimate(VecF const a) noexcept { return _mm256_rsqrt_ps(a.v); }
+inline VecF abs(VecF const a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+inline VecF min(VecF const a, VecF const b) noexcept { return _mm256_min_ps(a.v, b.v); }
+inline VecF max(VecF const a, VecF const b) noexcept { return _mm256_max_ps(a.v, b.v); }
+inline VecF round(VecF const a) noexcept { return _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecF floor(VecF const a) noexcept { return _mm256_floor_ps(a.v); }
+inline
+VecF
+frexp(VecF const a, VecF * const e) noexcept
+{
+	auto const bits = _mm256_castps_si256(a.v);
+	auto const expMask = _mm256_set1_epi32(0x7f800000);
+	auto const biased = _mm256_srli_epi32(_mm256_and_si256(bits, expMask), 23);
+	*e = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(biased, _mm256_set1_epi32(0x4b000000))),
+			   _mm256_set1_ps(8388608.0f + 126.0f));
+	return _mm256_castsi256_ps(_mm256_or_si256(_mm256_andnot_si256(expMask, bits), _mm256_set1_epi32(0x3f000000)));
+}
+
+inline
+VecF
+ldexp(VecF const a, VecF const e) noexcept
+{
+	auto const ei = _mm256_castps_si256(_mm256_add_ps(e.v, _mm256_set1_ps(12582912.0f)));
+	return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(a.v), _mm256_slli_epi32(ei, 23)));
+}
+
+inline VecF loadu(float const * const p) noexcept { return _mm256_loadu_ps(p); }
+inline void storeu(float * const p, VecF const a) noexcept { _mm256_storeu_ps(p, a.v); }
+
+inline
+__m256i
+partialMaskF(std::size_t const n) noexcept
+{
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+inline VecF loadPartial(float const * const p, std::size_t const n) noexcept { return _mm256_maskload_ps(p, partialMaskF(n)); }
+inline void storePartial(float * const p, VecF const a, std::size_t const n) noexcept { _mm256_maskstore_ps(p, partialMaskF(n), a.v); }
+
+/* Eight x, y, z triples from p, split into their components, as for double. */
+inline
+void
+loadu3(float const * const p, VecF * const x, VecF * const y, VecF * const z) noexcept
+{
+	auto const a = _mm256_loadu_ps(p);
+	auto const b = _mm256_loadu_ps(p + 8);
+	auto const c = _mm256_loadu_ps(p + 16);
+	*x = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(a, b, 0x92), c, 0x24),
+				      _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+	*y = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(a, b, 0x24), c, 0x49),
+				      _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6));
+	*z = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(a, b, 0x49), c, 0x92),
+				      _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+}
+
+inline
+void
+storeu3(float * const p, VecF const x, VecF const y, VecF const z) noexcept
+{
+	/* The inverse permutes, after which each store is a blend again. */
+	auto const xs = _mm256_permutevar8x32_ps(x.v, _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+	auto const ys = _mm256_permutevar8x32_ps(y.v, _mm256_setr_epi32(5, 0, 3, 6, 1, 4, 7, 2));
+	auto const zs = _mm256_permutevar8x32_ps(z.v, _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+	_mm256_storeu_ps(p, _mm256_blend_ps(_mm256_blend_ps(xs, ys, 0x92), zs, 0x24));
+	_mm256_storeu_ps(p + 8, _mm256_blend_ps(_mm256_blend_ps(xs, ys, 0x24), zs, 0x49));
+	_mm256_storeu_ps(p + 16, _mm256_blend_ps(_mm256_blend_ps(xs, ys, 0x49), zs, 0x92));
+}
+
+inline
+void
+loadi(std::int32_t const * const p, VecF * const hi, VecF * const lo) noexcept
+{
+	auto const i = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+	auto const h = _mm256_slli_epi32(_mm256_srai_epi32(i, 16), 16);
+	*hi = _mm256_cvtepi32_ps(h);
+	*lo = _mm256_cvtepi32_ps(_mm256_sub_epi32(i, h));
+}
+
+inline
+void
+storei(std::int32_t * const p, VecF const a) noexcept
+{
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm256_cvtps_epi32(a.v));
+}
+
+/* Floats from doubles, and back. */
+inline void loadConvert(float const * const p, VecF * const v) noexcept { *v = loadu(p); }
+inline void storeConvert(float * const p, VecF const a) noexcept { storeu(p, a); }
+
+inline
+void
+loadConvert(double const * const p, VecF * const v) noexcept
+{
+	*v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(p))),
+				  _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), 1);
+}
+
+inline
+void
+storeConvert(double * const p, VecF const a) noexcept
+{
+	_mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(a.v)));
+	_mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(a.v, 1)));
+}
+
+} // !namespace avx2
+} // !namespace simd
+} // !namespace terra
+TERRA_TARGET_END()
+#endif // TERRA_SIMD_AVX2
+
+#if defined(TERRA_SIMD_AVX512)
+TERRA_TARGET_BEGIN(TERRA_TARGET_AVX512)
+namespace terra {
+namespace simd {
+namespace avx512 {
+
+struct VecD {
+	VecD() = default;
+	VecD(__m512d const x) noexcept : v(x) {}
+	VecD(double const s) noexcept : v(_mm512_set1_pd(s)) {}
+	__m512d v;
+};
+
+struct MaskD {
+	__mmask8 m;
+};
+
+struct VecF {
+	VecF() = default;
+	VecF(__m512 const x) noexcept : v(x) {}
+	VecF(float const s) noexcept : v(_mm512_set1_ps(s)) {}
+	__m512 v;
+};
+
+struct MaskF {
+	__mmask16 m;
+};
+
+template<typename T>
+struct VecType;
+template<>
+struct VecType<double> {
+	using type = VecD;
+	using mask = MaskD;
+	enum { width = 8 };
+};
+template<>
+struct VecType<float> {
+	using type = VecF;
+	using mask = MaskF;
+	enum { width = 16 };
+};
+
+inline VecD operator+(VecD const a, VecD const b) noexcept { return _mm512_add_pd(a.v, b.v); }
+inline VecD operator-(VecD const a, VecD const b) noexcept { return _mm512_sub_pd(a.v, b.v); }
+inline VecD operator*(VecD const a, VecD const b) noexcept { return _mm512_mul_pd(a.v, b.v); }
+inline VecD operator/(VecD const a, VecD const b) noexcept { return _mm512_div_pd(a.v, b.v); }
+inline VecD operator-(VecD const a) noexcept { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a.v), _mm512_set1_epi64(0x8000000000000000ll))); }
+inline MaskD operator<(VecD const a, VecD const b) noexcept { return MaskD{_mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ)}; }
+inline MaskD operator<=(VecD const a, VecD const b) noexcept { return MaskD{_mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ)}; }
+inline MaskD operator>(VecD const a, VecD const b) noexcept { return MaskD{_mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ)}; }
+inline MaskD operator>=(VecD const a, VecD const b) noexcept { return MaskD{_mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ)}; }
+inline MaskD operator==(VecD const a, VecD const b) noexcept { return MaskD{_mm512_cmp_pd_mask(a.v, b.v, _CMP_EQ_OQ)}; }
+inline MaskD operator!=(VecD const a, VecD const b) noexcept { return MaskD{_mm512_cmp_pd_mask(a.v, b.v, _CMP_NEQ_UQ)}; }
+inline MaskD operator&(MaskD const a, MaskD const b) noexcept { return MaskD{static_cast<__mmask8>(a.m & b.m)}; }
+inline MaskD operator|(MaskD const a, MaskD const b) noexcept { return MaskD{static_cast<__mmask8>(a.m | b.m)}; }
+inline MaskD operator!(MaskD const a) noexcept { return MaskD{static_cast<__mmask8>(~a.m)}; }
+inline bool any(MaskD const m) noexcept { return m.m != 0; }
+inline bool all(MaskD const m) noexcept { return m.m == 0xff; }
+inline VecD select(MaskD const m, VecD const a, VecD const b) noexcept { return _mm512_mask_blend_pd(m.m, b.v, a.v); }
+inline VecD fma(VecD const a, VecD const b, VecD const c) noexcept { return _mm512_fmadd_pd(a.v, b.v, c.v); }
+inline VecD sqrt(VecD const a) noexcept { return _mm512_maskz_sqrt_pd(0xff, a.v); }
+inline VecD abs(VecD const a) noexcept { return _mm512_abs_pd(a.v); }
+inline VecD min(VecD const a, VecD const b) noexcept { return _mm512_maskz_min_pd(0xff, a.v, b.v); }
+inline VecD max(VecD const a, VecD const b) noexcept { return _mm512_maskz_max_pd(0xff, a.v, b.v); }
+inline VecD round(VecD const a) noexcept { return _mm512_maskz_roundscale_pd(0xff, a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecD floor(VecD const a) noexcept { return _mm512_maskz_roundscale_pd(0xff, a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline VecD frexp(VecD const a, VecD * const e) noexcept { *e = VecD(_mm512_maskz_getexp_pd(0xff, a.v)) + 1.0; return _mm512_maskz_getmant_pd(0xff, a.v, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src); }
+inline VecD ldexp(VecD const a, VecD const e) noexcept { return _mm512_maskz_scalef_pd(0xff, a.v, e.v); }
+inline VecD loadu(double const * const p) noexcept { return _mm512_loadu_pd(p); }
+inline void storeu(double * const p, VecD const a) noexcept { _mm512_storeu_pd(p, a.v); }
+inline VecD loadPartial(double const * const p, std::size_t const n) noexcept { return _mm512_maskz_loadu_pd(static_cast<__mmask8>((1u << n) - 1u), p); }
+inline void storePartial(double * const p, VecD const a, std::size_t const n) noexcept { _mm512_mask_storeu_pd(p, static_cast<__mmask8>((1u << n) - 1u), a.v); }
+
+/*
+ * Eight x, y, z triples from p, split into their components: each component
+ * takes what it can from the first two vectors, then the rest from the third.
+ */
+inline
+void
+loadu3(double const * const p, VecD * const x, VecD * const y, VecD * const z) noexcept
+{
+	auto const a = _mm512_loadu_pd(p);
+	auto const b = _mm512_loadu_pd(p + 8);
+	auto const c = _mm512_loadu_pd(p + 16);
+	*x = _mm512_permutex2var_pd(_mm512_permutex2var_pd(a, _mm512_setr_epi64(0, 3, 6, 9, 12, 15, 0, 0), b),
+				      _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 10, 13), c);
+	*y = _mm512_permutex2var_pd(_mm512_permutex2var_pd(a, _mm512_setr_epi64(1, 4, 7, 10, 13, 0, 0, 0), b),
+				      _mm512_setr_epi64(0, 1, 2, 3, 4, 8, 11, 14), c);
+	*z = _mm512_permutex2var_pd(_mm512_permutex2var_pd(a, _mm512_setr_epi64(2, 5, 8, 11, 14, 0, 0, 0), b),
+				      _mm512_setr_epi64(0, 1, 2, 3, 4, 9, 12, 15), c);
+}
+
+inline
+void
+storeu3(double * const p, VecD const x, VecD const y, VecD const z) noexcept
+{
+	_mm512_storeu_pd(p, _mm512_permutex2var_pd(_mm512_permutex2var_pd(x.v, _mm512_setr_epi64(0, 8, 0, 1, 9, 0, 2, 10), y.v),
+						   _mm512_setr_epi64(0, 1, 8, 3, 4, 9, 6, 7), z.v));
+	_mm512_storeu_pd(p + 8, _mm512_permutex2var_pd(_mm512_permutex2var_pd(x.v, _mm512_setr_epi64(0, 3, 11, 0, 4, 12, 0, 5), y.v),
+						   _mm512_setr_epi64(10, 1, 2, 11, 4, 5, 12, 7), z.v));
+	_mm512_storeu_pd(p + 16, _mm512_permutex2var_pd(_mm512_permutex2var_pd(x.v, _mm512_setr_epi64(13, 0, 6, 14, 0, 7, 15, 0), y.v),
+						   _mm512_setr_epi64(0, 13, 2, 3, 14, 5, 6, 15), z.v));
+}
+
+/* Eight int32 as their high and low 16 bits, each exact in double. */
+inline
+void
+loadi(std::int32_t const * const p, VecD * const hi, VecD * const lo) noexcept
+{
+	auto const i = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+	auto const h = _mm256_slli_epi32(_mm256_srai_epi32(i, 16), 16);
+	*hi = _mm512_maskz_cvtepi32_pd(0xff, h);
+	*lo = _mm512_maskz_cvtepi32_pd(0xff, _mm256_sub_epi32(i, h));
+}
+
+/* Integral values within the int32 range, as int32. */
+inline
+void
+storei(std::int32_t * const p, VecD const a) noexcept
+{
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_maskz_cvtpd_epi32(0xff, a.v));
+}
+
+/* Doubles from floats, and back. */
+inline void loadConvert(double const * const p, VecD * const v) noexcept { *v = loadu(p); }
+inline void storeConvert(double * const p, VecD const a) noexcept { storeu(p, a); }
+inline void loadConvert(float const * const p, VecD * const v) noexcept { *v = _mm512_maskz_cvtps_pd(0xff, _mm256_loadu_ps(p)); }
+inline void storeConvert(float * const p, VecD const a) noexcept { _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(0xff, a.v)); }
+
+inline VecF operator+(VecF const a, VecF const b) noexcept { return _mm512_add_ps(a.v, b.v); }
+inline VecF operator-(VecF const a, VecF const b) noexcept { return _mm512_sub_ps(a.v, b.v); }
+inline VecF operator*(VecF const a, VecF const b) noexcept { return _mm512_mul_ps(a.v, b.v); }
+inline VecF operator/(VecF const a, VecF const b) noexcept { return _mm512_div_ps(a.v, b.v); }
+inline VecF operator-(VecF const a) noexcept { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(static_cast<int>(0x80000000u)))); }
+inline MaskF operator<(VecF const a, VecF const b) noexcept { return MaskF{_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)}; }
+inline MaskF operator<=(VecF const a, VecF const b) noexcept { return MaskF{_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)}; }
+inline MaskF operator>(VecF const a, VecF const b) noexcept { return MaskF{_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)}; }
+inline MaskF operator>=(VecF const a, VecF const b) noexcept { return MaskF{_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)}; }
+inline MaskF operator==(VecF const a, VecF const b) noexcept { return MaskF{_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)}; }
+inline MaskF operator!=(VecF const a, VecF const b) noexcept { return MaskF{_mm512_cmp_ps_mask(a.v, b.v, _CMP_NEQ_UQ)}; }
+inline MaskF operator&(MaskF const a, MaskF const b) noexcept { return MaskF{static_cast<__mmask16>(a.m & b.m)}; }
+inline MaskF operator|(MaskF const a, MaskF const b) noexcept { return MaskF{static_cast<__mmask16>(a.m | b.m)}; }
+inline MaskF operator!(MaskF const a) noexcept { return MaskF{static_cast<__mmask16>(~a.m)}; }
+inline bool any(MaskF const m) noexcept { return m.m != 0; }
+inline bool all(MaskF const m) noexcept { return m.m == 0xffff; }
+inline VecF select(MaskF const m, VecF const a, VecF const b) noexcept { return _mm512_mask_blend_ps(m.m, b.v, a.v); }
+inline VecF fma(VecF const a, VecF const b, VecF const c) noexcept { return _mm512_fmadd_ps(a.v, b.v, c.v); }
+inline VecF sqrt(VecF const a) noexcept { return _mm512_maskz_sqrt_ps(0xffff, a.v); }
+inline VecF rsqrtEstimate(VecF const a) noexcept { return _mm512_maskz_rsqrt14_ps(0xffff, a.v); }
+inline VecF abs(VecF const a) noexcept { return _mm512_abs_ps(a.v); }
+inline VecF min(VecF const a, VecF const b) noexcept { return _mm512_maskz_min_ps(0xffff, a.v, b.v); }
+inline VecF max(VecF const a, VecF const b) noexcept { return _mm512_maskz_max_ps(0xffff, a.v, b.v); }
+inline VecF round(VecF const a) noexcept { return _mm512_maskz_roundscale_ps(0xffff, a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecF floor(VecF const a) noexcept { return _mm512_maskz_roundscale_ps(0xffff, a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline VecF frexp(VecF const a, VecF * const e) noexcept { *e = VecF(_mm512_maskz_getexp_ps(0xffff, a.v)) + 1.0f; return _mm512_maskz_getmant_ps(0xffff, a.v, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src); }
+inline VecF ldexp(VecF const a, VecF const e) noexcept { return _mm512_maskz_scalef_ps(0xffff, a.v, e.v); }
+inline VecF loadu(float const * const p) noexcept { return _mm512_loadu_ps(p); }
+inline void storeu(float * const p, VecF const a) noexcept { _mm512_storeu_ps(p, a.v); }
+inline VecF loadPartial(float const * const p, std::size_t const n) noexcept { return _mm512_maskz_loadu_ps(static_cast<__mmask16>((1u << n) - 1u), p); }
+inline void storePartial(float * const p, VecF const a, std::size_t const n) noexcept { _mm512_mask_storeu_ps(p, static_cast<__mmask16>((1u << n) - 1u), a.v); }
+
+/* Sixteen x, y, z triples from p, split into their components, as for double. */
+inline
+void
+loadu3(float const * const p, VecF * const x, VecF * const y, VecF * const z) noexcept
+{
+	auto const a = _mm512_loadu_ps(p);
+	auto const b = _mm512_loadu_ps(p + 16);
+	auto const c = _mm512_loadu_ps(p + 32);
+	*x = _mm512_permutex2var_ps(
+		_mm512_permutex2var_ps(a, _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 0, 0, 0, 0, 0), b),
+		_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 17, 20, 23, 26, 29), c);
+	*y = _mm512_permutex2var_ps(
+		_mm512_permutex2var_ps(a, _mm512_setr_epi32(1, 4, 7, 10, 13, 16, 19, 22, 25, 28, 31, 0, 0, 0, 0, 0), b),
+		_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 18, 21, 24, 27, 30), c);
+	*z = _mm512_permutex2var_ps(
+		_mm512_permutex2var_ps(a, _mm512_setr_epi32(2, 5, 8, 11, 14, 17, 20, 23, 26, 29, 0, 0, 0, 0, 0, 0), b),
+		_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 16, 19, 22, 25, 28, 31), c);
+}
+
+inline
+void
+storeu3(float * const p, VecF const x, VecF const y, VecF const z) noexcept
+{
+	_mm512_storeu_ps(p, _mm512_permutex2var_ps(
+		_mm512_permutex2var_ps(x.v, _mm512_setr_epi32(0, 16, 0, 1, 17, 0, 2, 18, 0, 3, 19, 0, 4, 20, 0, 5), y.v),
+		_mm512_setr_epi32(0, 1, 16, 3, 4, 17, 6, 7, 18, 9, 10, 19, 12, 13, 20, 15), z.v));
+	_mm512_storeu_ps(p + 16, _mm512_permutex2var_ps(
+		_mm512_permutex2var_ps(x.v, _mm512_setr_epi32(21, 0, 6, 22, 0, 7, 23, 0, 8, 24, 0, 9, 25, 0, 10, 26), y.v),
+		_mm512_setr_epi32(0, 21, 2, 3, 22, 5, 6, 23, 8, 9, 24, 11, 12, 25, 14, 15), z.v));
+	_mm512_storeu_ps(p + 32, _mm512_permutex2var_ps(
+		_mm512_permutex2var_ps(x.v, _mm512_setr_epi32(0, 11, 27, 0, 12, 28, 0, 13, 29, 0, 14, 30, 0, 15, 31, 0), y.v),
+		_mm512_setr_epi32(26, 1, 2, 27, 4, 5, 28, 7, 8, 29, 10, 11, 30, 13, 14, 31), z.v));
+}
+
+inline
+void
+loadi(std::int32_t const * const p, VecF * const hi, VecF * const lo) noexcept
+{
+	auto const i = _mm512_loadu_si512(p);
+	auto const h = _mm512_maskz_slli_epi32(0xffff, _mm512_maskz_srai_epi32(0xffff, i, 16), 16);
+	*hi = _mm512_maskz_cvtepi32_ps(0xffff, h);
+	*lo = _mm512_maskz_cvtepi32_ps(0xffff, _mm512_sub_epi32(i, h));
+}
+
+inline
+void
+storei(std::int32_t * const p, VecF const a) noexcept
+{
+	_mm512_storeu_si512(p, _mm512_maskz_cvtps_epi32(0xffff, a.v));
+}
+
+/* Floats from doubles, and back. */
+inline void loadConvert(float const * const p, VecF * const v) noexcept { *v = loadu(p); }
+inline void storeConvert(float * const p, VecF const a) noexcept { storeu(p, a); }
+
+inline
+void
+loadConvert(double const * const p, VecF * const v) noexcept
+{
+	auto const lo = _mm512_maskz_cvtpd_ps(0xff, _mm512_loadu_pd(p));
+	auto const hi = _mm512_maskz_cvtpd_ps(0xff, _mm512_loadu_pd(p + 8));
+	*v = _mm512_castpd_ps(_mm512_maskz_insertf64x4(0xff, _mm512_castpd256_pd512(_mm256_castps_pd(lo)),
+						       _mm256_castps_pd(hi), 1));
+}
+
+inline
+void
+storeConvert(double * const p, VecF const a) noexcept
+{
+	auto const lo = _mm512_maskz_extractf64x4_pd(0xf, _mm512_castps_pd(a.v), 0);
+	auto const hi = _mm512_maskz_extractf64x4_pd(0xf, _mm512_castps_pd(a.v), 1);
+	_mm512_storeu_pd(p, _mm512_maskz_cvtps_pd(0xff, _mm256_castpd_ps(lo)));
+	_mm512_storeu_pd(p + 8, _mm512_maskz_cvtps_pd(0xff, _mm256_castpd_ps(hi)));
+}
+
+} // !namespace avx512
+} // !namespace simd
+} // !namespace terra
+TERRA_TARGET_END()
+#endif // TERRA_SIMD_AVX512
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/SimdMath.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/SimdApproximate.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/SimdDegrees.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/SimdConvert.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+namespace detail {
+
+/*
+ * The element type of the arrays x, y, z of an SoA coordinate struct, i.e.
+ * the type the coordinates are stored as.
+ */
+template<typename Coord>
+using SoAElement = typename std::remove_cv<
+	typename std::remove_reference<decltype(std::declval<Coord &>().x[0])>::type>::type;
+
+} // !namespace detail
+} // !namespace terra
+
+#endif // !terra_impl_Simd_hpp
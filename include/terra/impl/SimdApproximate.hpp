@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Math used by the kernels, picked by the type of the reference body:
+ * sincos(x, &s, &c, model) and friends forward to the exact functions, unless
+ * the model is an Approximate<Model>, which gets the float approximations
+ * below. Expanded into every instruction set namespace, scalar included, by
+ * SimdForEach.hpp. Deliberately has no include guard.
+ *
+ * The approximations give up the last bits of float in exchange for shorter
+ * polynomials, a cheaper argument reduction and reciprocal square root
+ * estimates in place of divisions, measured as:
+ *	sincos	|error| < 1.6e-7 for |x| < 1000
+ *	atan2	|error| < 2.7e-7 rad
+ *	rsqrt	relative error < 2.7e-7 (2^-21.8, AVX2 and SSE estimates)
+ * Rounding is the level's own round(), not a magic-number add that
+ * -ffast-math would fold away.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+namespace approximate {
+
+/* sin and cos of r + q*pi/2, for |r| <= pi/4 and an integral q. */
+template<typename V>
+inline
+void
+sincosQuadrant(V const r, V const q, V * const s, V * const c) noexcept
+{
+	auto const z = r*r;
+	auto ps = fma(z, -1.9495638441943867e-4f, 8.331978681181632e-3f);
+	ps = fma(ps, z, -1.6666650669627792e-1f);
+	auto const sin_r = fma(r*z, ps, r);
+	auto const pc = fma(z, -1.3652455988868522e-3f, 4.1661278894364e-2f);
+	auto const cos_r = fma(z*z, pc, fma(z, -0.5f, 1.0f));
+
+	/* The quadrant q mod 4; the offset keeps q/4 off ties, making round a floor. */
+	auto const m = fma(round(fma(q, 0.25f, -0.375f)), -4.0f, q);
+	auto const swap = (m == 1.0f) | (m == 3.0f);
+	auto const sv = select(swap, cos_r, sin_r);
+	auto const cv = select(swap, sin_r, cos_r);
+	*s = select(m >= 2.0f, -sv, sv);
+	*c = select((m == 1.0f) | (m == 2.0f), -cv, cv);
+}
+
+template<typename V>
+inline
+void
+sincos(V const x, V * const s, V * const c) noexcept
+{
+	auto const q = round(x*0.636619772367581343f);
+	auto r = fma(q, -1.57079637050628662109375f, x);
+	r = fma(q, 4.37113900018624283e-8f, r);
+	sincosQuadrant(r, q, s, c);
+}
+
+template<typename V>
+inline
+V
+rsqrt(V const x) noexcept
+{
+	auto const r = rsqrtEstimate(x);
+	return r*fma(x*r, r*-0.5f, 1.5f);
+}
+
+/*
+ * The octant-folded polynomial of the vector levels, with one division. It is
+ * no cheaper there, but spares the scalar path a call into libm.
+ */
+template<typename V>
+inline
+V
+atan2(V const y, V const x) noexcept
+{
+	auto const ax = abs(x);
+	auto const ay = abs(y);
+	auto const num = min(ax, ay);
+	auto const den = max(ax, ay);
+	auto const big = num > 0.414213562373095f*den;
+	auto const u = select(den == 0.0f, V(0.0f), select(big, num - den, num)/select(big, num + den, den));
+
+	auto const z = u*u;
+	auto p = fma(z, 8.05374449538e-2f, -1.38776856032e-1f);
+	p = fma(p, z, 1.99777106478e-1f);
+	p = fma(p, z, -3.33329491539e-1f);
+	auto r = fma(u*z, p, u);
+	r = r + select(big, V(0.785398163397448f), V(0.0f));
+
+	r = select(ay > ax, 1.57079632679489661923f - r, r);
+	r = select(x < 0.0f, 3.14159265358979323846f - r, r);
+	return select(y < 0.0f, -r, r);
+}
+
+} // !namespace approximate
+
+template<typename V, typename Model>
+inline
+void
+sincos(V const x, V * const s, V * const c, Model const &) noexcept
+{
+	sincos(x, s, c);
+}
+
+template<typename V, typename Model>
+inline
+void
+sincos(V const x, V * const s, V * const c, Approximate<Model> const &) noexcept
+{
+	approximate::sincos(x, s, c);
+}
+
+template<typename V, typename Model>
+inline
+void
+sincosQuadrant(V const r, V const q, V * const s, V * const c, Model const &) noexcept
+{
+	sincosQuadrant(r, q, s, c);
+}
+
+template<typename V, typename Model>
+inline
+void
+sincosQuadrant(V const r, V const q, V * const s, V * const c, Approximate<Model> const &) noexcept
+{
+	approximate::sincosQuadrant(r, q, s, c);
+}
+
+template<typename V, typename Model>
+inline
+V
+atan2(V const y, V const x, Model const &) noexcept
+{
+	return atan2(y, x);
+}
+
+template<typename V, typename Model>
+inline
+V
+atan2(V const y, V const x, Approximate<Model> const &) noexcept
+{
+	return approximate::atan2(y, x);
+}
+
+template<typename V, typename Model>
+inline
+V
+rsqrt(V const x, Model const &) noexcept
+{
+	return rsqrt(x);
+}
+
+template<typename V, typename Model>
+inline
+V
+rsqrt(V const x, Approximate<Model> const &) noexcept
+{
+	return approximate::rsqrt(x);
+}
+
+/* a/sqrt(x), one rounding when exact. */
+template<typename V, typename Model>
+inline
+V
+divSqrt(V const a, V const x, Model const &) noexcept
+{
+	return a/sqrt(x);
+}
+
+template<typename V, typename Model>
+inline
+V
+divSqrt(V const a, V const x, Approximate<Model> const &) noexcept
+{
+	return a*approximate::rsqrt(x);
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Loads and stores of coordinates kept in one floating-point type and
+ * computed in another, e.g. float arrays converted with a double model, for
+ * the batch kernels. Whole vectors widen or narrow in registers; the partial
+ * one at the end of a series goes through a zeroed buffer. Expanded into
+ * every instruction set namespace, scalar included, by SimdForEach.hpp.
+ * Deliberately has no include guard.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/* A vector of T from the S at p. */
+template<typename T, typename S>
+inline
+typename VecType<T>::type
+loadAs(S const * const p) noexcept
+{
+	typename VecType<T>::type v;
+	loadConvert(p, &v);
+	return v;
+}
+
+template<typename S, typename V>
+inline
+void
+storeAs(S * const p, V const v) noexcept
+{
+	storeConvert(p, v);
+}
+
+/* The first n lanes from the S at p, the rest zero. */
+template<typename T>
+inline
+typename VecType<T>::type
+loadPartialAs(T const * const p, std::size_t const n) noexcept
+{
+	return loadPartial(p, n);
+}
+
+template<typename T, typename S>
+inline
+typename std::enable_if<!std::is_same<T, S>::value, typename VecType<T>::type>::type
+loadPartialAs(S const * const p, std::size_t const n) noexcept
+{
+	S buf[VecType<T>::width] = {};
+	std::memcpy(buf, p, n*sizeof *p);
+	return loadAs<T>(buf);
+}
+
+template<typename T>
+inline
+void
+storePartialAs(T * const p, typename VecType<T>::type const v, std::size_t const n) noexcept
+{
+	storePartial(p, v, n);
+}
+
+template<typename T, typename S>
+inline
+typename std::enable_if<!std::is_same<T, S>::value>::type
+storePartialAs(S * const p, typename VecType<T>::type const v, std::size_t const n) noexcept
+{
+	S buf[VecType<T>::width];
+	storeConvert(buf, v);
+	std::memcpy(p, buf, n*sizeof *p);
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
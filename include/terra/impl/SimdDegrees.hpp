@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Math used by the kernels for a Degrees<Model>, whose longitudes and
+ * latitudes are in degrees. Sines and cosines reduce the argument by 90
+ * degrees, which is exact, and hand the remainder in radians to the wrapped
+ * model's polynomials; arctangents are scaled to degrees before they are
+ * stored. Either way the scaling costs a multiplication in registers rather
+ * than a pass over the arrays. Expanded into every instruction set namespace,
+ * scalar included, by SimdForEach.hpp. Deliberately has no include guard.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+namespace degrees {
+
+/* x*pi/180 and x*180/pi, the constants split in two to round about once. */
+template<typename V>
+inline
+V
+toRadians(V const x, float) noexcept
+{
+	return fma(x, 0.01745329238474369f, x*1.3519960151420207e-10f);
+}
+
+template<typename V>
+inline
+V
+toRadians(V const x, double) noexcept
+{
+	return fma(x, 0.017453292519943295, x*2.9486522708701687e-19);
+}
+
+template<typename V>
+inline
+V
+fromRadians(V const x, float) noexcept
+{
+	return fma(x, 57.295780181884766f, x*-6.688024427603523e-07f);
+}
+
+template<typename V>
+inline
+V
+fromRadians(V const x, double) noexcept
+{
+	return fma(x, 57.29577951308232, x*-1.9878495670576283e-15);
+}
+
+} // !namespace degrees
+
+/* An angle computed in radians, in the unit of the model's coordinates. */
+template<typename V, typename Model>
+inline
+V
+fromRadians(V const x, Model const &) noexcept
+{
+	return x;
+}
+
+template<typename V, typename Model>
+inline
+V
+fromRadians(V const x, Degrees<Model> const &) noexcept
+{
+	return degrees::fromRadians(x, typename Model::value_type());
+}
+
+/* An angle in the unit of the model's coordinates, in radians. */
+template<typename V, typename Model>
+inline
+V
+toRadians(V const x, Model const &) noexcept
+{
+	return x;
+}
+
+template<typename V, typename Model>
+inline
+V
+toRadians(V const x, Degrees<Model> const &) noexcept
+{
+	return degrees::toRadians(x, typename Model::value_type());
+}
+
+/* The model whose math takes and gives radians, for angles computed along the way. */
+template<typename Model>
+inline
+Model const &
+radians(Model const &model) noexcept
+{
+	return model;
+}
+
+template<typename Model>
+inline
+Model const &
+radians(Degrees<Model> const &model) noexcept
+{
+	return model;
+}
+
+/*
+ * x - 90*q is exact whenever 90*q is, below 2^24 degrees in float and 2^53
+ * in double, so the remainder is as accurate as the input at any longitude.
+ */
+template<typename V, typename Model>
+inline
+void
+sincos(V const x, V * const s, V * const c, Degrees<Model> const &model) noexcept
+{
+	using T = typename Model::value_type;
+	auto const q = round(x*T(1.0/90.0));
+	auto const r = degrees::toRadians(fma(q, T(-90), x), T());
+	sincosQuadrant(r, q, s, c, static_cast<Model const &>(model));
+}
+
+template<typename V, typename Model>
+inline
+V
+atan2(V const y, V const x, Degrees<Model> const &model) noexcept
+{
+	return fromRadians(atan2(y, x, static_cast<Model const &>(model)), model);
+}
+
+template<typename V, typename Model>
+inline
+V
+rsqrt(V const x, Degrees<Model> const &model) noexcept
+{
+	return rsqrt(x, static_cast<Model const &>(model));
+}
+
+template<typename V, typename Model>
+inline
+V
+divSqrt(V const a, V const x, Degrees<Model> const &model) noexcept
+{
+	return divSqrt(a, x, static_cast<Model const &>(model));
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Expands the header named by TERRA_SIMD_FOREACH_FILE once for every enabled
+ * instruction set, with TERRA_SIMD_ISA set to the namespace the expansion
+ * belongs in and TERRA_SIMD_ISA_SCALAR telling the scalar pass apart. Vector
+ * passes are compiled for their own instruction set (see TERRA_TARGET_BEGIN).
+ * Deliberately has no include guard.
+ */
+
+#define TERRA_SIMD_ISA scalar
+#define TERRA_SIMD_ISA_SCALAR 1
+#include TERRA_SIMD_FOREACH_FILE
+#undef TERRA_SIMD_ISA_SCALAR
+#undef TERRA_SIMD_ISA
+
+#define TERRA_SIMD_ISA_SCALAR 0
+
+#if defined(TERRA_SIMD_SSE2)
+TERRA_TARGET_BEGIN(TERRA_TARGET_SSE2)
+#define TERRA_SIMD_ISA sse2
+#include TERRA_SIMD_FOREACH_FILE
+#undef TERRA_SIMD_ISA
+TERRA_TARGET_END()
+#endif
+
+#if defined(TERRA_SIMD_SSE42)
+TERRA_TARGET_BEGIN(TERRA_TARGET_SSE42)
+#define TERRA_SIMD_ISA sse42
+#include TERRA_SIMD_FOREACH_FILE
+#undef TERRA_SIMD_ISA
+TERRA_TARGET_END()
+#endif
+
+#if defined(TERRA_SIMD_AVX2)
+TERRA_TARGET_BEGIN(TERRA_TARGET_AVX2)
+#define TERRA_SIMD_ISA avx2
+#include TERRA_SIMD_FOREACH_FILE
+#undef TERRA_SIMD_ISA
+TERRA_TARGET_END()
+#endif
+
+#if defined(TERRA_SIMD_AVX512)
+TERRA_TARGET_BEGIN(TERRA_TARGET_AVX512)
+#define TERRA_SIMD_ISA avx512
+#include TERRA_SIMD_FOREACH_FILE
+#undef TERRA_SIMD_ISA
+TERRA_TARGET_END()
+#endif
+
+#undef TERRA_SIMD_ISA_SCALAR
+#undef TERRA_SIMD_FOREACH_FILE
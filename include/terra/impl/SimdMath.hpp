@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Lane-parallel elementary functions, expanded into every vector namespace
+ * by SimdForEach.hpp. The polynomials are the Cephes ones; in double they
+ * stay within a couple of ulp of libm over the ranges geodesy needs. The
+ * scalar namespace uses libm directly and gets nothing from this file.
+ */
+
+#if !TERRA_SIMD_ISA_SCALAR
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/*
+ * sin and cos of r + q*pi/2, for |r| <= pi/4 and an integral q: both
+ * polynomials, picked and negated per quadrant. The quadrant is tracked in
+ * floating point so that no integer vector support is needed.
+ */
+inline
+void
+sincosQuadrant(VecD const r, VecD const q, VecD * const s, VecD * const c) noexcept
+{
+	auto const z = r*r;
+	auto ps = fma(z, 1.58962301576546568060e-10, -2.50507477628578072866e-08);
+	ps = fma(ps, z, 2.75573136213857245213e-06);
+	ps = fma(ps, z, -1.98412698295895385996e-04);
+	ps = fma(ps, z, 8.33333333332211858878e-03);
+	ps = fma(ps, z, -1.66666666666666307295e-01);
+	auto const sin_r = fma(r*z, ps, r);
+	auto pc = fma(z, -1.13585365213876817300e-11, 2.08757008419747316778e-09);
+	pc = fma(pc, z, -2.75573141792967388112e-07);
+	pc = fma(pc, z, 2.48015872888517045348e-05);
+	pc = fma(pc, z, -1.38888888888730564116e-03);
+	pc = fma(pc, z, 4.16666666666665929218e-02);
+	auto const cos_r = fma(z*z, pc, fma(z, -0.5, 1.0));
+
+	auto const m = q - 4.0*floor(q*0.25);
+	auto const swap = (m == 1.0) | (m == 3.0);
+	auto const sv = select(swap, cos_r, sin_r);
+	auto const cv = select(swap, sin_r, cos_r);
+	*s = select(m >= 2.0, -sv, sv);
+	*c = select((m == 1.0) | (m == 2.0), -cv, cv);
+}
+
+/* Reduce by pi/2 in three parts (Cody-Waite). */
+inline
+void
+sincos(VecD const x, VecD * const s, VecD * const c) noexcept
+{
+	auto const q = round(x*0.63661977236758134308);
+	auto r = fma(q, -1.57079625129699707031e+00, x);
+	r = fma(q, -7.54978941586159635336e-08, r);
+	r = fma(q, -5.39030285815811905290e-15, r);
+	sincosQuadrant(r, q, s, c);
+}
+
+/*
+ * Four-quadrant arctangent. The ratio of the smaller to the larger magnitude
+ * is reduced to |u| <= tan(pi/8) in the same division, then unfolded by octant.
+ */
+inline
+VecD
+atan2(VecD const y, VecD const x) noexcept
+{
+	auto const ax = abs(x);
+	auto const ay = abs(y);
+	auto const num = min(ax, ay);
+	auto const den = max(ax, ay);
+	auto const big = num > 0.41421356237309504880*den;
+	auto const u = select(den == 0.0, VecD(0.0), select(big, num - den, num)/select(big, num + den, den));
+
+	auto const z = u*u;
+	auto pp = fma(z, -8.750608600031904122785e-01, -1.615753718733365076637e+01);
+	pp = fma(pp, z, -7.500855792314704667340e+01);
+	pp = fma(pp, z, -1.228866684490136173410e+02);
+	pp = fma(pp, z, -6.485021904942025371773e+01);
+	auto pq = z + 2.485846490142306297962e+01;
+	pq = fma(pq, z, 1.650270098316988542046e+02);
+	pq = fma(pq, z, 4.328810604912902668951e+02);
+	pq = fma(pq, z, 4.853903996359136964868e+02);
+	pq = fma(pq, z, 1.945506571482613964425e+02);
+	auto r = fma(u*z, pp/pq, u);
+	r = r + select(big, VecD(7.85398163397448309616e-01), VecD(0.0));
+	r = r + select(big, VecD(3.061616997868383017935e-17), VecD(0.0));
+
+	r = select(ay > ax, (1.57079632679489661923 - r) + 6.123233995736765886130e-17, r);
+	r = select(x < 0.0, (3.14159265358979323846 - r) + 1.224646799147353177226e-16, r);
+	return select(y < 0.0, -r, r);
+}
+
+inline
+VecD
+rsqrt(VecD const x) noexcept
+{
+	return 1.0/sqrt(x);
+}
+
+/*
+ * Cube root of a normal or zero x. The exponent is split off and brought to a
+ * multiple of three, leaving a mantissa in [0.5, 4) whose linear guess Halley's
+ * method refines, tripling the correct digits each step.
+ */
+inline
+VecD
+cbrt(VecD const x) noexcept
+{
+	VecD e;
+	auto const m = frexp(abs(x), &e);
+	auto const q = floor((e + 0.5)*(1.0/3.0));
+	auto const r = e - 3.0*q;
+	auto const mr = m*select(r == 1.0, VecD(2.0), select(r == 2.0, VecD(4.0), VecD(1.0)));
+
+	auto y = fma(mr, 0.23, 0.7);
+	for (auto i = 0; i < 3; ++i) {
+		auto const y3 = y*y*y;
+		y = y*(y3 + 2.0*mr)/(2.0*y3 + mr);
+	}
+	auto const c = ldexp(y, q);
+	return select(x == 0.0, VecD(0.0), select(x < 0.0, -c, c));
+}
+
+/*
+ * Natural logarithm of a positive normal x. The mantissa is brought to
+ * [sqrt(1/2), sqrt(2)) and log(1 + r) taken as r - r^2/2 plus a rational
+ * correction; the exponent's share adds ln 2 in two parts.
+ */
+inline
+VecD
+log(VecD const x) noexcept
+{
+	VecD e;
+	auto const m = frexp(x, &e);
+	auto const small = m < 0.70710678118654752440;
+	auto const k = select(small, e - 1.0, e);
+	auto const r = select(small, m + m, m) - 1.0;
+	auto const z = r*r;
+	auto pp = fma(r, 1.01875663804580931796e-04, 4.97494994976747001425e-01);
+	pp = fma(pp, r, 4.70579119878881725854e+00);
+	pp = fma(pp, r, 1.44989225341610930846e+01);
+	pp = fma(pp, r, 1.79368678507819816313e+01);
+	pp = fma(pp, r, 7.70838733755885391666e+00);
+	auto pq = r + 1.12873587189167450590e+01;
+	pq = fma(pq, r, 4.52279145837532221105e+01);
+	pq = fma(pq, r, 8.29875266912776603211e+01);
+	pq = fma(pq, r, 7.11544750618563894466e+01);
+	pq = fma(pq, r, 2.31251620126765340583e+01);
+	auto y = r*(z*pp/pq);
+	y = fma(k, -2.121944400546905827679e-04, y);
+	y = fma(z, -0.5, y);
+	return fma(k, 0.693359375, r + y);
+}
+
+/*
+ * e^x, x clamped to the normal range. Reduced by ln 2 in two parts to
+ * |r| <= ln(2)/2, where e^r = 1 + 2r P/(Q - r P), then scaled by 2^q.
+ */
+inline
+VecD
+exp(VecD const x) noexcept
+{
+	auto const xc = min(max(x, VecD(-708.0)), VecD(709.0));
+	auto const q = floor(fma(xc, 1.44269504088896340736, 0.5));
+	auto r = fma(q, -6.93145751953125e-01, xc);
+	r = fma(q, -1.42860682030941723212e-06, r);
+	auto const z = r*r;
+	auto pp = fma(z, 1.26177193074810590878e-04, 3.02994407707441961300e-02);
+	pp = r*fma(pp, z, 9.99999999999999999910e-01);
+	auto pq = fma(z, 3.00198505138664455042e-06, 2.52448340349684104192e-03);
+	pq = fma(pq, z, 2.27265548208155028766e-01);
+	pq = fma(pq, z, 2.00000000000000000009e+00);
+	return ldexp(fma(pp/(pq - pp), 2.0, 1.0), q);
+}
+
+inline
+void
+sincosQuadrant(VecF const r, VecF const q, VecF * const s, VecF * const c) noexcept
+{
+	auto const z = r*r;
+	auto ps = fma(z, -1.9515295891e-4f, 8.3321608736e-3f);
+	ps = fma(ps, z, -1.6666654611e-1f);
+	auto const sin_r = fma(r*z, ps, r);
+	auto pc = fma(z, 2.443315711809948e-5f, -1.388731625493765e-3f);
+	pc = fma(pc, z, 4.166664568298827e-2f);
+	auto const cos_r = fma(z*z, pc, fma(z, -0.5f, 1.0f));
+
+	auto const m = q - 4.0f*floor(q*0.25f);
+	auto const swap = (m == 1.0f) | (m == 3.0f);
+	auto const sv = select(swap, cos_r, sin_r);
+	auto const cv = select(swap, sin_r, cos_r);
+	*s = select(m >= 2.0f, -sv, sv);
+	*c = select((m == 1.0f) | (m == 2.0f), -cv, cv);
+}
+
+inline
+void
+sincos(VecF const x, VecF * const s, VecF * const c) noexcept
+{
+	auto const q = round(x*0.636619772367581343f);
+	auto r = fma(q, -1.5703125f, x);
+	r = fma(q, -4.837512969970703125e-4f, r);
+	r = fma(q, -7.54978995489188216e-8f, r);
+	sincosQuadrant(r, q, s, c);
+}
+
+inline
+VecF
+atan2(VecF const y, VecF const x) noexcept
+{
+	auto const ax = abs(x);
+	auto const ay = abs(y);
+	auto const num = min(ax, ay);
+	auto const den = max(ax, ay);
+	auto const big = num > 0.414213562373095f*den;
+	auto const u = select(den == 0.0f, VecF(0.0f), select(big, num - den, num)/select(big, num + den, den));
+
+	auto const z = u*u;
+	auto pp = fma(z, 8.05374449538e-2f, -1.38776856032e-1f);
+	pp = fma(pp, z, 1.99777106478e-1f);
+	pp = fma(pp, z, -3.33329491539e-1f);
+	auto r = fma(u*z, pp, u);
+	r = r + select(big, VecF(0.785398163397448f), VecF(0.0f));
+
+	r = select(ay > ax, 1.57079632679489661923f - r, r);
+	r = select(x < 0.0f, 3.14159265358979323846f - r, r);
+	return select(y < 0.0f, -r, r);
+}
+
+inline
+VecF
+rsqrt(VecF const x) noexcept
+{
+	return 1.0f/sqrt(x);
+}
+
+inline
+VecF
+cbrt(VecF const x) noexcept
+{
+	VecF e;
+	auto const m = frexp(abs(x), &e);
+	auto const q = floor((e + 0.5f)*(1.0f/3.0f));
+	auto const r = e - 3.0f*q;
+	auto const mr = m*select(r == 1.0f, VecF(2.0f), select(r == 2.0f, VecF(4.0f), VecF(1.0f)));
+
+	auto y = fma(mr, 0.23f, 0.7f);
+	for (auto i = 0; i < 2; ++i) {
+		auto const y3 = y*y*y;
+		y = y*(y3 + 2.0f*mr)/(2.0f*y3 + mr);
+	}
+	auto const c = ldexp(y, q);
+	return select(x == 0.0f, VecF(0.0f), select(x < 0.0f, -c, c));
+}
+
+inline
+VecF
+log(VecF const x) noexcept
+{
+	VecF e;
+	auto const m = frexp(x, &e);
+	auto const small = m < 0.707106781186547524f;
+	auto const k = select(small, e - 1.0f, e);
+	auto const r = select(small, m + m, m) - 1.0f;
+	auto const z = r*r;
+	auto p = fma(r, 7.0376836292e-2f, -1.1514610310e-1f);
+	p = fma(p, r, 1.1676998740e-1f);
+	p = fma(p, r, -1.2420140846e-1f);
+	p = fma(p, r, 1.4249322787e-1f);
+	p = fma(p, r, -1.6668057665e-1f);
+	p = fma(p, r, 2.0000714765e-1f);
+	p = fma(p, r, -2.4999993993e-1f);
+	p = fma(p, r, 3.3333331174e-1f);
+	auto y = p*r*z;
+	y = fma(k, -2.12194440e-4f, y);
+	y = fma(z, -0.5f, y);
+	return fma(k, 0.693359375f, r + y);
+}
+
+inline
+VecF
+exp(VecF const x) noexcept
+{
+	auto const xc = min(max(x, VecF(-87.0f)), VecF(88.0f));
+	auto const q = floor(fma(xc, 1.44269504088896341f, 0.5f));
+	auto r = fma(q, -0.693359375f, xc);
+	r = fma(q, 2.12194440e-4f, r);
+	auto p = fma(r, 1.9875691500e-4f, 1.3981999507e-3f);
+	p = fma(p, r, 8.3334519073e-3f);
+	p = fma(p, r, 4.1665795894e-2f);
+	p = fma(p, r, 1.6666665459e-1f);
+	p = fma(p, r, 5.0000001201e-1f);
+	return ldexp(fma(p, r*r, r + 1.0f), q);
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
+
+#endif // !TERRA_SIMD_ISA_SCALAR
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * 128-bit vector types, expanded by Simd.hpp once for plain SSE2 and once,
+ * with TERRA_SIMD_SSE41 set, for SSE4.2 where blends and rounding are single
+ * instructions. Deliberately has no include guard.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+struct VecD {
+	VecD() = default;
+	VecD(__m128d const x) noexcept : v(x) {}
+	VecD(double const s) noexcept : v(_mm_set1_pd(s)) {}
+	__m128d v;
+};
+
+struct MaskD {
+	__m128d v;
+};
+
+struct VecF {
+	VecF() = default;
+	VecF(__m128 const x) noexcept : v(x) {}
+	VecF(float const s) noexcept : v(_mm_set1_ps(s)) {}
+	__m128 v;
+};
+
+struct MaskF {
+	__m128 v;
+};
+
+template<typename T>
+struct VecType;
+template<>
+struct VecType<double> {
+	using type = VecD;
+	using mask = MaskD;
+	enum { width = 2 };
+};
+template<>
+struct VecType<float> {
+	using type = VecF;
+	using mask = MaskF;
+	enum { width = 4 };
+};
+
+inline VecD operator+(VecD const a, VecD const b) noexcept { return _mm_add_pd(a.v, b.v); }
+inline VecD operator-(VecD const a, VecD const b) noexcept { return _mm_sub_pd(a.v, b.v); }
+inline VecD operator*(VecD const a, VecD const b) noexcept { return _mm_mul_pd(a.v, b.v); }
+inline VecD operator/(VecD const a, VecD const b) noexcept { return _mm_div_pd(a.v, b.v); }
+inline VecD operator-(VecD const a) noexcept { return _mm_xor_pd(a.v, _mm_set1_pd(-0.0)); }
+inline MaskD operator<(VecD const a, VecD const b) noexcept { return MaskD{_mm_cmplt_pd(a.v, b.v)}; }
+inline MaskD operator<=(VecD const a, VecD const b) noexcept { return MaskD{_mm_cmple_pd(a.v, b.v)}; }
+inline MaskD operator>(VecD const a, VecD const b) noexcept { return MaskD{_mm_cmpgt_pd(a.v, b.v)}; }
+inline MaskD operator>=(VecD const a, VecD const b) noexcept { return MaskD{_mm_cmpge_pd(a.v, b.v)}; }
+inline MaskD operator==(VecD const a, VecD const b) noexcept { return MaskD{_mm_cmpeq_pd(a.v, b.v)}; }
+inline MaskD operator!=(VecD const a, VecD const b) noexcept { return MaskD{_mm_cmpneq_pd(a.v, b.v)}; }
+inline MaskD operator&(MaskD const a, MaskD const b) noexcept { return MaskD{_mm_and_pd(a.v, b.v)}; }
+inline MaskD operator|(MaskD const a, MaskD const b) noexcept { return MaskD{_mm_or_pd(a.v, b.v)}; }
+inline MaskD operator!(MaskD const a) noexcept { return MaskD{_mm_xor_pd(a.v, _mm_castsi128_pd(_mm_set1_epi32(-1)))}; }
+inline bool any(MaskD const m) noexcept { return _mm_movemask_pd(m.v) != 0; }
+inline bool all(MaskD const m) noexcept { return _mm_movemask_pd(m.v) == 0x3; }
+#if TERRA_SIMD_SSE41
+inline VecD select(MaskD const m, VecD const a, VecD const b) noexcept { return _mm_blendv_pd(b.v, a.v, m.v); }
+#else
+inline VecD select(MaskD const m, VecD const a, VecD const b) noexcept { return _mm_or_pd(_mm_and_pd(m.v, a.v), _mm_andnot_pd(m.v, b.v)); }
+#endif
+inline VecD fma(VecD const a, VecD const b, VecD const c) noexcept { return a*b + c; }
+inline VecD sqrt(VecD const a) noexcept { return _mm_sqrt_pd(a.v); }
+inline VecD abs(VecD const a) noexcept { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+inline VecD min(VecD const a, VecD const b) noexcept { return _mm_min_pd(a.v, b.v); }
+inline VecD max(VecD const a, VecD const b) noexcept { return _mm_max_pd(a.v, b.v); }
+
+#if TERRA_SIMD_SSE41
+inline VecD round(VecD const a) noexcept { return _mm_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecD floor(VecD const a) noexcept { return _mm_floor_pd(a.v); }
+#else
+/*
+ * Round to nearest through int32, for |a| < 2^31; larger values and NaN are
+ * returned as they are. Not by adding and subtracting 1.5*2^52, which
+ * -ffast-math folds away.
+ */
+inline
+VecD
+round(VecD const a) noexcept
+{
+	auto const r = _mm_cvtepi32_pd(_mm_cvtpd_epi32(a.v));
+	auto const keep = _mm_cmpnlt_pd(abs(a).v, _mm_set1_pd(2147483648.0));
+	return _mm_or_pd(_mm_and_pd(keep, a.v), _mm_andnot_pd(keep, r));
+}
+
+inline
+VecD
+floor(VecD const a) noexcept
+{
+	auto const r = round(a);
+	return _mm_sub_pd(r.v, _mm_and_pd(_mm_cmpgt_pd(r.v, a.v), _mm_set1_pd(1.0)));
+}
+#endif
+
+/* a = m*2^e with m in [0.5, 1), for normal a; e is returned as a double. */
+inline
+VecD
+frexp(VecD const a, VecD * const e) noexcept
+{
+	auto const bits = _mm_castpd_si128(a.v);
+	auto const expMask = _mm_set1_epi64x(0x7ff0000000000000ll);
+	auto const biased = _mm_srli_epi64(_mm_and_si128(bits, expMask), 52);
+	/* The biased exponent read as the mantissa of 2^52. */
+	*e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(biased, _mm_set1_epi64x(0x4330000000000000ll))),
+			_mm_set1_pd(4503599627370496.0 + 1022.0));
+	return _mm_castsi128_pd(_mm_or_si128(_mm_andnot_si128(expMask, bits), _mm_set1_epi64x(0x3fe0000000000000ll)));
+}
+
+/* a*2^e for integral e, as long as the result is normal. */
+inline
+VecD
+ldexp(VecD const a, VecD const e) noexcept
+{
+	/* Adding 1.5*2^52 leaves e in the low mantissa bits, in two's complement. */
+	auto const ei = _mm_castpd_si128(_mm_add_pd(e.v, _mm_set1_pd(6755399441055744.0)));
+	return _mm_castsi128_pd(_mm_add_epi64(_mm_castpd_si128(a.v), _mm_slli_epi64(ei, 52)));
+}
+
+inline VecD loadu(double const * const p) noexcept { return _mm_loadu_pd(p); }
+inline void storeu(double * const p, VecD const a) noexcept { _mm_storeu_pd(p, a.v); }
+
+inline
+VecD
+loadPartial(double const * const p, std::size_t const n) noexcept
+{
+	double buf[2] = {};
+	std::memcpy(buf, p, n*sizeof *p);
+	return _mm_loadu_pd(buf);
+}
+
+inline
+void
+storePartial(double * const p, VecD const a, std::size_t const n) noexcept
+{
+	double buf[2];
+	_mm_storeu_pd(buf, a.v);
+	std::memcpy(p, buf, n*sizeof *p);
+}
+
+/* Two x, y, z triples from p, split into their components. */
+inline
+void
+loadu3(double const * const p, VecD * const x, VecD * const y, VecD * const z) noexcept
+{
+	auto const a = _mm_loadu_pd(p);
+	auto const b = _mm_loadu_pd(p + 2);
+	auto const c = _mm_loadu_pd(p + 4);
+	*x = _mm_shuffle_pd(a, b, 0x2);
+	*y = _mm_shuffle_pd(a, c, 0x1);
+	*z = _mm_shuffle_pd(b, c, 0x2);
+}
+
+inline
+void
+storeu3(double * const p, VecD const x, VecD const y, VecD const z) noexcept
+{
+	_mm_storeu_pd(p, _mm_shuffle_pd(x.v, y.v, 0x0));
+	_mm_storeu_pd(p + 2, _mm_shuffle_pd(z.v, x.v, 0x2));
+	_mm_storeu_pd(p + 4, _mm_shuffle_pd(y.v, z.v, 0x3));
+}
+
+/* Two int32 as their high and low 16 bits, each exact in double. */
+inline
+void
+loadi(std::int32_t const * const p, VecD * const hi, VecD * const lo) noexcept
+{
+	auto const i = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(p));
+	auto const h = _mm_slli_epi32(_mm_srai_epi32(i, 16), 16);
+	*hi = _mm_cvtepi32_pd(h);
+	*lo = _mm_cvtepi32_pd(_mm_sub_epi32(i, h));
+}
+
+/* Integral values within the int32 range, as int32. */
+inline
+void
+storei(std::int32_t * const p, VecD const a) noexcept
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_cvtpd_epi32(a.v));
+}
+
+/* Doubles from floats, and back. */
+inline void loadConvert(double const * const p, VecD * const v) noexcept { *v = loadu(p); }
+inline void storeConvert(double * const p, VecD const a) noexcept { storeu(p, a); }
+
+inline
+void
+loadConvert(float const * const p, VecD * const v) noexcept
+{
+	*v = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(p))));
+}
+
+inline
+void
+storeConvert(float * const p, VecD const a) noexcept
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_castps_si128(_mm_cvtpd_ps(a.v)));
+}
+
+inline VecF operator+(VecF const a, VecF const b) noexcept { return _mm_add_ps(a.v, b.v); }
+inline VecF operator-(VecF const a, VecF const b) noexcept { return _mm_sub_ps(a.v, b.v); }
+inline VecF operator*(VecF const a, VecF const b) noexcept { return _mm_mul_ps(a.v, b.v); }
+inline VecF operator/(VecF const a, VecF const b) noexcept { return _mm_div_ps(a.v, b.v); }
+inline VecF operator-(VecF const a) noexcept { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+inline MaskF operator<(VecF const a, VecF const b) noexcept { return MaskF{_mm_cmplt_ps(a.v, b.v)}; }
+inline MaskF operator<=(VecF const a, VecF const b) noexcept { return MaskF{_mm_cmple_ps(a.v, b.v)}; }
+inline MaskF operator>(VecF const a, VecF const b) noexcept { return MaskF{_mm_cmpgt_ps(a.v, b.v)}; }
+inline MaskF operator>=(VecF const a, VecF const b) noexcept { return MaskF{_mm_cmpge_ps(a.v, b.v)}; }
+inline MaskF operator==(VecF const a, VecF const b) noexcept { return MaskF{_mm_cmpeq_ps(a.v, b.v)}; }
+inline MaskF operator!=(VecF const a, VecF const b) noexcept { return MaskF{_mm_cmpneq_ps(a.v, b.v)}; }
+inline MaskF operator&(MaskF const a, MaskF const b) noexcept { return MaskF{_mm_and_ps(a.v, b.v)}; }
+inline MaskF operator|(MaskF const a, MaskF const b) noexcept { return MaskF{_mm_or_ps(a.v, b.v)}; }
+inline MaskF operator!(MaskF const a) noexcept { return MaskF{_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))}; }
+inline bool any(MaskF const m) noexcept { return _mm_movemask_ps(m.v) != 0; }
+inline bool all(MaskF const m) noexcept { return _mm_movemask_ps(m.v) == 0xf; }
+#if TERRA_SIMD_SSE41
+inline VecF select(MaskF const m, VecF const a, VecF const b) noexcept { return _mm_blendv_ps(b.v, a.v, m.v); }
+#else
+inline VecF select(MaskF const m, VecF const a, VecF const b) noexcept { return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)); }
+#endif
+inline VecF fma(VecF const a, VecF const b, VecF const c) noexcept { return a*b + c; }
+inline VecF sqrt(VecF const a) noexcept { return _mm_sqrt_ps(a.v); }
+inline VecF rsqrtEstimate(VecF const a) noexcept { return _mm_rsqrt_ps(a.v); }
+inline VecF abs(VecF const a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline VecF min(VecF const a, VecF const b) noexcept { return _mm_min_ps(a.v, b.v); }
+inline VecF max(VecF const a, VecF const b) noexcept { return _mm_max_ps(a.v, b.v); }
+
+#if TERRA_SIMD_SSE41
+inline VecF round(VecF const a) noexcept { return _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecF floor(VecF const a) noexcept { return _mm_floor_ps(a.v); }
+#else
+/* Round to nearest through int32, as for double; floats from 2^23 on are integral already. */
+inline
+VecF
+round(VecF const a) noexcept
+{
+	auto const r = _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v));
+	auto const keep = _mm_cmpnlt_ps(abs(a).v, _mm_set1_ps(2147483648.0f));
+	return _mm_or_ps(_mm_and_ps(keep, a.v), _mm_andnot_ps(keep, r));
+}
+
+inline
+VecF
+floor(VecF const a) noexcept
+{
+	auto const r = round(a);
+	return _mm_sub_ps(r.v, _mm_and_ps(_mm_cmpgt_ps(r.v, a.v), _mm_set1_ps(1.0f)));
+}
+#endif
+
+inline
+VecF
+frexp(VecF const a, VecF * const e) noexcept
+{
+	auto const bits = _mm_castps_si128(a.v);
+	auto const expMask = _mm_set1_epi32(0x7f800000);
+	auto const biased = _mm_srli_epi32(_mm_and_si128(bits, expMask), 23);
+	*e = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(biased, _mm_set1_epi32(0x4b000000))),
+			_mm_set1_ps(8388608.0f + 126.0f));
+	return _mm_castsi128_ps(_mm_or_si128(_mm_andnot_si128(expMask, bits), _mm_set1_epi32(0x3f000000)));
+}
+
+inline
+VecF
+ldexp(VecF const a, VecF const e) noexcept
+{
+	auto const ei = _mm_castps_si128(_mm_add_ps(e.v, _mm_set1_ps(12582912.0f)));
+	return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(a.v), _mm_slli_epi32(ei, 23)));
+}
+
+inline VecF loadu(float const * const p) noexcept { return _mm_loadu_ps(p); }
+inline void storeu(float * const p, VecF const a) noexcept { _mm_storeu_ps(p, a.v); }
+
+inline
+VecF
+loadPartial(float const * const p, std::size_t const n) noexcept
+{
+	float buf[4] = {};
+	std::memcpy(buf, p, n*sizeof *p);
+	return _mm_loadu_ps(buf);
+}
+
+inline
+void
+storePartial(float * const p, VecF const a, std::size_t const n) noexcept
+{
+	float buf[4];
+	_mm_storeu_ps(buf, a.v);
+	std::memcpy(p, buf, n*sizeof *p);
+}
+
+/* Four x, y, z triples from p, split into their components. */
+inline
+void
+loadu3(float const * const p, VecF * const x, VecF * const y, VecF * const z) noexcept
+{
+	auto const a = _mm_loadu_ps(p);		/* x0 y0 z0 x1 */
+	auto const b = _mm_loadu_ps(p + 4);	/* y1 z1 x2 y2 */
+	auto const c = _mm_loadu_ps(p + 8);	/* z2 x3 y3 z3 */
+	*x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+			    _MM_SHUFFLE(2, 0, 2, 0));
+	*z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+			    _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+inline
+void
+storeu3(float * const p, VecF const x, VecF const y, VecF const z) noexcept
+{
+	auto const even = _MM_SHUFFLE(2, 0, 2, 0);
+	_mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(x.v, y.v, _MM_SHUFFLE(0, 0, 0, 0)),
+					_mm_shuffle_ps(z.v, x.v, _MM_SHUFFLE(1, 1, 0, 0)), even));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y.v, z.v, _MM_SHUFFLE(1, 1, 1, 1)),
+					    _mm_shuffle_ps(x.v, y.v, _MM_SHUFFLE(2, 2, 2, 2)), even));
+	_mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z.v, x.v, _MM_SHUFFLE(3, 3, 2, 2)),
+					    _mm_shuffle_ps(y.v, z.v, _MM_SHUFFLE(3, 3, 3, 3)), even));
+}
+
+inline
+void
+loadi(std::int32_t const * const p, VecF * const hi, VecF * const lo) noexcept
+{
+	auto const i = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+	auto const h = _mm_slli_epi32(_mm_srai_epi32(i, 16), 16);
+	*hi = _mm_cvtepi32_ps(h);
+	*lo = _mm_cvtepi32_ps(_mm_sub_epi32(i, h));
+}
+
+inline
+void
+storei(std::int32_t * const p, VecF const a) noexcept
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_cvtps_epi32(a.v));
+}
+
+/* Floats from doubles, and back. */
+inline void loadConvert(float const * const p, VecF * const v) noexcept { *v = loadu(p); }
+inline void storeConvert(float * const p, VecF const a) noexcept { storeu(p, a); }
+
+inline
+void
+loadConvert(double const * const p, VecF * const v) noexcept
+{
+	*v = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+}
+
+inline
+void
+storeConvert(double * const p, VecF const a) noexcept
+{
+	_mm_storeu_pd(p, _mm_cvtps_pd(a.v));
+	_mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(a.v, a.v)));
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_SpatialIndexImpl_hpp
+#define terra_impl_SpatialIndexImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/impl/Simd.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/SpatialIndexKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+namespace detail {
+
+/* Queries answered per task of the batch queries, and leaves boxed per task. */
+constexpr std::size_t spatialIndexQueryChunk = 256;
+constexpr std::size_t spatialIndexLeafChunk = 1024;
+
+/* Deep enough for every tree that fits in memory, two entries per level. */
+constexpr std::size_t spatialIndexStackSize = 128;
+
+template<typename T>
+using SquaredDistancesFn = void (*)(T const *, T const *, T const *, std::size_t, T, T, T, T *);
+
+template<typename T>
+inline
+SquaredDistancesFn<T>
+squaredDistancesKernel() noexcept
+{
+	TERRA_SIMD_TABLE(SquaredDistancesFn<T>, kernels, squaredDistances<T>);
+	return kernels[simd::levelIndex()];
+}
+
+inline
+std::size_t
+numTasks(std::size_t const count, std::size_t const perTask) noexcept
+{
+	return count/perTask + (count%perTask ? 1 : 0);
+}
+
+} // !namespace detail
+
+template<typename T>
+template<typename Executor, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+SpatialIndex<T>::build(
+	Executor &executor,
+	Coord const &fromGeodetic,
+	std::size_t const numCoords,
+	Model const model)
+{
+	x_.resize(numCoords);
+	y_.resize(numCoords);
+	z_.resize(numCoords);
+	if (numCoords) {
+		detail::SoAView<T> to{ x_.data(), y_.data(), z_.data() };
+		auto const from = detail::soaView(fromGeodetic, 0);
+		geodToECEFSoA(executor, &to, from, numCoords, model);
+	}
+	buildTree(executor);
+}
+
+template<typename T>
+template<typename Executor, typename Coord>
+inline
+void
+SpatialIndex<T>::buildECEF(
+	Executor &executor,
+	Coord const &fromECEF,
+	std::size_t const numCoords)
+{
+	x_.resize(numCoords);
+	y_.resize(numCoords);
+	z_.resize(numCoords);
+	executor.run(detail::numChunks(numCoords), [&](std::size_t const chunk) {
+		auto const first = chunk*parallelChunkSize;
+		auto const last = first + detail::chunkSize(chunk, numCoords);
+		for (auto i = first; i < last; ++i) {
+			x_[i] = fromECEF.x[i];
+			y_[i] = fromECEF.y[i];
+			z_[i] = fromECEF.z[i];
+		}
+	});
+	buildTree(executor);
+}
+
+/*
+ * Partition the points level by level, each node's range around the median of
+ * its widest axis, with every node of a level a task of its own. The points
+ * stay put while index_ is permuted, and are gathered into tree order at the
+ * end; the boxes are then computed from the leaves up.
+ */
+template<typename T>
+template<typename Executor>
+inline
+void
+SpatialIndex<T>::buildTree(Executor &executor)
+{
+	auto const n = x_.size();
+	index_.resize(n);
+	for (auto i = std::size_t(0); i < n; ++i)
+		index_[i] = i;
+	depth_ = 0;
+	if (n == 0) {
+		bounds_.clear();
+		return;
+	}
+	while (((n - 1) >> depth_) + 1 > spatialIndexLeafSize)
+		++depth_;
+
+	T const * const coords[3] = { x_.data(), y_.data(), z_.data() };
+	for (auto depth = std::size_t(0); depth < depth_; ++depth) {
+		auto const firstNode = (std::size_t(1) << depth) - 1;
+		executor.run(std::size_t(1) << depth, [&](std::size_t const p) {
+			std::size_t first, last;
+			range(firstNode + p, depth, &first, &last);
+			T lo[3], hi[3];
+			for (auto axis = 0; axis < 3; ++axis)
+				lo[axis] = hi[axis] = coords[axis][index_[first]];
+			for (auto i = first + 1; i < last; ++i) {
+				for (auto axis = 0; axis < 3; ++axis) {
+					auto const c = coords[axis][index_[i]];
+					lo[axis] = std::min(lo[axis], c);
+					hi[axis] = std::max(hi[axis], c);
+				}
+			}
+			auto axis = 0;
+			if (hi[1] - lo[1] > hi[axis] - lo[axis])
+				axis = 1;
+			if (hi[2] - lo[2] > hi[axis] - lo[axis])
+				axis = 2;
+			auto const c = coords[axis];
+			auto const mid = ((2*p + 1)*n) >> (depth + 1);
+			std::nth_element(index_.begin() + first, index_.begin() + mid, index_.begin() + last,
+					 [c](std::size_t const a, std::size_t const b) { return c[a] < c[b]; });
+		});
+	}
+
+	std::vector<T> x(n), y(n), z(n);
+	executor.run(detail::numChunks(n), [&](std::size_t const chunk) {
+		auto const first = chunk*parallelChunkSize;
+		auto const last = first + detail::chunkSize(chunk, n);
+		for (auto i = first; i < last; ++i) {
+			x[i] = x_[index_[i]];
+			y[i] = y_[index_[i]];
+			z[i] = z_[index_[i]];
+		}
+	});
+	x_.swap(x);
+	y_.swap(y);
+	z_.swap(z);
+
+	auto const numLeaves = std::size_t(1) << depth_;
+	auto const firstLeaf = numLeaves - 1;
+	bounds_.resize(6*(2*numLeaves - 1));
+	executor.run(detail::numTasks(numLeaves, detail::spatialIndexLeafChunk), [&](std::size_t const task) {
+		auto const leafEnd = std::min(numLeaves, (task + 1)*detail::spatialIndexLeafChunk);
+		for (auto p = task*detail::spatialIndexLeafChunk; p < leafEnd; ++p) {
+			std::size_t first, last;
+			range(firstLeaf + p, depth_, &first, &last);
+			auto * const box = &bounds_[6*(firstLeaf + p)];
+			box[0] = box[1] = box[2] = std::numeric_limits<T>::infinity();
+			box[3] = box[4] = box[5] = -std::numeric_limits<T>::infinity();
+			for (auto i = first; i < last; ++i) {
+				box[0] = std::min(box[0], x_[i]);
+				box[1] = std::min(box[1], y_[i]);
+				box[2] = std::min(box[2], z_[i]);
+				box[3] = std::max(box[3], x_[i]);
+				box[4] = std::max(box[4], y_[i]);
+				box[5] = std::max(box[5], z_[i]);
+			}
+		}
+	});
+	for (auto node = firstLeaf; node-- > 0;) {
+		auto * const box = &bounds_[6*node];
+		auto const * const left = &bounds_[6*(2*node + 1)];
+		auto const * const right = &bounds_[6*(2*node + 2)];
+		for (auto axis = 0; axis < 3; ++axis) {
+			box[axis] = std::min(left[axis], right[axis]);
+			box[axis + 3] = std::max(left[axis + 3], right[axis + 3]);
+		}
+	}
+}
+
+template<typename T>
+inline
+std::size_t
+SpatialIndex<T>::size() const noexcept
+{
+	return x_.size();
+}
+
+template<typename T>
+inline
+void
+SpatialIndex<T>::range(
+	std::size_t const node,
+	std::size_t const depth,
+	std::size_t * const first,
+	std::size_t * const last) const noexcept
+{
+	auto const p = node + 1 - (std::size_t(1) << depth);
+	*first = (p*x_.size()) >> depth;
+	*last = ((p + 1)*x_.size()) >> depth;
+}
+
+/* Squared distances from q to the nearest and farthest points of a node's box. */
+template<typename T>
+inline
+void
+SpatialIndex<T>::boxDistances(
+	T const (&q)[3],
+	std::size_t const node,
+	T * const nearest,
+	T * const farthest) const noexcept
+{
+	auto const * const box = &bounds_[6*node];
+	auto near = T(0), far = T(0);
+	for (auto axis = 0; axis < 3; ++axis) {
+		auto const below = box[axis] - q[axis];
+		auto const above = q[axis] - box[axis + 3];
+		auto const d = std::max(std::max(below, above), T(0));
+		auto const f = std::max(-below, -above);
+		near += d*d;
+		far += f*f;
+	}
+	*nearest = near;
+	*farthest = far;
+}
+
+/* The leaf a query walks down to, by the nearer box at every node. */
+template<typename T>
+inline
+std::size_t
+SpatialIndex<T>::leafOf(T const (&q)[3]) const noexcept
+{
+	auto node = std::size_t(0);
+	for (auto depth = std::size_t(0); depth < depth_; ++depth) {
+		T left, right, far;
+		boxDistances(q, 2*node + 1, &left, &far);
+		boxDistances(q, 2*node + 2, &right, &far);
+		node = right < left ? 2*node + 2 : 2*node + 1;
+	}
+	return node + 1 - (std::size_t(1) << depth_);
+}
+
+template<typename T>
+inline
+std::size_t
+SpatialIndex<T>::radius(
+	T const (&ecef)[3],
+	T const chord,
+	std::vector<std::size_t> * const indices) const
+{
+	assert(indices && "indices is nullptr");
+
+	T scratch[spatialIndexLeafSize];
+	return radius(ecef, chord, indices, scratch);
+}
+
+template<typename T>
+inline
+std::size_t
+SpatialIndex<T>::radius(
+	T const (&q)[3],
+	T const chord,
+	std::vector<std::size_t> * const indices,
+	T * const scratch) const
+{
+	if (x_.empty())
+		return 0;
+
+	auto const distances = detail::squaredDistancesKernel<T>();
+	auto const r2 = chord*chord;
+	auto const count = indices->size();
+	std::size_t stack[detail::spatialIndexStackSize][2];
+	auto top = std::size_t(0);
+	stack[top][0] = 0;
+	stack[top++][1] = 0;
+	while (top) {
+		--top;
+		auto const node = stack[top][0];
+		auto const depth = stack[top][1];
+		T near, far;
+		boxDistances(q, node, &near, &far);
+		if (near > r2)
+			continue;
+		std::size_t first, last;
+		range(node, depth, &first, &last);
+		if (far <= r2) {
+			indices->insert(indices->end(), index_.begin() + first, index_.begin() + last);
+		} else if (depth == depth_) {
+			distances(&x_[first], &y_[first], &z_[first], last - first, q[0], q[1], q[2], scratch);
+			for (auto i = first; i < last; ++i) {
+				if (scratch[i - first] <= r2)
+					indices->push_back(index_[i]);
+			}
+		} else {
+			stack[top][0] = 2*node + 1;
+			stack[top++][1] = depth + 1;
+			stack[top][0] = 2*node + 2;
+			stack[top++][1] = depth + 1;
+		}
+	}
+	return indices->size() - count;
+}
+
+template<typename T>
+inline
+std::size_t
+SpatialIndex<T>::nearest(
+	T const (&ecef)[3],
+	std::size_t const k,
+	std::size_t * const indices,
+	T * const chords) const
+{
+	assert(indices && "indices is nullptr");
+
+	std::vector<Candidate> heap;
+	T scratch[spatialIndexLeafSize];
+	return nearest(ecef, k, indices, chords, &heap, scratch);
+}
+
+/*
+ * Depth first, the nearer child first, keeping the k best in a max-heap and
+ * skipping nodes whose box is farther than the k-th best so far.
+ */
+template<typename T>
+inline
+std::size_t
+SpatialIndex<T>::nearest(
+	T const (&q)[3],
+	std::size_t const k,
+	std::size_t * const indices,
+	T * const chords,
+	std::vector<Candidate> * const heap,
+	T * const scratch) const
+{
+	heap->clear();
+	if (k && !x_.empty()) {
+		auto const distances = detail::squaredDistancesKernel<T>();
+		struct Entry {
+			std::size_t node;
+			std::size_t depth;
+			T near;
+		};
+		Entry stack[detail::spatialIndexStackSize];
+		auto top = std::size_t(0);
+		T near, far;
+		boxDistances(q, 0, &near, &far);
+		stack[top++] = Entry{ 0, 0, near };
+		while (top) {
+			auto const entry = stack[--top];
+			if (heap->size() == k && entry.near > heap->front().first)
+				continue;
+			if (entry.depth == depth_) {
+				std::size_t first, last;
+				range(entry.node, entry.depth, &first, &last);
+				distances(&x_[first], &y_[first], &z_[first], last - first, q[0], q[1], q[2], scratch);
+				for (auto i = first; i < last; ++i) {
+					Candidate const candidate(scratch[i - first], index_[i]);
+					if (heap->size() < k) {
+						heap->push_back(candidate);
+						std::push_heap(heap->begin(), heap->end());
+					} else if (candidate < heap->front()) {
+						std::pop_heap(heap->begin(), heap->end());
+						heap->back() = candidate;
+						std::push_heap(heap->begin(), heap->end());
+					}
+				}
+				continue;
+			}
+			T left, right;
+			boxDistances(q, 2*entry.node + 1, &left, &far);
+			boxDistances(q, 2*entry.node + 2, &right, &far);
+			Entry const l{ 2*entry.node + 1, entry.depth + 1, left };
+			Entry const r{ 2*entry.node + 2, entry.depth + 1, right };
+			stack[top++] = right < left ? l : r;
+			stack[top++] = right < left ? r : l;
+		}
+		std::sort_heap(heap->begin(), heap->end());
+	}
+
+	for (auto i = std::size_t(0); i < k; ++i) {
+		auto const found = i < heap->size();
+		indices[i] = found ? (*heap)[i].second : std::size_t(-1);
+		if (chords)
+			chords[i] = found ? std::sqrt((*heap)[i].first) : std::numeric_limits<T>::infinity();
+	}
+	return heap->size();
+}
+
+/* A permutation of the queries grouping them by the leaf they walk down to. */
+template<typename T>
+template<typename Executor, typename Coord>
+inline
+std::vector<std::size_t>
+SpatialIndex<T>::treeOrder(
+	Executor &executor,
+	Coord const &ecef,
+	std::size_t const numQueries) const
+{
+	std::vector<std::size_t> leaf(numQueries);
+	executor.run(detail::numChunks(numQueries), [&](std::size_t const chunk) {
+		auto const first = chunk*parallelChunkSize;
+		auto const last = first + detail::chunkSize(chunk, numQueries);
+		for (auto i = first; i < last; ++i) {
+			T const q[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+			leaf[i] = leafOf(q);
+		}
+	});
+
+	std::vector<std::size_t> start((std::size_t(1) << depth_) + 1, 0);
+	for (auto i = std::size_t(0); i < numQueries; ++i)
+		++start[leaf[i] + 1];
+	for (auto p = std::size_t(1); p < start.size(); ++p)
+		start[p] += start[p - 1];
+	std::vector<std::size_t> order(numQueries);
+	for (auto i = std::size_t(0); i < numQueries; ++i)
+		order[start[leaf[i]]++] = i;
+	return order;
+}
+
+template<typename T>
+template<typename Executor, typename Coord>
+inline
+void
+SpatialIndex<T>::radiusSoA(
+	Executor &executor,
+	Coord const &ecef,
+	std::size_t const numQueries,
+	T const chord,
+	std::vector<std::size_t> * const offsets,
+	std::vector<std::size_t> * const indices) const
+{
+	assert(offsets && "offsets is nullptr");
+	assert(indices && "indices is nullptr");
+
+	offsets->assign(numQueries + 1, 0);
+	indices->clear();
+	if (x_.empty())
+		return;
+
+	auto const order = treeOrder(executor, ecef, numQueries);
+	auto const numTasks = detail::numTasks(numQueries, detail::spatialIndexQueryChunk);
+	std::vector<std::vector<std::size_t>> found(numTasks);
+	executor.run(numTasks, [&](std::size_t const task) {
+		T scratch[spatialIndexLeafSize];
+		auto const last = std::min(numQueries, (task + 1)*detail::spatialIndexQueryChunk);
+		for (auto j = task*detail::spatialIndexQueryChunk; j < last; ++j) {
+			auto const i = order[j];
+			T const q[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+			(*offsets)[i + 1] = radius(q, chord, &found[task], scratch);
+		}
+	});
+
+	for (auto i = std::size_t(0); i < numQueries; ++i)
+		(*offsets)[i + 1] += (*offsets)[i];
+	indices->resize(offsets->back());
+	executor.run(numTasks, [&](std::size_t const task) {
+		auto from = found[task].begin();
+		auto const last = std::min(numQueries, (task + 1)*detail::spatialIndexQueryChunk);
+		for (auto j = task*detail::spatialIndexQueryChunk; j < last; ++j) {
+			auto const i = order[j];
+			auto const count = (*offsets)[i + 1] - (*offsets)[i];
+			std::copy(from, from + count, indices->begin() + (*offsets)[i]);
+			from += count;
+		}
+	});
+}
+
+template<typename T>
+template<typename Executor, typename Coord>
+inline
+void
+SpatialIndex<T>::nearestSoA(
+	Executor &executor,
+	Coord const &ecef,
+	std::size_t const numQueries,
+	std::size_t const k,
+	std::size_t * const indices,
+	T * const chords) const
+{
+	assert((indices || numQueries*k == 0) && "indices is nullptr");
+
+	auto const order = treeOrder(executor, ecef, numQueries);
+	executor.run(detail::numTasks(numQueries, detail::spatialIndexQueryChunk), [&](std::size_t const task) {
+		std::vector<Candidate> heap;
+		T scratch[spatialIndexLeafSize];
+		auto const last = std::min(numQueries, (task + 1)*detail::spatialIndexQueryChunk);
+		for (auto j = task*detail::spatialIndexQueryChunk; j < last; ++j) {
+			auto const i = order[j];
+			T const q[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+			nearest(q, k, indices + i*k, chords ? chords + i*k : nullptr, &heap, scratch);
+		}
+	});
+}
+
+template<typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value, typename Model::value_type>::type
+chordLength(
+	typename Model::value_type const distance,
+	Model const &model) noexcept
+{
+	using T = typename Model::value_type;
+	auto const half = std::min(distance/(2*model.radius), T(1.5707963267948966));
+	return 2*model.radius*std::sin(half);
+}
+
+template<typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value, typename Model::value_type>::type
+chordLength(
+	typename Model::value_type const distance,
+	Model const &) noexcept
+{
+	return distance;
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_SpatialIndexImpl_hpp
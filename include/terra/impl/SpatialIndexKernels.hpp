@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Leaf kernels of the spatial index, expanded into every instruction set
+ * namespace by SimdForEach.hpp. The tree walk itself is scalar; a leaf's
+ * points are compared with the query a vector at a time.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/* Squared distances from (qx, qy, qz) to the n points at x, y, z. */
+template<typename T>
+inline
+void
+squaredDistances(
+	T const * const TERRA_RESTRICT x,
+	T const * const TERRA_RESTRICT y,
+	T const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	T const qx,
+	T const qy,
+	T const qz,
+	T * const TERRA_RESTRICT toDistances) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+	V const vx(qx), vy(qy), vz(qz);
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		auto const dx = loadu(x + i) - vx;
+		auto const dy = loadu(y + i) - vy;
+		auto const dz = loadu(z + i) - vz;
+		storeu(toDistances + i, fma(dx, dx, fma(dy, dy, dz*dz)));
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		auto const dx = loadPartial(x + i, rest) - vx;
+		auto const dy = loadPartial(y + i, rest) - vy;
+		auto const dz = loadPartial(z + i, rest) - vz;
+		storePartial(toDistances + i, fma(dx, dx, fma(dy, dy, dz*dz)), rest);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -17,124 +17,239 @@
 #ifndef terra_impl_SphereImpl_hpp
 #define terra_impl_SphereImpl_hpp
 
+#include <terra/Dispatch.hpp>
+#include <terra/Transpose.hpp>
+#include <terra/impl/Simd.hpp>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/SphereKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
 namespace terra {
 
-template<typename T, typename Coord>
+namespace detail {
+
+/* Spheres need no preparing; see the ellipsoid overloads in EllipsoidImpl.hpp. */
+template<typename Model>
 inline
-void
+typename std::enable_if<IsSphere<Model>::value, Model>::type
+prepare(Model const sphere) noexcept
+{
+	return sphere;
+}
+
+} // !namespace detail
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
 geodToECEF(
 	Coord * const coord,
-	Sphere<T> const sphere) noexcept
+	Model const sphere) noexcept
 {
 	assert(coord && "coord is nullptr");
 
-	auto const lon = (*coord)[0];
-	auto const lat = (*coord)[1];
-	auto const alt = (*coord)[2];
-	auto const n = sphere.radius + alt;
-	auto const sin_lon = std::sin(lon);
-	auto const cos_lon = std::cos(lon);
-	auto const sin_lat = std::sin(lat);
-	auto const cos_lat = std::cos(lat);
-	(*coord)[0] = n*cos_lat*cos_lon;
-	(*coord)[1] = n*cos_lat*sin_lon;
-	(*coord)[2] = n*sin_lat;
+	using T = typename Model::value_type;
+	T x, y, z;
+	simd::scalar::geodToECEF<T>(&x, &y, &z, T((*coord)[0]), T((*coord)[1]), (*coord)[2], sphere);
+	(*coord)[0] = x;
+	(*coord)[1] = y;
+	(*coord)[2] = z;
 }
  
-template<typename T, typename Coord>
+template<typename Coord, typename Model>
 inline
-void
+typename std::enable_if<IsSphere<Model>::value>::type
 geodToECEF(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord const & TERRA_RESTRICT fromGeodetic,
-	Sphere<T> const sphere) noexcept
+	Model const sphere) noexcept
 {
 	assert(toECEF && "toECEF is nullptr");
 
-	auto const lon = fromGeodetic[0];
-	auto const lat = fromGeodetic[1];
-	auto const alt = sphere.radius + fromGeodetic[2];
-	auto const sin_lon = std::sin(lon);
-	auto const cos_lon = std::cos(lon);
-	auto const sin_lat = std::sin(lat);
-	auto const cos_lat = std::cos(lat);
-	(*toECEF)[0] = alt*cos_lat*cos_lon;
-	(*toECEF)[1] = alt*cos_lat*sin_lon;
-	(*toECEF)[2] = alt*sin_lat;
+	using T = typename Model::value_type;
+	T x, y, z;
+	simd::scalar::geodToECEF<T>(&x, &y, &z, T(fromGeodetic[0]), T(fromGeodetic[1]), fromGeodetic[2], sphere);
+	(*toECEF)[0] = x;
+	(*toECEF)[1] = y;
+	(*toECEF)[2] = z;
 }
 
-template<typename T, typename Coord>
+template<typename Coord, typename Model>
 inline
-void
+typename std::enable_if<IsSphere<Model>::value>::type
 ecefToGeod(
 	Coord * const coord,
-	Sphere<T> const sphere) noexcept
+	Model const sphere) noexcept
 {
 	assert(coord && "coord is nullptr");
 
-	auto const x = (*coord)[0];
-	auto const y = (*coord)[1];
-	auto const z = (*coord)[2];
-	auto const r = sphere.radius;
-	auto const p = std::sqrt(x*x + y*y);
-	auto const lon = std::atan2(y, x);
-	auto const lat = std::atan2(z, p);
-	auto const coslat = std::cos(lat);
-	auto const alt = (p/coslat) - r;
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::ecefToGeod<T>(&lon, &lat, &alt, (*coord)[0], (*coord)[1], (*coord)[2], sphere);
 	(*coord)[0] = lon;
 	(*coord)[1] = lat;
 	(*coord)[2] = alt;
 }
 
-template<typename T, typename Coord>
+template<typename Coord, typename Model>
 inline
-void
+typename std::enable_if<IsSphere<Model>::value>::type
 ecefToGeod(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord const & TERRA_RESTRICT fromECEF,
-	Sphere<T> const sphere) noexcept
+	Model const sphere) noexcept
 {
 	assert(toGeodetic && "toGeodetic is nullptr");
 
-	auto const r = sphere.radius;
-	auto const x = fromECEF[0];
-	auto const y = fromECEF[1];
-	auto const z = fromECEF[2];
-	auto const p = std::sqrt(x*x + y*y);
-	auto const lon = std::atan2(y, x);
-	auto const lat = std::atan2(z, p);
-	auto const coslat = std::cos(lat);
-	auto const alt = (p/coslat) - r;
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::ecefToGeod<T>(&lon, &lat, &alt, fromECEF[0], fromECEF[1], fromECEF[2], sphere);
 	(*toGeodetic)[0] = lon;
 	(*toGeodetic)[1] = lat;
 	(*toGeodetic)[2] = alt;
 }
 
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using T = typename Model::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToECEFSoA<T, Model, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toECEF->x[0], &toECEF->y[0], &toECEF->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, sphere);
+}
+
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEFAoS(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using T = typename Model::value_type;
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToECEFSoA<T, Model>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, geodToECEFAoS<T, Model>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toECEF, fromGeodetic, numCoords, sphere);
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodSoA<T, Model, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, sphere);
+}
+
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodSoA<T, Model>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, ecefToGeodAoS<T, Model>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGeodetic, fromECEF, numCoords, sphere);
+}
+
+/*
+ * The T-first overloads name the template arguments of the Model ones, which
+ * they are more specialized than, so as not to pick themselves again.
+ */
+
 template<typename T, typename Coord>
 inline
 void
-geodToECEFSoA(
+geodToECEF(
+	Coord * const coord,
+	Sphere<T> const sphere) noexcept
+{
+	geodToECEF<Coord, Sphere<T>>(coord, sphere);
+}
+
+template<typename T, typename Coord>
+inline
+void
+geodToECEF(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
 	Sphere<T> const sphere) noexcept
 {
-	assert(toECEF && "toECEF is nullptr");
+	geodToECEF<Coord, Sphere<T>>(toECEF, fromGeodetic, sphere);
+}
 
-	auto const r = sphere.radius;
+template<typename T, typename Coord>
+inline
+void
+ecefToGeod(
+	Coord * const coord,
+	Sphere<T> const sphere) noexcept
+{
+	ecefToGeod<Coord, Sphere<T>>(coord, sphere);
+}
 
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const lon = fromGeodetic.x[i];
-		auto const lat = fromGeodetic.y[i];
-		auto const alt = r + fromGeodetic.z[i];
-		auto const sin_lon = std::sin(lon);
-		auto const cos_lon = std::cos(lon);
-		auto const sin_lat = std::sin(lat);
-		auto const cos_lat = std::cos(lat);
-		toECEF->x[i] = alt*cos_lat*cos_lon;
-		toECEF->y[i] = alt*cos_lat*sin_lon;
-		toECEF->z[i] = alt*sin_lat;
-	}	
+template<typename T, typename Coord>
+inline
+void
+ecefToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromECEF,
+	Sphere<T> const sphere) noexcept
+{
+	ecefToGeod<Coord, Sphere<T>>(toGeodetic, fromECEF, sphere);
+}
+
+template<typename T, typename Coord>
+inline
+void
+geodToECEFSoA(
+	Coord * const TERRA_RESTRICT toECEF,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Sphere<T> const sphere) noexcept
+{
+	geodToECEFSoA<Coord, Sphere<T>>(toECEF, fromGeodetic, numCoords, sphere);
 }
 
 template<typename T, typename Coord, typename Coord2>
@@ -143,25 +258,10 @@ void
 geodToECEFAoS(
 	Coord * const TERRA_RESTRICT toECEF,
 	Coord2 const & TERRA_RESTRICT fromGeodetic,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept
 {
-	assert(toECEF && "toECEF is nullptr");
-
-	auto const r = sphere.radius;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const lon = fromGeodetic[i][0];
-		auto const lat = fromGeodetic[i][1];
-		auto const alt = r + fromGeodetic[i][2];
-		auto const sin_lon = std::sin(lon);
-		auto const cos_lon = std::cos(lon);
-		auto const sin_lat = std::sin(lat);
-		auto const cos_lat = std::cos(lat);
-		(*toECEF)[i][0] = alt*cos_lat*cos_lon;
-		(*toECEF)[i][1] = alt*cos_lat*sin_lon;
-		(*toECEF)[i][2] = alt*sin_lat;
-	}	
+	geodToECEFAoS<Coord, Coord2, Sphere<T>>(toECEF, fromGeodetic, numCoords, sphere);
 }
 
 template<typename T, typename Coord>
@@ -170,26 +270,10 @@ void
 ecefToGeodSoA(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord const & TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept
 {
-	assert(toGeodetic && "toGeodetic is nullptr");
-
-	auto const r = sphere.radius;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const x = fromECEF.x[i];
-		auto const y = fromECEF.y[i];
-		auto const z = fromECEF.z[i];
-		auto const p = std::sqrt(x*x + y*y);
-		auto const lon = std::atan2(y, x);
-		auto const lat = std::atan2(z, p);
-		auto const coslat = std::cos(lat);
-		auto const alt = (p/coslat) - r;
-		toGeodetic->x[i] = lon;
-		toGeodetic->y[i] = lat;
-		toGeodetic->z[i] = alt;
-	}	
+	ecefToGeodSoA<Coord, Sphere<T>>(toGeodetic, fromECEF, numCoords, sphere);
 }
 
 template<typename T, typename Coord, typename Coord2>
@@ -198,26 +282,10 @@ void
 ecefToGeodAoS(
 	Coord * const TERRA_RESTRICT toGeodetic,
 	Coord2 const & TERRA_RESTRICT fromECEF,
-	unsigned const numCoords,
+	std::size_t const numCoords,
 	Sphere<T> const sphere) noexcept
 {
-	assert(toGeodetic && "toGeodetic is nullptr");
-
-	auto const r = sphere.radius;
-
-	for (auto i = 0u; i < numCoords; ++i) {
-		auto const x = fromECEF[i][0];
-		auto const y = fromECEF[i][1];
-		auto const z = fromECEF[i][2];
-		auto const p = std::sqrt(x*x + y*y);
-		auto const lon = std::atan2(y, x);
-		auto const lat = std::atan2(z, p);
-		auto const coslat = std::cos(lat);
-		auto const alt = (p/coslat) - r;
-		(*toGeodetic)[i][0] = lon;
-		(*toGeodetic)[i][1] = lat;
-		(*toGeodetic)[i][2] = alt;
-	}	
+	ecefToGeodAoS<Coord, Coord2, Sphere<T>>(toGeodetic, fromECEF, numCoords, sphere);
 }
 
 } // !namespace terra
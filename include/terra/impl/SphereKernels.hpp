@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for Sphere<T>, expanded into every instruction set namespace
+ * by SimdForEach.hpp. Coordinates are passed as separate component arrays,
+ * for the public SoA functions, or as packed triples, for the AoS ones; the
+ * arrays may hold another floating-point type S, converted in registers. The
+ * sphere is a Sphere<T> or an Approximate<Sphere<float>>, either possibly
+ * wrapped in Degrees<>. The angles given to geodToECEF are vectors, or anything
+ * else sincos takes, like the reduced Quadrant<V> of FixedKernels.hpp.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+template<typename V, typename Angle, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEF(
+	V * const x,
+	V * const y,
+	V * const z,
+	Angle const lon,
+	Angle const lat,
+	V const alt,
+	Model const &sphere) noexcept
+{
+	auto const r = sphere.radius;
+
+	V sin_lon, cos_lon, sin_lat, cos_lat;
+	sincos(lon, &sin_lon, &cos_lon, sphere);
+	sincos(lat, &sin_lat, &cos_lat, sphere);
+	auto const n = r + alt;
+	auto const n_cos_lat = n*cos_lat;
+	*x = n_cos_lat*cos_lon;
+	*y = n_cos_lat*sin_lon;
+	*z = n*sin_lat;
+}
+
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeod(
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &sphere) noexcept
+{
+	auto const r = sphere.radius;
+
+	auto const p2 = x*x + y*y;
+	auto const p = sqrt(p2);
+	*lon = atan2(y, x, sphere);
+	*lat = atan2(z, p, sphere);
+	/* p/cos(lat) is the distance from the centre, which needs no cosine. */
+	*alt = sqrt(p2 + z*z) - r;
+}
+
+/* Spheres have the one algorithm, whichever an ellipsoid caller asks for. */
+template<typename Algorithm, typename V, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeod(
+	Algorithm,
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const z,
+	Model const &sphere) noexcept
+{
+	ecefToGeod(lon, lat, alt, x, y, z, sphere);
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEFSoA(
+	S * const TERRA_RESTRICT x,
+	S * const TERRA_RESTRICT y,
+	S * const TERRA_RESTRICT z,
+	S const * const TERRA_RESTRICT lon,
+	S const * const TERRA_RESTRICT lat,
+	S const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vz;
+		geodToECEF(&vx, &vy, &vz, loadAs<T>(lon + i), loadAs<T>(lat + i), loadAs<T>(alt + i), sphere);
+		storeAs(x + i, vx);
+		storeAs(y + i, vy);
+		storeAs(z + i, vz);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vx, vy, vz;
+		geodToECEF(&vx, &vy, &vz,
+			   loadPartialAs<T>(lon + i, rest), loadPartialAs<T>(lat + i, rest), loadPartialAs<T>(alt + i, rest),
+			   sphere);
+		storePartialAs<T>(x + i, vx, rest);
+		storePartialAs<T>(y + i, vy, rest);
+		storePartialAs<T>(z + i, vz, rest);
+	}
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		ecefToGeod(&vlon, &vlat, &valt, loadAs<T>(x + i), loadAs<T>(y + i), loadAs<T>(z + i), sphere);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		ecefToGeod(&vlon, &vlat, &valt,
+			   loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest), loadPartialAs<T>(z + i, rest),
+			   sphere);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToECEFAoS(
+	T * const TERRA_RESTRICT ecef,
+	T const * const TERRA_RESTRICT geodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V lon, lat, alt, x, y, z;
+		loadu3(geodetic + 3*i, &lon, &lat, &alt);
+		geodToECEF(&x, &y, &z, lon, lat, alt, sphere);
+		storeu3(ecef + 3*i, x, y, z);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V lon, lat, alt, x, y, z;
+		loadPartial3(geodetic + 3*i, rest, &lon, &lat, &alt);
+		geodToECEF(&x, &y, &z, lon, lat, alt, sphere);
+		storePartial3(ecef + 3*i, rest, x, y, z);
+	}
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodAoS(
+	T * const TERRA_RESTRICT geodetic,
+	T const * const TERRA_RESTRICT ecef,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V x, y, z, lon, lat, alt;
+		loadu3(ecef + 3*i, &x, &y, &z);
+		ecefToGeod(&lon, &lat, &alt, x, y, z, sphere);
+		storeu3(geodetic + 3*i, lon, lat, alt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V x, y, z, lon, lat, alt;
+		loadPartial3(ecef + 3*i, rest, &x, &y, &z);
+		ecefToGeod(&lon, &lat, &alt, x, y, z, sphere);
+		storePartial3(geodetic + 3*i, rest, lon, lat, alt);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
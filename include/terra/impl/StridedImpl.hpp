@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_StridedImpl_hpp
+#define terra_impl_StridedImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/Transpose.hpp>
+#include <terra/impl/Simd.hpp>
+
+namespace terra {
+
+namespace detail {
+
+/* Coordinate i of a component, i times stride bytes after the first. */
+template<typename T>
+inline
+T *
+element(T * const first, std::ptrdiff_t const stride, std::size_t const i) noexcept
+{
+	using Byte = typename std::conditional<std::is_const<T>::value, char const, char>::type;
+	return reinterpret_cast<T *>(reinterpret_cast<Byte *>(first) + static_cast<std::ptrdiff_t>(i)*stride);
+}
+
+/*
+ * Run an SoA kernel over strided coordinates. Plain arrays that are not
+ * converted in place go straight to the kernel; anything else a block at a
+ * time through stack buffers, like simd::runAoS, which also makes converting
+ * in place safe.
+ */
+template<typename T, typename U, typename Kernel, typename Model>
+inline
+void
+runStrided(
+	Kernel const kernel,
+	Strided<T> const &to,
+	Strided<U> const &from,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	static_assert(std::is_same<typename Strided<U>::value_type, T>::value,
+		      "input and output must have the same component type");
+
+	auto const planar = to.stride == std::ptrdiff_t(sizeof(T)) && from.stride == std::ptrdiff_t(sizeof(T));
+	auto const aliased = [&](T const * const p) {
+		return p == from.x || p == from.y || p == from.z;
+	};
+	if (planar && !aliased(to.x) && !aliased(to.y) && !aliased(to.z)) {
+		kernel(to.x, to.y, to.z, from.x, from.y, from.z, numCoords, model);
+		return;
+	}
+
+	constexpr std::size_t blockSize = 256;
+	T in0[blockSize], in1[blockSize], in2[blockSize];
+	T out0[blockSize], out1[blockSize], out2[blockSize];
+
+	for (auto i = std::size_t(0); i < numCoords; i += blockSize) {
+		auto const n = numCoords - i < blockSize ? numCoords - i : blockSize;
+		for (auto j = std::size_t(0); j < n; ++j) {
+			in0[j] = *element(from.x, from.stride, i + j);
+			in1[j] = *element(from.y, from.stride, i + j);
+			in2[j] = *element(from.z, from.stride, i + j);
+		}
+		kernel(out0, out1, out2, in0, in1, in2, n, model);
+		for (auto j = std::size_t(0); j < n; ++j) {
+			*element(to.x, to.stride, i + j) = out0[j];
+			*element(to.y, to.stride, i + j) = out1[j];
+			*element(to.z, to.stride, i + j) = out2[j];
+		}
+	}
+}
+
+} // !namespace detail
+
+template<typename T>
+inline
+Strided<T>
+strided(
+	T * const first,
+	std::ptrdiff_t const stride) noexcept
+{
+	return Strided<T>{ first, first + 1, first + 2, stride };
+}
+
+template<typename T>
+inline
+Strided<T>
+strided(
+	T * const x,
+	T * const y,
+	T * const z,
+	std::ptrdiff_t const stride) noexcept
+{
+	return Strided<T>{ x, y, z, stride };
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToECEFStrided(
+	Strided<T> * const coords,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(coords && "coords is nullptr");
+
+	geodToECEFStrided(coords, *coords, numCoords, model);
+}
+
+template<typename T, typename U, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToECEFStrided(
+	Strided<T> * const toECEF,
+	Strided<U> const &fromGeodetic,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	assert(toECEF && "toECEF is nullptr");
+
+	using Prepared = decltype(detail::prepare(model));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToECEFSoA<typename Prepared::value_type, Prepared, T>);
+	detail::runStrided(kernels[simd::levelIndex()], *toECEF, fromGeodetic, numCoords, detail::prepare(model));
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const coords,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(coords && "coords is nullptr");
+
+	ecefToGeodStrided(coords, *coords, numCoords, sphere);
+}
+
+template<typename Algorithm, typename T, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const coords,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	assert(coords && "coords is nullptr");
+
+	ecefToGeodStrided<Algorithm>(coords, *coords, numCoords, ellipsoid);
+}
+
+template<typename T, typename U, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const toGeodetic,
+	Strided<U> const &fromECEF,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodSoA<typename Model::value_type, Model, T>);
+	detail::runStrided(kernels[simd::levelIndex()], *toGeodetic, fromECEF, numCoords, sphere);
+}
+
+template<typename Algorithm, typename T, typename U, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefToGeodStrided(
+	Strided<T> * const toGeodetic,
+	Strided<U> const &fromECEF,
+	std::size_t const numCoords,
+	Model const ellipsoid) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Prepared = decltype(detail::prepare(ellipsoid));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToGeodSoA<Algorithm, typename Prepared::value_type, Prepared, T>);
+	detail::runStrided(kernels[simd::levelIndex()], *toGeodetic, fromECEF, numCoords, detail::prepare(ellipsoid));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_StridedImpl_hpp
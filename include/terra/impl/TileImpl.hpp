@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_TileImpl_hpp
+#define terra_impl_TileImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/impl/Simd.hpp>
+#include <cmath>
+#include <limits>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/TileKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+namespace detail {
+
+/* The element type of a TileCoord's arrays, checked to be one Tile supports. */
+template<typename TileCoord>
+struct TileElement {
+	using type = SoAElement<TileCoord>;
+
+	static_assert(std::is_same<type, float>::value || std::is_same<type, double>::value ||
+		      std::is_same<type, std::int16_t>::value || std::is_same<type, std::int32_t>::value,
+		      "tile offsets are float, double, std::int16_t or std::int32_t");
+};
+
+} // !namespace detail
+
+template<typename T>
+inline
+Tile<T>
+tile(
+	T const x,
+	T const y,
+	T const z,
+	T const scale) noexcept
+{
+	return Tile<T>{ { x, y, z }, scale };
+}
+
+template<typename TileCoord, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value || IsEllipsoid<Model>::value>::type
+geodToECEFTileSoA(
+	TileCoord * const TERRA_RESTRICT toTile,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Tile<typename Model::value_type> const &tile,
+	Model const model) noexcept
+{
+	assert(toTile && "toTile is nullptr");
+	assert(tile.scale > 0 && "tile.scale is not positive");
+
+	using Prepared = decltype(detail::prepare(model));
+	using T = typename Prepared::value_type;
+	using E = typename detail::TileElement<TileCoord>::type;
+	using Fn = void (*)(E *, E *, E *, T const *, T const *, T const *, std::size_t, Tile<T>, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToECEFTileSoA<T, E, Prepared>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toTile->x[0], &toTile->y[0], &toTile->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, tile, detail::prepare(model));
+}
+
+template<typename Coord, typename TileCoord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+ecefTileToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	TileCoord const & TERRA_RESTRICT fromTile,
+	std::size_t const numCoords,
+	Tile<typename Model::value_type> const &tile,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using E = typename detail::TileElement<TileCoord>::type;
+	using Fn = void (*)(T *, T *, T *, E const *, E const *, E const *, std::size_t, Tile<T>, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefTileToGeodSoA<Bowring, T, E, Model>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromTile.x[0], &fromTile.y[0], &fromTile.z[0],
+			numCoords, tile, sphere);
+}
+
+template<typename Algorithm, typename Coord, typename TileCoord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value && IsEcefToGeodAlgorithm<Algorithm>::value>::type
+ecefTileToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	TileCoord const & TERRA_RESTRICT fromTile,
+	std::size_t const numCoords,
+	Tile<typename Model::value_type> const &tile,
+	Model const ellipsoid) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Prepared = decltype(detail::prepare(ellipsoid));
+	using T = typename Prepared::value_type;
+	using E = typename detail::TileElement<TileCoord>::type;
+	using Fn = void (*)(T *, T *, T *, E const *, E const *, E const *, std::size_t, Tile<T>, Prepared);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefTileToGeodSoA<Algorithm, T, E, Prepared>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromTile.x[0], &fromTile.y[0], &fromTile.z[0],
+			numCoords, tile, detail::prepare(ellipsoid));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_TileImpl_hpp
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for ECEF coordinates stored relative to a tile centre,
+ * expanded into every instruction set namespace by SimdForEach.hpp. The
+ * offsets are converted from and to their storage type a vector at a time
+ * through a buffer of T, around the sphere and ellipsoid per-point kernels.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+namespace tile {
+
+/* The first n offsets at p, the rest of the vector zero. */
+template<typename T, typename E>
+inline
+typename VecType<T>::type
+load(E const * const p, std::size_t const n) noexcept
+{
+	T buf[VecType<T>::width] = {};
+	for (auto j = std::size_t(0); j < n; ++j)
+		buf[j] = T(p[j]);
+	return loadu(buf);
+}
+
+/*
+ * The first n lanes of v to p. NaN, which units() passes through in scalar,
+ * stores as the least E for integers, as the vector max() leaves it.
+ */
+template<typename T, typename E, typename V>
+inline
+void
+store(E * const p, V const v, std::size_t const n) noexcept
+{
+	T buf[VecType<T>::width];
+	storeu(buf, v);
+	for (auto j = std::size_t(0); j < n; ++j)
+		p[j] = buf[j] == buf[j] || std::is_floating_point<E>::value ? E(buf[j]) : std::numeric_limits<E>::min();
+}
+
+/* Integers round to the nearest unit, saturating at the ends of E's range. */
+template<typename T, typename E, typename V>
+inline
+typename std::enable_if<std::is_floating_point<E>::value, V>::type
+units(V const x) noexcept
+{
+	return x;
+}
+
+template<typename T, typename E, typename V>
+inline
+typename std::enable_if<std::is_integral<E>::value, V>::type
+units(V const x) noexcept
+{
+	/* The largest T not above the largest E: 2^31 - 128 for int32 in float. */
+	auto const emax = std::numeric_limits<E>::max();
+	auto const top = double(T(emax)) > double(emax) ? std::nextafter(T(emax), T(0)) : T(emax);
+	return min(max(round(x), V(T(std::numeric_limits<E>::min()))), V(top));
+}
+
+} // !namespace tile
+
+template<typename T, typename E, typename Model>
+inline
+void
+geodToECEFTileSoA(
+	E * const TERRA_RESTRICT x,
+	E * const TERRA_RESTRICT y,
+	E * const TERRA_RESTRICT z,
+	T const * const TERRA_RESTRICT lon,
+	T const * const TERRA_RESTRICT lat,
+	T const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	Tile<T> const tile,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+	V const cx(tile.centre[0]), cy(tile.centre[1]), cz(tile.centre[2]);
+	V const inverseScale(T(1)/tile.scale);
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vz;
+		geodToECEF(&vx, &vy, &vz, loadu(lon + i), loadu(lat + i), loadu(alt + i), model);
+		tile::store<T>(x + i, tile::units<T, E>((vx - cx)*inverseScale), width);
+		tile::store<T>(y + i, tile::units<T, E>((vy - cy)*inverseScale), width);
+		tile::store<T>(z + i, tile::units<T, E>((vz - cz)*inverseScale), width);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vx, vy, vz;
+		geodToECEF(&vx, &vy, &vz, loadPartial(lon + i, rest), loadPartial(lat + i, rest), loadPartial(alt + i, rest),
+			   model);
+		tile::store<T>(x + i, tile::units<T, E>((vx - cx)*inverseScale), rest);
+		tile::store<T>(y + i, tile::units<T, E>((vy - cy)*inverseScale), rest);
+		tile::store<T>(z + i, tile::units<T, E>((vz - cz)*inverseScale), rest);
+	}
+}
+
+template<typename Algorithm, typename T, typename E, typename Model>
+inline
+void
+ecefTileToGeodSoA(
+	T * const TERRA_RESTRICT lon,
+	T * const TERRA_RESTRICT lat,
+	T * const TERRA_RESTRICT alt,
+	E const * const TERRA_RESTRICT x,
+	E const * const TERRA_RESTRICT y,
+	E const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	Tile<T> const tile,
+	Model const model) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+	V const cx(tile.centre[0]), cy(tile.centre[1]), cz(tile.centre[2]);
+	V const scale(tile.scale);
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt,
+			   fma(tile::load<T>(x + i, width), scale, cx),
+			   fma(tile::load<T>(y + i, width), scale, cy),
+			   fma(tile::load<T>(z + i, width), scale, cz),
+			   model);
+		storeu(lon + i, vlon);
+		storeu(lat + i, vlat);
+		storeu(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		ecefToGeod(Algorithm(), &vlon, &vlat, &valt,
+			   fma(tile::load<T>(x + i, rest), scale, cx),
+			   fma(tile::load<T>(y + i, rest), scale, cy),
+			   fma(tile::load<T>(z + i, rest), scale, cz),
+			   model);
+		storePartial(lon + i, vlon, rest);
+		storePartial(lat + i, vlat, rest);
+		storePartial(alt + i, valt, rest);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_TransposeImpl_hpp
+#define terra_impl_TransposeImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/impl/Simd.hpp>
+#include <array>
+#include <type_traits>
+#include <vector>
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/TransposeKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+namespace detail {
+
+/* Whether a row of an AoS array is three T back to back. */
+template<typename Row, typename T>
+struct IsPackedRow : std::false_type {};
+template<typename T>
+struct IsPackedRow<T[3], T> : std::true_type {};
+template<typename T>
+struct IsPackedRow<std::array<T, 3>, T> : std::integral_constant<bool, sizeof(std::array<T, 3>) == 3*sizeof(T)> {};
+
+/*
+ * Whether an AoS array keeps its rows back to back, so that it can be read as
+ * one array of T. Parallel.hpp adds its chunk views.
+ */
+template<typename Coord, typename T>
+struct IsPackedAoS : std::false_type {};
+template<typename Row, typename T>
+struct IsPackedAoS<Row *, T> : IsPackedRow<typename std::remove_cv<Row>::type, T> {};
+template<typename Row, std::size_t N, typename T>
+struct IsPackedAoS<Row[N], T> : IsPackedRow<typename std::remove_cv<Row>::type, T> {};
+template<typename Row, std::size_t N, typename T>
+struct IsPackedAoS<std::array<Row, N>, T> : IsPackedRow<Row, T> {};
+template<typename Row, typename Allocator, typename T>
+struct IsPackedAoS<std::vector<Row, Allocator>, T> : IsPackedRow<Row, T> {};
+
+template<typename T, typename Coord>
+using PackedAoS = IsPackedAoS<typename std::remove_cv<Coord>::type, T>;
+
+/* Read numCoords rows, from row offset on, into separate component arrays. */
+template<typename T, typename Coord>
+inline
+void
+gatherAoS(
+	T * const TERRA_RESTRICT x,
+	T * const TERRA_RESTRICT y,
+	T * const TERRA_RESTRICT z,
+	Coord const & TERRA_RESTRICT from,
+	std::size_t const offset,
+	std::size_t const numCoords,
+	std::true_type) noexcept
+{
+	using Fn = void (*)(T *, T *, T *, T const *, std::size_t);
+	TERRA_SIMD_TABLE(Fn, kernels, aosToSoA<T>);
+	kernels[simd::levelIndex()](x, y, z, &from[offset][0], numCoords);
+}
+
+template<typename T, typename Coord>
+inline
+void
+gatherAoS(
+	T * const TERRA_RESTRICT x,
+	T * const TERRA_RESTRICT y,
+	T * const TERRA_RESTRICT z,
+	Coord const & TERRA_RESTRICT from,
+	std::size_t const offset,
+	std::size_t const numCoords,
+	std::false_type) noexcept
+{
+	for (auto i = std::size_t(0); i < numCoords; ++i) {
+		x[i] = from[offset + i][0];
+		y[i] = from[offset + i][1];
+		z[i] = from[offset + i][2];
+	}
+}
+
+/* Write numCoords rows, from row offset on, from separate component arrays. */
+template<typename T, typename Coord>
+inline
+void
+scatterAoS(
+	Coord * const TERRA_RESTRICT to,
+	std::size_t const offset,
+	T const * const TERRA_RESTRICT x,
+	T const * const TERRA_RESTRICT y,
+	T const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	std::true_type) noexcept
+{
+	using Fn = void (*)(T *, T const *, T const *, T const *, std::size_t);
+	TERRA_SIMD_TABLE(Fn, kernels, soaToAoS<T>);
+	kernels[simd::levelIndex()](&(*to)[offset][0], x, y, z, numCoords);
+}
+
+template<typename T, typename Coord>
+inline
+void
+scatterAoS(
+	Coord * const TERRA_RESTRICT to,
+	std::size_t const offset,
+	T const * const TERRA_RESTRICT x,
+	T const * const TERRA_RESTRICT y,
+	T const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	std::false_type) noexcept
+{
+	for (auto i = std::size_t(0); i < numCoords; ++i) {
+		(*to)[offset + i][0] = x[i];
+		(*to)[offset + i][1] = y[i];
+		(*to)[offset + i][2] = z[i];
+	}
+}
+
+} // !namespace detail
+
+namespace simd {
+
+/*
+ * Run a kernel over AoS input. Packed rows on both sides go to the packed
+ * kernel, which transposes in registers. Anything else runs the SoA kernel a
+ * block at a time through stack buffers small enough to stay in L1, with
+ * packed rows on either side transposed by shuffles and any other 3-tuple
+ * type with operator[] copied element by element.
+ */
+template<typename T, typename Kernel, typename PackedKernel, typename Coord, typename Coord2, typename Model>
+inline
+void
+runAoS(
+	Kernel const kernel,
+	PackedKernel const,
+	Coord * const TERRA_RESTRICT to,
+	Coord2 const & TERRA_RESTRICT from,
+	std::size_t const numCoords,
+	Model const model,
+	std::false_type) noexcept
+{
+	constexpr std::size_t blockSize = 256;
+	T in0[blockSize], in1[blockSize], in2[blockSize];
+	T out0[blockSize], out1[blockSize], out2[blockSize];
+
+	for (auto i = std::size_t(0); i < numCoords; i += blockSize) {
+		auto const n = numCoords - i < blockSize ? numCoords - i : blockSize;
+		detail::gatherAoS(in0, in1, in2, from, i, n, detail::PackedAoS<T, Coord2>());
+		kernel(out0, out1, out2, in0, in1, in2, n, model);
+		detail::scatterAoS<T>(to, i, out0, out1, out2, n, detail::PackedAoS<T, Coord>());
+	}
+}
+
+template<typename T, typename Kernel, typename PackedKernel, typename Coord, typename Coord2, typename Model>
+inline
+void
+runAoS(
+	Kernel const,
+	PackedKernel const packedKernel,
+	Coord * const TERRA_RESTRICT to,
+	Coord2 const & TERRA_RESTRICT from,
+	std::size_t const numCoords,
+	Model const model,
+	std::true_type) noexcept
+{
+	if (numCoords)
+		packedKernel(&(*to)[0][0], &from[0][0], numCoords, model);
+}
+
+template<typename T, typename Kernel, typename PackedKernel, typename Coord, typename Coord2, typename Model>
+inline
+void
+runAoS(
+	Kernel const kernel,
+	PackedKernel const packedKernel,
+	Coord * const TERRA_RESTRICT to,
+	Coord2 const & TERRA_RESTRICT from,
+	std::size_t const numCoords,
+	Model const model) noexcept
+{
+	using Packed = std::integral_constant<bool, detail::PackedAoS<T, Coord>::value &&
+						    detail::PackedAoS<T, Coord2>::value>;
+	runAoS<T>(kernel, packedKernel, to, from, numCoords, model, Packed());
+}
+
+} // !namespace simd
+
+template<typename Coord, typename Coord2>
+inline
+void
+aosToSoA(
+	Coord * const TERRA_RESTRICT toSoA,
+	Coord2 const & TERRA_RESTRICT fromAoS,
+	std::size_t const numCoords) noexcept
+{
+	assert(toSoA && "toSoA is nullptr");
+
+	using T = typename std::remove_reference<decltype(toSoA->x[0])>::type;
+	if (numCoords)
+		detail::gatherAoS(&toSoA->x[0], &toSoA->y[0], &toSoA->z[0], fromAoS, 0, numCoords,
+				  detail::PackedAoS<T, Coord2>());
+}
+
+template<typename Coord2, typename Coord>
+inline
+void
+soaToAoS(
+	Coord2 * const TERRA_RESTRICT toAoS,
+	Coord const & TERRA_RESTRICT fromSoA,
+	std::size_t const numCoords) noexcept
+{
+	assert(toAoS && "toAoS is nullptr");
+
+	using T = typename std::remove_cv<typename std::remove_reference<decltype(fromSoA.x[0])>::type>::type;
+	if (numCoords)
+		detail::scatterAoS<T>(toAoS, 0, &fromSoA.x[0], &fromSoA.y[0], &fromSoA.z[0], numCoords,
+				      detail::PackedAoS<T, Coord2>());
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_TransposeImpl_hpp
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Transposes between packed x, y, z triples and separate component arrays,
+ * expanded into every instruction set namespace by SimdForEach.hpp. Whole
+ * vectors go through loadu3/storeu3; the remainder one triple at a time. The
+ * packed AoS kernels use the partial forms below for their last vector.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/* The first n < width triples at p, the other lanes zero. */
+template<typename T, typename V>
+inline
+void
+loadPartial3(T const * const p, std::size_t const n, V * const x, V * const y, V * const z) noexcept
+{
+	T buf[3*VecType<T>::width] = {};
+	std::memcpy(buf, p, 3*n*sizeof *p);
+	loadu3(buf, x, y, z);
+}
+
+template<typename T, typename V>
+inline
+void
+storePartial3(T * const p, std::size_t const n, V const x, V const y, V const z) noexcept
+{
+	T buf[3*VecType<T>::width];
+	storeu3(buf, x, y, z);
+	std::memcpy(p, buf, 3*n*sizeof *p);
+}
+
+template<typename T>
+inline
+void
+aosToSoA(
+	T * const TERRA_RESTRICT x,
+	T * const TERRA_RESTRICT y,
+	T * const TERRA_RESTRICT z,
+	T const * const TERRA_RESTRICT aos,
+	std::size_t const numCoords) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vz;
+		loadu3(aos + 3*i, &vx, &vy, &vz);
+		storeu(x + i, vx);
+		storeu(y + i, vy);
+		storeu(z + i, vz);
+	}
+	for (; i < numCoords; ++i) {
+		x[i] = aos[3*i + 0];
+		y[i] = aos[3*i + 1];
+		z[i] = aos[3*i + 2];
+	}
+}
+
+template<typename T>
+inline
+void
+soaToAoS(
+	T * const TERRA_RESTRICT aos,
+	T const * const TERRA_RESTRICT x,
+	T const * const TERRA_RESTRICT y,
+	T const * const TERRA_RESTRICT z,
+	std::size_t const numCoords) noexcept
+{
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width)
+		storeu3(aos + 3*i, loadu(x + i), loadu(y + i), loadu(z + i));
+	for (; i < numCoords; ++i) {
+		aos[3*i + 0] = x[i];
+		aos[3*i + 1] = y[i];
+		aos[3*i + 2] = z[i];
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
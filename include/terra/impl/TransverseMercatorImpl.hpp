@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_TransverseMercatorImpl_hpp
+#define terra_impl_TransverseMercatorImpl_hpp
+
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/Transpose.hpp>
+#include <terra/impl/Simd.hpp>
+#include <cmath>
+#include <type_traits>
+
+namespace terra {
+namespace detail {
+
+/* A projection and the reference body of its geodetic coordinates, passed as one. */
+template<typename Projection, typename Model>
+struct ProjectedModel {
+	static_assert(std::is_same<typename Model::value_type, typename Projection::value_type>::value,
+		      "the reference body must use the projection's floating-point type");
+
+	Projection projection;
+	Model model;
+};
+
+template<typename Projection, typename Model>
+inline
+auto
+projectedModel(Projection const &projection, Model const model) noexcept
+	-> ProjectedModel<Projection, decltype(prepare(model))>
+{
+	return ProjectedModel<Projection, decltype(prepare(model))>{ projection, prepare(model) };
+}
+
+/* An angle in degrees, in the unit of the model's angles, and back. */
+template<typename Model>
+inline
+typename Model::value_type
+fromDegrees(double const x, Model const &) noexcept
+{
+	return typename Model::value_type(x*(3.14159265358979323846/180.0));
+}
+
+template<typename Model>
+inline
+typename Model::value_type
+fromDegrees(double const x, Degrees<Model> const &) noexcept
+{
+	return typename Model::value_type(x);
+}
+
+template<typename Model>
+inline
+double
+toDegrees(typename Model::value_type const x, Model const &) noexcept
+{
+	return double(x)*(180.0/3.14159265358979323846);
+}
+
+template<typename Model>
+inline
+double
+toDegrees(typename Model::value_type const x, Degrees<Model> const &) noexcept
+{
+	return double(x);
+}
+
+} // !namespace detail
+} // !namespace terra
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/TransverseMercatorKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+/*
+ * The coefficients are Karney's (2011) eqs. 35 and 36, summed in double from
+ * the third flattening n whatever T is; the rectifying radius is eq. 14.
+ */
+template<typename T>
+template<typename Model>
+inline
+TransverseMercator<T>::TransverseMercator(
+	T const centralMeridian,
+	Model const model,
+	T const scale,
+	T const falseEasting,
+	T const falseNorthing) noexcept :
+	centralMeridian(centralMeridian),
+	falseEasting(falseEasting),
+	falseNorthing(falseNorthing)
+{
+	static_assert(std::is_same<typename Model::value_type, T>::value,
+		      "the reference body must use the projection's floating-point type");
+
+	auto const ellipsoid = detail::prepare(model);
+	simd::scalar::sincos(centralMeridian, &sinCentral, &cosCentral, ellipsoid);
+
+	auto const a = double(ellipsoid.semiMajor);
+	auto const b = double(ellipsoid.semiMinor);
+	auto const n = (a - b)/(a + b);
+	auto const n2 = n*n;
+	auto const n3 = n2*n;
+	auto const n4 = n3*n;
+	auto const n5 = n4*n;
+	auto const n6 = n5*n;
+	scaledRadius = T(double(scale)*a/(1.0 + n)*(1.0 + n2*(1.0/4 + n2*(1.0/64 + n2*(1.0/256)))));
+	eccentricity = T(std::sqrt((a - b)*(a + b))/a);
+
+	alpha[0] = T(n*(1.0/2 + n*(-2.0/3 + n*(5.0/16 + n*(41.0/180 + n*(-127.0/288 + n*(7891.0/37800)))))));
+	alpha[1] = T(n2*(13.0/48 + n*(-3.0/5 + n*(557.0/1440 + n*(281.0/630 + n*(-1983433.0/1935360))))));
+	alpha[2] = T(n3*(61.0/240 + n*(-103.0/140 + n*(15061.0/26880 + n*(167603.0/181440)))));
+	alpha[3] = T(n4*(49561.0/161280 + n*(-179.0/168 + n*(6601661.0/7257600))));
+	alpha[4] = T(n5*(34729.0/80640 + n*(-3418889.0/1995840)));
+	alpha[5] = T(n6*(212378941.0/319334400));
+
+	beta[0] = T(n*(1.0/2 + n*(-2.0/3 + n*(37.0/96 + n*(-1.0/360 + n*(-81.0/512 + n*(96199.0/604800)))))));
+	beta[1] = T(n2*(1.0/48 + n*(1.0/15 + n*(-437.0/1440 + n*(46.0/105 + n*(-1118711.0/3870720))))));
+	beta[2] = T(n3*(17.0/480 + n*(-37.0/840 + n*(-209.0/4480 + n*(5569.0/90720)))));
+	beta[3] = T(n4*(4397.0/161280 + n*(-11.0/504 + n*(-830251.0/7257600))));
+	beta[4] = T(n5*(4583.0/161280 + n*(-108847.0/3991680)));
+	beta[5] = T(n6*(20648693.0/638668800));
+}
+
+template<typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value, TransverseMercator<typename Model::value_type>>::type
+utm(
+	unsigned const zone,
+	bool const north,
+	Model const model) noexcept
+{
+	assert(zone >= 1 && zone <= 60 && "zone is not within 1 to 60");
+
+	using T = typename Model::value_type;
+	return TransverseMercator<T>(detail::fromDegrees(6.0*zone - 183.0, model), model, T(0.9996), T(500000),
+				     north ? T(0) : T(10000000));
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value, unsigned>::type
+utmZone(
+	T const lon,
+	T const lat,
+	Model const model) noexcept
+{
+	static_assert(std::is_same<typename Model::value_type, T>::value,
+		      "the reference body must use the coordinate's floating-point type");
+
+	auto const phi = detail::toDegrees(lat, model);
+	auto lambda = detail::toDegrees(lon, model);
+	lambda -= 360.0*std::floor((lambda + 180.0)/360.0);
+	auto zone = unsigned((lambda + 180.0)/6.0) + 1;
+	if (zone > 60)
+		zone = 60;
+
+	if (phi >= 56.0 && phi < 64.0 && lambda >= 3.0 && lambda < 12.0)
+		zone = 32;
+	else if (phi >= 72.0 && phi <= 84.0 && lambda >= 0.0 && lambda < 42.0)
+		zone = lambda < 9.0 ? 31 : lambda < 21.0 ? 33 : lambda < 33.0 ? 35 : 37;
+	return zone;
+}
+
+/* The single coordinate functions run the scalar instance of the per-point kernels. */
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercator(
+	Coord * const coord,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T e, n, h;
+	simd::scalar::geodToTransverseMercator<T>(&e, &n, &h, (*coord)[0], (*coord)[1], (*coord)[2],
+						  detail::projectedModel(projection, model));
+	(*coord)[0] = e;
+	(*coord)[1] = n;
+	(*coord)[2] = h;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercator(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGrid && "toGrid is nullptr");
+
+	T e, n, h;
+	simd::scalar::geodToTransverseMercator<T>(&e, &n, &h, fromGeodetic[0], fromGeodetic[1], fromGeodetic[2],
+						  detail::projectedModel(projection, model));
+	(*toGrid)[0] = e;
+	(*toGrid)[1] = n;
+	(*toGrid)[2] = h;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeod(
+	Coord * const coord,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T lon, lat, alt;
+	simd::scalar::transverseMercatorToGeod<T>(&lon, &lat, &alt, (*coord)[0], (*coord)[1], (*coord)[2],
+						  detail::projectedModel(projection, model));
+	(*coord)[0] = lon;
+	(*coord)[1] = lat;
+	(*coord)[2] = alt;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGrid,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	T lon, lat, alt;
+	simd::scalar::transverseMercatorToGeod<T>(&lon, &lat, &alt, fromGrid[0], fromGrid[1], fromGrid[2],
+						  detail::projectedModel(projection, model));
+	(*toGeodetic)[0] = lon;
+	(*toGeodetic)[1] = lat;
+	(*toGeodetic)[2] = alt;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercator(
+	Coord * const coord,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	T e, n, h;
+	simd::scalar::ecefToTransverseMercator<T>(&e, &n, &h, (*coord)[0], (*coord)[1], (*coord)[2],
+						  detail::projectedModel(projection, model));
+	(*coord)[0] = e;
+	(*coord)[1] = n;
+	(*coord)[2] = h;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercator(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromECEF,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGrid && "toGrid is nullptr");
+
+	T e, n, h;
+	simd::scalar::ecefToTransverseMercator<T>(&e, &n, &h, fromECEF[0], fromECEF[1], fromECEF[2],
+						  detail::projectedModel(projection, model));
+	(*toGrid)[0] = e;
+	(*toGrid)[1] = n;
+	(*toGrid)[2] = h;
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercatorSoA(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGrid && "toGrid is nullptr");
+
+	using Projected = decltype(detail::projectedModel(projection, model));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToTransverseMercatorSoA<T, decltype(Projected::model), S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGrid->x[0], &toGrid->y[0], &toGrid->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, detail::projectedModel(projection, model));
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromGrid,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Projected = decltype(detail::projectedModel(projection, model));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(Fn, kernels, transverseMercatorToGeodSoA<T, decltype(Projected::model), S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromGrid.x[0], &fromGrid.y[0], &fromGrid.z[0],
+			numCoords, detail::projectedModel(projection, model));
+}
+
+template<typename T, typename Coord, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercatorSoA(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGrid && "toGrid is nullptr");
+
+	using Projected = decltype(detail::projectedModel(projection, model));
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToTransverseMercatorSoA<T, decltype(Projected::model), S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGrid->x[0], &toGrid->y[0], &toGrid->z[0],
+			&fromECEF.x[0], &fromECEF.y[0], &fromECEF.z[0],
+			numCoords, detail::projectedModel(projection, model));
+}
+
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+geodToTransverseMercatorAoS(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGrid && "toGrid is nullptr");
+
+	using Projected = decltype(detail::projectedModel(projection, model));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToTransverseMercatorSoA<T, decltype(Projected::model)>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, geodToTransverseMercatorAoS<T, decltype(Projected::model)>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGrid, fromGeodetic, numCoords,
+			detail::projectedModel(projection, model));
+}
+
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+transverseMercatorToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromGrid,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using Projected = decltype(detail::projectedModel(projection, model));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(Fn, kernels, transverseMercatorToGeodSoA<T, decltype(Projected::model)>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, transverseMercatorToGeodAoS<T, decltype(Projected::model)>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGeodetic, fromGrid, numCoords,
+			detail::projectedModel(projection, model));
+}
+
+template<typename T, typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsEllipsoid<Model>::value>::type
+ecefToTransverseMercatorAoS(
+	Coord * const TERRA_RESTRICT toGrid,
+	Coord2 const & TERRA_RESTRICT fromECEF,
+	std::size_t const numCoords,
+	TransverseMercator<T> const &projection,
+	Model const model) noexcept
+{
+	assert(toGrid && "toGrid is nullptr");
+
+	using Projected = decltype(detail::projectedModel(projection, model));
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(Fn, kernels, ecefToTransverseMercatorSoA<T, decltype(Projected::model)>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Projected);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, ecefToTransverseMercatorAoS<T, decltype(Projected::model)>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGrid, fromECEF, numCoords,
+			detail::projectedModel(projection, model));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_TransverseMercatorImpl_hpp
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for TransverseMercator<T>, expanded into every instruction set
+ * namespace by SimdForEach.hpp. Both directions pass through the conformal
+ * sphere, as in Karney (2011), "Transverse Mercator with an accuracy of a few
+ * nanometers", J. Geodesy 85: the conformal latitude, then Krüger's series in
+ * the complex angle zeta = xi + i eta, summed by Clenshaw's recurrence from
+ * the sine and cosine of 2 xi and the sinh and cosh of 2 eta. Going forward
+ * those follow algebraically from the sines and cosines of latitude and
+ * longitude, which leaves one atan2 and one log; going back takes a sincos
+ * and an exp per angle and two Newton steps for the latitude.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/*
+ * sinh(e atanh(e s)) for the sine s of a latitude: how far the tangent of the
+ * conformal latitude is shifted from it. e s stays below 0.1 on terrestrial
+ * ellipsoids, where both functions are short odd series, exact to rounding.
+ */
+template<typename V, typename T>
+inline
+V
+conformalShift(V const s, T const e) noexcept
+{
+	auto const x = s*e;
+	auto const x2 = x*x;
+	auto p = fma(x2, V(T(1.0/15)), V(T(1.0/13)));
+	p = fma(p, x2, V(T(1.0/11)));
+	p = fma(p, x2, V(T(1.0/9)));
+	p = fma(p, x2, V(T(1.0/7)));
+	p = fma(p, x2, V(T(1.0/5)));
+	p = fma(p, x2, V(T(1.0/3)));
+	auto const q = (x*e)*fma(p, x2, V(T(1)));
+	auto const q2 = q*q;
+	auto h = fma(q2, V(T(1.0/5040)), V(T(1.0/120)));
+	h = fma(h, q2, V(T(1.0/6)));
+	return fma(q*q2, h, q);
+}
+
+/*
+ * The sum of c[k] sin(2(k + 1) zeta) over the six terms. With a = 2 cos(2 zeta),
+ * y_k = c_k + a y_k+1 - y_k+2 and the sum is y_1 sin(2 zeta), all complex.
+ */
+template<typename V, typename T>
+inline
+void
+kruger(
+	V * const dxi,
+	V * const deta,
+	V const sin2xi,
+	V const cos2xi,
+	V const sinh2eta,
+	V const cosh2eta,
+	T const (&c)[6]) noexcept
+{
+	auto const ar = T(2)*(cos2xi*cosh2eta);
+	auto const ai = T(-2)*(sin2xi*sinh2eta);
+	auto yr = V(c[5]);
+	auto yi = V(T(0));
+	auto yr1 = V(T(0));
+	auto yi1 = V(T(0));
+	for (auto k = 4; k >= 0; --k) {
+		auto const tr = (ar*yr - ai*yi - yr1) + c[k];
+		auto const ti = ar*yi + ai*yr - yi1;
+		yr1 = yr;
+		yi1 = yi;
+		yr = tr;
+		yi = ti;
+	}
+	auto const sr = sin2xi*cosh2eta;
+	auto const si = cos2xi*sinh2eta;
+	*dxi = yr*sr - yi*si;
+	*deta = yr*si + yi*sr;
+}
+
+/*
+ * Easting and northing of a point given the sine and cosine of its latitude
+ * and of its longitude from the central meridian. s, c is the conformal
+ * latitude scaled by cos(lat) and the cosine of the longitude, which makes
+ * the angle xi; the rest of their hypotenuse is sinh(eta).
+ */
+template<typename V, typename T, typename Model>
+inline
+void
+conformalToTransverseMercator(
+	V * const easting,
+	V * const northing,
+	V const sin_lat,
+	V const cos_lat,
+	V const sin_lam,
+	V const cos_lam,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const &pm) noexcept
+{
+	auto const &tm = pm.projection;
+	auto const sigma = conformalShift(sin_lat, tm.eccentricity);
+	auto const s = sin_lat*sqrt(fma(sigma, sigma, V(T(1)))) - sigma;
+	auto const c = cos_lat*cos_lam;
+	auto const inv_r = rsqrt(s*s + c*c, pm.model);
+	auto const sin_xi = s*inv_r;
+	auto const cos_xi = c*inv_r;
+	auto const sinh_eta = (cos_lat*sin_lam)*inv_r;
+	auto const cosh_eta = sqrt(fma(sinh_eta, sinh_eta, V(T(1))));
+	auto const xi = atan2(s, c, radians(pm.model));
+	auto const abs_eta = log(abs(sinh_eta) + cosh_eta);
+	auto const eta = select(sinh_eta < T(0), -abs_eta, abs_eta);
+
+	V dxi, deta;
+	kruger(&dxi, &deta, T(2)*(sin_xi*cos_xi), (cos_xi - sin_xi)*(cos_xi + sin_xi),
+	       T(2)*(sinh_eta*cosh_eta), fma(T(2)*sinh_eta, sinh_eta, V(T(1))), tm.alpha);
+	*easting = fma(eta + deta, V(tm.scaledRadius), V(tm.falseEasting));
+	*northing = fma(xi + dxi, V(tm.scaledRadius), V(tm.falseNorthing));
+}
+
+template<typename V, typename T, typename Model>
+inline
+void
+geodToTransverseMercator(
+	V * const easting,
+	V * const northing,
+	V * const height,
+	V const lon,
+	V const lat,
+	V const alt,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const &pm) noexcept
+{
+	V sin_lat, cos_lat, sin_lam, cos_lam;
+	sincos(lat, &sin_lat, &cos_lat, pm.model);
+	sincos(lon - pm.projection.centralMeridian, &sin_lam, &cos_lam, pm.model);
+	conformalToTransverseMercator(easting, northing, sin_lat, cos_lat, sin_lam, cos_lam, pm);
+	*height = alt;
+}
+
+/*
+ * The longitude from the central meridian is x, y rotated by it, the latitude
+ * one Bowring step as an unnormalised pair; neither becomes an angle.
+ */
+template<typename V, typename T, typename Model>
+inline
+void
+ecefToTransverseMercator(
+	V * const easting,
+	V * const northing,
+	V * const height,
+	V const x,
+	V const y,
+	V const z,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const &pm) noexcept
+{
+	auto const &tm = pm.projection;
+	auto const p = sqrt(x*x + y*y);
+	auto const axis = p == T(0);
+	auto const inv_p = T(1)/select(axis, V(T(1)), p);
+	auto const cos_lam = select(axis, V(T(1)), (x*tm.cosCentral + y*tm.sinCentral)*inv_p);
+	auto const sin_lam = (y*tm.cosCentral - x*tm.sinCentral)*inv_p;
+
+	V num, den;
+	bowring<1>(&num, &den, p, z, pm.model);
+	auto const inv_r = rsqrt(num*num + den*den, pm.model);
+	conformalToTransverseMercator(easting, northing, num*inv_r, den*inv_r, sin_lam, cos_lam, pm);
+	*height = altitude(p, z, num, den, pm.model);
+}
+
+/*
+ * The series back to the conformal sphere, then Newton on the tangent of the
+ * latitude, from tau' = tan(conformal latitude), which is clamped so that the
+ * poles stay finite.
+ */
+template<typename V, typename T, typename Model>
+inline
+void
+transverseMercatorToGeod(
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const easting,
+	V const northing,
+	V const height,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const &pm) noexcept
+{
+	auto const &tm = pm.projection;
+	auto const e = tm.eccentricity;
+	auto const one_e2 = T(1) - e*e;
+	auto const inv_k = T(1)/tm.scaledRadius;
+	auto const xi = (northing - tm.falseNorthing)*inv_k;
+	auto const eta = (easting - tm.falseEasting)*inv_k;
+
+	V sin2xi, cos2xi;
+	sincos(xi + xi, &sin2xi, &cos2xi, radians(pm.model));
+	auto const exp2eta = exp(eta + eta);
+	auto const inv_exp2eta = T(1)/exp2eta;
+	V dxi, deta;
+	kruger(&dxi, &deta, sin2xi, cos2xi, T(0.5)*(exp2eta - inv_exp2eta), T(0.5)*(exp2eta + inv_exp2eta), tm.beta);
+
+	V sin_xi, cos_xi;
+	sincos(xi - dxi, &sin_xi, &cos_xi, radians(pm.model));
+	auto const exp_eta = exp(eta - deta);
+	auto const sinh_eta = T(0.5)*(exp_eta - T(1)/exp_eta);
+	auto const tau1 = min(max(sin_xi*rsqrt(sinh_eta*sinh_eta + cos_xi*cos_xi, pm.model), V(T(-1e15))), V(T(1e15)));
+
+	auto tau = tau1*(T(1)/one_e2);
+	for (auto i = 0; i < 2; ++i) {
+		auto const r = sqrt(fma(tau, tau, V(T(1))));
+		auto const sigma = conformalShift(tau/r, e);
+		auto const tau_i = tau*sqrt(fma(sigma, sigma, V(T(1)))) - sigma*r;
+		tau = tau + (tau1 - tau_i)*fma(tau*tau, V(one_e2), V(T(1)))/
+			(one_e2*r*sqrt(fma(tau_i, tau_i, V(T(1)))));
+	}
+	/* Within a half turn of 0, like the input: east of the antimeridian, zone 60 would give more than 180 degrees. */
+	auto const turn = IsDegrees<Model>::value ? T(360) : T(6.28318530717958647693);
+	auto const lambda = atan2(sinh_eta, cos_xi, pm.model) + tm.centralMeridian;
+	*lon = fma(round(lambda*(T(1)/turn)), V(-turn), lambda);
+	*lat = atan2(tau, V(T(1)), pm.model);
+	*alt = height;
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+void
+geodToTransverseMercatorSoA(
+	S * const TERRA_RESTRICT easting,
+	S * const TERRA_RESTRICT northing,
+	S * const TERRA_RESTRICT height,
+	S const * const TERRA_RESTRICT lon,
+	S const * const TERRA_RESTRICT lat,
+	S const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const pm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V ve, vn, vh;
+		geodToTransverseMercator(&ve, &vn, &vh, loadAs<T>(lon + i), loadAs<T>(lat + i), loadAs<T>(alt + i), pm);
+		storeAs(easting + i, ve);
+		storeAs(northing + i, vn);
+		storeAs(height + i, vh);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V ve, vn, vh;
+		geodToTransverseMercator(&ve, &vn, &vh,
+					 loadPartialAs<T>(lon + i, rest), loadPartialAs<T>(lat + i, rest),
+					 loadPartialAs<T>(alt + i, rest), pm);
+		storePartialAs<T>(easting + i, ve, rest);
+		storePartialAs<T>(northing + i, vn, rest);
+		storePartialAs<T>(height + i, vh, rest);
+	}
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+void
+ecefToTransverseMercatorSoA(
+	S * const TERRA_RESTRICT easting,
+	S * const TERRA_RESTRICT northing,
+	S * const TERRA_RESTRICT height,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT z,
+	std::size_t const numCoords,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const pm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V ve, vn, vh;
+		ecefToTransverseMercator(&ve, &vn, &vh, loadAs<T>(x + i), loadAs<T>(y + i), loadAs<T>(z + i), pm);
+		storeAs(easting + i, ve);
+		storeAs(northing + i, vn);
+		storeAs(height + i, vh);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V ve, vn, vh;
+		ecefToTransverseMercator(&ve, &vn, &vh,
+					 loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest),
+					 loadPartialAs<T>(z + i, rest), pm);
+		storePartialAs<T>(easting + i, ve, rest);
+		storePartialAs<T>(northing + i, vn, rest);
+		storePartialAs<T>(height + i, vh, rest);
+	}
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+void
+transverseMercatorToGeodSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT easting,
+	S const * const TERRA_RESTRICT northing,
+	S const * const TERRA_RESTRICT height,
+	std::size_t const numCoords,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const pm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		transverseMercatorToGeod(&vlon, &vlat, &valt,
+					 loadAs<T>(easting + i), loadAs<T>(northing + i), loadAs<T>(height + i), pm);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		/* The padding lanes are easting and northing 0, 500 km west of the UTM false origin; they unproject cleanly. */
+		transverseMercatorToGeod(&vlon, &vlat, &valt,
+					 loadPartialAs<T>(easting + i, rest), loadPartialAs<T>(northing + i, rest),
+					 loadPartialAs<T>(height + i, rest), pm);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+template<typename T, typename Model>
+inline
+void
+geodToTransverseMercatorAoS(
+	T * const TERRA_RESTRICT grid,
+	T const * const TERRA_RESTRICT geodetic,
+	std::size_t const numCoords,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const pm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V lon, lat, alt, e, n, h;
+		loadu3(geodetic + 3*i, &lon, &lat, &alt);
+		geodToTransverseMercator(&e, &n, &h, lon, lat, alt, pm);
+		storeu3(grid + 3*i, e, n, h);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V lon, lat, alt, e, n, h;
+		loadPartial3(geodetic + 3*i, rest, &lon, &lat, &alt);
+		geodToTransverseMercator(&e, &n, &h, lon, lat, alt, pm);
+		storePartial3(grid + 3*i, rest, e, n, h);
+	}
+}
+
+template<typename T, typename Model>
+inline
+void
+ecefToTransverseMercatorAoS(
+	T * const TERRA_RESTRICT grid,
+	T const * const TERRA_RESTRICT ecef,
+	std::size_t const numCoords,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const pm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V x, y, z, e, n, h;
+		loadu3(ecef + 3*i, &x, &y, &z);
+		ecefToTransverseMercator(&e, &n, &h, x, y, z, pm);
+		storeu3(grid + 3*i, e, n, h);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V x, y, z, e, n, h;
+		loadPartial3(ecef + 3*i, rest, &x, &y, &z);
+		ecefToTransverseMercator(&e, &n, &h, x, y, z, pm);
+		storePartial3(grid + 3*i, rest, e, n, h);
+	}
+}
+
+template<typename T, typename Model>
+inline
+void
+transverseMercatorToGeodAoS(
+	T * const TERRA_RESTRICT geodetic,
+	T const * const TERRA_RESTRICT grid,
+	std::size_t const numCoords,
+	detail::ProjectedModel<TransverseMercator<T>, Model> const pm) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V e, n, h, lon, lat, alt;
+		loadu3(grid + 3*i, &e, &n, &h);
+		transverseMercatorToGeod(&lon, &lat, &alt, e, n, h, pm);
+		storeu3(geodetic + 3*i, lon, lat, alt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V e, n, h, lon, lat, alt;
+		loadPartial3(grid + 3*i, rest, &e, &n, &h);
+		transverseMercatorToGeod(&lon, &lat, &alt, e, n, h, pm);
+		storePartial3(geodetic + 3*i, rest, lon, lat, alt);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_impl_WebMercatorImpl_hpp
+#define terra_impl_WebMercatorImpl_hpp
+
+#include <terra/Dispatch.hpp>
+#include <terra/Tile.hpp>
+#include <terra/Transpose.hpp>
+#include <terra/impl/Simd.hpp>
+#include <type_traits>
+
+namespace terra {
+namespace detail {
+
+/* The tile grid of a zoom level and the sphere of its angles, passed as one. */
+template<typename Model>
+struct WebMercatorTiles {
+	using T = typename Model::value_type;
+
+	Model sphere;
+	T count;	/* Tiles along either axis, 2^zoom. */
+	T half;		/* count/2, the tile coordinate of the origin. */
+	T perRadian;	/* count/(2 pi). */
+	T tileSize;	/* Pixels along either side of a tile. */
+};
+
+template<typename Model>
+inline
+WebMercatorTiles<Model>
+webMercatorTiles(unsigned const zoom, Model const sphere, unsigned const tileSize) noexcept
+{
+	using T = typename Model::value_type;
+	auto const count = double(1ul << zoom);
+	return WebMercatorTiles<Model>{ sphere, T(count), T(0.5*count), T(count/(2.0*3.14159265358979323846)),
+					T(tileSize) };
+}
+
+} // !namespace detail
+} // !namespace terra
+
+#define TERRA_SIMD_FOREACH_FILE <terra/impl/WebMercatorKernels.hpp>
+#include <terra/impl/SimdForEach.hpp>
+
+namespace terra {
+
+/* The single coordinate functions run the scalar instance of the per-point kernels. */
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercator(
+	Coord * const coord,
+	Model const sphere) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	using T = typename Model::value_type;
+	T x, y, h;
+	simd::scalar::geodToWebMercator<T>(&x, &y, &h, (*coord)[0], (*coord)[1], (*coord)[2], sphere);
+	(*coord)[0] = x;
+	(*coord)[1] = y;
+	(*coord)[2] = h;
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercator(
+	Coord * const TERRA_RESTRICT toMercator,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	Model const sphere) noexcept
+{
+	assert(toMercator && "toMercator is nullptr");
+
+	using T = typename Model::value_type;
+	T x, y, h;
+	simd::scalar::geodToWebMercator<T>(&x, &y, &h, fromGeodetic[0], fromGeodetic[1], fromGeodetic[2], sphere);
+	(*toMercator)[0] = x;
+	(*toMercator)[1] = y;
+	(*toMercator)[2] = h;
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeod(
+	Coord * const coord,
+	Model const sphere) noexcept
+{
+	assert(coord && "coord is nullptr");
+
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::webMercatorToGeod<T>(&lon, &lat, &alt, (*coord)[0], (*coord)[1], (*coord)[2], sphere);
+	(*coord)[0] = lon;
+	(*coord)[1] = lat;
+	(*coord)[2] = alt;
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeod(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromMercator,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	T lon, lat, alt;
+	simd::scalar::webMercatorToGeod<T>(&lon, &lat, &alt, fromMercator[0], fromMercator[1], fromMercator[2], sphere);
+	(*toGeodetic)[0] = lon;
+	(*toGeodetic)[1] = lat;
+	(*toGeodetic)[2] = alt;
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorSoA(
+	Coord * const TERRA_RESTRICT toMercator,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toMercator && "toMercator is nullptr");
+
+	using T = typename Model::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToWebMercatorSoA<T, Model, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toMercator->x[0], &toMercator->y[0], &toMercator->z[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0], &fromGeodetic.z[0],
+			numCoords, sphere);
+}
+
+template<typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeodSoA(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord const & TERRA_RESTRICT fromMercator,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using S = detail::SoAElement<Coord>;
+	using Fn = void (*)(S *, S *, S *, S const *, S const *, S const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, webMercatorToGeodSoA<T, Model, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toGeodetic->x[0], &toGeodetic->y[0], &toGeodetic->z[0],
+			&fromMercator.x[0], &fromMercator.y[0], &fromMercator.z[0],
+			numCoords, sphere);
+}
+
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorAoS(
+	Coord * const TERRA_RESTRICT toMercator,
+	Coord2 const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toMercator && "toMercator is nullptr");
+
+	using T = typename Model::value_type;
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToWebMercatorSoA<T, Model>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, geodToWebMercatorAoS<T, Model>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toMercator, fromGeodetic, numCoords, sphere);
+}
+
+template<typename Coord, typename Coord2, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeodAoS(
+	Coord * const TERRA_RESTRICT toGeodetic,
+	Coord2 const & TERRA_RESTRICT fromMercator,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	assert(toGeodetic && "toGeodetic is nullptr");
+
+	using T = typename Model::value_type;
+	using Fn = void (*)(T *, T *, T *, T const *, T const *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(Fn, kernels, webMercatorToGeodSoA<T, Model>);
+	using PackedFn = void (*)(T *, T const *, std::size_t, Model);
+	TERRA_SIMD_TABLE(PackedFn, packedKernels, webMercatorToGeodAoS<T, Model>);
+	auto const level = simd::levelIndex();
+	simd::runAoS<T>(kernels[level], packedKernels[level], toGeodetic, fromMercator, numCoords, sphere);
+}
+
+template<typename TileIndex, typename Pixel, typename Coord, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorTileSoA(
+	TileIndex * const TERRA_RESTRICT toTile,
+	Pixel * const TERRA_RESTRICT toPixel,
+	Coord const & TERRA_RESTRICT fromGeodetic,
+	std::size_t const numCoords,
+	unsigned const zoom,
+	Model const sphere,
+	unsigned const tileSize) noexcept
+{
+	assert(toTile && "toTile is nullptr");
+	assert(toPixel && "toPixel is nullptr");
+	assert(zoom <= 30 && "zoom is above 30");
+
+	using T = typename Model::value_type;
+	using E = detail::SoAElement<TileIndex>;
+	using P = detail::SoAElement<Pixel>;
+	using S = detail::SoAElement<Coord>;
+	static_assert(std::is_integral<E>::value, "tile indices must be integers");
+	using Fn = void (*)(E *, E *, P *, P *, S const *, S const *, std::size_t, detail::WebMercatorTiles<Model>);
+	TERRA_SIMD_TABLE(Fn, kernels, geodToWebMercatorTileSoA<T, Model, E, P, S>);
+	if (numCoords)
+		kernels[simd::levelIndex()](
+			&toTile->x[0], &toTile->y[0], &toPixel->x[0], &toPixel->y[0],
+			&fromGeodetic.x[0], &fromGeodetic.y[0],
+			numCoords, detail::webMercatorTiles(zoom, sphere, tileSize));
+}
+
+} // !namespace terra
+
+#endif // !terra_impl_WebMercatorImpl_hpp
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch kernels for the spherical Mercator projection, expanded into every
+ * instruction set namespace by SimdForEach.hpp. The sphere is a Sphere<T> or
+ * an Approximate<Sphere<float>>, either possibly wrapped in Degrees<>. The tile
+ * kernel goes from the angles to tile and pixel in one scale and offset per
+ * axis; its indices are stored through the buffers of TileKernels.hpp.
+ */
+
+namespace terra {
+namespace simd {
+namespace TERRA_SIMD_ISA {
+
+/*
+ * The isometric latitude atanh(sin(lat)), as log((1 + |sin|)/|cos|) with the
+ * sign of the sine: the cosine keeps it accurate near the poles, where 1 - sin
+ * has lost its digits. The cosine is taken by magnitude: that of pi/2
+ * rounded to float is a hair below 0, which would send a pole to the other
+ * edge of the map.
+ */
+template<typename V, typename Model>
+inline
+V
+isometricLatitude(V const lat, Model const &sphere) noexcept
+{
+	using T = typename Model::value_type;
+
+	V sin_lat, cos_lat;
+	sincos(lat, &sin_lat, &cos_lat, sphere);
+	auto const psi = log((T(1) + abs(sin_lat))/abs(cos_lat));
+	return select(sin_lat < T(0), -psi, psi);
+}
+
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercator(
+	V * const x,
+	V * const y,
+	V * const height,
+	V const lon,
+	V const lat,
+	V const alt,
+	Model const &sphere) noexcept
+{
+	auto const r = sphere.radius;
+
+	*x = toRadians(lon, sphere)*r;
+	*y = isometricLatitude(lat, sphere)*r;
+	*height = alt;
+}
+
+/* The latitude is the Gudermannian, atan(sinh(y/r)). */
+template<typename V, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeod(
+	V * const lon,
+	V * const lat,
+	V * const alt,
+	V const x,
+	V const y,
+	V const height,
+	Model const &sphere) noexcept
+{
+	using T = typename Model::value_type;
+	auto const inv_r = T(1)/sphere.radius;
+
+	auto const e = exp(y*inv_r);
+	*lon = fromRadians(x*inv_r, sphere);
+	*lat = atan2(T(0.5)*(e - T(1)/e), V(T(1)), sphere);
+	*alt = height;
+}
+
+/* The tile and the pixel within it along one axis, f in tiles from the map's edge. */
+template<typename V, typename Model>
+inline
+void
+tileAndPixel(
+	V * const tile,
+	V * const pixel,
+	V const f,
+	detail::WebMercatorTiles<Model> const &tiles) noexcept
+{
+	using T = typename Model::value_type;
+
+	auto const g = min(max(f, V(T(0))), V(tiles.count));
+	auto const t = min(floor(g), V(tiles.count - T(1)));
+	*tile = t;
+	*pixel = (g - t)*tiles.tileSize;
+}
+
+template<typename V, typename Model>
+inline
+void
+geodToWebMercatorTile(
+	V * const tileX,
+	V * const tileY,
+	V * const pixelX,
+	V * const pixelY,
+	V const lon,
+	V const lat,
+	detail::WebMercatorTiles<Model> const &tiles) noexcept
+{
+	auto const fx = fma(toRadians(lon, tiles.sphere), V(tiles.perRadian), V(tiles.half));
+	auto const fy = V(tiles.half) - isometricLatitude(lat, tiles.sphere)*tiles.perRadian;
+	tileAndPixel(tileX, pixelX, fx, tiles);
+	tileAndPixel(tileY, pixelY, fy, tiles);
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorSoA(
+	S * const TERRA_RESTRICT x,
+	S * const TERRA_RESTRICT y,
+	S * const TERRA_RESTRICT height,
+	S const * const TERRA_RESTRICT lon,
+	S const * const TERRA_RESTRICT lat,
+	S const * const TERRA_RESTRICT alt,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vx, vy, vh;
+		geodToWebMercator(&vx, &vy, &vh, loadAs<T>(lon + i), loadAs<T>(lat + i), loadAs<T>(alt + i), sphere);
+		storeAs(x + i, vx);
+		storeAs(y + i, vy);
+		storeAs(height + i, vh);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vx, vy, vh;
+		geodToWebMercator(&vx, &vy, &vh,
+				  loadPartialAs<T>(lon + i, rest), loadPartialAs<T>(lat + i, rest),
+				  loadPartialAs<T>(alt + i, rest), sphere);
+		storePartialAs<T>(x + i, vx, rest);
+		storePartialAs<T>(y + i, vy, rest);
+		storePartialAs<T>(height + i, vh, rest);
+	}
+}
+
+template<typename T, typename Model, typename S = T>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeodSoA(
+	S * const TERRA_RESTRICT lon,
+	S * const TERRA_RESTRICT lat,
+	S * const TERRA_RESTRICT alt,
+	S const * const TERRA_RESTRICT x,
+	S const * const TERRA_RESTRICT y,
+	S const * const TERRA_RESTRICT height,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V vlon, vlat, valt;
+		webMercatorToGeod(&vlon, &vlat, &valt, loadAs<T>(x + i), loadAs<T>(y + i), loadAs<T>(height + i), sphere);
+		storeAs(lon + i, vlon);
+		storeAs(lat + i, vlat);
+		storeAs(alt + i, valt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V vlon, vlat, valt;
+		webMercatorToGeod(&vlon, &vlat, &valt,
+				  loadPartialAs<T>(x + i, rest), loadPartialAs<T>(y + i, rest),
+				  loadPartialAs<T>(height + i, rest), sphere);
+		storePartialAs<T>(lon + i, vlon, rest);
+		storePartialAs<T>(lat + i, vlat, rest);
+		storePartialAs<T>(alt + i, valt, rest);
+	}
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+geodToWebMercatorAoS(
+	T * const TERRA_RESTRICT mercator,
+	T const * const TERRA_RESTRICT geodetic,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V lon, lat, alt, x, y, h;
+		loadu3(geodetic + 3*i, &lon, &lat, &alt);
+		geodToWebMercator(&x, &y, &h, lon, lat, alt, sphere);
+		storeu3(mercator + 3*i, x, y, h);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V lon, lat, alt, x, y, h;
+		loadPartial3(geodetic + 3*i, rest, &lon, &lat, &alt);
+		geodToWebMercator(&x, &y, &h, lon, lat, alt, sphere);
+		storePartial3(mercator + 3*i, rest, x, y, h);
+	}
+}
+
+template<typename T, typename Model>
+inline
+typename std::enable_if<IsSphere<Model>::value>::type
+webMercatorToGeodAoS(
+	T * const TERRA_RESTRICT geodetic,
+	T const * const TERRA_RESTRICT mercator,
+	std::size_t const numCoords,
+	Model const sphere) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V x, y, h, lon, lat, alt;
+		loadu3(mercator + 3*i, &x, &y, &h);
+		webMercatorToGeod(&lon, &lat, &alt, x, y, h, sphere);
+		storeu3(geodetic + 3*i, lon, lat, alt);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V x, y, h, lon, lat, alt;
+		loadPartial3(mercator + 3*i, rest, &x, &y, &h);
+		webMercatorToGeod(&lon, &lat, &alt, x, y, h, sphere);
+		storePartial3(geodetic + 3*i, rest, lon, lat, alt);
+	}
+}
+
+template<typename T, typename Model, typename E, typename P, typename S = T>
+inline
+void
+geodToWebMercatorTileSoA(
+	E * const TERRA_RESTRICT tileX,
+	E * const TERRA_RESTRICT tileY,
+	P * const TERRA_RESTRICT pixelX,
+	P * const TERRA_RESTRICT pixelY,
+	S const * const TERRA_RESTRICT lon,
+	S const * const TERRA_RESTRICT lat,
+	std::size_t const numCoords,
+	detail::WebMercatorTiles<Model> const tiles) noexcept
+{
+	using V = typename VecType<T>::type;
+	constexpr std::size_t width = VecType<T>::width;
+
+	auto i = std::size_t(0);
+	for (; i + width <= numCoords; i += width) {
+		V tx, ty, px, py;
+		geodToWebMercatorTile(&tx, &ty, &px, &py, loadAs<T>(lon + i), loadAs<T>(lat + i), tiles);
+		tile::store<T>(tileX + i, tx, width);
+		tile::store<T>(tileY + i, ty, width);
+		storeAs(pixelX + i, px);
+		storeAs(pixelY + i, py);
+	}
+	if (i < numCoords) {
+		auto const rest = numCoords - i;
+		V tx, ty, px, py;
+		geodToWebMercatorTile(&tx, &ty, &px, &py, loadPartialAs<T>(lon + i, rest), loadPartialAs<T>(lat + i, rest),
+				      tiles);
+		tile::store<T>(tileX + i, tx, rest);
+		tile::store<T>(tileY + i, ty, rest);
+		storePartialAs<T>(pixelX + i, px, rest);
+		storePartialAs<T>(pixelY + i, py, rest);
+	}
+}
+
+} // !namespace TERRA_SIMD_ISA
+} // !namespace simd
+} // !namespace terra
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Dispatch.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct CoordSoA {
+	float* x;
+	float* y;
+	float* z;
+};
+
+/* The documented maxima, with some margin. */
+constexpr auto const lengthTolerance = 3.0;
+constexpr auto const angleTolerance = 4e-7;
+constexpr auto const altitudeTolerance = 2.0;
+
+template<typename Model, typename Reference>
+static
+void
+testApproximateModel(Model const model, Reference const reference, char const * const name)
+{
+#define FUNC "testApproximateModel: "
+	double const altitudes[] = { -500.0, 0.0, 1000.0, 8848.0, 100000.0 };
+	constexpr auto const numAltitudes = sizeof altitudes/sizeof altitudes[0];
+	constexpr auto const numLongitudes = 22u;
+	constexpr auto const numLatitudes = 37u;
+	constexpr auto const numCoords = numAltitudes*numLongitudes*numLatitudes;
+	double const pi = 3.14159265358979323846;
+
+	/* Reference conversions in double, from the float inputs. */
+	std::vector<float> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<float> x(numCoords), y(numCoords), z(numCoords);
+	std::vector<double> refECEF(3*numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		lon[i] = float((double(i%numLongitudes)*17.0 - 179.0)*pi/180.0);
+		lat[i] = float((double(i/numLongitudes%numLatitudes)*5.0 - 90.0)*pi/180.0);
+		alt[i] = float(altitudes[i/(numLongitudes*numLatitudes)]);
+		double coord[3] = { lon[i], lat[i], alt[i] };
+		terra::geodToECEF(&coord, reference);
+		refECEF[3*i + 0] = coord[0];
+		refECEF[3*i + 1] = coord[1];
+		refECEF[3*i + 2] = coord[2];
+		x[i] = float(coord[0]);
+		y[i] = float(coord[1]);
+		z[i] = float(coord[2]);
+	}
+
+	auto const checkECEF = [&](char const * const what, unsigned const i, float const * const got) {
+		for (auto j = 0; j < 3; ++j) {
+			if (!(std::abs(got[j] - refECEF[3*i + j]) <= lengthTolerance)) {
+				std::fprintf(stderr, FUNC "%s: geodToECEF: %s: FAIL: coordinate %u: (%f, %f, %f) != (%f, %f, %f)\n",
+					     name, what, i, got[0], got[1], got[2],
+					     refECEF[3*i + 0], refECEF[3*i + 1], refECEF[3*i + 2]);
+				exit(-1);
+			}
+		}
+	};
+	auto const checkGeod = [&](char const * const what, unsigned const i, float const * const got) {
+		/* Longitude is undefined at the poles. */
+		bool const pole = std::abs(std::abs(double(lat[i])) - pi/2.0) < 1e-6;
+		if ((!pole && !(std::abs(got[0] - double(lon[i])) <= angleTolerance)) ||
+		    !(std::abs(got[1] - double(lat[i])) <= angleTolerance) ||
+		    !(std::abs(got[2] - double(alt[i])) <= altitudeTolerance)) {
+			std::fprintf(stderr, FUNC "%s: ecefToGeod: %s: FAIL: coordinate %u: (%.9f, %.9f, %f) != (%.9f, %.9f, %f)\n",
+				     name, what, i, got[0], got[1], got[2], lon[i], lat[i], alt[i]);
+			exit(-1);
+		}
+	};
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		float coord[3] = { lon[i], lat[i], alt[i] };
+		terra::geodToECEF(&coord, model);
+		checkECEF("single", i, coord);
+
+		coord[0] = x[i];
+		coord[1] = y[i];
+		coord[2] = z[i];
+		terra::ecefToGeod(&coord, model);
+		checkGeod("single", i, coord);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<float> ox(numCoords), oy(numCoords), oz(numCoords);
+		CoordSoA out = { ox.data(), oy.data(), oz.data() };
+		CoordSoA const geod = { lon.data(), lat.data(), alt.data() };
+		CoordSoA const ecef = { x.data(), y.data(), z.data() };
+
+		terra::geodToECEFSoA(&out, geod, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			float const got[3] = { ox[i], oy[i], oz[i] };
+			checkECEF(terra::simdLevelName(level), i, got);
+		}
+
+		terra::ecefToGeodSoA(&out, ecef, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			float const got[3] = { ox[i], oy[i], oz[i] };
+			checkGeod(terra::simdLevelName(level), i, got);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::vector<float> aos(3*numCoords);
+	auto coords = reinterpret_cast<float (*)[3]>(aos.data());
+	for (auto i = 0u; i < numCoords; ++i) {
+		coords[i][0] = lon[i];
+		coords[i][1] = lat[i];
+		coords[i][2] = alt[i];
+	}
+	std::vector<float> aosOut(3*numCoords);
+	auto out = reinterpret_cast<float (*)[3]>(aosOut.data());
+	terra::geodToECEFAoS(&out, coords, numCoords, model);
+	for (auto i = 0u; i < numCoords; ++i) {
+		checkECEF("AoS", i, out[i]);
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testApproximate()
+{
+	testApproximateModel(terra::approximate(terra::Sphere<float>(6378137.0f)),
+			     terra::Sphere<double>(6378137.0), "Sphere");
+	testApproximateModel(terra::Approximate<terra::WGS84<float>>(), terra::WGS84<double>(), "WGS84");
+	testApproximateModel(terra::approximate(terra::Ellipsoid<float>(6378137.0f, terra::WGS84<float>::semiMinor)),
+			     terra::PreparedEllipsoid<double>(terra::Ellipsoid<double>(6378137.0, terra::WGS84<double>::semiMinor)),
+			     "Ellipsoid");
+}
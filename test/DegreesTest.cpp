@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/LocalFrame.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 3.0;
+	static constexpr double angle = 4e-7*180.0/3.14159265358979323846;
+	static constexpr double altitude = 2.0;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-6;
+	static constexpr double angle = 1e-11;
+	static constexpr double altitude = 1e-6;
+};
+
+/*
+ * Conversions on a Degrees<> body agree with the radian ones, in double,
+ * through every path that takes a body.
+ */
+template<typename Model, typename Reference>
+static
+void
+testDegreesModel(Model const model, Reference const reference, char const * const name)
+{
+#define FUNC "testDegreesModel: "
+	using T = typename Model::value_type;
+	double const altitudes[] = { -500.0, 0.0, 8848.0, 100000.0 };
+	constexpr auto const numAltitudes = sizeof altitudes/sizeof altitudes[0];
+	constexpr auto const numLongitudes = 25u;
+	constexpr auto const numLatitudes = 37u;
+	constexpr auto const numCoords = numAltitudes*numLongitudes*numLatitudes;
+	double const pi = 3.14159265358979323846;
+
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<T> x(numCoords), y(numCoords), z(numCoords);
+	std::vector<double> refECEF(3*numCoords), refGeod(3*numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		/* Longitudes from -180 to 180 degrees, and a few turns beyond. */
+		lon[i] = T(double(i%numLongitudes)*15.0 - 180.0 + (i%numLongitudes > 22 ? 720.0 : 0.0));
+		lat[i] = T(double(i/numLongitudes%numLatitudes)*5.0 - 90.0);
+		alt[i] = T(altitudes[i/(numLongitudes*numLatitudes)]);
+		double coord[3] = { double(lon[i])*pi/180.0, double(lat[i])*pi/180.0, double(alt[i]) };
+		terra::geodToECEF(&coord, reference);
+		refECEF[3*i + 0] = coord[0];
+		refECEF[3*i + 1] = coord[1];
+		refECEF[3*i + 2] = coord[2];
+		x[i] = T(coord[0]);
+		y[i] = T(coord[1]);
+		z[i] = T(coord[2]);
+		/* Back from the rounded coordinates, so the algorithm's own error cancels. */
+		coord[0] = double(x[i]);
+		coord[1] = double(y[i]);
+		coord[2] = double(z[i]);
+		terra::ecefToGeod(&coord, reference);
+		refGeod[3*i + 0] = coord[0]*180.0/pi;
+		refGeod[3*i + 1] = coord[1]*180.0/pi;
+		refGeod[3*i + 2] = coord[2];
+	}
+
+	auto const checkECEF = [&](char const * const what, unsigned const i, T const * const got) {
+		for (auto j = 0; j < 3; ++j) {
+			if (!(std::abs(got[j] - refECEF[3*i + j]) <= Tolerance<T>::length)) {
+				std::fprintf(stderr, FUNC "%s: geodToECEF: %s: FAIL: coordinate %u: (%f, %f, %f) != (%f, %f, %f)\n",
+					     name, what, i, double(got[0]), double(got[1]), double(got[2]),
+					     refECEF[3*i + 0], refECEF[3*i + 1], refECEF[3*i + 2]);
+				exit(-1);
+			}
+		}
+	};
+	auto const checkGeod = [&](char const * const what, unsigned const i, T const * const got) {
+		/* Longitude is undefined at the poles, and comes back within [-180, 180]. */
+		bool const pole = std::abs(lat[i]) == T(90);
+		auto const dlon = std::remainder(double(got[0]) - refGeod[3*i + 0], 360.0);
+		if ((!pole && !(std::abs(dlon) <= Tolerance<T>::angle)) ||
+		    !(std::abs(got[0]) <= T(180)) ||
+		    !(std::abs(got[1] - refGeod[3*i + 1]) <= Tolerance<T>::angle) ||
+		    !(std::abs(got[2] - refGeod[3*i + 2]) <= Tolerance<T>::altitude)) {
+			std::fprintf(stderr, FUNC "%s: ecefToGeod: %s: FAIL: coordinate %u: (%.12f, %.12f, %f) != (%.12f, %.12f, %f)\n",
+				     name, what, i, double(got[0]), double(got[1]), double(got[2]),
+				     refGeod[3*i + 0], refGeod[3*i + 1], refGeod[3*i + 2]);
+			exit(-1);
+		}
+	};
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T coord[3] = { lon[i], lat[i], alt[i] };
+		terra::geodToECEF(&coord, model);
+		checkECEF("single", i, coord);
+
+		coord[0] = x[i];
+		coord[1] = y[i];
+		coord[2] = z[i];
+		terra::ecefToGeod(&coord, model);
+		checkGeod("single", i, coord);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> ox(numCoords), oy(numCoords), oz(numCoords);
+		CoordSoA<T> out = { ox.data(), oy.data(), oz.data() };
+		CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+		CoordSoA<T> const ecef = { x.data(), y.data(), z.data() };
+
+		terra::geodToECEFSoA(&out, geod, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { ox[i], oy[i], oz[i] };
+			checkECEF(terra::simdLevelName(level), i, got);
+		}
+
+		terra::ecefToGeodSoA(&out, ecef, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { ox[i], oy[i], oz[i] };
+			checkGeod(terra::simdLevelName(level), i, got);
+		}
+
+		std::vector<T> aos(3*numCoords), aosOut(3*numCoords);
+		auto coords = reinterpret_cast<T (*)[3]>(aos.data());
+		auto aosCoords = reinterpret_cast<T (*)[3]>(aosOut.data());
+		for (auto i = 0u; i < numCoords; ++i) {
+			coords[i][0] = lon[i];
+			coords[i][1] = lat[i];
+			coords[i][2] = alt[i];
+		}
+		terra::geodToECEFAoS(&aosCoords, coords, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i)
+			checkECEF("AoS", i, aosCoords[i]);
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/*
+ * Multiples of 90 degrees reduce exactly, so the coordinates on the axes
+ * come out exactly zero, and whole turns change nothing.
+ */
+template<typename Model>
+static
+void
+testDegreesExact(Model const model, char const * const name)
+{
+#define FUNC "testDegreesExact: "
+	using T = typename Model::value_type;
+	constexpr auto const numCoords = 9u;
+	T lon[numCoords] = { 0, 90, 180, -90, 270, -180, 360*1000 + 90, 45, 360*1000 + 45 };
+	T lat[numCoords] = { 0, 0, 0, 0, 0, 0, 0, 90, -90 };
+	T alt[numCoords] = { 0, 10, 20, 30, 40, 50, 10, 60, 70 };
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		T x[numCoords], y[numCoords], z[numCoords];
+		CoordSoA<T> out = { x, y, z };
+		CoordSoA<T> const geod = { lon, lat, alt };
+		terra::geodToECEFSoA(&out, geod, numCoords, model);
+
+		bool const ok =
+			y[0] == T(0) && z[0] == T(0) &&
+			x[1] == T(0) && z[1] == T(0) &&
+			y[2] == T(0) && z[2] == T(0) && x[2] == -x[0] - T(20) &&
+			x[3] == T(0) && z[3] == T(0) && y[3] == -y[1] - T(20) &&
+			x[4] == x[3] && y[4] == y[3] - T(10) &&
+			x[5] == x[2] - T(30) && y[5] == T(0) &&
+			x[6] == x[1] && y[6] == y[1] && z[6] == z[1] &&
+			x[7] == T(0) && y[7] == T(0) &&
+			x[8] == T(0) && y[8] == T(0) && z[8] < T(0);
+		if (!ok) {
+			std::fprintf(stderr, FUNC "%s: %s: FAIL\n", name, terra::simdLevelName(level));
+			for (auto i = 0u; i < numCoords; ++i) {
+				std::fprintf(stderr, "\t(%g, %g, %g) -> (%.17g, %.17g, %.17g)\n",
+					     double(lon[i]), double(lat[i]), double(alt[i]),
+					     double(x[i]), double(y[i]), double(z[i]));
+			}
+			exit(-1);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+template<typename Algorithm>
+static
+void
+testDegreesAlgorithm(char const * const name)
+{
+#define FUNC "testDegreesAlgorithm: "
+	constexpr auto const numCoords = 37u;
+	double const pi = 3.14159265358979323846;
+	auto const model = terra::degrees(terra::WGS84<double>());
+
+	double lon[numCoords], lat[numCoords], alt[numCoords];
+	double x[numCoords], y[numCoords], z[numCoords];
+	for (auto i = 0u; i < numCoords; ++i) {
+		lon[i] = double(i)*9.5 - 170.0;
+		lat[i] = double(i)*4.75 - 85.5;
+		alt[i] = double(i)*100.0;
+		double coord[3] = { lon[i]*pi/180.0, lat[i]*pi/180.0, alt[i] };
+		terra::geodToECEF(&coord, terra::WGS84<double>());
+		x[i] = coord[0];
+		y[i] = coord[1];
+		z[i] = coord[2];
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		double olon[numCoords], olat[numCoords], oalt[numCoords];
+		CoordSoA<double> out = { olon, olat, oalt };
+		CoordSoA<double> const ecef = { x, y, z };
+		terra::ecefToGeodSoA<Algorithm>(&out, ecef, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (!(std::abs(olon[i] - lon[i]) <= 1e-10) ||
+			    !(std::abs(olat[i] - lat[i]) <= 1e-10) ||
+			    !(std::abs(oalt[i] - alt[i]) <= 1e-6)) {
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: coordinate %u: (%.12f, %.12f, %f) != (%.12f, %.12f, %f)\n",
+					     name, terra::simdLevelName(level), i, olon[i], olat[i], oalt[i],
+					     lon[i], lat[i], alt[i]);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/* A frame set up in degrees is the frame set up in radians. */
+template<typename T>
+static
+void
+testDegreesFrame()
+{
+#define FUNC "testDegreesFrame: "
+	T const lonDeg = T(-74.000401);
+	T const latDeg = T(40.719645);
+	T const lon = T(double(lonDeg)*3.14159265358979323846/180.0);
+	T const lat = T(double(latDeg)*3.14159265358979323846/180.0);
+	terra::LocalFrame<T> const frame(lon, lat, T(5), terra::WGS84<T>());
+	terra::LocalFrame<T> const frameDeg(lonDeg, latDeg, T(5), terra::degrees(terra::WGS84<T>()));
+
+	for (auto i = 0; i < 3; ++i) {
+		if (!(std::abs(frameDeg.origin[i] - frame.origin[i]) <= Tolerance<T>::length)) {
+			std::fprintf(stderr, FUNC "FAIL: origin[%d]: %f != %f\n", i,
+				     double(frameDeg.origin[i]), double(frame.origin[i]));
+			exit(-1);
+		}
+		for (auto j = 0; j < 3; ++j) {
+			if (!(std::abs(frameDeg.rotation[i][j] - frame.rotation[i][j]) <= T(4)*std::numeric_limits<T>::epsilon())) {
+				std::fprintf(stderr, FUNC "FAIL: rotation[%d][%d]: %.9g != %.9g\n", i, j,
+					     double(frameDeg.rotation[i][j]), double(frame.rotation[i][j]));
+				exit(-1);
+			}
+		}
+	}
+
+	/* The fused conversions take and give degrees too. */
+	constexpr auto const numCoords = 3u;
+	T geod[numCoords][3] = { { lonDeg, latDeg, T(5) }, { T(-73.99), T(40.73), T(100) }, { T(-74.01), T(40.70), T(-20) } };
+	T enu[numCoords][3], back[numCoords][3];
+	terra::geodToENUAoS(&enu, geod, numCoords, frameDeg, terra::degrees(terra::WGS84<T>()));
+	terra::enuToGeodAoS(&back, enu, numCoords, frameDeg, terra::degrees(terra::WGS84<T>()));
+	if (!(std::abs(enu[0][0]) <= Tolerance<T>::length && std::abs(enu[0][1]) <= Tolerance<T>::length &&
+	      std::abs(enu[0][2]) <= Tolerance<T>::length)) {
+		std::fprintf(stderr, FUNC "FAIL: origin in ENU: (%f, %f, %f)\n",
+			     double(enu[0][0]), double(enu[0][1]), double(enu[0][2]));
+		exit(-1);
+	}
+	for (auto i = 0u; i < numCoords; ++i) {
+		if (!(std::abs(back[i][0] - geod[i][0]) <= Tolerance<T>::angle) ||
+		    !(std::abs(back[i][1] - geod[i][1]) <= Tolerance<T>::angle) ||
+		    !(std::abs(back[i][2] - geod[i][2]) <= Tolerance<T>::altitude)) {
+			std::fprintf(stderr, FUNC "FAIL: round trip %u: (%.9f, %.9f, %f) != (%.9f, %.9f, %f)\n", i,
+				     double(back[i][0]), double(back[i][1]), double(back[i][2]),
+				     double(geod[i][0]), double(geod[i][1]), double(geod[i][2]));
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", sizeof(T) == sizeof(float) ? "Float" : "Double");
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testDegrees()
+{
+	testDegreesModel(terra::degrees(terra::Sphere<double>(6371000.0)), terra::Sphere<double>(6371000.0), "Sphere<double>");
+	testDegreesModel(terra::degrees(terra::WGS84<double>()), terra::WGS84<double>(), "WGS84<double>");
+	testDegreesModel(terra::degrees(terra::Ellipsoid<double>(6378137.0, 6356752.314245)),
+			 terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid<double>");
+	testDegreesModel(terra::degrees(terra::Sphere<float>(6371000.0f)), terra::Sphere<double>(6371000.0), "Sphere<float>");
+	testDegreesModel(terra::degrees(terra::WGS84<float>()), terra::WGS84<double>(), "WGS84<float>");
+	testDegreesModel(terra::degrees(terra::approximate(terra::Sphere<float>(6371000.0f))),
+			 terra::Sphere<double>(6371000.0), "Approximate<Sphere<float>>");
+	testDegreesModel(terra::degrees(terra::approximate(terra::WGS84<float>())), terra::WGS84<double>(),
+			 "Approximate<WGS84<float>>");
+	testDegreesExact(terra::degrees(terra::Sphere<double>(6371000.0)), "Sphere<double>");
+	testDegreesExact(terra::degrees(terra::WGS84<double>()), "WGS84<double>");
+	testDegreesExact(terra::degrees(terra::WGS84<float>()), "WGS84<float>");
+	testDegreesAlgorithm<terra::Vermeille>("Vermeille");
+	testDegreesAlgorithm<terra::Olson>("Olson");
+	testDegreesAlgorithm<terra::BowringIterative<2>>("BowringIterative<2>");
+	testDegreesFrame<float>();
+	testDegreesFrame<double>();
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Dispatch.hpp>
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define DEG2RAD(a) ((a)*(3.141592653/180.0f))
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct Buffers {
+	explicit Buffers(unsigned const n) : x(n), y(n), z(n) {}
+	CoordSoA<T> soa() { return CoordSoA<T>{x.data(), y.data(), z.data()}; }
+	std::vector<T> x, y, z;
+};
+
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double angle = 1e-12;
+	static constexpr double length = 1e-6;
+	static constexpr char const *str = "double";
+};
+template<>
+struct Tolerance<float> {
+	static constexpr float angle = 1e-5f;
+	static constexpr float length = 4.0f;
+	static constexpr char const *str = "float";
+};
+
+template<typename T>
+static
+void
+compare(
+	char const * const what,
+	terra::SimdLevel const level,
+	std::vector<T> const &a,
+	std::vector<T> const &b,
+	T const tolerance)
+{
+	for (auto i = 0u; i < a.size(); ++i) {
+		if (!(std::abs(a[i] - b[i]) <= tolerance)) {
+			std::fprintf(stderr, "testDispatchModel: %s: FAIL: %s at %s differs from scalar at %u: %f != %f\n",
+				     Tolerance<T>::str, what, terra::simdLevelName(level), i,
+				     double(a[i]), double(b[i]));
+			exit(-1);
+		}
+	}
+}
+
+template<typename T, typename Model>
+static
+void
+testDispatchModel(Model const model)
+{
+	constexpr auto const numCoords = 1027u;
+
+	Buffers<T> geod(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		geod.x[i] = DEG2RAD((T((i*37)%360) - T(179.75)));
+		geod.y[i] = DEG2RAD((T((i*53)%180) - T(89.5)));
+		geod.z[i] = T((i*97)%20000) - T(1000);
+	}
+
+	Buffers<T> refECEF(numCoords), refGeod(numCoords);
+	terra::setSimdLevel(terra::SimdLevel::Scalar);
+	auto in = geod.soa();
+	auto out = refECEF.soa();
+	terra::geodToECEFSoA(&out, in, numCoords, model);
+	auto back = refGeod.soa();
+	terra::ecefToGeodSoA(&back, out, numCoords, model);
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		if (terra::setSimdLevel(level) != level || terra::simdLevel() != level) {
+			std::fprintf(stderr, "testDispatchModel: FAIL: could not select %s\n", terra::simdLevelName(level));
+			exit(-1);
+		}
+
+		Buffers<T> ecef(numCoords), geod2(numCoords);
+		auto ecefSoA = ecef.soa();
+		terra::geodToECEFSoA(&ecefSoA, in, numCoords, model);
+		compare("ECEF X", level, ecef.x, refECEF.x, Tolerance<T>::length);
+		compare("ECEF Y", level, ecef.y, refECEF.y, Tolerance<T>::length);
+		compare("ECEF Z", level, ecef.z, refECEF.z, Tolerance<T>::length);
+
+		auto geodSoA = geod2.soa();
+		terra::ecefToGeodSoA(&geodSoA, out, numCoords, model);
+		compare("longitude", level, geod2.x, refGeod.x, Tolerance<T>::angle);
+		compare("latitude", level, geod2.y, refGeod.y, Tolerance<T>::angle);
+		compare("altitude", level, geod2.z, refGeod.z, Tolerance<T>::length);
+
+		/* The AoS functions go through the same kernels. */
+		std::vector<T> aos(numCoords*3);
+		auto aosPtr = reinterpret_cast<T(*)[3]>(aos.data());
+		for (auto i = 0u; i < numCoords; ++i) {
+			aosPtr[i][0] = refECEF.x[i];
+			aosPtr[i][1] = refECEF.y[i];
+			aosPtr[i][2] = refECEF.z[i];
+		}
+		std::vector<T> aosGeod(numCoords*3);
+		auto aosGeodPtr = reinterpret_cast<T(*)[3]>(aosGeod.data());
+		terra::ecefToGeodAoS(&aosGeodPtr, aosPtr, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			geod2.x[i] = aosGeodPtr[i][0];
+			geod2.y[i] = aosGeodPtr[i][1];
+			geod2.z[i] = aosGeodPtr[i][2];
+		}
+		compare("AoS longitude", level, geod2.x, refGeod.x, Tolerance<T>::angle);
+		compare("AoS latitude", level, geod2.y, refGeod.y, Tolerance<T>::angle);
+		compare("AoS altitude", level, geod2.z, refGeod.z, Tolerance<T>::length);
+
+		std::printf("testDispatchModel: %s: %s: SUCCESS\n", Tolerance<T>::str, terra::simdLevelName(level));
+	}
+}
+
+static
+void
+testDispatchLevels()
+{
+	auto const detected = terra::detectSimdLevel();
+	terra::resetSimdLevel();
+	if (terra::simdLevel() != detected) {
+		std::fprintf(stderr, "testDispatchLevels: FAIL: level %s is not the detected %s\n",
+			     terra::simdLevelName(terra::simdLevel()), terra::simdLevelName(detected));
+		exit(-1);
+	}
+	if (terra::setSimdLevel(terra::SimdLevel::AVX512) != detected) {
+		std::fprintf(stderr, "testDispatchLevels: FAIL: level was not clamped to %s\n",
+			     terra::simdLevelName(detected));
+		exit(-1);
+	}
+	std::printf("testDispatchLevels: detected %s: SUCCESS\n", terra::simdLevelName(detected));
+}
+
+} // !namespace
+
+void
+testDispatch()
+{
+	testDispatchLevels();
+	testDispatchModel<float>(terra::Ellipsoid<float>(6378137.0f, 6356752.314245f));
+	testDispatchModel<double>(terra::Ellipsoid<double>(6378137.0, 6356752.314245));
+	testDispatchModel<float>(terra::Sphere<float>(6371000.0f));
+	testDispatchModel<double>(terra::Sphere<double>(6371000.0));
+	terra::resetSimdLevel();
+}
@@ -14,9 +14,14 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
 #include <terra/Ellipsoid.hpp>
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 #define DEG2RAD(a) (a*(3.141592653/180.0f))
 
@@ -39,7 +44,7 @@ struct TestContext {
 };
 template<>
 struct TestContext<double> {
-	TestContext() : ellipsoid(6378137.0, 6356752.314245), tolerance(0.00001),
+	TestContext() : ellipsoid(6378137.0, 6356752.314245), tolerance(0.00001), batchTolerance(0.00001), angleTolerance(1e-10),
 	geod{
 		{ DEG2RAD(   0.000000), DEG2RAD(   0.000000),    0.0 },
 		{ DEG2RAD( -74.000401), DEG2RAD(  40.719645),    5.0 },
@@ -59,12 +64,14 @@ struct TestContext<double> {
 	{ }
 	terra::Ellipsoid<double> ellipsoid;
 	double tolerance;
+	double batchTolerance;
+	double angleTolerance;
 	Coord<double>::type geod[6];
 	Coord<double>::type ecef[6];
 };
 template<>
 struct TestContext<float> {
-	TestContext() : ellipsoid(6378137.0f, 6356752.314245f), tolerance(0.75f),
+	TestContext() : ellipsoid(6378137.0f, 6356752.314245f), tolerance(0.75f), batchTolerance(2.0f), angleTolerance(1e-6f),
 	geod{
 		{ DEG2RAD(   0.000000f), DEG2RAD(   0.000000f),    0.0f },
 		{ DEG2RAD( -74.000401f), DEG2RAD(  40.719645f),    5.0f },
@@ -84,6 +91,8 @@ struct TestContext<float> {
        	{}
 	terra::Ellipsoid<float> ellipsoid;
 	float tolerance;
+	float batchTolerance;
+	float angleTolerance;
 	Coord<float>::type geod[6];
 	Coord<float>::type ecef[6];
 };
@@ -293,6 +302,170 @@ testEllipsoidSoA(TestContext<T> const &ctx)
 #undef FUNC
 }
 
+template<typename T>
+static
+void
+testEllipsoidSoABatch(TestContext<T> const &ctx)
+{
+#define FUNC "testEllipsoidSoABatch: "
+
+	/* Enough coordinates to run every vector width and leave a partial tail. */
+	constexpr auto const numCoords = 1027u;
+
+	CoordSoA<T> geod, ecef;
+	geod.x = new T[numCoords];
+	geod.y = new T[numCoords];
+	geod.z = new T[numCoords];
+	ecef.x = new T[numCoords];
+	ecef.y = new T[numCoords];
+	ecef.z = new T[numCoords];
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		geod.x[i] = DEG2RAD(T((i*37) % 360) - T(179.75));
+		geod.y[i] = DEG2RAD(T((i*53) % 180) - T(89.5));
+		geod.z[i] = T((i*97) % 20000) - T(1000);
+	}
+
+	terra::geodToECEFSoA(&ecef, geod, numCoords, ctx.ellipsoid);
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		typename Coord<T>::type const from = { geod.x[i], geod.y[i], geod.z[i] };
+		typename Coord<T>::type ref;
+		terra::geodToECEF(&ref, from, ctx.ellipsoid);
+		T const got[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+		for (auto j = 0u; j < 3; ++j) {
+			if (std::abs(got[j] - ref[j]) > ctx.batchTolerance) {
+				auto const diff = std::abs(got[j] - ref[j]);
+				std::fprintf(stderr, FUNC "%s: FAIL: ECEF coordinate %u of %u failed: %f != %f, %f\n",
+					     Type<T>::str, j, i, got[j], ref[j], diff);
+				exit(-1);
+			}
+		}
+	}
+
+	/*
+	 * The scalar inverse loses metres in float, so check the round trip
+	 * instead, from coordinates within range: angles in radians, altitude
+	 * in metres.
+	 */
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const lon = T((i*37) % 359) - T(179);
+		T const lat = T((i*53) % 179) - T(89);
+		geod.x[i] = DEG2RAD(lon);
+		geod.y[i] = DEG2RAD(lat);
+	}
+
+	CoordSoA<T> back;
+	back.x = new T[numCoords];
+	back.y = new T[numCoords];
+	back.z = new T[numCoords];
+
+	terra::geodToECEFSoA(&ecef, geod, numCoords, ctx.ellipsoid);
+	terra::ecefToGeodSoA(&back, ecef, numCoords, ctx.ellipsoid);
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const ref[3] = { geod.x[i], geod.y[i], geod.z[i] };
+		T const got[3] = { back.x[i], back.y[i], back.z[i] };
+		for (auto j = 0u; j < 3; ++j) {
+			auto const tolerance = j < 2 ? ctx.angleTolerance : ctx.batchTolerance;
+			if (std::abs(got[j] - ref[j]) > tolerance) {
+				auto const diff = std::abs(got[j] - ref[j]);
+				std::fprintf(stderr, FUNC "%s: FAIL: Geodetic coordinate %u of %u failed: %.9f != %.9f, %.9f\n",
+					     Type<T>::str, j, i, got[j], ref[j], diff);
+				exit(-1);
+			}
+		}
+	}
+
+	delete[] back.z;
+	delete[] back.y;
+	delete[] back.x;
+	delete[] ecef.z;
+	delete[] ecef.y;
+	delete[] ecef.x;
+	delete[] geod.z;
+	delete[] geod.y;
+	delete[] geod.x;
+
+	std::printf(FUNC "%s: SUCCESS\n", Type<T>::str);
+#undef FUNC
+}
+
+static_assert(terra::WGS84<double>::semiMajor == 6378137.0, "WGS84 is not constexpr");
+static_assert(terra::GRS80<double>::eccentricitySq > 0.00669438 &&
+	      terra::GRS80<double>::eccentricitySq < 0.00669439, "GRS80 eccentricity is wrong");
+
+template<typename T, typename Model>
+static
+void
+testEllipsoidModel(TestContext<T> const &ctx, Model const model, char const * const name)
+{
+#define FUNC "testEllipsoidModel: "
+	constexpr auto const numCoords = sizeof ctx.geod/sizeof(typename Coord<T>::type);
+
+	CoordSoA<T> geod, ecef;
+	geod.x = new T[numCoords];
+	geod.y = new T[numCoords];
+	geod.z = new T[numCoords];
+	ecef.x = new T[numCoords];
+	ecef.y = new T[numCoords];
+	ecef.z = new T[numCoords];
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		typename Coord<T>::type coord = { ctx.geod[i][0], ctx.geod[i][1], ctx.geod[i][2] };
+		terra::geodToECEF(&coord, model);
+		for (auto j = 0u; j < 3; ++j) {
+			if (std::abs(coord[j] - ctx.ecef[i][j]) > ctx.tolerance) {
+				auto const diff = std::abs(coord[j] - ctx.ecef[i][j]);
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: ECEF coordinate %u of %u failed: %f != %f, %f\n",
+					     Type<T>::str, name, j, i, coord[j], ctx.ecef[i][j], diff);
+				exit(-1);
+			}
+		}
+
+		typename Coord<T>::type back;
+		terra::ecefToGeod(&back, coord, model);
+		for (auto j = 0u; j < 3; ++j) {
+			if (std::abs(back[j] - ctx.geod[i][j]) > ctx.tolerance) {
+				auto const diff = std::abs(back[j] - ctx.geod[i][j]);
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: Geodetic coordinate %u of %u failed: %f != %f, %f\n",
+					     Type<T>::str, name, j, i, back[j], ctx.geod[i][j], diff);
+				exit(-1);
+			}
+		}
+
+		geod.x[i] = ctx.geod[i][0];
+		geod.y[i] = ctx.geod[i][1];
+		geod.z[i] = ctx.geod[i][2];
+	}
+
+	terra::geodToECEFSoA(&ecef, geod, numCoords, model);
+	terra::ecefToGeodSoA(&geod, ecef, numCoords, model);
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const got[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+		T const gotGeod[3] = { geod.x[i], geod.y[i], geod.z[i] };
+		for (auto j = 0u; j < 3; ++j) {
+			if (std::abs(got[j] - ctx.ecef[i][j]) > ctx.tolerance ||
+			    std::abs(gotGeod[j] - ctx.geod[i][j]) > ctx.tolerance) {
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: SoA coordinate %u of %u failed\n",
+					     Type<T>::str, name, j, i);
+				exit(-1);
+			}
+		}
+	}
+
+	delete[] ecef.z;
+	delete[] ecef.y;
+	delete[] ecef.x;
+	delete[] geod.z;
+	delete[] geod.y;
+	delete[] geod.x;
+
+	std::printf(FUNC "%s: %s: SUCCESS\n", Type<T>::str, name);
+#undef FUNC
+}
+
 template<typename T>
 static
 void
@@ -358,6 +531,282 @@ testEllipsoidAoS(TestContext<T> const &ctx)
 #undef FUNC
 }
 
+template<typename T>
+struct AlgorithmTolerance {
+};
+template<>
+struct AlgorithmTolerance<double> {
+	static constexpr double angle = 1e-12;
+	static constexpr double length = 1e-6;
+};
+template<>
+struct AlgorithmTolerance<float> {
+	static constexpr float angle = 1e-6f;
+	static constexpr float length = 8.0f;
+};
+
+template<typename Algorithm, typename T>
+static
+void
+testEllipsoidAlgorithm(char const * const name, T const angleTolerance)
+{
+#define FUNC "testEllipsoidAlgorithm: "
+	/* All latitudes, from below the surface up to geostationary orbit. */
+	T const altitudes[] = { T(-10000), T(0), T(8848), T(400000), T(20200000), T(35786000) };
+	constexpr auto const numAltitudes = sizeof altitudes/sizeof altitudes[0];
+	constexpr auto const numLatitudes = 37u;
+	constexpr auto const numCoords = numAltitudes*numLatitudes;
+
+	std::vector<T> x(numCoords), y(numCoords), z(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const lon = T(i%7)*T(51.0) - T(179.0);
+		T const lat = T(i%numLatitudes)*T(5.0) - T(90.0);
+		x[i] = DEG2RAD(lon);
+		y[i] = DEG2RAD(lat);
+		z[i] = altitudes[i/numLatitudes];
+	}
+	CoordSoA<T> geod = { x.data(), y.data(), z.data() };
+
+	std::vector<T> ex(numCoords), ey(numCoords), ez(numCoords);
+	CoordSoA<T> ecef = { ex.data(), ey.data(), ez.data() };
+	terra::geodToECEFSoA(&ecef, geod, numCoords, terra::WGS84<T>());
+
+	auto const check = [&](char const * const what, unsigned const i, T const * const got) {
+		T const want[3] = { x[i], y[i], z[i] };
+		/* Longitude is undefined at the poles. */
+		bool const pole = std::abs(std::abs(y[i]) - DEG2RAD(T(90.0))) < T(1e-6);
+		if ((!pole && !(std::abs(got[0] - want[0]) <= AlgorithmTolerance<T>::angle)) ||
+		    !(std::abs(got[1] - want[1]) <= angleTolerance) ||
+		    !(std::abs(got[2] - want[2]) <= AlgorithmTolerance<T>::length*(T(1) + want[2]/T(1e6)))) {
+			std::fprintf(stderr, FUNC "%s: %s: %s: FAIL: coordinate %u: (%g, %g, %g) != (%g, %g, %g)\n",
+				     Type<T>::str, name, what, i, double(got[0]), double(got[1]), double(got[2]),
+				     double(want[0]), double(want[1]), double(want[2]));
+			exit(-1);
+		}
+	};
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const from[3] = { ex[i], ey[i], ez[i] };
+		T to[3];
+		terra::ecefToGeod<Algorithm>(&to, from, terra::WGS84<T>());
+		check("single", i, to);
+		terra::ecefToGeod<Algorithm>(&to, from, terra::Ellipsoid<T>(6378137.0, terra::WGS84<T>::semiMinor));
+		check("single, Ellipsoid", i, to);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+		CoordSoA<T> back = { gx.data(), gy.data(), gz.data() };
+		terra::ecefToGeodSoA<Algorithm>(&back, ecef, numCoords, terra::WGS84<T>());
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { gx[i], gy[i], gz[i] };
+			check(terra::simdLevelName(level), i, got);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: %s: SUCCESS\n", Type<T>::str, name);
+#undef FUNC
+}
+
+/*
+ * BowringTolerance with the caller's tolerance, from below the surface out to
+ * geostationary orbit and onto the poles: single, SoA and AoS results are
+ * within the tolerance, or the type's resolution, of the exact latitude, and
+ * each point converted on its own comes out the same as in a batch, whatever
+ * the lanes next to it needed.
+ */
+template<typename T>
+static
+void
+testEllipsoidTolerance(double const tolerance, T const floor)
+{
+#define FUNC "testEllipsoidTolerance: "
+	T const altitudes[] = { T(-10000), T(0), T(8848), T(400000), T(20200000), T(35786000) };
+	constexpr auto const numAltitudes = sizeof altitudes/sizeof altitudes[0];
+	constexpr auto const numLatitudes = 37u;
+	constexpr auto const numCoords = numAltitudes*numLatitudes;
+	terra::BowringTolerance const algorithm(tolerance);
+
+	std::vector<T> x(numCoords), y(numCoords), z(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const lon = T(i%7)*T(51.0) - T(179.0);
+		T const lat = T(i%numLatitudes)*T(5.0) - T(90.0);
+		x[i] = DEG2RAD(lon);
+		y[i] = DEG2RAD(lat);
+		z[i] = altitudes[(i*5u)%numAltitudes];
+	}
+	CoordSoA<T> geod = { x.data(), y.data(), z.data() };
+	std::vector<T> ex(numCoords), ey(numCoords), ez(numCoords);
+	CoordSoA<T> ecef = { ex.data(), ey.data(), ez.data() };
+	terra::geodToECEFSoA(&ecef, geod, numCoords, terra::WGS84<T>());
+
+	auto const angleTolerance = std::max(T(tolerance), floor);
+	auto const check = [&](char const * const what, unsigned const i, T const * const got) {
+		bool const pole = std::abs(std::abs(y[i]) - DEG2RAD(T(90.0))) < T(1e-6);
+		if ((!pole && !(std::abs(got[0] - x[i]) <= AlgorithmTolerance<T>::angle)) ||
+		    !(std::abs(got[1] - y[i]) <= angleTolerance) ||
+		    !(std::abs(got[2] - z[i]) <= AlgorithmTolerance<T>::length*(T(1) + z[i]/T(1e6)) +
+						 angleTolerance*T(6.4e6))) {
+			std::fprintf(stderr, FUNC "%s: %g: %s: FAIL: coordinate %u: (%g, %g, %g) != (%g, %g, %g)\n",
+				     Type<T>::str, tolerance, what, i, double(got[0]), double(got[1]), double(got[2]),
+				     double(x[i]), double(y[i]), double(z[i]));
+			exit(-1);
+		}
+	};
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const from[3] = { ex[i], ey[i], ez[i] };
+		T to[3];
+		terra::ecefToGeod(&to, from, terra::WGS84<T>(), algorithm);
+		check("single", i, to);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+		CoordSoA<T> out = { gx.data(), gy.data(), gz.data() };
+		terra::ecefToGeodSoA(&out, ecef, numCoords, terra::WGS84<T>(), algorithm);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { gx[i], gy[i], gz[i] };
+			check(terra::simdLevelName(level), i, got);
+
+			T lone[3];
+			CoordSoA<T> one = { &lone[0], &lone[1], &lone[2] };
+			CoordSoA<T> const from = { &ex[i], &ey[i], &ez[i] };
+			terra::ecefToGeodSoA(&one, from, 1, terra::WGS84<T>(), algorithm);
+			if (lone[0] != got[0] || lone[1] != got[1] || lone[2] != got[2]) {
+				std::fprintf(stderr, FUNC "%s: %g: %s: FAIL: coordinate %u depends on its neighbours\n",
+					     Type<T>::str, tolerance, terra::simdLevelName(level), i);
+				exit(-1);
+			}
+		}
+
+		std::vector<typename Coord<T>::type> rows(numCoords), back(numCoords);
+		for (auto i = 0u; i < numCoords; ++i) {
+			rows[i][0] = ex[i];
+			rows[i][1] = ey[i];
+			rows[i][2] = ez[i];
+		}
+		terra::ecefToGeodAoS(&back, rows, numCoords, terra::WGS84<T>(), algorithm);
+		for (auto i = 0u; i < numCoords; ++i) {
+			check(terra::simdLevelName(level), i, back[i]);
+			if (back[i][0] != gx[i] || back[i][1] != gy[i] || back[i][2] != gz[i]) {
+				std::fprintf(stderr, FUNC "%s: %g: %s: FAIL: AoS coordinate %u differs from SoA\n",
+					     Type<T>::str, tolerance, terra::simdLevelName(level), i);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: %g: SUCCESS\n", Type<T>::str, tolerance);
+#undef FUNC
+}
+
+/* Distance from the ECEF point after the round trip, in metres: Bowring's own error in double. */
+template<typename T>
+struct TrajectoryTolerance {
+};
+template<>
+struct TrajectoryTolerance<double> {
+	static constexpr double length = 1e-4;
+};
+template<>
+struct TrajectoryTolerance<float> {
+	static constexpr double length = 4.0;
+};
+
+/*
+ * A track sampled every 0.6 m or so, in four legs: a climb at mid latitude
+ * with a gap in it, one across the antimeridian, one over the north pole, and
+ * points in no order at all. Every point converted along the track lands back
+ * on its ECEF position, at every instruction set level.
+ */
+template<typename T, typename Algorithm, typename Model>
+static
+void
+testEllipsoidTrajectory(Model const ellipsoid, double const angleScale, char const * const name)
+{
+#define FUNC "testEllipsoidTrajectory: "
+	constexpr auto const legCoords = 1003u;
+	constexpr auto const numCoords = 4*legCoords;
+	double const pi = 3.14159265358979323846;
+	double const degree = pi/180.0;
+	double const step = 1e-7;
+
+	std::vector<T> ex(numCoords), ey(numCoords), ez(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const j = double(i%legCoords);
+		double coord[3];
+		switch (i/legCoords) {
+		case 0:
+			coord[0] = 18.0*degree + j*step + (j > 500 ? 0.1 : 0.0);
+			coord[1] = 59.0*degree + 0.5*j*step;
+			coord[2] = 1000.0 + 20.0*j;
+			break;
+		case 1:
+			coord[0] = pi - 500.0*step + j*step;
+			coord[1] = -33.0*degree - 0.25*j*step;
+			coord[2] = 10000.0;
+			break;
+		case 2:
+			coord[0] = -45.0*degree;
+			coord[1] = 0.5*pi - 400.0*step + j*step;
+			coord[2] = 400000.0;
+			break;
+		default:
+			coord[0] = (2.0*std::fmod(j*0.6180339887498949, 1.0) - 1.0)*pi;
+			coord[1] = std::asin(2.0*std::fmod(j*0.7548776662466927, 1.0) - 1.0);
+			coord[2] = std::fmod(j*0.5698402909980532, 1.0)*1e5;
+			break;
+		}
+		if (coord[1] > 0.5*pi) {
+			coord[0] += pi;
+			coord[1] = pi - coord[1];
+		}
+		terra::geodToECEF(&coord, terra::WGS84<double>());
+		ex[i] = T(coord[0]);
+		ey[i] = T(coord[1]);
+		ez[i] = T(coord[2]);
+	}
+	CoordSoA<T> const ecef = { ex.data(), ey.data(), ez.data() };
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+		CoordSoA<T> geod = { gx.data(), gy.data(), gz.data() };
+		terra::ecefToGeodTrajectorySoA<Algorithm>(&geod, ecef, numCoords, ellipsoid);
+		for (auto i = 0u; i < numCoords; ++i) {
+			double coord[3] = { double(gx[i])/angleScale, double(gy[i])/angleScale, double(gz[i]) };
+			terra::geodToECEF(&coord, terra::WGS84<double>());
+			auto const dx = coord[0] - double(ex[i]);
+			auto const dy = coord[1] - double(ey[i]);
+			auto const dz = coord[2] - double(ez[i]);
+			auto const d = std::sqrt(dx*dx + dy*dy + dz*dz);
+			if (!(d <= TrajectoryTolerance<T>::length) || !(std::abs(double(gx[i])/angleScale) <= double(T(pi)))) {
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: coordinate %u: %g m off, longitude %g\n",
+					     name, terra::simdLevelName(level), i, d, double(gx[i]));
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
 } // !namespace
 
 void
@@ -369,9 +818,42 @@ testEllipsoid()
 	testEllipsoidSingleInplace(ctxSP);
 	testEllipsoidSingle(ctxSP);
 	testEllipsoidSoA(ctxSP);
+	testEllipsoidSoABatch(ctxSP);
 	testEllipsoidAoS(ctxSP);
+	testEllipsoidModel(ctxSP, terra::PreparedEllipsoid<float>(ctxSP.ellipsoid), "Prepared");
+	testEllipsoidModel(ctxSP, terra::WGS84<float>(), "WGS84");
 	testEllipsoidSingleInplace(ctxDP);
 	testEllipsoidSingle(ctxDP);
 	testEllipsoidSoA(ctxDP);
+	testEllipsoidSoABatch(ctxDP);
 	testEllipsoidAoS(ctxDP);
+	testEllipsoidModel(ctxDP, terra::PreparedEllipsoid<double>(ctxDP.ellipsoid), "Prepared");
+	testEllipsoidModel(ctxDP, terra::WGS84<double>(), "WGS84");
+
+	/* Bowring's single step drifts by centimeters towards GEO. */
+	testEllipsoidAlgorithm<terra::Bowring>("Bowring", 1e-8);
+	testEllipsoidAlgorithm<terra::BowringIterative<2>>("BowringIterative<2>", 1e-12);
+	testEllipsoidAlgorithm<terra::BowringIterative<3>>("BowringIterative<3>", 1e-12);
+	testEllipsoidAlgorithm<terra::Vermeille>("Vermeille", 1e-12);
+	testEllipsoidAlgorithm<terra::Olson>("Olson", 1e-12);
+	testEllipsoidAlgorithm<terra::Bowring>("Bowring", 1e-6f);
+	testEllipsoidAlgorithm<terra::BowringIterative<2>>("BowringIterative<2>", 1e-6f);
+	testEllipsoidAlgorithm<terra::Vermeille>("Vermeille", 1e-6f);
+	testEllipsoidAlgorithm<terra::Olson>("Olson", 1e-6f);
+	testEllipsoidAlgorithm<terra::BowringTolerance>("BowringTolerance", 1e-12);
+	testEllipsoidAlgorithm<terra::BowringTolerance>("BowringTolerance", 1e-6f);
+	testEllipsoidTolerance<double>(1e-3, 1e-12);
+	testEllipsoidTolerance<double>(1e-9, 1e-12);
+	testEllipsoidTolerance<double>(0.0, 1e-12);
+	testEllipsoidTolerance<float>(1e-3, 1e-6f);
+	testEllipsoidTolerance<float>(0.0, 1e-6f);
+
+	double const degrees = 180.0/3.14159265358979323846;
+	testEllipsoidTrajectory<double, terra::Bowring>(terra::WGS84<double>(), 1.0, "WGS84<double>");
+	testEllipsoidTrajectory<double, terra::Olson>(terra::WGS84<double>(), 1.0, "WGS84<double>, Olson");
+	testEllipsoidTrajectory<double, terra::Bowring>(terra::degrees(terra::WGS84<double>()), degrees,
+							"Degrees<WGS84<double>>");
+	testEllipsoidTrajectory<float, terra::Bowring>(terra::WGS84<float>(), 1.0, "WGS84<float>");
+	testEllipsoidTrajectory<float, terra::Bowring>(terra::degrees(terra::WGS84<float>()), degrees,
+						       "Degrees<WGS84<float>>");
 }
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/Fixed.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+using FixedSoA = CoordSoA<std::int32_t>;
+
+/* In fixed-point units: 1e-7 degrees and millimetres. */
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 3.0;
+	static constexpr double angle = 4e-7*180.0/3.14159265358979323846*1e7;
+	static constexpr double altitude = 2000.0;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-6;
+	static constexpr double angle = 0.5 + 1e-3;
+	static constexpr double altitude = 0.5 + 1e-3;
+};
+
+/*
+ * The fixed-point conversions agree with the radian ones in double, at every
+ * instruction set level, and in double round trip exactly.
+ */
+template<typename Model, typename Reference>
+static
+void
+testFixedModel(Model const model, Reference const reference, char const * const name)
+{
+#define FUNC "testFixedModel: "
+	using T = typename decltype(terra::detail::prepare(model))::value_type;
+	std::int32_t const altitudes[] = { -500000, 0, 8848123, 100000001 };
+	constexpr auto const numAltitudes = sizeof altitudes/sizeof altitudes[0];
+	constexpr auto const numLongitudes = 25u;
+	constexpr auto const numLatitudes = 37u;
+	/* Not a multiple of any vector width, so the tails are exercised. */
+	constexpr auto const numCoords = numAltitudes*numLongitudes*numLatitudes;
+	double const radiansPerUnit = 3.14159265358979323846/1.8e9;
+
+	std::vector<std::int32_t> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<T> x(numCoords), y(numCoords), z(numCoords);
+	std::vector<double> refECEF(3*numCoords), refGeod(3*numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		/* Steps of 15 and 5 degrees plus an odd offset, and the ends of the ranges. */
+		auto const ilon = i%numLongitudes;
+		auto const ilat = i/numLongitudes%numLatitudes;
+		lon[i] = ilon == 0 ? -1800000000 : (std::int32_t(ilon) - 12)*150000000 + (ilon < 24 ? 1234567 : 0);
+		lat[i] = ilat == 0 || ilat == numLatitudes - 1 ?
+			std::int32_t(ilat)*50000000 - 900000000 : std::int32_t(ilat)*50000000 - 900000000 - 7654321;
+		alt[i] = altitudes[i/(numLongitudes*numLatitudes)];
+		double coord[3] = { double(lon[i])*radiansPerUnit, double(lat[i])*radiansPerUnit, double(alt[i])*1e-3 };
+		terra::geodToECEF(&coord, reference);
+		refECEF[3*i + 0] = coord[0];
+		refECEF[3*i + 1] = coord[1];
+		refECEF[3*i + 2] = coord[2];
+		x[i] = T(coord[0]);
+		y[i] = T(coord[1]);
+		z[i] = T(coord[2]);
+		/* Back from the rounded coordinates, so the algorithm's own error cancels. */
+		coord[0] = double(x[i]);
+		coord[1] = double(y[i]);
+		coord[2] = double(z[i]);
+		terra::ecefToGeod(&coord, reference);
+		refGeod[3*i + 0] = coord[0]/radiansPerUnit;
+		refGeod[3*i + 1] = coord[1]/radiansPerUnit;
+		refGeod[3*i + 2] = coord[2]*1e3;
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> ox(numCoords), oy(numCoords), oz(numCoords);
+		CoordSoA<T> out = { ox.data(), oy.data(), oz.data() };
+		FixedSoA const geod = { lon.data(), lat.data(), alt.data() };
+		terra::geodFixedToECEFSoA(&out, geod, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (!(std::abs(ox[i] - refECEF[3*i + 0]) <= Tolerance<T>::length) ||
+			    !(std::abs(oy[i] - refECEF[3*i + 1]) <= Tolerance<T>::length) ||
+			    !(std::abs(oz[i] - refECEF[3*i + 2]) <= Tolerance<T>::length)) {
+				std::fprintf(stderr, FUNC "%s: geodFixedToECEF: %s: FAIL: coordinate %u: (%f, %f, %f) != (%f, %f, %f)\n",
+					     name, terra::simdLevelName(level), i, double(ox[i]), double(oy[i]), double(oz[i]),
+					     refECEF[3*i + 0], refECEF[3*i + 1], refECEF[3*i + 2]);
+				exit(-1);
+			}
+		}
+
+		std::vector<std::int32_t> olon(numCoords), olat(numCoords), oalt(numCoords);
+		FixedSoA fixed = { olon.data(), olat.data(), oalt.data() };
+		CoordSoA<T> const ecef = { x.data(), y.data(), z.data() };
+		terra::ecefToGeodFixedSoA(&fixed, ecef, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			/* Longitude is undefined at the poles, and comes back within [-180, 180]. */
+			bool const pole = lat[i] == 900000000 || lat[i] == -900000000;
+			auto const dlon = std::remainder(double(olon[i]) - refGeod[3*i + 0], 3.6e9);
+			if ((!pole && !(std::abs(dlon) <= Tolerance<T>::angle)) ||
+			    !(olon[i] >= -1800000000 && olon[i] <= 1800000000) ||
+			    !(std::abs(olat[i] - refGeod[3*i + 1]) <= Tolerance<T>::angle) ||
+			    !(std::abs(oalt[i] - refGeod[3*i + 2]) <= Tolerance<T>::altitude)) {
+				std::fprintf(stderr, FUNC "%s: ecefToGeodFixed: %s: FAIL: coordinate %u: (%d, %d, %d) != (%.1f, %.1f, %.1f)\n",
+					     name, terra::simdLevelName(level), i, int(olon[i]), int(olat[i]), int(oalt[i]),
+					     refGeod[3*i + 0], refGeod[3*i + 1], refGeod[3*i + 2]);
+				exit(-1);
+			}
+		}
+
+		if (sizeof(T) == sizeof(double)) {
+			terra::ecefToGeodFixedSoA(&fixed, out, numCoords, model);
+			for (auto i = 0u; i < numCoords; ++i) {
+				bool const pole = lat[i] == 900000000 || lat[i] == -900000000;
+				if ((!pole && std::remainder(double(olon[i]) - double(lon[i]), 3.6e9) != 0.0) ||
+				    olat[i] != lat[i] || oalt[i] != alt[i]) {
+					std::fprintf(stderr, FUNC "%s: round trip: %s: FAIL: coordinate %u: (%d, %d, %d) != (%d, %d, %d)\n",
+						     name, terra::simdLevelName(level), i, int(olon[i]), int(olat[i]), int(oalt[i]),
+						     int(lon[i]), int(lat[i]), int(alt[i]));
+					exit(-1);
+				}
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/* Altitudes beyond the int32 range of millimetres saturate rather than wrap, and NaN is INT32_MIN. */
+template<typename T>
+static
+void
+testFixedSaturation()
+{
+#define FUNC "testFixedSaturation: "
+	constexpr auto const numCoords = 6u;
+	T const r = T(6378137);
+	T x[numCoords] = { T(4)*r, T(0), T(0), -r, T(1e9), std::numeric_limits<T>::quiet_NaN() };
+	T y[numCoords] = { T(0), T(4)*r, T(0), T(0), T(0), std::numeric_limits<T>::quiet_NaN() };
+	T z[numCoords] = { T(0), T(0), T(10), T(0), T(0), std::numeric_limits<T>::quiet_NaN() };
+	/* The largest T not above INT32_MAX. */
+	std::int32_t const top = sizeof(T) == sizeof(float) ? 2147483520 : 2147483647;
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::int32_t lon[numCoords], lat[numCoords], alt[numCoords];
+		FixedSoA out = { lon, lat, alt };
+		CoordSoA<T> const ecef = { x, y, z };
+		terra::ecefToGeodFixedSoA(&out, ecef, numCoords, terra::WGS84<T>());
+
+		/* The centre is thousands of kilometres below the surface. */
+		bool const ok =
+			lon[0] == 0 && lat[0] == 0 && alt[0] == top &&
+			lon[1] == 900000000 && lat[1] == 0 && alt[1] == top &&
+			lat[2] == 900000000 && alt[2] == -2147483647 - 1 &&
+			(lon[3] == 1800000000 || lon[3] == -1800000000) && lat[3] == 0 && std::abs(alt[3]) <= 1000 &&
+			alt[4] == top &&
+			lon[5] == -2147483647 - 1 && lat[5] == -2147483647 - 1 && alt[5] == -2147483647 - 1;
+		if (!ok) {
+			std::fprintf(stderr, FUNC "%s: FAIL\n", terra::simdLevelName(level));
+			for (auto i = 0u; i < numCoords; ++i) {
+				std::fprintf(stderr, "\t(%g, %g, %g) -> (%d, %d, %d)\n",
+					     double(x[i]), double(y[i]), double(z[i]), int(lon[i]), int(lat[i]), int(alt[i]));
+			}
+			exit(-1);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", sizeof(T) == sizeof(float) ? "Float" : "Double");
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testFixed()
+{
+	testFixedModel(terra::Sphere<double>(6371000.0), terra::Sphere<double>(6371000.0), "Sphere<double>");
+	testFixedModel(terra::WGS84<double>(), terra::WGS84<double>(), "WGS84<double>");
+	testFixedModel(terra::Ellipsoid<double>(6378137.0, 6356752.314245),
+		       terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid<double>");
+	testFixedModel(terra::Sphere<float>(6371000.0f), terra::Sphere<double>(6371000.0), "Sphere<float>");
+	testFixedModel(terra::WGS84<float>(), terra::WGS84<double>(), "WGS84<float>");
+	testFixedModel(terra::approximate(terra::Sphere<float>(6371000.0f)), terra::Sphere<double>(6371000.0),
+		       "Approximate<Sphere<float>>");
+	testFixedModel(terra::approximate(terra::WGS84<float>()), terra::WGS84<double>(), "Approximate<WGS84<float>>");
+	testFixedSaturation<float>();
+	testFixedSaturation<double>();
+}
@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/Geodesic.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+constexpr auto const pi = 3.14159265358979323846;
+
+/*
+ * Distances in metres, angles in radians. In float the azimuth of a short line
+ * loses digits to the difference of the sines and cosines of its ends.
+ */
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 8.0;
+	static constexpr double azimuth = 5e-5;
+	static constexpr double angle = 3e-6;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-6;
+	static constexpr double azimuth = 1e-11;
+	static constexpr double angle = 1e-11;
+};
+
+/*
+ * Pairs of points and the geodesics between them, solved in double on the
+ * reference body, agree with those of the model at every instruction set level,
+ * and the direct problem leads back along them. Angles are given to the model
+ * in its unit, radiansPerUnit radians.
+ */
+template<typename Model, typename Reference>
+static
+void
+testGeodesicModel(Model const model, Reference const reference, double const radiansPerUnit, char const * const name)
+{
+#define FUNC "testGeodesicModel: "
+	using T = typename decltype(terra::detail::prepare(model))::value_type;
+	/* Not a multiple of any vector width, so the tails are exercised. */
+	constexpr auto const numCoords = 1003u;
+
+	std::vector<double> lon1(numCoords), lat1(numCoords), lon2(numCoords), lat2(numCoords), alt(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		auto const d = std::fmod(double(i)*0.4142135623730950, 1.0);
+		lon1[i] = (2.0*u - 1.0)*pi;
+		lat1[i] = (2.0*v - 1.0)*1.5;
+		/* Up to about 115 degrees of longitude apart, or the same point. */
+		lon2[i] = i%97 == 0 ? lon1[i] : std::remainder(lon1[i] + (2.0*d - 1.0)*2.0, 2.0*pi);
+		lat2[i] = i%97 == 0 ? lat1[i] : (2.0*w - 1.0)*1.5;
+		alt[i] = double(i);
+	}
+
+	/* The reference, from the coordinates as the model gets them. */
+	std::vector<T> in[5];
+	std::vector<double> ref[3];
+	for (auto j = 0; j < 5; ++j)
+		in[j].resize(numCoords);
+	for (auto j = 0; j < 3; ++j)
+		ref[j].resize(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		in[0][i] = T(lon1[i]/radiansPerUnit);
+		in[1][i] = T(lat1[i]/radiansPerUnit);
+		in[2][i] = T(lon2[i]/radiansPerUnit);
+		in[3][i] = T(lat2[i]/radiansPerUnit);
+		in[4][i] = T(alt[i]);
+		lon1[i] = double(in[0][i])*radiansPerUnit;
+		lat1[i] = double(in[1][i])*radiansPerUnit;
+		lon2[i] = double(in[2][i])*radiansPerUnit;
+		lat2[i] = double(in[3][i])*radiansPerUnit;
+	}
+	terra::setSimdLevel(terra::SimdLevel::Scalar);
+	{
+		CoordSoA<double> const from = { lon1.data(), lat1.data(), alt.data() };
+		CoordSoA<double> const to = { lon2.data(), lat2.data(), alt.data() };
+		CoordSoA<double> geodesic = { ref[0].data(), ref[1].data(), ref[2].data() };
+		terra::geodesicInverseSoA(&geodesic, from, to, numCoords, reference);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> s(numCoords), a1(numCoords), a2(numCoords);
+		CoordSoA<T> const from = { in[0].data(), in[1].data(), in[4].data() };
+		CoordSoA<T> const to = { in[2].data(), in[3].data(), in[4].data() };
+		CoordSoA<T> geodesic = { s.data(), a1.data(), a2.data() };
+		terra::geodesicInverseSoA(&geodesic, from, to, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			/* The azimuths between coincident points are arbitrary. */
+			auto const da1 = std::remainder(double(a1[i])*radiansPerUnit - ref[1][i], 2.0*pi);
+			auto const da2 = std::remainder(double(a2[i])*radiansPerUnit - ref[2][i], 2.0*pi);
+			if (!(std::abs(double(s[i]) - ref[0][i]) <= Tolerance<T>::length) ||
+			    (ref[0][i] > 0.0 && !(std::abs(da1) <= Tolerance<T>::azimuth)) ||
+			    (ref[0][i] > 0.0 && !(std::abs(da2) <= Tolerance<T>::azimuth))) {
+				std::fprintf(stderr, FUNC "%s: geodesicInverse: %s: FAIL: pair %u: (%.9g, %.9g, %.9g) != (%.9g, %.9g, %.9g)\n",
+					     name, terra::simdLevelName(level), i,
+					     double(s[i]), double(a1[i])*radiansPerUnit, double(a2[i])*radiansPerUnit,
+					     ref[0][i], ref[1][i], ref[2][i]);
+				exit(-1);
+			}
+		}
+
+		std::vector<T> olon(numCoords), olat(numCoords), oalt(numCoords);
+		CoordSoA<T> out = { olon.data(), olat.data(), oalt.data() };
+		terra::geodesicDirectSoA(&out, from, geodesic, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			auto const dlon = std::remainder(double(olon[i])*radiansPerUnit - lon2[i], 2.0*pi)*std::cos(lat2[i]);
+			if (!(std::abs(dlon) <= Tolerance<T>::angle) ||
+			    !(std::abs(double(olat[i])*radiansPerUnit - lat2[i]) <= Tolerance<T>::angle) ||
+			    oalt[i] != in[4][i]) {
+				std::fprintf(stderr, FUNC "%s: geodesicDirect: %s: FAIL: point %u: (%.9g, %.9g, %.9g) != (%.9g, %.9g, %.9g)\n",
+					     name, terra::simdLevelName(level), i,
+					     double(olon[i])*radiansPerUnit, double(olat[i])*radiansPerUnit, double(oalt[i]),
+					     lon2[i], lat2[i], double(in[4][i]));
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/*
+ * Published and closed form geodesics on GRS80 and WGS84: Vincenty's own
+ * Flinders Peak to Buninyong, a quarter of the meridian, and an arc of the
+ * equator, whose geodesic is the equator itself.
+ */
+static
+void
+testGeodesicReference()
+{
+#define FUNC "testGeodesicReference: "
+	auto const dms = [](double const d, double const m, double const s) {
+		return (d + m/60.0 + s/3600.0)*pi/180.0;
+	};
+	double lon1[] = { dms(144, 25, 29.52440), 0.0, -0.3 };
+	double lat1[] = { -dms(37, 57, 3.72030), 0.0, 0.0 };
+	double lon2[] = { dms(143, 55, 35.38390), 0.0, 0.7 };
+	double lat2[] = { -dms(37, 39, 10.15610), pi/2.0, 0.0 };
+	double alt[] = { 0.0, 0.0, 0.0 };
+	double const distances[] = { 54972.271, 10001965.7293, 6378137.0 };
+	double const azimuths1[] = { dms(306, 52, 5.37) - 2.0*pi, 0.0, pi/2.0 };
+	double const azimuths2[] = { dms(127, 10, 25.07), pi, -pi/2.0 };
+	double const tolerances[] = { 1e-3, 1e-4, 1e-5 };
+	constexpr auto const numCoords = sizeof distances/sizeof distances[0];
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		double s[numCoords], a1[numCoords], a2[numCoords];
+		CoordSoA<double> const from = { lon1, lat1, alt };
+		CoordSoA<double> const to = { lon2, lat2, alt };
+		CoordSoA<double> geodesic = { s, a1, a2 };
+		terra::geodesicInverseSoA(&geodesic, from, to, 1, terra::GRS80<double>());
+		terra::geodesicInverseSoA(&geodesic, from, to, 1, terra::Ellipsoid<double>(6378137.0, 6356752.314140347));
+		CoordSoA<double> const fromWGS84 = { lon1 + 1, lat1 + 1, alt + 1 };
+		CoordSoA<double> const toWGS84 = { lon2 + 1, lat2 + 1, alt + 1 };
+		CoordSoA<double> geodesicWGS84 = { s + 1, a1 + 1, a2 + 1 };
+		terra::geodesicInverseSoA(&geodesicWGS84, fromWGS84, toWGS84, numCoords - 1, terra::WGS84<double>());
+		for (auto i = 0u; i < numCoords; ++i) {
+			/* Azimuths as published, to 0.01 seconds of arc. */
+			if (!(std::abs(s[i] - distances[i]) <= tolerances[i]) ||
+			    !(std::abs(std::remainder(a1[i] - azimuths1[i], 2.0*pi)) <= 5e-8) ||
+			    !(std::abs(std::remainder(a2[i] - azimuths2[i], 2.0*pi)) <= 5e-8)) {
+				std::fprintf(stderr, FUNC "%s: FAIL: geodesic %u: (%.6f, %.9f, %.9f) != (%.6f, %.9f, %.9f)\n",
+					     terra::simdLevelName(level), i, s[i], a1[i], a2[i],
+					     distances[i], azimuths1[i], azimuths2[i]);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+/*
+ * Nearly antipodal points on the equator, where Vincenty's iteration does not
+ * converge, come out as NaN without holding up or changing their neighbours.
+ */
+static
+void
+testGeodesicAntipodal()
+{
+#define FUNC "testGeodesicAntipodal: "
+	constexpr auto const numCoords = 37u;
+	double lon1[numCoords], lat1[numCoords], lon2[numCoords], lat2[numCoords], alt[numCoords];
+	for (auto i = 0u; i < numCoords; ++i) {
+		lon1[i] = 0.1*i - 1.0;
+		lat1[i] = i%5 == 3 ? 0.0 : 0.02*i - 0.3;
+		lon2[i] = i%5 == 3 ? lon1[i] + 0.999*pi : lon1[i] + 0.5;
+		lat2[i] = i%5 == 3 ? 0.0 : 0.4 - 0.01*i;
+		alt[i] = 0.0;
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		double s[numCoords], a1[numCoords], a2[numCoords];
+		CoordSoA<double> const from = { lon1, lat1, alt };
+		CoordSoA<double> const to = { lon2, lat2, alt };
+		CoordSoA<double> geodesic = { s, a1, a2 };
+		terra::geodesicInverseSoA(&geodesic, from, to, numCoords, terra::WGS84<double>());
+		for (auto i = 0u; i < numCoords; ++i) {
+			double one[3];
+			CoordSoA<double> const fromOne = { lon1 + i, lat1 + i, alt + i };
+			CoordSoA<double> const toOne = { lon2 + i, lat2 + i, alt + i };
+			CoordSoA<double> geodesicOne = { one + 0, one + 1, one + 2 };
+			terra::geodesicInverseSoA(&geodesicOne, fromOne, toOne, 1, terra::WGS84<double>());
+			bool const antipodal = i%5 == 3;
+			if ((antipodal && !(std::isnan(s[i]) && std::isnan(a1[i]) && std::isnan(a2[i]))) ||
+			    (!antipodal && !(s[i] == one[0] && a1[i] == one[1] && a2[i] == one[2]))) {
+				std::fprintf(stderr, FUNC "%s: FAIL: pair %u: (%.9g, %.9g, %.9g), alone (%.9g, %.9g, %.9g)\n",
+					     terra::simdLevelName(level), i, s[i], a1[i], a2[i], one[0], one[1], one[2]);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+/*
+ * The great circle on a sphere agrees with one worked out in long double from
+ * the unit vectors of the points, at every instruction set level.
+ */
+static
+void
+testGeodesicSphere()
+{
+#define FUNC "testGeodesicSphere: "
+	constexpr auto const numCoords = 1003u;
+	constexpr auto const radius = 6371000.0;
+	std::vector<double> lon1(numCoords), lat1(numCoords), lon2(numCoords), lat2(numCoords), alt(numCoords);
+	std::vector<double> ref[3];
+	for (auto j = 0; j < 3; ++j)
+		ref[j].resize(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		auto const d = std::fmod(double(i)*0.4142135623730950, 1.0);
+		/* Every 7th pair within a few metres, the rest anywhere. */
+		lon1[i] = (2.0*u - 1.0)*pi;
+		lat1[i] = (2.0*v - 1.0)*1.5;
+		lon2[i] = i%7 == 0 ? lon1[i] + (d - 0.5)*1e-6 : (2.0*d - 1.0)*pi;
+		lat2[i] = i%7 == 0 ? lat1[i] + (w - 0.5)*1e-6 : (2.0*w - 1.0)*1.5;
+
+		long double const a[3] = { std::cos((long double)lat1[i])*std::cos((long double)lon1[i]),
+					   std::cos((long double)lat1[i])*std::sin((long double)lon1[i]),
+					   std::sin((long double)lat1[i]) };
+		long double const b[3] = { std::cos((long double)lat2[i])*std::cos((long double)lon2[i]),
+					   std::cos((long double)lat2[i])*std::sin((long double)lon2[i]),
+					   std::sin((long double)lat2[i]) };
+		long double const c[3] = { a[1]*b[2] - a[2]*b[1], a[2]*b[0] - a[0]*b[2], a[0]*b[1] - a[1]*b[0] };
+		ref[0][i] = double(radius*std::atan2(std::sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]),
+						     a[0]*b[0] + a[1]*b[1] + a[2]*b[2]));
+		/* North at a point is (-sin(lat)*cos(lon), -sin(lat)*sin(lon), cos(lat)), east (-sin(lon), cos(lon), 0). */
+		auto const azimuth = [](long double const (&q)[3], double const lon, double const lat) {
+			long double const north[3] = { -std::sin((long double)lat)*std::cos((long double)lon),
+						       -std::sin((long double)lat)*std::sin((long double)lon),
+						       std::cos((long double)lat) };
+			long double const east[3] = { -std::sin((long double)lon), std::cos((long double)lon), 0.0L };
+			/* Towards q is along q less its part along the point, which is neither north nor east. */
+			return double(std::atan2(q[0]*east[0] + q[1]*east[1], q[0]*north[0] + q[1]*north[1] + q[2]*north[2]));
+		};
+		ref[1][i] = azimuth(b, lon1[i], lat1[i]);
+		ref[2][i] = azimuth(a, lon2[i], lat2[i]);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<double> s(numCoords), a1(numCoords), a2(numCoords);
+		CoordSoA<double> const from = { lon1.data(), lat1.data(), alt.data() };
+		CoordSoA<double> const to = { lon2.data(), lat2.data(), alt.data() };
+		CoordSoA<double> geodesic = { s.data(), a1.data(), a2.data() };
+		terra::geodesicInverseSoA(&geodesic, from, to, numCoords, terra::Sphere<double>(radius));
+		for (auto i = 0u; i < numCoords; ++i) {
+			/* Short lines lose the digits of their ends that the points were rounded to. */
+			auto const azimuthTolerance = i%7 == 0 ? 1e-8 : Tolerance<double>::azimuth;
+			if (!(std::abs(s[i] - ref[0][i]) <= Tolerance<double>::length*10.0) ||
+			    !(std::abs(std::remainder(a1[i] - ref[1][i], 2.0*pi)) <= azimuthTolerance) ||
+			    !(std::abs(std::remainder(a2[i] - ref[2][i], 2.0*pi)) <= azimuthTolerance)) {
+				std::fprintf(stderr, FUNC "%s: FAIL: pair %u: (%.9f, %.12f, %.12f) != (%.9f, %.12f, %.12f)\n",
+					     terra::simdLevelName(level), i, s[i], a1[i], a2[i], ref[0][i], ref[1][i], ref[2][i]);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+/*
+ * One point to many and the distances alone agree with the pairwise solution,
+ * to rounding: the compiler may contract the instances differently.
+ */
+template<typename Model>
+static
+void
+testGeodesicOneToMany(Model const model, char const * const name)
+{
+#define FUNC "testGeodesicOneToMany: "
+	using T = typename decltype(terra::detail::prepare(model))::value_type;
+	constexpr auto const numCoords = 1003u;
+	T const point[3] = { T(0.3), T(0.9), T(0) };
+	std::vector<T> lon1(numCoords, point[0]), lat1(numCoords, point[1]), lon2(numCoords), lat2(numCoords);
+	std::vector<T> alt(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		lon2[i] = T((2.0*std::fmod(double(i)*0.6180339887498949, 1.0) - 1.0)*1.5);
+		lat2[i] = T((2.0*std::fmod(double(i)*0.7548776662466927, 1.0) - 1.0)*1.5);
+	}
+	auto const close = [](T const a, T const b) {
+		return std::abs(double(a) - double(b)) <= 8.0*double(std::numeric_limits<T>::epsilon())*
+			std::fmax(std::abs(double(b)), 1.0);
+	};
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> s(numCoords), a1(numCoords), a2(numCoords), t(numCoords), b1(numCoords), b2(numCoords);
+		std::vector<T> d(numCoords), e(numCoords);
+		CoordSoA<T> const from = { lon1.data(), lat1.data(), alt.data() };
+		CoordSoA<T> const to = { lon2.data(), lat2.data(), alt.data() };
+		CoordSoA<T> pairwise = { s.data(), a1.data(), a2.data() };
+		CoordSoA<T> oneToMany = { t.data(), b1.data(), b2.data() };
+		terra::geodesicInverseSoA(&pairwise, from, to, numCoords, model);
+		terra::geodesicInverseOneToManySoA(&oneToMany, point, to, numCoords, model);
+		terra::geodesicDistanceSoA(d.data(), from, to, numCoords, model);
+		terra::geodesicDistanceOneToManySoA(e.data(), point, to, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (!close(t[i], s[i]) || !close(b1[i], a1[i]) || !close(b2[i], a2[i]) ||
+			    !close(d[i], s[i]) || !close(e[i], s[i])) {
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: point %u: (%.9g, %.9g, %.9g, %.9g, %.9g) != (%.9g, %.9g, %.9g)\n",
+					     name, terra::simdLevelName(level), i, double(t[i]), double(b1[i]), double(b2[i]),
+					     double(d[i]), double(e[i]), double(s[i]), double(a1[i]), double(a2[i]));
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testGeodesic()
+{
+	testGeodesicReference();
+	testGeodesicAntipodal();
+	testGeodesicSphere();
+	terra::WGS84<double> const wgs84;
+	terra::Sphere<double> const sphere(6371000.0);
+	testGeodesicModel(terra::WGS84<double>(), wgs84, 1.0, "WGS84<double>");
+	testGeodesicModel(terra::Ellipsoid<double>(6378137.0, 6356752.314245179), wgs84, 1.0, "Ellipsoid<double>");
+	testGeodesicModel(terra::degrees(terra::WGS84<double>()), wgs84, pi/180.0, "Degrees<WGS84<double>>");
+	testGeodesicModel(terra::WGS84<float>(), wgs84, 1.0, "WGS84<float>");
+	testGeodesicModel(terra::approximate(terra::WGS84<float>()), wgs84, 1.0, "Approximate<WGS84<float>>");
+	testGeodesicModel(terra::Sphere<double>(6371000.0), sphere, 1.0, "Sphere<double>");
+	testGeodesicModel(terra::degrees(terra::Sphere<double>(6371000.0)), sphere, pi/180.0, "Degrees<Sphere<double>>");
+	testGeodesicModel(terra::Sphere<float>(6371000.0f), sphere, 1.0, "Sphere<float>");
+	testGeodesicModel(terra::approximate(terra::Sphere<float>(6371000.0f)), sphere, 1.0, "Approximate<Sphere<float>>");
+	testGeodesicOneToMany(terra::Sphere<double>(6371000.0), "Sphere<double>");
+	testGeodesicOneToMany(terra::Sphere<float>(6371000.0f), "Sphere<float>");
+	testGeodesicOneToMany(terra::WGS84<double>(), "WGS84<double>");
+	testGeodesicOneToMany(terra::WGS84<float>(), "WGS84<float>");
+}
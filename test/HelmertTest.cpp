@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/Helmert.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+/* Error of the fused kernel against a double reference, in metres: Bowring's near the surface in double. */
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 4.0;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-4;
+};
+
+double const arcsec = 3.14159265358979323846/(180.0*3600.0);
+
+/*
+ * The WGS 72 to WGS 84 example of EPSG Guidance Note 7-2: 55N 4E on WGS 72
+ * lands at (3657660.78, 255778.43, 5201387.75), 55°0'0.090"N 4°0'0.554"E,
+ * 3.22 m on WGS 84, in either rotation convention.
+ */
+static
+void
+testHelmertReference()
+{
+#define FUNC "testHelmertReference: "
+	double const degree = 3.14159265358979323846/180.0;
+	terra::Ellipsoid<double> const wgs72(6378135.0, 6378135.0*(1.0 - 1.0/298.26));
+	terra::Helmert<double> const transforms[2] = {
+		terra::Helmert<double>(0.0, 0.0, 4.5, 0.0, 0.0, 0.554, 0.219),
+		terra::Helmert<double>(0.0, 0.0, 4.5, 0.0, 0.0, -0.554, 0.219, terra::HelmertConvention::CoordinateFrame)
+	};
+
+	for (auto const &transform : transforms) {
+		double ecef[3] = { 4.0*degree, 55.0*degree, 0.0 };
+		terra::geodToECEF(&ecef, wgs72);
+		terra::helmert(&ecef, transform);
+		if (std::abs(ecef[0] - 3657660.78) > 0.006 || std::abs(ecef[1] - 255778.43) > 0.006 ||
+		    std::abs(ecef[2] - 5201387.75) > 0.006) {
+			std::fprintf(stderr, FUNC "FAIL: helmert: (%.3f, %.3f, %.3f)\n", ecef[0], ecef[1], ecef[2]);
+			exit(-1);
+		}
+
+		double geod[3] = { 4.0*degree, 55.0*degree, 0.0 };
+		terra::datumTransform(&geod, transform, wgs72, terra::WGS84<double>());
+		auto const dlon = (geod[0] - 4.0*degree)/arcsec;
+		auto const dlat = (geod[1] - 55.0*degree)/arcsec;
+		if (std::abs(dlon - 0.554) > 0.0006 || std::abs(dlat - 0.090) > 0.0006 || std::abs(geod[2] - 3.22) > 0.006) {
+			std::fprintf(stderr, FUNC "FAIL: datumTransform: (%.4f\", %.4f\", %.3f m)\n", dlon, dlat, geod[2]);
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+/*
+ * The fused SoA kernel lands within the tolerance of the three passes done
+ * in double, at every instruction set level; the SoA ECEF kernel matches the
+ * single one, and the inverse brings the points back.
+ */
+template<typename S, typename From, typename To, typename FromReference, typename ToReference>
+static
+void
+testHelmertModel(
+	From const from,
+	To const to,
+	FromReference const fromReference,
+	ToReference const toReference,
+	double const angleScale,
+	char const * const name)
+{
+#define FUNC "testHelmertModel: "
+	using T = typename From::value_type;
+	/* Not a multiple of any vector width, so the tails are exercised. */
+	constexpr auto const numCoords = 1003u;
+	/* ETRS89 to OSGB36, as published by the Ordnance Survey. */
+	terra::Helmert<double> const reference(-446.448, 125.157, -542.060, -0.1502, -0.2470, -0.8421, 20.4894);
+	terra::Helmert<T> const transform(T(-446.448), T(125.157), T(-542.060), T(-0.1502), T(-0.2470), T(-0.8421),
+					  T(20.4894));
+
+	std::vector<S> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<double> refECEF(3*numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = S((2.0*u - 1.0)*3.14159265358979323846*angleScale);
+		lat[i] = S(std::asin(2.0*v - 1.0)*angleScale);
+		alt[i] = S((2.0*w - 1.0)*1e4);
+		double coord[3] = { double(lon[i])/angleScale, double(lat[i])/angleScale, double(alt[i]) };
+		terra::geodToECEF(&coord, fromReference);
+		terra::helmert(&coord, reference);
+		refECEF[3*i + 0] = coord[0];
+		refECEF[3*i + 1] = coord[1];
+		refECEF[3*i + 2] = coord[2];
+	}
+	CoordSoA<S> const geod = { lon.data(), lat.data(), alt.data() };
+	/* Float storage rounds the angles to about a metre, whatever T is. */
+	auto const tolerance = Tolerance<T>::length + (sizeof(S) < sizeof(T) ? Tolerance<S>::length : 0.0);
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<S> olon(numCoords), olat(numCoords), oalt(numCoords);
+		CoordSoA<S> out = { olon.data(), olat.data(), oalt.data() };
+		terra::datumTransformSoA(&out, geod, numCoords, transform, from, to);
+		for (auto i = 0u; i < numCoords; ++i) {
+			double coord[3] = { double(olon[i])/angleScale, double(olat[i])/angleScale, double(oalt[i]) };
+			terra::geodToECEF(&coord, toReference);
+			auto const dx = coord[0] - refECEF[3*i + 0];
+			auto const dy = coord[1] - refECEF[3*i + 1];
+			auto const dz = coord[2] - refECEF[3*i + 2];
+			if (!(std::sqrt(dx*dx + dy*dy + dz*dz) <= tolerance)) {
+				std::fprintf(stderr, FUNC "%s: datumTransformSoA: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, std::sqrt(dx*dx + dy*dy + dz*dz));
+				exit(-1);
+			}
+		}
+
+		std::vector<S> blon(numCoords), blat(numCoords), balt(numCoords);
+		CoordSoA<S> back = { blon.data(), blat.data(), balt.data() };
+		terra::datumTransformSoA(&back, out, numCoords, terra::inverse(transform), to, from);
+		for (auto i = 0u; i < numCoords; ++i) {
+			double a[3] = { double(lon[i])/angleScale, double(lat[i])/angleScale, double(alt[i]) };
+			double b[3] = { double(blon[i])/angleScale, double(blat[i])/angleScale, double(balt[i]) };
+			terra::geodToECEF(&a, fromReference);
+			terra::geodToECEF(&b, fromReference);
+			auto const d = std::sqrt((a[0] - b[0])*(a[0] - b[0]) + (a[1] - b[1])*(a[1] - b[1]) +
+						 (a[2] - b[2])*(a[2] - b[2]));
+			if (!(d <= 2.0*tolerance)) {
+				std::fprintf(stderr, FUNC "%s: inverse: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, d);
+				exit(-1);
+			}
+		}
+
+		std::vector<S> x0(numCoords), y0(numCoords), z0(numCoords), x(numCoords), y(numCoords), z(numCoords);
+		for (auto i = 0u; i < numCoords; ++i) {
+			x0[i] = S(refECEF[3*i + 0]);
+			y0[i] = S(refECEF[3*i + 1]);
+			z0[i] = S(refECEF[3*i + 2]);
+		}
+		CoordSoA<S> const source = { x0.data(), y0.data(), z0.data() };
+		CoordSoA<S> ecef = { x.data(), y.data(), z.data() };
+		terra::helmertSoA(&ecef, source, numCoords, transform);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T coord[3] = { T(x0[i]), T(y0[i]), T(z0[i]) };
+			terra::helmert(&coord, transform);
+			S const got[3] = { x[i], y[i], z[i] };
+			for (auto j = 0; j < 3; ++j) {
+				if (!(std::abs(double(got[j]) - double(coord[j])) <= 1e-6*std::abs(double(coord[j])))) {
+					std::fprintf(stderr, FUNC "%s: helmertSoA: %s: FAIL: coordinate %u\n",
+						     name, terra::simdLevelName(level), i);
+					exit(-1);
+				}
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testHelmert()
+{
+	double const degrees = 180.0/3.14159265358979323846;
+	terra::Ellipsoid<double> const airy(6377563.396, 6356256.909);
+	terra::Ellipsoid<float> const airyFloat(6377563.396f, 6356256.909f);
+	testHelmertReference();
+	testHelmertModel<double>(terra::GRS80<double>(), airy, terra::GRS80<double>(), airy, 1.0, "GRS80<double> to Airy");
+	testHelmertModel<double>(terra::degrees(terra::GRS80<double>()), terra::degrees(airy), terra::GRS80<double>(), airy,
+				 degrees, "Degrees<GRS80<double>> to Degrees<Airy>");
+	testHelmertModel<float>(terra::GRS80<double>(), airy, terra::GRS80<double>(), airy, 1.0,
+				"GRS80<double> to Airy, float storage");
+	testHelmertModel<float>(terra::GRS80<float>(), airyFloat, terra::GRS80<double>(), airy, 1.0,
+				"GRS80<float> to Airy<float>");
+	testHelmertModel<double>(terra::GRS80<double>(), terra::Sphere<double>(6371000.0), terra::GRS80<double>(),
+				 terra::Sphere<double>(6371000.0), 1.0, "GRS80<double> to Sphere<double>");
+}
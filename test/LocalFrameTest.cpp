@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Dispatch.hpp>
+#include <terra/LocalFrame.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct Type {
+};
+template<>
+struct Type<float> {
+	static constexpr auto const str = "Float";
+	/* Two ulps of an ECEF coordinate. */
+	static constexpr auto const tolerance = 1.0f;
+};
+template<>
+struct Type<double> {
+	static constexpr auto const str = "Double";
+	static constexpr auto const tolerance = 1e-6;
+};
+
+template<typename T>
+static
+bool
+near(T const * const a, T const * const b, T const tolerance)
+{
+	return std::abs(a[0] - b[0]) <= tolerance &&
+	       std::abs(a[1] - b[1]) <= tolerance &&
+	       std::abs(a[2] - b[2]) <= tolerance;
+}
+
+template<typename T>
+static
+void
+testLocalFrameAxes()
+{
+#define FUNC "testLocalFrameAxes: "
+	auto const tolerance = Type<T>::tolerance;
+	auto const a = terra::WGS84<T>::semiMajor;
+
+	/* At lon = lat = 0, east is +y, north +z and up +x. */
+	terra::LocalFrame<T> const equator(T(0), T(0), T(0), terra::WGS84<T>());
+	T const ecef[3] = { a + T(100), T(10), T(20) };
+	T const enu[3] = { T(10), T(20), T(100) };
+	T const ned[3] = { T(20), T(10), T(-100) };
+	T got[3];
+
+	terra::ecefToENU(&got, ecef, equator);
+	if (!near(got, enu, tolerance)) {
+		std::fprintf(stderr, FUNC "%s: FAIL: ENU (%f, %f, %f)\n",
+			     Type<T>::str, double(got[0]), double(got[1]), double(got[2]));
+		exit(-1);
+	}
+	terra::ecefToNED(&got, ecef, equator);
+	if (!near(got, ned, tolerance)) {
+		std::fprintf(stderr, FUNC "%s: FAIL: NED (%f, %f, %f)\n",
+			     Type<T>::str, double(got[0]), double(got[1]), double(got[2]));
+		exit(-1);
+	}
+	terra::enuToECEF(&got, enu, equator);
+	if (!near(got, ecef, tolerance)) {
+		std::fprintf(stderr, FUNC "%s: FAIL: ENU to ECEF (%f, %f, %f)\n",
+			     Type<T>::str, double(got[0]), double(got[1]), double(got[2]));
+		exit(-1);
+	}
+	terra::nedToECEF(&got, ned, equator);
+	if (!near(got, ecef, tolerance)) {
+		std::fprintf(stderr, FUNC "%s: FAIL: NED to ECEF (%f, %f, %f)\n",
+			     Type<T>::str, double(got[0]), double(got[1]), double(got[2]));
+		exit(-1);
+	}
+
+	/* Up is the ellipsoid normal: straight above the origin is (0, 0, h). */
+	T const lon = T(-74.000401*3.14159265358979323846/180.0);
+	T const lat = T(40.719645*3.14159265358979323846/180.0);
+	T const above[3] = { T(0), T(0), T(500) };
+	terra::LocalFrame<T> const frame(lon, lat, T(5), terra::Ellipsoid<T>(a, terra::WGS84<T>::semiMinor));
+	got[0] = lon;
+	got[1] = lat;
+	got[2] = T(505);
+	terra::geodToECEF(&got, terra::WGS84<T>());
+	terra::ecefToENU(&got, frame);
+	if (!near(got, above, tolerance)) {
+		std::fprintf(stderr, FUNC "%s: FAIL: above origin (%f, %f, %f)\n",
+			     Type<T>::str, double(got[0]), double(got[1]), double(got[2]));
+		exit(-1);
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", Type<T>::str);
+#undef FUNC
+}
+
+template<typename T>
+static
+void
+testLocalFrameBatch()
+{
+#define FUNC "testLocalFrameBatch: "
+	auto const tolerance = Type<T>::tolerance;
+	terra::LocalFrame<T> const frame(T(2.4382), T(0.6226), T(50), terra::Sphere<T>(T(6371000)));
+
+	/* Points within a few hundred km of the origin, at any height. */
+	constexpr auto const numCoords = 1003u;
+	std::vector<T> ex(numCoords), ey(numCoords), ez(numCoords);
+	std::vector<T> enu(3*numCoords), ned(3*numCoords);
+	auto const enuRows = reinterpret_cast<T (*)[3]>(enu.data());
+	auto const nedRows = reinterpret_cast<T (*)[3]>(ned.data());
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const local[3] = { T(int(i*7919u%1000u) - 500)*T(500), T(int(i*104729u%1000u) - 500)*T(500),
+				     T(int(i*15485863u%1000u))*T(100) };
+		T ecef[3];
+		terra::enuToECEF(&ecef, local, frame);
+		ex[i] = ecef[0];
+		ey[i] = ecef[1];
+		ez[i] = ecef[2];
+		terra::ecefToENU(&enuRows[i], ecef, frame);
+		terra::ecefToNED(&nedRows[i], ecef, frame);
+		if (!near(enuRows[i], local, T(4)*tolerance)) {
+			std::fprintf(stderr, FUNC "%s: FAIL: round trip %u: (%f, %f, %f) != (%f, %f, %f)\n",
+				     Type<T>::str, i, double(enuRows[i][0]), double(enuRows[i][1]), double(enuRows[i][2]),
+				     double(local[0]), double(local[1]), double(local[2]));
+			exit(-1);
+		}
+	}
+	CoordSoA<T> const ecef = { ex.data(), ey.data(), ez.data() };
+
+	auto const check = [&](char const * const what, T const * const got, T const * const want) {
+		if (!near(got, want, tolerance)) {
+			std::fprintf(stderr, FUNC "%s: %s: FAIL: (%f, %f, %f) != (%f, %f, %f)\n",
+				     Type<T>::str, what, double(got[0]), double(got[1]), double(got[2]),
+				     double(want[0]), double(want[1]), double(want[2]));
+			exit(-1);
+		}
+	};
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> lx(numCoords), ly(numCoords), lz(numCoords);
+		std::vector<T> bx(numCoords), by(numCoords), bz(numCoords);
+		CoordSoA<T> local = { lx.data(), ly.data(), lz.data() };
+		CoordSoA<T> back = { bx.data(), by.data(), bz.data() };
+
+		terra::ecefToENUSoA(&local, ecef, numCoords, frame);
+		terra::enuToECEFSoA(&back, local, numCoords, frame);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { lx[i], ly[i], lz[i] };
+			check("ENU SoA", got, enuRows[i]);
+			T const gotECEF[3] = { bx[i], by[i], bz[i] };
+			T const wantECEF[3] = { ex[i], ey[i], ez[i] };
+			check("ENU SoA to ECEF", gotECEF, wantECEF);
+		}
+
+		terra::ecefToNEDSoA(&local, ecef, numCoords, frame);
+		terra::nedToECEFSoA(&back, local, numCoords, frame);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { lx[i], ly[i], lz[i] };
+			check("NED SoA", got, nedRows[i]);
+			T const gotECEF[3] = { bx[i], by[i], bz[i] };
+			T const wantECEF[3] = { ex[i], ey[i], ez[i] };
+			check("NED SoA to ECEF", gotECEF, wantECEF);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::vector<T> ecefAoS(3*numCoords), out(3*numCoords), back(3*numCoords);
+	auto const ecefRows = reinterpret_cast<T (*)[3]>(ecefAoS.data());
+	auto outRows = reinterpret_cast<T (*)[3]>(out.data());
+	auto backRows = reinterpret_cast<T (*)[3]>(back.data());
+	for (auto i = 0u; i < numCoords; ++i) {
+		ecefRows[i][0] = ex[i];
+		ecefRows[i][1] = ey[i];
+		ecefRows[i][2] = ez[i];
+	}
+	terra::ecefToENUAoS(&outRows, ecefRows, numCoords, frame);
+	terra::enuToECEFAoS(&backRows, outRows, numCoords, frame);
+	for (auto i = 0u; i < numCoords; ++i) {
+		check("ENU AoS", outRows[i], enuRows[i]);
+		check("ENU AoS to ECEF", backRows[i], ecefRows[i]);
+	}
+	terra::ecefToNEDAoS(&outRows, ecefRows, numCoords, frame);
+	terra::nedToECEFAoS(&backRows, outRows, numCoords, frame);
+	for (auto i = 0u; i < numCoords; ++i) {
+		check("NED AoS", outRows[i], nedRows[i]);
+		check("NED AoS to ECEF", backRows[i], ecefRows[i]);
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", Type<T>::str);
+#undef FUNC
+}
+
+template<typename T, typename Model>
+static
+void
+testLocalFrameFused(Model const model, char const * const name)
+{
+#define FUNC "testLocalFrameFused: "
+	auto const tolerance = Type<T>::tolerance;
+	/*
+	 * The reference rounds ECEF to T between the two passes and may contract
+	 * differently, so ENU can be off by a few ulps of ECEF; a round trip
+	 * through the frame and ecefToGeod by a few more.
+	 */
+	auto const enuTolerance = T(2)*tolerance;
+	auto const angleTolerance = T(4)*tolerance/T(6.4e6);
+	auto const altitudeTolerance = T(2)*tolerance;
+	terra::LocalFrame<T> const frame(T(-1.2916), T(0.7107), T(10), model);
+
+	constexpr auto const numCoords = 517u;
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<T> enu(3*numCoords);
+	auto const enuRows = reinterpret_cast<T (*)[3]>(enu.data());
+	for (auto i = 0u; i < numCoords; ++i) {
+		lon[i] = T(-1.2916) + T(int(i*7919u%1000u) - 500)*T(2e-5);
+		lat[i] = T(0.7107) + T(int(i*104729u%1000u) - 500)*T(2e-5);
+		alt[i] = T(int(i*15485863u%1000u))*T(10);
+		T coord[3] = { lon[i], lat[i], alt[i] };
+		terra::geodToECEF(&coord, model);
+		terra::ecefToENU(&enuRows[i], coord, frame);
+	}
+
+	auto const checkENU = [&](char const * const what, unsigned const i, T const * const got) {
+		if (!near(got, enuRows[i], enuTolerance)) {
+			std::fprintf(stderr, FUNC "%s: %s: %s: FAIL: coordinate %u: (%f, %f, %f) != (%f, %f, %f)\n",
+				     Type<T>::str, name, what, i, double(got[0]), double(got[1]), double(got[2]),
+				     double(enuRows[i][0]), double(enuRows[i][1]), double(enuRows[i][2]));
+			exit(-1);
+		}
+	};
+	auto const checkGeod = [&](char const * const what, unsigned const i, T const * const got) {
+		if (!(std::abs(got[0] - lon[i]) <= angleTolerance) || !(std::abs(got[1] - lat[i]) <= angleTolerance) ||
+		    !(std::abs(got[2] - alt[i]) <= altitudeTolerance)) {
+			std::fprintf(stderr, FUNC "%s: %s: %s: FAIL: coordinate %u: (%.9f, %.9f, %f) != (%.9f, %.9f, %f)\n",
+				     Type<T>::str, name, what, i, double(got[0]), double(got[1]), double(got[2]),
+				     double(lon[i]), double(lat[i]), double(alt[i]));
+			exit(-1);
+		}
+	};
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const geod[3] = { lon[i], lat[i], alt[i] };
+		T got[3];
+		terra::geodToENU(&got, geod, frame, model);
+		checkENU("single", i, got);
+		terra::enuToGeod(&got, frame, model);
+		checkGeod("single", i, got);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> lx(numCoords), ly(numCoords), lz(numCoords);
+		std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+		CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+		CoordSoA<T> local = { lx.data(), ly.data(), lz.data() };
+		CoordSoA<T> back = { gx.data(), gy.data(), gz.data() };
+
+		terra::geodToENUSoA(&local, geod, numCoords, frame, model);
+		terra::enuToGeodSoA(&back, local, numCoords, frame, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { lx[i], ly[i], lz[i] };
+			checkENU(terra::simdLevelName(level), i, got);
+			T const gotGeod[3] = { gx[i], gy[i], gz[i] };
+			checkGeod(terra::simdLevelName(level), i, gotGeod);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::vector<T> geodAoS(3*numCoords), out(3*numCoords), back(3*numCoords);
+	auto const geodRows = reinterpret_cast<T (*)[3]>(geodAoS.data());
+	auto outRows = reinterpret_cast<T (*)[3]>(out.data());
+	auto backRows = reinterpret_cast<T (*)[3]>(back.data());
+	for (auto i = 0u; i < numCoords; ++i) {
+		geodRows[i][0] = lon[i];
+		geodRows[i][1] = lat[i];
+		geodRows[i][2] = alt[i];
+	}
+	terra::geodToENUAoS(&outRows, geodRows, numCoords, frame, model);
+	terra::enuToGeodAoS(&backRows, outRows, numCoords, frame, model);
+	for (auto i = 0u; i < numCoords; ++i) {
+		checkENU("AoS", i, outRows[i]);
+		checkGeod("AoS", i, backRows[i]);
+	}
+
+	std::printf(FUNC "%s: %s: SUCCESS\n", Type<T>::str, name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testLocalFrame()
+{
+	testLocalFrameAxes<float>();
+	testLocalFrameAxes<double>();
+	testLocalFrameBatch<float>();
+	testLocalFrameBatch<double>();
+	testLocalFrameFused<float>(terra::Sphere<float>(6371000.0f), "Sphere");
+	testLocalFrameFused<float>(terra::WGS84<float>(), "WGS84");
+	testLocalFrameFused<double>(terra::Sphere<double>(6371000.0), "Sphere");
+	testLocalFrameFused<double>(terra::WGS84<double>(), "WGS84");
+	testLocalFrameFused<double>(terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid");
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Parallel.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define DEG2RAD(a) ((a)*(3.141592653/180.0f))
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+static
+void
+testThreadPool()
+{
+#define FUNC "testThreadPool: "
+	terra::ThreadPool pool(4);
+	if (pool.size() != 4) {
+		std::fprintf(stderr, FUNC "FAIL: pool has %u threads, not 4\n", pool.size());
+		exit(-1);
+	}
+
+	/* Uneven task counts, run repeatedly so that stealing kicks in. */
+	std::size_t const counts[] = { 0, 1, 3, 4, 5, 1000, 100003 };
+	for (auto const numTasks : counts) {
+		std::vector<std::atomic<int>> hits(numTasks);
+		for (auto &h : hits)
+			h = 0;
+		for (auto round = 0; round < 3; ++round) {
+			pool.run(numTasks, [&](std::size_t const i) {
+				hits[i].fetch_add(1);
+			});
+		}
+		for (auto i = std::size_t(0); i < numTasks; ++i) {
+			if (hits[i] != 3) {
+				std::fprintf(stderr, FUNC "FAIL: task %zu of %zu ran %d times, not 3\n",
+					     i, numTasks, int(hits[i]));
+				exit(-1);
+			}
+		}
+	}
+
+	/* A loop started from within a task runs in place rather than deadlocking. */
+	std::atomic<int> inner(0);
+	pool.run(8, [&](std::size_t) {
+		pool.run(10, [&](std::size_t) { inner.fetch_add(1); });
+	});
+	if (inner != 80) {
+		std::fprintf(stderr, FUNC "FAIL: nested loops ran %d tasks, not 80\n", int(inner));
+		exit(-1);
+	}
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+template<typename T, typename Model, typename Executor>
+static
+void
+testParallelModel(Executor &executor, Model const model, char const * const name)
+{
+#define FUNC "testParallelModel: "
+	/* Several chunks and a partial one. */
+	auto const numCoords = 3*terra::parallelChunkSize + 77;
+
+	std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		gx[i] = DEG2RAD((T((i*37)%360) - T(179.75)));
+		gy[i] = DEG2RAD((T((i*53)%180) - T(89.5)));
+		gz[i] = T((i*97)%20000) - T(1000);
+	}
+	CoordSoA<T> const geod = { gx.data(), gy.data(), gz.data() };
+
+	std::vector<T> sx(numCoords), sy(numCoords), sz(numCoords);
+	std::vector<T> px(numCoords), py(numCoords), pz(numCoords);
+	CoordSoA<T> serial = { sx.data(), sy.data(), sz.data() };
+	CoordSoA<T> parallel = { px.data(), py.data(), pz.data() };
+
+	/* Same kernels on the same data, so the results must be identical. */
+	terra::geodToECEFSoA(&serial, geod, numCoords, model);
+	terra::geodToECEFSoA(executor, &parallel, geod, numCoords, model);
+	if (sx != px || sy != py || sz != pz) {
+		std::fprintf(stderr, FUNC "%s: FAIL: parallel geodToECEFSoA differs\n", name);
+		exit(-1);
+	}
+
+	CoordSoA<T> const ecef = serial;
+	std::vector<T> bx(numCoords), by(numCoords), bz(numCoords);
+	CoordSoA<T> back = { bx.data(), by.data(), bz.data() };
+	terra::ecefToGeodSoA(&back, ecef, numCoords, model);
+	terra::ecefToGeodSoA(executor, &parallel, ecef, numCoords, model);
+	if (bx != px || by != py || bz != pz) {
+		std::fprintf(stderr, FUNC "%s: FAIL: parallel ecefToGeodSoA differs\n", name);
+		exit(-1);
+	}
+
+	using Coord = T[3];
+	std::vector<T> aosIn(3*numCoords), aosOut(3*numCoords);
+	auto in = reinterpret_cast<Coord *>(aosIn.data());
+	auto out = reinterpret_cast<Coord *>(aosOut.data());
+	for (auto i = 0u; i < numCoords; ++i) {
+		in[i][0] = gx[i];
+		in[i][1] = gy[i];
+		in[i][2] = gz[i];
+	}
+	terra::geodToECEFAoS(executor, &out, in, numCoords, model);
+	for (auto i = 0u; i < numCoords; ++i) {
+		if (out[i][0] != sx[i] || out[i][1] != sy[i] || out[i][2] != sz[i]) {
+			std::fprintf(stderr, FUNC "%s: FAIL: parallel geodToECEFAoS differs at %u\n", name, i);
+			exit(-1);
+		}
+	}
+	terra::ecefToGeodAoS(executor, &in, out, numCoords, model);
+	for (auto i = 0u; i < numCoords; ++i) {
+		if (in[i][0] != bx[i] || in[i][1] != by[i] || in[i][2] != bz[i]) {
+			std::fprintf(stderr, FUNC "%s: FAIL: parallel ecefToGeodAoS differs at %u\n", name, i);
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testParallel()
+{
+	testThreadPool();
+
+	terra::ThreadPool pool(3);
+	terra::SerialExecutor serial;
+	testParallelModel<double>(pool, terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid<double>");
+	testParallelModel<float>(pool, terra::WGS84<float>(), "WGS84<float>");
+	testParallelModel<double>(pool, terra::Sphere<double>(6371000.0), "Sphere<double>");
+	testParallelModel<double>(serial, terra::GRS80<double>(), "GRS80<double>, serial");
+}
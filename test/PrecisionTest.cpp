@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/LocalFrame.hpp>
+#include <terra/Strided.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct Series {
+	explicit Series(std::size_t const n) : x(n), y(n), z(n) {}
+	CoordSoA<T> soa() { return CoordSoA<T>{ x.data(), y.data(), z.data() }; }
+	std::vector<T> x, y, z;
+};
+
+/* Not a multiple of any vector width, so the tails are exercised. */
+constexpr auto const numCoords = 1003u;
+
+static
+Series<double>
+makeGeodetic()
+{
+	Series<double> geod(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		geod.x[i] = (2.0*u - 1.0)*3.14159265358979323846;
+		geod.y[i] = (2.0*v - 1.0)*1.5;
+		geod.z[i] = w*10000.0 - 500.0;
+	}
+	return geod;
+}
+
+template<typename S, typename T>
+static
+Series<S>
+convert(Series<T> const &from)
+{
+	Series<S> to(from.x.size());
+	for (auto i = std::size_t(0); i < from.x.size(); ++i) {
+		to.x[i] = S(from.x[i]);
+		to.y[i] = S(from.y[i]);
+		to.z[i] = S(from.z[i]);
+	}
+	return to;
+}
+
+/*
+ * Stored as S, computed as T, the results are those of converting the input to
+ * T, running the T kernels and converting the output back, at every level.
+ * Only up to rounding: the compiler is free to contract the two instances of a
+ * kernel into fused multiply-adds differently.
+ */
+template<typename S, typename Model>
+static
+void
+testPrecisionModel(Model const model, char const * const name)
+{
+#define FUNC "testPrecisionModel: "
+	using T = typename Model::value_type;
+	auto geod = convert<S>(makeGeodetic());
+	auto geodT = convert<T>(geod);
+	terra::LocalFrame<T> const frame(T(0.5), T(0.8), T(100), terra::WGS84<T>());
+
+	/* A few units in the last place of T, on angles or on ECEF sized lengths, plus one of S. */
+	auto const close = [](S const got, S const want, double const scale) {
+		auto const ulp = std::abs(double(std::nextafter(want, S(1e30))) - double(want));
+		return std::abs(double(got) - double(want)) <= 8.0*double(std::numeric_limits<T>::epsilon())*scale + ulp;
+	};
+	auto const check = [&](char const * const what, terra::SimdLevel const level,
+			       Series<S> const &got, Series<T> const &expected, bool const geodetic) {
+		auto const want = convert<S>(expected);
+		auto const scale = geodetic ? 4.0 : 6.4e6;
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (!close(got.x[i], want.x[i], scale) || !close(got.y[i], want.y[i], scale) ||
+			    !close(got.z[i], want.z[i], 6.4e6)) {
+				std::fprintf(stderr, FUNC "%s: %s: %s: FAIL: coordinate %u: (%.17g, %.17g, %.17g) != (%.17g, %.17g, %.17g)\n",
+					     name, what, terra::simdLevelName(level), i,
+					     double(got.x[i]), double(got.y[i]), double(got.z[i]),
+					     double(want.x[i]), double(want.y[i]), double(want.z[i]));
+				exit(-1);
+			}
+		}
+	};
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		Series<S> ecef(numCoords), out(numCoords);
+		Series<T> ecefT(numCoords), outT(numCoords);
+		auto ecefSoA = ecef.soa(), outSoA = out.soa();
+		auto ecefTSoA = ecefT.soa(), outTSoA = outT.soa();
+
+		terra::geodToECEFSoA(&ecefSoA, geod.soa(), numCoords, model);
+		terra::geodToECEFSoA(&ecefTSoA, geodT.soa(), numCoords, model);
+		check("geodToECEFSoA", level, ecef, ecefT, false);
+
+		/* Back from the stored coordinates, as the caller would. */
+		ecefT = convert<T>(ecef);
+		ecefTSoA = ecefT.soa();
+		terra::ecefToGeodSoA(&outSoA, ecef.soa(), numCoords, model);
+		terra::ecefToGeodSoA(&outTSoA, ecefT.soa(), numCoords, model);
+		check("ecefToGeodSoA", level, out, outT, true);
+
+		terra::ecefToENUSoA(&outSoA, ecef.soa(), numCoords, frame);
+		terra::ecefToENUSoA(&outTSoA, ecefT.soa(), numCoords, frame);
+		check("ecefToENUSoA", level, out, outT, false);
+
+		terra::geodToENUSoA(&outSoA, geod.soa(), numCoords, frame, model);
+		terra::geodToENUSoA(&outTSoA, geodT.soa(), numCoords, frame, model);
+		check("geodToENUSoA", level, out, outT, false);
+
+		auto const enuT = outT;
+		auto enu = convert<S>(enuT);
+		auto enuTRounded = convert<T>(enu);
+		terra::enuToGeodSoA(&outSoA, enu.soa(), numCoords, frame, model);
+		terra::enuToGeodSoA(&outTSoA, enuTRounded.soa(), numCoords, frame, model);
+		check("enuToGeodSoA", level, out, outT, true);
+
+		terra::enuToECEFSoA(&outSoA, enu.soa(), numCoords, frame);
+		terra::enuToECEFSoA(&outTSoA, enuTRounded.soa(), numCoords, frame);
+		check("enuToECEFSoA", level, out, outT, false);
+
+		/* Records of S, gathered a block at a time. */
+		std::vector<S> records(4*numCoords);
+		for (auto i = 0u; i < numCoords; ++i) {
+			records[4*i + 0] = geod.x[i];
+			records[4*i + 1] = geod.y[i];
+			records[4*i + 2] = geod.z[i];
+		}
+		auto strided = terra::strided(records.data(), std::ptrdiff_t(4*sizeof(S)));
+		terra::geodToECEFStrided(&strided, numCoords, model);
+		terra::ecefToGeodStrided(&strided, numCoords, model);
+		terra::ecefToGeodSoA(&outTSoA, convert<T>(ecef).soa(), numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			out.x[i] = records[4*i + 0];
+			out.y[i] = records[4*i + 1];
+			out.z[i] = records[4*i + 2];
+		}
+		check("Strided", level, out, outT, true);
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/*
+ * Float storage with double computation: the only error left is that of
+ * storing in float, so the results are the double ones rounded, to within a
+ * unit in the last place, and far closer than computing in float.
+ */
+static
+void
+testPrecisionRounding()
+{
+#define FUNC "testPrecisionRounding: "
+	auto geod = convert<float>(makeGeodetic());
+	auto geodD = convert<double>(geod);
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		Series<float> ecef(numCoords), ecefFloat(numCoords);
+		Series<double> ecefD(numCoords);
+		auto ecefSoA = ecef.soa(), ecefFloatSoA = ecefFloat.soa();
+		auto ecefDSoA = ecefD.soa();
+		terra::geodToECEFSoA(&ecefSoA, geod.soa(), numCoords, terra::WGS84<double>());
+		terra::geodToECEFSoA(&ecefFloatSoA, geod.soa(), numCoords, terra::WGS84<float>());
+		terra::geodToECEFSoA(&ecefDSoA, geodD.soa(), numCoords, terra::WGS84<double>());
+
+		auto maxError = 0.0, maxErrorFloat = 0.0;
+		for (auto i = 0u; i < numCoords; ++i) {
+			float const got[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+			float const gotFloat[3] = { ecefFloat.x[i], ecefFloat.y[i], ecefFloat.z[i] };
+			double const want[3] = { ecefD.x[i], ecefD.y[i], ecefD.z[i] };
+			for (auto j = 0; j < 3; ++j) {
+				auto const ulp = std::nextafter(float(want[j]), 1e30f) - float(want[j]);
+				if (!(std::abs(double(got[j]) - want[j]) <= double(ulp))) {
+					std::fprintf(stderr, FUNC "%s: FAIL: coordinate %u[%d]: %.9g != %.9g\n",
+						     terra::simdLevelName(level), i, j, double(got[j]), want[j]);
+					exit(-1);
+				}
+				maxError = std::fmax(maxError, std::abs(double(got[j]) - want[j]));
+				maxErrorFloat = std::fmax(maxErrorFloat, std::abs(double(gotFloat[j]) - want[j]));
+			}
+		}
+		if (!(maxError < maxErrorFloat)) {
+			std::fprintf(stderr, FUNC "%s: FAIL: %g m is no better than %g m computing in float\n",
+				     terra::simdLevelName(level), maxError, maxErrorFloat);
+			exit(-1);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testPrecision()
+{
+	testPrecisionModel<float>(terra::Sphere<double>(6371000.0), "float in Sphere<double>");
+	testPrecisionModel<float>(terra::WGS84<double>(), "float in WGS84<double>");
+	testPrecisionModel<float>(terra::Ellipsoid<double>(6378137.0, 6356752.314245), "float in Ellipsoid<double>");
+	testPrecisionModel<double>(terra::Sphere<float>(6371000.0f), "double in Sphere<float>");
+	testPrecisionModel<double>(terra::WGS84<float>(), "double in WGS84<float>");
+	testPrecisionModel<double>(terra::approximate(terra::WGS84<float>()), "double in Approximate<WGS84<float>>");
+	testPrecisionModel<float>(terra::WGS84<float>(), "float in WGS84<float>");
+	testPrecisionRounding();
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/Parallel.hpp>
+#include <terra/SpatialIndex.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+/*
+ * Points clustered around a city, with some duplicates, and spread over the
+ * globe; queries at points, between them and on the far side, with radii
+ * from a leaf's width to a continent's. Radius and nearest queries agree
+ * with brute force over the same ECEF coordinates, within rounding of the
+ * squared distances, and the batch queries with the single ones, at every
+ * instruction set level.
+ */
+template<typename Model>
+static
+void
+testSpatialIndexModel(
+	Model const model,
+	double const angleScale,
+	char const * const name)
+{
+#define FUNC "testSpatialIndexModel: "
+	using T = typename Model::value_type;
+	constexpr auto const numCoords = 5003u;
+	constexpr auto const numQueries = 301u;
+	constexpr auto const k = 7u;
+	double const eps = sizeof(T) == sizeof(float) ? 1e-5 : 1e-12;
+
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		if (i%5 == 0) {
+			lon[i] = T(angleScale*(2.0*u - 1.0)*3.141592653589793);
+			lat[i] = T(angleScale*std::asin(2.0*v - 1.0));
+		} else if (i%97 == 1) {
+			lon[i] = lon[i - 1];
+			lat[i] = lat[i - 1];
+		} else {
+			lon[i] = T(angleScale*(0.3 + 0.01*u));
+			lat[i] = T(angleScale*(1.0 + 0.01*v));
+		}
+		alt[i] = T(100.0*w);
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+
+	std::vector<T> x(numCoords), y(numCoords), z(numCoords);
+	CoordSoA<T> ecef = { x.data(), y.data(), z.data() };
+	terra::geodToECEFSoA(&ecef, geod, numCoords, model);
+
+	std::vector<T> qx(numQueries), qy(numQueries), qz(numQueries);
+	for (auto i = 0u; i < numQueries; ++i) {
+		auto const j = (i*7919u)%numCoords;
+		auto const s = i%3 == 0 ? 0.0 : i%3 == 1 ? 300.0 : -2e6;
+		qx[i] = T(x[j] + s);
+		qy[i] = T(y[j] - s);
+		qz[i] = T(z[j] + 0.5*s);
+	}
+	CoordSoA<T> const queries = { qx.data(), qy.data(), qz.data() };
+
+	auto const squared = [&](std::size_t const q, std::size_t const p) {
+		auto const dx = double(x[p]) - double(qx[q]);
+		auto const dy = double(y[p]) - double(qy[q]);
+		auto const dz = double(z[p]) - double(qz[q]);
+		return dx*dx + dy*dy + dz*dz;
+	};
+
+	terra::ThreadPool pool(4);
+	terra::SpatialIndex<T> index;
+	index.build(pool, geod, numCoords, model);
+	if (index.size() != numCoords) {
+		std::fprintf(stderr, FUNC "%s: FAIL: size %u, not %u\n", name, unsigned(index.size()), numCoords);
+		exit(-1);
+	}
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		for (auto const chord : { 50.0, 20000.0, 3e6 }) {
+			std::vector<std::size_t> offsets, batch;
+			index.radiusSoA(pool, queries, numQueries, T(chord), &offsets, &batch);
+			for (auto q = 0u; q < numQueries; ++q) {
+				T const point[3] = { qx[q], qy[q], qz[q] };
+				std::vector<std::size_t> found;
+				index.radius(point, T(chord), &found);
+				std::vector<bool> in(numCoords, false);
+				for (auto const p : found)
+					in[p] = true;
+				auto ok = std::equal(found.begin(), found.end(), batch.begin() + offsets[q]) &&
+					  offsets[q + 1] - offsets[q] == found.size();
+				for (auto p = 0u; p < numCoords && ok; ++p) {
+					auto const d2 = squared(q, p);
+					if ((d2 < chord*chord*(1 - eps) && !in[p]) || (d2 > chord*chord*(1 + eps) && in[p]))
+						ok = false;
+				}
+				if (!ok) {
+					std::fprintf(stderr, FUNC "%s: %s: FAIL: radius %g around query %u\n",
+						     name, terra::simdLevelName(level), chord, q);
+					exit(-1);
+				}
+			}
+		}
+
+		std::vector<std::size_t> batch(numQueries*k);
+		std::vector<T> batchChords(numQueries*k);
+		index.nearestSoA(pool, queries, numQueries, k, batch.data(), batchChords.data());
+		for (auto q = 0u; q < numQueries; ++q) {
+			T const point[3] = { qx[q], qy[q], qz[q] };
+			std::size_t got[k];
+			T chords[k];
+			auto const n = index.nearest(point, k, got, chords);
+			std::vector<double> all(numCoords);
+			for (auto p = 0u; p < numCoords; ++p)
+				all[p] = squared(q, p);
+			std::nth_element(all.begin(), all.begin() + (k - 1), all.end());
+			auto ok = n == k && std::equal(got, got + k, batch.begin() + q*k) &&
+				  std::equal(chords, chords + k, batchChords.begin() + q*k);
+			for (auto i = 0u; i < k && ok; ++i) {
+				auto const d2 = squared(q, got[i]);
+				auto const chord = double(chords[i]);
+				ok = std::abs(chord*chord - d2) <= eps*d2 + 1e-6 &&
+				     (i == 0 || chords[i - 1] <= chords[i]) &&
+				     std::count(got, got + k, got[i]) == 1;
+			}
+			if (ok && squared(q, got[k - 1]) > all[k - 1]*(1 + eps) + 1e-6)
+				ok = false;
+			if (!ok) {
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: nearest to query %u\n",
+					     name, terra::simdLevelName(level), q);
+				for (auto i = 0u; i < n; ++i)
+					std::fprintf(stderr, "\t%u: %.9g (%.9g)\n", unsigned(got[i]), double(chords[i]),
+						     std::sqrt(squared(q, got[i])));
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	/* Built serially or from ECEF, the tree is the same. */
+	terra::SerialExecutor serial;
+	terra::SpatialIndex<T> fromECEF;
+	fromECEF.buildECEF(serial, ecef, numCoords);
+	for (auto q = 0u; q < numQueries; ++q) {
+		T const point[3] = { qx[q], qy[q], qz[q] };
+		std::size_t a[k], b[k];
+		index.nearest(point, k, a, nullptr);
+		fromECEF.nearest(point, k, b, nullptr);
+		if (!std::equal(a, a + k, b)) {
+			std::fprintf(stderr, FUNC "%s: FAIL: serial ECEF build differs at query %u\n", name, q);
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/* Empty and tiny indices; asking for more neighbours than there are points. */
+template<typename T>
+static
+void
+testSpatialIndexSmall()
+{
+#define FUNC "testSpatialIndexSmall: "
+	terra::SerialExecutor serial;
+	terra::SpatialIndex<T> index;
+	T const origin[3] = { T(0), T(0), T(0) };
+	std::vector<std::size_t> found;
+	std::size_t got[4];
+	T chords[4];
+
+	if (index.size() != 0 || index.radius(origin, T(1e9), &found) != 0 ||
+	    index.nearest(origin, 4, got, chords) != 0 || got[0] != std::size_t(-1) || !std::isinf(chords[3])) {
+		std::fprintf(stderr, FUNC "FAIL: empty index\n");
+		exit(-1);
+	}
+
+	T px[3] = { T(3), T(1), T(2) }, py[3] = { T(0), T(0), T(0) }, pz[3] = { T(0), T(0), T(0) };
+	CoordSoA<T> const points = { px, py, pz };
+	index.buildECEF(serial, points, 3);
+	auto const n = index.nearest(origin, 4, got, chords);
+	if (n != 3 || got[0] != 1 || got[1] != 2 || got[2] != 0 || got[3] != std::size_t(-1) ||
+	    chords[0] != T(1) || chords[2] != T(3) || !std::isinf(chords[3])) {
+		std::fprintf(stderr, FUNC "FAIL: three points\n");
+		exit(-1);
+	}
+	if (index.radius(origin, T(2), &found) != 2 || index.radius(origin, T(0.5), &found) != 0) {
+		std::fprintf(stderr, FUNC "FAIL: radius on three points\n");
+		exit(-1);
+	}
+
+	/* A quarter of the way round the sphere spans a chord of r*sqrt(2). */
+	terra::Sphere<T> const sphere(T(6371000));
+	auto const chord = terra::chordLength(T(6371000*1.5707963267948966), sphere);
+	if (std::abs(chord - T(6371000*1.4142135623730951)) > T(1e-5)*chord ||
+	    terra::chordLength(T(1e9), sphere) != T(2*6371000) ||
+	    terra::chordLength(T(1000), terra::WGS84<T>()) != T(1000)) {
+		std::fprintf(stderr, FUNC "FAIL: chordLength\n");
+		exit(-1);
+	}
+
+	std::printf(FUNC "%s: SUCCESS\n", sizeof(T) == sizeof(float) ? "Float" : "Double");
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testSpatialIndex()
+{
+	double const degrees = 180.0/3.14159265358979323846;
+	testSpatialIndexModel(terra::WGS84<double>(), 1.0, "WGS84<double>");
+	testSpatialIndexModel(terra::WGS84<float>(), 1.0, "WGS84<float>");
+	testSpatialIndexModel(terra::Sphere<double>(6371000.0), 1.0, "Sphere<double>");
+	testSpatialIndexModel(terra::degrees(terra::Sphere<float>(6371000.0f)), degrees, "Degrees<Sphere<float>>");
+	testSpatialIndexSmall<float>();
+	testSpatialIndexSmall<double>();
+}
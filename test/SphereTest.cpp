@@ -39,7 +39,7 @@ struct TestContext {
 };
 template<>
 struct TestContext<double> {
-	TestContext() : sphere(6378137.0), tolerance(0.00001),
+	TestContext() : sphere(6378137.0), tolerance(0.00001), batchTolerance(0.00001), angleTolerance(1e-10),
 	geod{
 		{ DEG2RAD(   0.000000), DEG2RAD(   0.000000),    0.0 },
 		{ DEG2RAD( -74.000401), DEG2RAD(  40.719645),    5.0 },
@@ -59,12 +59,14 @@ struct TestContext<double> {
 	{ }
 	terra::Sphere<double> sphere;
 	double tolerance;
+	double batchTolerance;
+	double angleTolerance;
 	Coord<double>::type geod[6];
 	Coord<double>::type ecef[6];
 };
 template<>
 struct TestContext<float> {
-	TestContext() : sphere(6378137.0f), tolerance(0.75f),
+	TestContext() : sphere(6378137.0f), tolerance(0.75f), batchTolerance(2.0f), angleTolerance(1e-6f),
 	geod{
 		{ DEG2RAD(   0.000000f), DEG2RAD(   0.000000f),    0.0f },
 		{ DEG2RAD( -74.000401f), DEG2RAD(  40.719645f),    5.0f },
@@ -84,6 +86,8 @@ struct TestContext<float> {
        	{}
 	terra::Sphere<float> sphere;
 	float tolerance;
+	float batchTolerance;
+	float angleTolerance;
 	Coord<float>::type geod[6];
 	Coord<float>::type ecef[6];
 };
@@ -109,7 +113,8 @@ testSphereSingleInplace(TestContext<T> const & ctx)
 #define FUNC "testSphereSingleInplace: "
 	for (auto i = 0u; i < sizeof ctx.geod/sizeof(typename Coord<T>::type); ++i) {
 		typename Coord<T>::type coord = { ctx.geod[i][0], ctx.geod[i][1], ctx.geod[i][2] };
-		terra::geodToECEF(&coord, ctx.sphere);
+		/* With T named, as the Sphere<T> signatures have always allowed. */
+		terra::geodToECEF<T>(&coord, ctx.sphere);
 		if (std::abs(coord[0] - ctx.ecef[i][0]) > ctx.tolerance) {
 			auto const diff = std::abs(coord[0] - ctx.ecef[i][0]);
 			std::fprintf(stderr, FUNC "%s: FAIL: ECEF X coordinate failed: %f != %f, %f\n",
@@ -129,7 +134,7 @@ testSphereSingleInplace(TestContext<T> const & ctx)
 			exit(-1);
 		}
 
-		terra::ecefToGeod(&coord, ctx.sphere);
+		terra::ecefToGeod<T>(&coord, ctx.sphere);
 		if (std::abs(coord[0] - ctx.geod[i][0]) > ctx.tolerance) {
 			auto const diff = std::abs(coord[0] - ctx.geod[i][0]);
 			std::fprintf(stderr, FUNC "%s: FAIL: Geodetic X coordinate failed: %f != %f, %f\n",
@@ -237,7 +242,7 @@ testSphereSoA(TestContext<T> const &ctx)
 
 	createSoA(&geod, ctx.geod, numCoords);
 
-	terra::geodToECEFSoA(&ecef, geod, numCoords, ctx.sphere);
+	terra::geodToECEFSoA<T>(&ecef, geod, numCoords, ctx.sphere);
 
 	for (auto i = 0u; i < numCoords; ++i) {
 		if (std::abs(ecef.x[i] - ctx.ecef[i][0]) > ctx.tolerance) {
@@ -260,7 +265,7 @@ testSphereSoA(TestContext<T> const &ctx)
 		}
 	}
 
-	terra::ecefToGeodSoA(&geod, ecef, numCoords, ctx.sphere);
+	terra::ecefToGeodSoA<T>(&geod, ecef, numCoords, ctx.sphere);
 
 	for (auto i = 0u; i < numCoords; ++i) {
 		if (std::abs(geod.x[i] - ctx.geod[i][0]) > ctx.tolerance) {
@@ -293,6 +298,95 @@ testSphereSoA(TestContext<T> const &ctx)
 #undef FUNC
 }
 
+template<typename T>
+static
+void
+testSphereSoABatch(TestContext<T> const &ctx)
+{
+#define FUNC "testSphereSoABatch: "
+
+	/* Enough coordinates to run every vector width and leave a partial tail. */
+	constexpr auto const numCoords = 1027u;
+
+	CoordSoA<T> geod, ecef;
+	geod.x = new T[numCoords];
+	geod.y = new T[numCoords];
+	geod.z = new T[numCoords];
+	ecef.x = new T[numCoords];
+	ecef.y = new T[numCoords];
+	ecef.z = new T[numCoords];
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		geod.x[i] = DEG2RAD(T((i*37) % 360) - T(179.75));
+		geod.y[i] = DEG2RAD(T((i*53) % 180) - T(89.5));
+		geod.z[i] = T((i*97) % 20000) - T(1000);
+	}
+
+	terra::geodToECEFSoA(&ecef, geod, numCoords, ctx.sphere);
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		typename Coord<T>::type const from = { geod.x[i], geod.y[i], geod.z[i] };
+		typename Coord<T>::type ref;
+		terra::geodToECEF(&ref, from, ctx.sphere);
+		T const got[3] = { ecef.x[i], ecef.y[i], ecef.z[i] };
+		for (auto j = 0u; j < 3; ++j) {
+			if (std::abs(got[j] - ref[j]) > ctx.batchTolerance) {
+				auto const diff = std::abs(got[j] - ref[j]);
+				std::fprintf(stderr, FUNC "%s: FAIL: ECEF coordinate %u of %u failed: %f != %f, %f\n",
+					     Type<T>::str, j, i, got[j], ref[j], diff);
+				exit(-1);
+			}
+		}
+	}
+
+	/*
+	 * The scalar inverse loses metres in float, so check the round trip
+	 * instead, from coordinates within range: angles in radians, altitude
+	 * in metres.
+	 */
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const lon = T((i*37) % 359) - T(179);
+		T const lat = T((i*53) % 179) - T(89);
+		geod.x[i] = DEG2RAD(lon);
+		geod.y[i] = DEG2RAD(lat);
+	}
+
+	CoordSoA<T> back;
+	back.x = new T[numCoords];
+	back.y = new T[numCoords];
+	back.z = new T[numCoords];
+
+	terra::geodToECEFSoA(&ecef, geod, numCoords, ctx.sphere);
+	terra::ecefToGeodSoA(&back, ecef, numCoords, ctx.sphere);
+
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const ref[3] = { geod.x[i], geod.y[i], geod.z[i] };
+		T const got[3] = { back.x[i], back.y[i], back.z[i] };
+		for (auto j = 0u; j < 3; ++j) {
+			auto const tolerance = j < 2 ? ctx.angleTolerance : ctx.batchTolerance;
+			if (std::abs(got[j] - ref[j]) > tolerance) {
+				auto const diff = std::abs(got[j] - ref[j]);
+				std::fprintf(stderr, FUNC "%s: FAIL: Geodetic coordinate %u of %u failed: %.9f != %.9f, %.9f\n",
+					     Type<T>::str, j, i, got[j], ref[j], diff);
+				exit(-1);
+			}
+		}
+	}
+
+	delete[] back.z;
+	delete[] back.y;
+	delete[] back.x;
+	delete[] ecef.z;
+	delete[] ecef.y;
+	delete[] ecef.x;
+	delete[] geod.z;
+	delete[] geod.y;
+	delete[] geod.x;
+
+	std::printf(FUNC "%s: SUCCESS\n", Type<T>::str);
+#undef FUNC
+}
+
 template<typename T>
 static
 void
@@ -305,7 +399,7 @@ testSphereAoS(TestContext<T> const &ctx)
 	typename Coord<T>::type* ecef = new typename Coord<T>::type[numCoords];
 	typename Coord<T>::type* geod = new typename Coord<T>::type[numCoords];
 
-	terra::geodToECEFAoS(&ecef, ctx.geod, numCoords, ctx.sphere);
+	terra::geodToECEFAoS<T>(&ecef, ctx.geod, numCoords, ctx.sphere);
 
 	for (auto i = 0u; i < numCoords; ++i) {
 		if (std::abs(ecef[i][0] - ctx.ecef[i][0]) > ctx.tolerance) {
@@ -328,7 +422,7 @@ testSphereAoS(TestContext<T> const &ctx)
 		}
 	}
 
-	terra::ecefToGeodAoS(&geod, ecef, numCoords, ctx.sphere);
+	terra::ecefToGeodAoS<T>(&geod, ecef, numCoords, ctx.sphere);
 
 	for (auto i = 0u; i < numCoords; ++i) {
 		if (std::abs(geod[i][0] - ctx.geod[i][0]) > ctx.tolerance) {
@@ -369,9 +463,11 @@ testSphere()
 	testSphereSingleInplace(ctxSP);
 	testSphereSingle(ctxSP);
 	testSphereSoA(ctxSP);
+	testSphereSoABatch(ctxSP);
 	testSphereAoS(ctxSP);
 	testSphereSingleInplace(ctxDP);
 	testSphereSingle(ctxDP);
 	testSphereSoA(ctxDP);
+	testSphereSoABatch(ctxDP);
 	testSphereAoS(ctxDP);
 }
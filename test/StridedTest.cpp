@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Dispatch.hpp>
+#include <terra/Strided.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct Type {
+};
+template<>
+struct Type<float> {
+	static constexpr auto const str = "Float";
+};
+template<>
+struct Type<double> {
+	static constexpr auto const str = "Double";
+};
+
+/* A point cloud record, the coordinate between other fields. */
+template<typename T>
+struct Record {
+	float intensity;
+	T position[3];
+	std::uint32_t classification;
+	double time;
+};
+
+template<typename T>
+static
+bool
+same(T const * const a, T const * const b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+template<typename T>
+static
+std::vector<T>
+makeGeodetic(std::size_t const numCoords)
+{
+	std::vector<T> geod(3*numCoords);
+	for (auto i = std::size_t(0); i < numCoords; ++i) {
+		geod[3*i + 0] = T(int(i*7919u%1000u) - 500)*T(0.00628);
+		geod[3*i + 1] = T(int(i*104729u%1000u) - 500)*T(0.00314);
+		geod[3*i + 2] = T(int(i*15485863u%1000u))*T(10);
+	}
+	return geod;
+}
+
+template<typename T, typename Model>
+static
+void
+testStridedModel(Model const model, char const * const name)
+{
+#define FUNC "testStridedModel: "
+	/* Not a multiple of any vector width, and more than one block. */
+	constexpr auto const numCoords = 1003u;
+	auto const geod = makeGeodetic<T>(numCoords);
+	auto const geodRows = reinterpret_cast<T const (*)[3]>(geod.data());
+
+	auto const fail = [&](char const * const what, char const * const level, unsigned const i) {
+		std::fprintf(stderr, FUNC "%s: %s: %s: %s: FAIL: coordinate %u\n",
+			     Type<T>::str, name, what, level, i);
+		exit(-1);
+	};
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		auto const levelName = terra::simdLevelName(level);
+		terra::setSimdLevel(level);
+
+		/* The same kernels run, so the results must match the AoS ones exactly. */
+		std::vector<T> ecef(3*numCoords), back(3*numCoords);
+		auto ecefRows = reinterpret_cast<T (*)[3]>(ecef.data());
+		auto backRows = reinterpret_cast<T (*)[3]>(back.data());
+		terra::geodToECEFAoS(&ecefRows, geodRows, numCoords, model);
+		terra::ecefToGeodAoS(&backRows, ecefRows, numCoords, model);
+
+		/* In place, over the records. */
+		std::vector<Record<T>> records(numCoords);
+		for (auto i = 0u; i < numCoords; ++i) {
+			records[i].intensity = float(i);
+			records[i].position[0] = geodRows[i][0];
+			records[i].position[1] = geodRows[i][1];
+			records[i].position[2] = geodRows[i][2];
+			records[i].classification = i*3u;
+			records[i].time = double(i)*0.5;
+		}
+		auto coords = terra::strided(&records[0].position[0], sizeof(Record<T>));
+		terra::geodToECEFStrided(&coords, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (!same(records[i].position, ecefRows[i]))
+				fail("geodToECEF in place", levelName, i);
+			if (records[i].intensity != float(i) || records[i].classification != i*3u ||
+			    records[i].time != double(i)*0.5)
+				fail("fields beside the coordinate", levelName, i);
+		}
+
+		/* Records to plain arrays, which go straight to the kernels. */
+		std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+		auto planar = terra::strided(gx.data(), gy.data(), gz.data(), sizeof(T));
+		auto const fromRecords = terra::strided(&records[0].position[0], sizeof(Record<T>));
+		terra::ecefToGeodStrided(&planar, fromRecords, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { gx[i], gy[i], gz[i] };
+			if (!same(got, backRows[i]))
+				fail("ecefToGeod to arrays", levelName, i);
+		}
+
+		/* Arrays of const input into components stored in reverse order. */
+		std::vector<T> again(3*numCoords);
+		auto againRows = reinterpret_cast<T (*)[3]>(again.data());
+		terra::geodToECEFAoS(&againRows, backRows, numCoords, model);
+		auto const fromPlanar = terra::strided<T const>(gx.data(), gy.data(), gz.data(), sizeof(T));
+		auto reversed = terra::strided(&records[0].position[2], &records[0].position[1], &records[0].position[0],
+					       sizeof(Record<T>));
+		terra::geodToECEFStrided(&reversed, fromPlanar, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { records[i].position[2], records[i].position[1], records[i].position[0] };
+			if (!same(got, againRows[i]))
+				fail("geodToECEF from const arrays", levelName, i);
+		}
+
+		/* Plain arrays in place take the block path too. */
+		auto ecefPlanar = terra::strided(gx.data(), gy.data(), gz.data(), sizeof(T));
+		for (auto i = 0u; i < numCoords; ++i) {
+			gx[i] = ecefRows[i][0];
+			gy[i] = ecefRows[i][1];
+			gz[i] = ecefRows[i][2];
+		}
+		terra::ecefToGeodStrided(&ecefPlanar, numCoords, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T const got[3] = { gx[i], gy[i], gz[i] };
+			if (!same(got, backRows[i]))
+				fail("ecefToGeod arrays in place", levelName, i);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: %s: SUCCESS\n", Type<T>::str, name);
+#undef FUNC
+}
+
+static
+void
+testStridedAlgorithm()
+{
+#define FUNC "testStridedAlgorithm: "
+	constexpr auto const numCoords = 300u;
+	auto const geod = makeGeodetic<double>(numCoords);
+	std::vector<double> ecef(3*numCoords), want(3*numCoords);
+	auto ecefRows = reinterpret_cast<double (*)[3]>(ecef.data());
+	auto wantRows = reinterpret_cast<double (*)[3]>(want.data());
+	terra::geodToECEFAoS(&ecefRows, reinterpret_cast<double const (*)[3]>(geod.data()), numCoords,
+			     terra::WGS84<double>());
+	terra::ecefToGeodAoS<terra::Olson>(&wantRows, ecefRows, numCoords, terra::WGS84<double>());
+
+	auto coords = terra::strided(ecef.data(), 3*sizeof(double));
+	terra::ecefToGeodStrided<terra::Olson>(&coords, numCoords, terra::WGS84<double>());
+	for (auto i = 0u; i < numCoords; ++i) {
+		if (!same(ecefRows[i], wantRows[i])) {
+			std::fprintf(stderr, FUNC "FAIL: coordinate %u\n", i);
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testStrided()
+{
+	testStridedModel<float>(terra::Sphere<float>(6371000.0f), "Sphere");
+	testStridedModel<float>(terra::WGS84<float>(), "WGS84");
+	testStridedModel<double>(terra::Sphere<double>(6371000.0), "Sphere");
+	testStridedModel<double>(terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid");
+	testStridedAlgorithm();
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Approximate.hpp>
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/Tile.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+/* Error of the model's own geodToECEF, in metres. */
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 3.0;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-6;
+};
+
+/*
+ * Offsets agree with the double reference less the centre to within half a
+ * unit, and the inverse lands within the quantization of the original point,
+ * at every instruction set level.
+ */
+template<typename E, typename Model, typename Reference>
+static
+void
+testTileModel(
+	Model const model,
+	Reference const reference,
+	double const angleScale,
+	double const scale,
+	double const spread,
+	char const * const name)
+{
+#define FUNC "testTileModel: "
+	using T = typename Model::value_type;
+	/* Not a multiple of any vector width, so the tails are exercised. */
+	constexpr auto const numCoords = 1003u;
+	double const centreLon = -1.2915, centreLat = 0.7106;
+
+	double centre[3] = { centreLon, centreLat, 0.0 };
+	terra::geodToECEF(&centre, reference);
+	auto const tile = terra::tile(T(centre[0]), T(centre[1]), T(centre[2]), T(scale));
+
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<double> refECEF(3*numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = T((centreLon + (2.0*u - 1.0)*spread)*angleScale);
+		lat[i] = T((centreLat + (2.0*v - 1.0)*spread)*angleScale);
+		alt[i] = T((2.0*w - 1.0)*spread*1e6);
+		double coord[3] = { double(lon[i])/angleScale, double(lat[i])/angleScale, double(alt[i]) };
+		terra::geodToECEF(&coord, reference);
+		refECEF[3*i + 0] = coord[0];
+		refECEF[3*i + 1] = coord[1];
+		refECEF[3*i + 2] = coord[2];
+	}
+	/* The centre as T, which the offsets are taken from. */
+	double const origin[3] = { double(tile.centre[0]), double(tile.centre[1]), double(tile.centre[2]) };
+	auto const tolerance = (std::is_integral<E>::value ? 0.5 : 1e-6*spread*1e7) + Tolerance<T>::length/scale;
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<E> ox(numCoords), oy(numCoords), oz(numCoords);
+		CoordSoA<E> offsets = { ox.data(), oy.data(), oz.data() };
+		CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+		terra::geodToECEFTileSoA(&offsets, geod, numCoords, tile, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			E const got[3] = { ox[i], oy[i], oz[i] };
+			for (auto j = 0; j < 3; ++j) {
+				auto const expected = (refECEF[3*i + j] - origin[j])/scale;
+				if (!(std::abs(double(got[j]) - expected) <= tolerance)) {
+					std::fprintf(stderr, FUNC "%s: geodToECEFTile: %s: FAIL: coordinate %u: (%f, %f, %f), [%d] != %f\n",
+						     name, terra::simdLevelName(level), i, double(got[0]), double(got[1]), double(got[2]),
+						     j, expected);
+					exit(-1);
+				}
+			}
+		}
+
+		std::vector<T> olon(numCoords), olat(numCoords), oalt(numCoords);
+		CoordSoA<T> out = { olon.data(), olat.data(), oalt.data() };
+		terra::ecefTileToGeodSoA(&out, offsets, numCoords, tile, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			double coord[3] = { double(olon[i])/angleScale, double(olat[i])/angleScale, double(oalt[i]) };
+			terra::geodToECEF(&coord, reference);
+			auto const dx = coord[0] - refECEF[3*i + 0];
+			auto const dy = coord[1] - refECEF[3*i + 1];
+			auto const dz = coord[2] - refECEF[3*i + 2];
+			/* Half a unit on each axis, and the model's error both ways. */
+			if (!(std::sqrt(dx*dx + dy*dy + dz*dz) <= 0.87*scale + 2.0*Tolerance<T>::length + tolerance*scale)) {
+				std::fprintf(stderr, FUNC "%s: ecefTileToGeod: %s: FAIL: coordinate %u: %f m off\n",
+					     name, terra::simdLevelName(level), i, std::sqrt(dx*dx + dy*dy + dz*dz));
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+/* Offsets beyond the range of the integers saturate rather than wrap, and NaN is the least. */
+template<typename T>
+static
+void
+testTileSaturation()
+{
+#define FUNC "testTileSaturation: "
+	constexpr auto const numCoords = 4u;
+	double const pi = 3.14159265358979323846;
+	T const nan = std::numeric_limits<T>::quiet_NaN();
+	T lon[numCoords] = { T(0), T(pi), T(0), nan };
+	T lat[numCoords] = { T(0), T(0), T(0), nan };
+	T alt[numCoords] = { T(0), T(0), T(1000), nan };
+	T const r = T(6378137);
+	auto const tile = terra::tile(r, T(0), T(0), T(0.01));
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::int16_t x[numCoords], y[numCoords], z[numCoords];
+		CoordSoA<std::int16_t> offsets = { x, y, z };
+		CoordSoA<T> const geod = { lon, lat, alt };
+		terra::geodToECEFTileSoA(&offsets, geod, numCoords, tile, terra::WGS84<T>());
+
+		/* In units of 1 cm, within the model's error where not saturated. */
+		auto const near = [](std::int16_t const v) {
+			return std::abs(double(v)) <= Tolerance<T>::length*100.0;
+		};
+		bool const ok =
+			near(x[0]) && near(y[0]) && near(z[0]) &&
+			x[1] == -32768 && near(y[1]) && near(z[1]) &&
+			x[2] == 32767 && near(y[2]) && near(z[2]) &&
+			x[3] == -32768 && y[3] == -32768 && z[3] == -32768;
+		if (!ok) {
+			std::fprintf(stderr, FUNC "%s: FAIL\n", terra::simdLevelName(level));
+			for (auto i = 0u; i < numCoords; ++i)
+				std::fprintf(stderr, "\t(%d, %d, %d)\n", int(x[i]), int(y[i]), int(z[i]));
+			exit(-1);
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", sizeof(T) == sizeof(float) ? "Float" : "Double");
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testTile()
+{
+	double const degrees = 180.0/3.14159265358979323846;
+	testTileModel<std::int32_t>(terra::WGS84<double>(), terra::WGS84<double>(), 1.0, 0.001, 1e-2, "WGS84<double>, int32");
+	testTileModel<std::int16_t>(terra::WGS84<double>(), terra::WGS84<double>(), 1.0, 0.01, 2e-5, "WGS84<double>, int16");
+	testTileModel<float>(terra::WGS84<double>(), terra::WGS84<double>(), 1.0, 1.0, 1e-2, "WGS84<double>, float");
+	testTileModel<double>(terra::Sphere<double>(6371000.0), terra::Sphere<double>(6371000.0), 1.0, 1.0, 1e-2,
+			      "Sphere<double>, double");
+	testTileModel<std::int32_t>(terra::Sphere<double>(6371000.0), terra::Sphere<double>(6371000.0), 1.0, 0.001, 1e-2,
+				    "Sphere<double>, int32");
+	testTileModel<std::int32_t>(terra::degrees(terra::WGS84<double>()), terra::WGS84<double>(), degrees, 0.001, 1e-2,
+				    "Degrees<WGS84<double>>, int32");
+	testTileModel<float>(terra::WGS84<float>(), terra::WGS84<double>(), 1.0, 1.0, 1e-2, "WGS84<float>, float");
+	testTileModel<std::int16_t>(terra::WGS84<float>(), terra::WGS84<double>(), 1.0, 0.1, 1e-4, "WGS84<float>, int16");
+	testTileModel<std::int32_t>(terra::approximate(terra::WGS84<float>()), terra::WGS84<double>(), 1.0, 0.01, 1e-2,
+				    "Approximate<WGS84<float>>, int32");
+	testTileSaturation<float>();
+	testTileSaturation<double>();
+}
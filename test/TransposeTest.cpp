@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Dispatch.hpp>
+#include <terra/LocalFrame.hpp>
+#include <terra/Transpose.hpp>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct Type {
+};
+template<>
+struct Type<float> {
+	static constexpr auto const str = "Float";
+};
+template<>
+struct Type<double> {
+	static constexpr auto const str = "Double";
+};
+
+/* A 3-tuple that is not packed, so it takes the element by element path. */
+template<typename T>
+struct Padded {
+	T &operator[](std::size_t const i) { return v[i]; }
+	T const &operator[](std::size_t const i) const { return v[i]; }
+	T v[3];
+	T pad;
+};
+
+template<typename T>
+static
+void
+testTransposeCopies()
+{
+#define FUNC "testTransposeCopies: "
+	/* Counts around the vector widths, and more than one block. */
+	std::size_t const counts[] = { 0, 1, 3, 7, 15, 16, 17, 33, 1003 };
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		for (auto const n : counts) {
+			std::vector<std::array<T, 3>> aos(n), back(n);
+			std::vector<Padded<T>> padded(n);
+			for (auto i = std::size_t(0); i < n; ++i) {
+				aos[i] = {{ T(3*i), T(3*i + 1), T(3*i + 2) }};
+				padded[i][0] = T(3*i);
+				padded[i][1] = T(3*i + 1);
+				padded[i][2] = T(3*i + 2);
+			}
+
+			std::vector<T> x(n + 1, T(-1)), y(n + 1, T(-1)), z(n + 1, T(-1));
+			CoordSoA<T> soa = { x.data(), y.data(), z.data() };
+			auto const check = [&](char const * const what) {
+				for (auto i = std::size_t(0); i < n; ++i) {
+					if (x[i] != T(3*i) || y[i] != T(3*i + 1) || z[i] != T(3*i + 2)) {
+						std::fprintf(stderr, FUNC "%s: %s: %s: FAIL: %zu of %zu\n",
+							     Type<T>::str, terra::simdLevelName(level), what, i, n);
+						exit(-1);
+					}
+				}
+				if (x[n] != T(-1) || y[n] != T(-1) || z[n] != T(-1)) {
+					std::fprintf(stderr, FUNC "%s: %s: %s: FAIL: wrote past %zu\n",
+						     Type<T>::str, terra::simdLevelName(level), what, n);
+					exit(-1);
+				}
+			};
+
+			terra::aosToSoA(&soa, aos, n);
+			check("aosToSoA");
+			x.assign(n + 1, T(-1));
+			y.assign(n + 1, T(-1));
+			z.assign(n + 1, T(-1));
+			terra::aosToSoA(&soa, padded, n);
+			check("aosToSoA unpacked");
+
+			back.resize(n + 1);
+			back[n] = {{ T(-1), T(-1), T(-1) }};
+			terra::soaToAoS(&back, soa, n);
+			for (auto i = std::size_t(0); i < n; ++i) {
+				if (back[i] != aos[i]) {
+					std::fprintf(stderr, FUNC "%s: %s: soaToAoS: FAIL: %zu of %zu\n",
+						     Type<T>::str, terra::simdLevelName(level), i, n);
+					exit(-1);
+				}
+			}
+			if (back[n][0] != T(-1) || back[n][1] != T(-1) || back[n][2] != T(-1)) {
+				std::fprintf(stderr, FUNC "%s: %s: soaToAoS: FAIL: wrote past %zu\n",
+					     Type<T>::str, terra::simdLevelName(level), n);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", Type<T>::str);
+#undef FUNC
+}
+
+/*
+ * The AoS conversions give the same coordinates whichever way they get
+ * there: the packed kernels, or the SoA kernels over transposed or copied
+ * blocks.
+ */
+template<typename T, typename Model>
+static
+void
+testTransposeConversions(Model const model, char const * const name)
+{
+#define FUNC "testTransposeConversions: "
+	constexpr auto const numCoords = 1003u;
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<std::array<T, 3>> geod(numCoords);
+	std::vector<Padded<T>> geodPadded(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		lon[i] = T(int(i*7919u%1000u) - 500)*T(0.00628);
+		lat[i] = T(int(i*104729u%1000u) - 500)*T(0.00314);
+		alt[i] = T(int(i*15485863u%1000u))*T(10);
+		geod[i] = {{ lon[i], lat[i], alt[i] }};
+		geodPadded[i][0] = lon[i];
+		geodPadded[i][1] = lat[i];
+		geodPadded[i][2] = alt[i];
+	}
+	CoordSoA<T> const geodSoA = { lon.data(), lat.data(), alt.data() };
+	terra::LocalFrame<T> const frame(T(0.3), T(0.9), T(0), model);
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		auto const check = [&](char const * const what, std::vector<std::array<T, 3>> const &got,
+				       std::vector<T> const &x, std::vector<T> const &y, std::vector<T> const &z) {
+			for (auto i = 0u; i < numCoords; ++i) {
+				if (got[i][0] != x[i] || got[i][1] != y[i] || got[i][2] != z[i]) {
+					std::fprintf(stderr, FUNC "%s: %s: %s: %s: FAIL: coordinate %u\n",
+						     Type<T>::str, name, terra::simdLevelName(level), what, i);
+					exit(-1);
+				}
+			}
+		};
+
+		std::vector<T> x(numCoords), y(numCoords), z(numCoords);
+		CoordSoA<T> soa = { x.data(), y.data(), z.data() };
+		std::vector<std::array<T, 3>> packed(numCoords), mixed(numCoords);
+		std::vector<Padded<T>> padded(numCoords);
+
+		terra::geodToECEFSoA(&soa, geodSoA, numCoords, model);
+		terra::geodToECEFAoS(&packed, geod, numCoords, model);
+		check("geodToECEF", packed, x, y, z);
+		terra::geodToECEFAoS(&padded, geod, numCoords, model);
+		terra::aosToSoA(&soa, padded, numCoords);
+		check("geodToECEF to unpacked", packed, x, y, z);
+		terra::geodToECEFAoS(&mixed, geodPadded, numCoords, model);
+		check("geodToECEF from unpacked", mixed, x, y, z);
+
+		auto const ecef = packed;
+		CoordSoA<T> const ecefSoA = { x.data(), y.data(), z.data() };
+		std::vector<T> gx(numCoords), gy(numCoords), gz(numCoords);
+		CoordSoA<T> geodOut = { gx.data(), gy.data(), gz.data() };
+		terra::ecefToGeodSoA(&geodOut, ecefSoA, numCoords, model);
+		terra::ecefToGeodAoS(&packed, ecef, numCoords, model);
+		check("ecefToGeod", packed, gx, gy, gz);
+
+		terra::ecefToENUSoA(&geodOut, ecefSoA, numCoords, frame);
+		terra::ecefToENUAoS(&packed, ecef, numCoords, frame);
+		check("ecefToENU", packed, gx, gy, gz);
+		terra::enuToECEFSoA(&geodOut, ecefSoA, numCoords, frame);
+		terra::enuToECEFAoS(&packed, ecef, numCoords, frame);
+		check("enuToECEF", packed, gx, gy, gz);
+
+		terra::geodToENUSoA(&geodOut, geodSoA, numCoords, frame, model);
+		terra::geodToENUAoS(&packed, geod, numCoords, frame, model);
+		check("geodToENU", packed, gx, gy, gz);
+		auto const enu = packed;
+		terra::aosToSoA(&soa, enu, numCoords);
+		terra::enuToGeodSoA(&geodOut, soa, numCoords, frame, model);
+		terra::enuToGeodAoS(&packed, enu, numCoords, frame, model);
+		check("enuToGeod", packed, gx, gy, gz);
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: %s: SUCCESS\n", Type<T>::str, name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testTranspose()
+{
+	testTransposeCopies<float>();
+	testTransposeCopies<double>();
+	testTransposeConversions<float>(terra::Sphere<float>(6371000.0f), "Sphere");
+	testTransposeConversions<float>(terra::WGS84<float>(), "WGS84");
+	testTransposeConversions<double>(terra::Sphere<double>(6371000.0), "Sphere");
+	testTransposeConversions<double>(terra::Ellipsoid<double>(6378137.0, 6356752.314245), "Ellipsoid");
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/TransverseMercator.hpp>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+/* Distance between two grid coordinates, or a geodetic round trip, in metres. */
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 4.0;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-5;
+};
+
+double const degree = 3.14159265358979323846/180.0;
+
+/*
+ * The origin of latitude on zone 31, the CN Tower in zone 17, and a point on
+ * the central meridian, whose northing is k0 times the meridian arc.
+ */
+static
+void
+testTransverseMercatorReference()
+{
+#define FUNC "testTransverseMercatorReference: "
+	struct {
+		unsigned zone;
+		double lon, lat, easting, northing;
+	} const points[] = {
+		{ 31, 0.0, 0.0, 166021.4431, 0.0 },
+		{ 17, -(79.0 + 23.0/60 + 13.7/3600), 43.0 + 38.0/60 + 33.24/3600, 630084.3105, 4833438.5488 },
+		{ 33, 15.0, 45.0, 500000.0, 0.9996*4984944.3779 },
+	};
+
+	for (auto const &p : points) {
+		auto const projection = terra::utm(p.zone, true, terra::WGS84<double>());
+		double coord[3] = { p.lon*degree, p.lat*degree, 12.0 };
+		terra::geodToTransverseMercator(&coord, projection, terra::WGS84<double>());
+		if (std::abs(coord[0] - p.easting) > 1e-3 || std::abs(coord[1] - p.northing) > 1e-3 || coord[2] != 12.0) {
+			std::fprintf(stderr, FUNC "FAIL: zone %u: (%.4f, %.4f)\n", p.zone, coord[0], coord[1]);
+			exit(-1);
+		}
+		terra::transverseMercatorToGeod(&coord, projection, terra::WGS84<double>());
+		if (std::abs(coord[0] - p.lon*degree) > 1e-12 || std::abs(coord[1] - p.lat*degree) > 1e-12) {
+			std::fprintf(stderr, FUNC "FAIL: zone %u: inverse (%.12f, %.12f)\n", p.zone, coord[0]/degree,
+				     coord[1]/degree);
+			exit(-1);
+		}
+	}
+
+	/* East of the antimeridian in zone 60 the inverse wraps the longitude, as it came in. */
+	auto const zone60 = terra::utm(60, false, terra::WGS84<double>());
+	auto const zone60Degrees = terra::utm(60, false, terra::degrees(terra::WGS84<double>()));
+	double coord[3] = { -179.5*degree, -40.0*degree, 0.0 };
+	double coordDegrees[3] = { -179.5, -40.0, 0.0 };
+	terra::geodToTransverseMercator(&coord, zone60, terra::WGS84<double>());
+	terra::transverseMercatorToGeod(&coord, zone60, terra::WGS84<double>());
+	terra::geodToTransverseMercator(&coordDegrees, zone60Degrees, terra::degrees(terra::WGS84<double>()));
+	terra::transverseMercatorToGeod(&coordDegrees, zone60Degrees, terra::degrees(terra::WGS84<double>()));
+	if (std::abs(coord[0] + 179.5*degree) > 1e-12 || std::abs(coordDegrees[0] + 179.5) > 1e-10) {
+		std::fprintf(stderr, FUNC "FAIL: zone 60: inverse longitude %.12f, %.12f\n", coord[0]/degree,
+			     coordDegrees[0]);
+		exit(-1);
+	}
+
+	struct {
+		double lon, lat;
+		unsigned zone;
+	} const zones[] = {
+		{ -79.387, 43.643, 17 }, { 5.0, 60.0, 32 }, { 2.0, 60.0, 31 }, { 10.0, 78.0, 33 },
+		{ 22.0, 80.0, 35 }, { 179.9, 0.0, 60 }, { 180.0, 0.0, 1 }, { -180.0, -40.0, 1 },
+	};
+	for (auto const &z : zones) {
+		auto const zone = terra::utmZone(z.lon*degree, z.lat*degree, terra::WGS84<double>());
+		auto const zoneDegrees = terra::utmZone(z.lon, z.lat, terra::degrees(terra::WGS84<double>()));
+		if (zone != z.zone || zoneDegrees != z.zone) {
+			std::fprintf(stderr, FUNC "FAIL: utmZone(%g, %g): %u, %u\n", z.lon, z.lat, zone, zoneDegrees);
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+/*
+ * At every instruction set level the SoA kernels match the single ones, the
+ * inverse brings points back, the ECEF kernel lands where the geodetic one
+ * does, and the AoS kernels match the SoA ones. The points reach 4 degrees
+ * past either edge of the zone, and both poles.
+ */
+template<typename Model>
+static
+void
+testTransverseMercatorModel(
+	Model const model,
+	double const angleScale,
+	char const * const name)
+{
+#define FUNC "testTransverseMercatorModel: "
+	using T = typename Model::value_type;
+	/* Not a multiple of any vector width, so the tails are exercised. */
+	constexpr auto const numCoords = 1003u;
+	auto const projection = terra::utm(33, false, model);
+	auto const tolerance = Tolerance<T>::length;
+
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<T> x0(numCoords), y0(numCoords), z0(numCoords);
+	std::vector<std::array<T, 3>> geodAoS(numCoords), ecefAoS(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = T((15.0 + (2.0*u - 1.0)*7.0)*degree*angleScale);
+		lat[i] = T((i < 2 ? (i == 0 ? 90.0 : -90.0) : (2.0*v - 1.0)*89.0)*degree*angleScale);
+		alt[i] = T((2.0*w - 1.0)*1e3);
+		T coord[3] = { lon[i], lat[i], alt[i] };
+		terra::geodToECEF(&coord, model);
+		x0[i] = coord[0];
+		y0[i] = coord[1];
+		z0[i] = coord[2];
+		geodAoS[i] = {{ lon[i], lat[i], alt[i] }};
+		ecefAoS[i] = {{ x0[i], y0[i], z0[i] }};
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+	CoordSoA<T> const ecef = { x0.data(), y0.data(), z0.data() };
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> e(numCoords), n(numCoords), h(numCoords);
+		CoordSoA<T> grid = { e.data(), n.data(), h.data() };
+		terra::geodToTransverseMercatorSoA(&grid, geod, numCoords, projection, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T coord[3] = { lon[i], lat[i], alt[i] };
+			terra::geodToTransverseMercator(&coord, projection, model);
+			auto const d = std::hypot(double(e[i]) - double(coord[0]), double(n[i]) - double(coord[1]));
+			if (!(d <= tolerance) || h[i] != alt[i]) {
+				std::fprintf(stderr, FUNC "%s: geodToTransverseMercatorSoA: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, d);
+				exit(-1);
+			}
+		}
+
+		std::vector<T> blon(numCoords), blat(numCoords), balt(numCoords);
+		CoordSoA<T> back = { blon.data(), blat.data(), balt.data() };
+		terra::transverseMercatorToGeodSoA(&back, grid, numCoords, projection, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T a[3] = { lon[i], lat[i], alt[i] };
+			T b[3] = { blon[i], blat[i], balt[i] };
+			terra::geodToECEF(&a, model);
+			terra::geodToECEF(&b, model);
+			auto const d = std::sqrt((double(a[0]) - double(b[0]))*(double(a[0]) - double(b[0])) +
+						 (double(a[1]) - double(b[1]))*(double(a[1]) - double(b[1])) +
+						 (double(a[2]) - double(b[2]))*(double(a[2]) - double(b[2])));
+			if (!(d <= 2.0*tolerance)) {
+				std::fprintf(stderr, FUNC "%s: transverseMercatorToGeodSoA: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, d);
+				exit(-1);
+			}
+		}
+
+		std::vector<T> ee(numCoords), en(numCoords), eh(numCoords);
+		CoordSoA<T> fromECEF = { ee.data(), en.data(), eh.data() };
+		terra::ecefToTransverseMercatorSoA(&fromECEF, ecef, numCoords, projection, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			auto const d = std::hypot(double(ee[i]) - double(e[i]), double(en[i]) - double(n[i]));
+			if (!(d <= 2.0*tolerance) || !(std::abs(double(eh[i]) - double(alt[i])) <= 2.0*tolerance)) {
+				std::fprintf(stderr, FUNC "%s: ecefToTransverseMercatorSoA: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, d);
+				exit(-1);
+			}
+		}
+
+		std::vector<std::array<T, 3>> gridAoS(numCoords), ecefGridAoS(numCoords), backAoS(numCoords);
+		terra::geodToTransverseMercatorAoS(&gridAoS, geodAoS, numCoords, projection, model);
+		terra::ecefToTransverseMercatorAoS(&ecefGridAoS, ecefAoS, numCoords, projection, model);
+		terra::transverseMercatorToGeodAoS(&backAoS, gridAoS, numCoords, projection, model);
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (gridAoS[i][0] != e[i] || gridAoS[i][1] != n[i] || gridAoS[i][2] != h[i] ||
+			    ecefGridAoS[i][0] != ee[i] || ecefGridAoS[i][1] != en[i] || ecefGridAoS[i][2] != eh[i] ||
+			    backAoS[i][0] != blon[i] || backAoS[i][1] != blat[i] || backAoS[i][2] != balt[i]) {
+				std::fprintf(stderr, FUNC "%s: AoS: %s: FAIL: coordinate %u\n",
+					     name, terra::simdLevelName(level), i);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testTransverseMercator()
+{
+	double const degrees = 180.0/3.14159265358979323846;
+	testTransverseMercatorReference();
+	testTransverseMercatorModel(terra::WGS84<double>(), 1.0, "WGS84<double>");
+	testTransverseMercatorModel(terra::degrees(terra::WGS84<double>()), degrees, "Degrees<WGS84<double>>");
+	testTransverseMercatorModel(terra::WGS84<float>(), 1.0, "WGS84<float>");
+	testTransverseMercatorModel(terra::Ellipsoid<double>(6377563.396, 6356256.909), 1.0, "Ellipsoid<double>");
+}
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <terra/Degrees.hpp>
+#include <terra/Dispatch.hpp>
+#include <terra/WebMercator.hpp>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct TileSoA {
+	T* x;
+	T* y;
+};
+
+/* Projected metres, and pixels at zoom 12, against double. */
+template<typename T>
+struct Tolerance {
+};
+template<>
+struct Tolerance<float> {
+	static constexpr double length = 4.0;
+	static constexpr double pixel = 0.1;
+};
+template<>
+struct Tolerance<double> {
+	static constexpr double length = 1e-6;
+	static constexpr double pixel = 1e-6;
+};
+
+double const pi = 3.14159265358979323846;
+double const degree = pi/180.0;
+
+/* EPSG:3857 at the antimeridian and the edge of the map, and OpenStreetMap tiles. */
+static
+void
+testWebMercatorReference()
+{
+#define FUNC "testWebMercatorReference: "
+	terra::Sphere<double> const sphere(6378137.0);
+	struct {
+		double lon, lat, x, y;
+	} const points[] = {
+		{ 180.0, 0.0, 20037508.342789244, 0.0 },
+		{ 0.0, 85.0511287798066, 0.0, 20037508.342789244 },
+		{ -0.1278, 51.5074, -14226.630923380362, 6711542.475587636 },
+	};
+	for (auto const &p : points) {
+		double coord[3] = { p.lon*degree, p.lat*degree, 5.0 };
+		terra::geodToWebMercator(&coord, sphere);
+		if (std::abs(coord[0] - p.x) > 1e-6 || std::abs(coord[1] - p.y) > 1e-6 || coord[2] != 5.0) {
+			std::fprintf(stderr, FUNC "FAIL: (%g, %g): (%.6f, %.6f)\n", p.lon, p.lat, coord[0], coord[1]);
+			exit(-1);
+		}
+		terra::webMercatorToGeod(&coord, sphere);
+		if (std::abs(coord[0] - p.lon*degree) > 1e-14 || std::abs(coord[1] - p.lat*degree) > 1e-14) {
+			std::fprintf(stderr, FUNC "FAIL: (%g, %g): inverse (%.14f, %.14f)\n", p.lon, p.lat, coord[0]/degree,
+				     coord[1]/degree);
+			exit(-1);
+		}
+	}
+
+	struct {
+		double lon, lat;
+		unsigned zoom;
+		std::uint32_t x, y;
+		double px, py;
+	} const tiles[] = {
+		{ -0.1278, 51.5074, 10, 511, 340, 162.93888, 129.57060 },
+		{ 2.2945, 48.8584, 17, 66371, 45091, 102.90062, 126.65835 },
+		{ 139.6917, 35.6895, 12, 3637, 1612, 97.56672, 204.53287 },
+		{ 180.0, 89.0, 3, 7, 0, 256.0, 0.0 },
+		{ -190.0, -89.0, 3, 0, 7, 0.0, 256.0 },
+	};
+	for (auto const &t : tiles) {
+		double lon = t.lon, lat = t.lat, px, py;
+		std::uint32_t x, y;
+		CoordSoA<double> const geod = { &lon, &lat, &lat };
+		TileSoA<std::uint32_t> index = { &x, &y };
+		TileSoA<double> pixel = { &px, &py };
+		terra::geodToWebMercatorTileSoA(&index, &pixel, geod, 1, t.zoom, terra::degrees(sphere));
+		if (x != t.x || y != t.y || std::abs(px - t.px) > 1e-4 || std::abs(py - t.py) > 1e-4) {
+			std::fprintf(stderr, FUNC "FAIL: (%g, %g) at zoom %u: %u/%u (%.5f, %.5f)\n", t.lon, t.lat, t.zoom, x, y,
+				     px, py);
+			exit(-1);
+		}
+	}
+
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+/*
+ * The poles, as pi/2 rounded to T, project beyond the edge of the map on
+ * their own side, and their tiles clamp onto that edge, at every level.
+ */
+template<typename T>
+static
+void
+testWebMercatorPoles()
+{
+#define FUNC "testWebMercatorPoles: "
+	terra::Sphere<T> const sphere(T(6378137));
+	constexpr auto const numCoords = 5u;
+	constexpr auto const zoom = 10u;
+	T lon[numCoords] = { T(0), T(1), T(-2), T(3), T(0) };
+	T lat[numCoords] = { T(pi/2), -T(pi/2), T(pi/2), -T(pi/2), T(0) };
+	T alt[numCoords] = {};
+	/* EPSG:3857 ends at y = pi r. */
+	auto const edge = pi*6378137.0;
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		T x[numCoords], y[numCoords], h[numCoords];
+		CoordSoA<T> const geod = { lon, lat, alt };
+		CoordSoA<T> mercator = { x, y, h };
+		terra::geodToWebMercatorSoA(&mercator, geod, numCoords, sphere);
+		std::uint32_t tx[numCoords], ty[numCoords];
+		T px[numCoords], py[numCoords];
+		TileSoA<std::uint32_t> index = { tx, ty };
+		TileSoA<T> pixel = { px, py };
+		terra::geodToWebMercatorTileSoA(&index, &pixel, geod, numCoords, zoom, sphere);
+		for (auto i = 0u; i < numCoords - 1; ++i) {
+			auto const north = lat[i] > T(0);
+			T coord[3] = { lon[i], lat[i], alt[i] };
+			terra::geodToWebMercator(&coord, sphere);
+			auto const beyond = [&](T const v) { return north ? double(v) > edge : double(v) < -edge; };
+			if (!beyond(y[i]) || !beyond(coord[1]) || ty[i] != (north ? 0u : (1u << zoom) - 1) ||
+			    py[i] != (north ? T(0) : T(256))) {
+				std::fprintf(stderr, FUNC "%s: %s: FAIL: latitude %g: y %g, single %g, tile %u (%g)\n",
+					     sizeof(T) == sizeof(float) ? "Float" : "Double", terra::simdLevelName(level),
+					     double(lat[i]), double(y[i]), double(coord[1]), unsigned(ty[i]), double(py[i]));
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", sizeof(T) == sizeof(float) ? "Float" : "Double");
+#undef FUNC
+}
+
+/*
+ * At every instruction set level the SoA kernels match the single ones and
+ * the inverse brings points back, the AoS kernels match the SoA ones, and the
+ * tiles and pixels at zoom 12 match those computed in double.
+ */
+template<typename Model>
+static
+void
+testWebMercatorModel(
+	Model const sphere,
+	double const angleScale,
+	char const * const name)
+{
+#define FUNC "testWebMercatorModel: "
+	using T = typename Model::value_type;
+	/* Not a multiple of any vector width, so the tails are exercised. */
+	constexpr auto const numCoords = 1003u;
+	constexpr auto const zoom = 12u;
+	auto const tolerance = Tolerance<T>::length;
+
+	std::vector<T> lon(numCoords), lat(numCoords), alt(numCoords);
+	std::vector<std::array<T, 3>> geodAoS(numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		auto const u = std::fmod(double(i)*0.6180339887498949, 1.0);
+		auto const v = std::fmod(double(i)*0.7548776662466927, 1.0);
+		auto const w = std::fmod(double(i)*0.5698402909980532, 1.0);
+		lon[i] = T((2.0*u - 1.0)*pi*angleScale);
+		lat[i] = T((2.0*v - 1.0)*85.0*degree*angleScale);
+		alt[i] = T((2.0*w - 1.0)*1e3);
+		geodAoS[i] = {{ lon[i], lat[i], alt[i] }};
+	}
+	CoordSoA<T> const geod = { lon.data(), lat.data(), alt.data() };
+
+	auto const detected = terra::detectSimdLevel();
+	for (auto l = 0; l <= int(detected); ++l) {
+		auto const level = terra::SimdLevel(l);
+		terra::setSimdLevel(level);
+
+		std::vector<T> x(numCoords), y(numCoords), h(numCoords);
+		CoordSoA<T> mercator = { x.data(), y.data(), h.data() };
+		terra::geodToWebMercatorSoA(&mercator, geod, numCoords, sphere);
+		for (auto i = 0u; i < numCoords; ++i) {
+			T coord[3] = { lon[i], lat[i], alt[i] };
+			terra::geodToWebMercator(&coord, sphere);
+			auto const d = std::hypot(double(x[i]) - double(coord[0]), double(y[i]) - double(coord[1]));
+			if (!(d <= tolerance) || h[i] != alt[i]) {
+				std::fprintf(stderr, FUNC "%s: geodToWebMercatorSoA: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, d);
+				exit(-1);
+			}
+		}
+
+		std::vector<T> blon(numCoords), blat(numCoords), balt(numCoords);
+		CoordSoA<T> back = { blon.data(), blat.data(), balt.data() };
+		terra::webMercatorToGeodSoA(&back, mercator, numCoords, sphere);
+		for (auto i = 0u; i < numCoords; ++i) {
+			/* Metres along the surface at the latitude, where the map is scaled by 1/cos. */
+			auto const dlon = (double(blon[i]) - double(lon[i]))/angleScale*std::cos(double(lat[i])/angleScale);
+			auto const dlat = (double(blat[i]) - double(lat[i]))/angleScale;
+			auto const d = sphere.radius*std::hypot(dlon, dlat);
+			if (!(d <= tolerance) || balt[i] != alt[i]) {
+				std::fprintf(stderr, FUNC "%s: webMercatorToGeodSoA: %s: FAIL: coordinate %u: %g m off\n",
+					     name, terra::simdLevelName(level), i, d);
+				exit(-1);
+			}
+		}
+
+		std::vector<std::array<T, 3>> mercatorAoS(numCoords), backAoS(numCoords);
+		terra::geodToWebMercatorAoS(&mercatorAoS, geodAoS, numCoords, sphere);
+		terra::webMercatorToGeodAoS(&backAoS, mercatorAoS, numCoords, sphere);
+		/* The same kernels, but each instantiation may contract into FMA differently, so a few ulps apart. */
+		auto const close = [](T const a, T const b) {
+			return std::abs(double(a) - double(b)) <= 4.0*double(std::numeric_limits<T>::epsilon())*
+				std::fmax(std::abs(double(b)), 1.0);
+		};
+		for (auto i = 0u; i < numCoords; ++i) {
+			if (!close(mercatorAoS[i][0], x[i]) || !close(mercatorAoS[i][1], y[i]) || mercatorAoS[i][2] != h[i] ||
+			    !close(backAoS[i][0], blon[i]) || !close(backAoS[i][1], blat[i]) || backAoS[i][2] != balt[i]) {
+				std::fprintf(stderr, FUNC "%s: AoS: %s: FAIL: coordinate %u\n",
+					     name, terra::simdLevelName(level), i);
+				exit(-1);
+			}
+		}
+
+		std::vector<std::int32_t> tx(numCoords), ty(numCoords);
+		std::vector<T> px(numCoords), py(numCoords);
+		TileSoA<std::int32_t> index = { tx.data(), ty.data() };
+		TileSoA<T> pixel = { px.data(), py.data() };
+		terra::geodToWebMercatorTileSoA(&index, &pixel, geod, numCoords, zoom, sphere);
+		for (auto i = 0u; i < numCoords; ++i) {
+			auto const phi = double(lat[i])/angleScale;
+			auto const fx = (0.5 + double(lon[i])/angleScale/(2.0*pi))*double(1u << zoom);
+			auto const fy = (0.5 - std::asinh(std::tan(phi))/(2.0*pi))*double(1u << zoom);
+			/* Either side of a tile edge is as good, within the tolerance. */
+			auto const ex = (double(tx[i]) + double(px[i])/256.0 - fx)*256.0;
+			auto const ey = (double(ty[i]) + double(py[i])/256.0 - fy)*256.0;
+			if (!(std::abs(ex) <= Tolerance<T>::pixel) || !(std::abs(ey) <= Tolerance<T>::pixel) ||
+			    !(px[i] >= T(0) && px[i] <= T(256) && py[i] >= T(0) && py[i] <= T(256))) {
+				std::fprintf(stderr, FUNC "%s: geodToWebMercatorTileSoA: %s: FAIL: coordinate %u: "
+					     "(%g, %g) pixels off\n", name, terra::simdLevelName(level), i, ex, ey);
+				exit(-1);
+			}
+		}
+	}
+	terra::resetSimdLevel();
+
+	std::printf(FUNC "%s: SUCCESS\n", name);
+#undef FUNC
+}
+
+} // !namespace
+
+void
+testWebMercator()
+{
+	double const degrees = 180.0/pi;
+	testWebMercatorReference();
+	testWebMercatorModel(terra::Sphere<double>(6378137.0), 1.0, "Sphere<double>");
+	testWebMercatorModel(terra::degrees(terra::Sphere<double>(6378137.0)), degrees, "Degrees<Sphere<double>>");
+	testWebMercatorModel(terra::Sphere<float>(6378137.0f), 1.0, "Sphere<float>");
+	testWebMercatorPoles<float>();
+	testWebMercatorPoles<double>();
+}
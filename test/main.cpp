@@ -16,10 +16,40 @@
 
 void testSphere();
 void testEllipsoid();
+void testDispatch();
+void testParallel();
+void testApproximate();
+void testLocalFrame();
+void testStrided();
+void testTranspose();
+void testDegrees();
+void testFixed();
+void testTile();
+void testPrecision();
+void testGeodesic();
+void testSpatialIndex();
+void testHelmert();
+void testTransverseMercator();
+void testWebMercator();
 
 int
 main()
 {
 	testSphere();
 	testEllipsoid();
+	testDispatch();
+	testParallel();
+	testApproximate();
+	testLocalFrame();
+	testStrided();
+	testTranspose();
+	testDegrees();
+	testFixed();
+	testTile();
+	testPrecision();
+	testGeodesic();
+	testSpatialIndex();
+	testHelmert();
+	testTransverseMercator();
+	testWebMercator();
 }
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "Convert.hpp"
+#include "MappedFile.hpp"
+#include <terra/Ellipsoid.hpp>
+#include <terra/Parallel.hpp>
+#include <terra/Sphere.hpp>
+#include <chrono>
+#include <cstdint>
+
+namespace convert {
+
+namespace {
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+/* A byte range of a file. */
+struct Range {
+	std::size_t offset;
+	std::size_t length;
+};
+
+/*
+ * The byte ranges holding the coordinates [first, first + n) of a file with
+ * total coordinates: one for rows, one per plane for SoA. Returns the count.
+ */
+template<typename T>
+unsigned
+chunkRanges(Layout const layout, std::size_t const total, std::size_t const first, std::size_t const n, Range * const ranges)
+{
+	if (layout == Layout::AoS) {
+		ranges[0] = Range{ first*3*sizeof(T), n*3*sizeof(T) };
+		return 1;
+	}
+	for (auto c = 0u; c < 3; ++c)
+		ranges[c] = Range{ (c*total + first)*sizeof(T), n*sizeof(T) };
+	return 3;
+}
+
+template<typename T, typename Model>
+void
+convertChunk(
+	terra::ThreadPool &pool,
+	Options const &options,
+	MappedFile const &in,
+	MappedFile const &out,
+	std::size_t const total,
+	std::size_t const first,
+	std::size_t const n,
+	Model const model)
+{
+	auto const geodToECEF = options.direction == Direction::GeodToECEF;
+
+	if (options.layout == Layout::AoS) {
+		using Row = T[3];
+		auto const from = reinterpret_cast<Row const *>(in.data()) + first;
+		auto to = reinterpret_cast<Row *>(out.data()) + first;
+		if (geodToECEF)
+			terra::geodToECEFAoS(pool, &to, from, n, model);
+		else
+			terra::ecefToGeodAoS(pool, &to, from, n, model);
+		return;
+	}
+
+	/* The SoA functions take one struct type for both sides; the input is only read. */
+	auto const src = const_cast<T *>(reinterpret_cast<T const *>(in.data()));
+	auto const dst = reinterpret_cast<T *>(out.data());
+	CoordSoA<T> const from = { src + first, src + total + first, src + 2*total + first };
+	CoordSoA<T> to = { dst + first, dst + total + first, dst + 2*total + first };
+	if (geodToECEF)
+		terra::geodToECEFSoA(pool, &to, from, n, model);
+	else
+		terra::ecefToGeodSoA(pool, &to, from, n, model);
+}
+
+template<typename T, typename Model>
+bool
+convertModel(
+	MappedFile const &in,
+	MappedFile const &out,
+	Options const &options,
+	Model const model,
+	Stats * const stats)
+{
+	auto const total = in.size()/(3*sizeof(T));
+	auto const chunk = options.chunkCoords > 0 ? options.chunkCoords : std::size_t(1);
+	terra::ThreadPool pool(options.threads);
+
+	auto const start = std::chrono::steady_clock::now();
+	in.advise(0, in.size(), MappedFile::Advice::Sequential);
+	Range ranges[3];
+	auto count = chunkRanges<T>(options.layout, total, 0, chunk < total ? chunk : total, ranges);
+	for (auto r = 0u; r < count; ++r)
+		in.advise(ranges[r].offset, ranges[r].length, MappedFile::Advice::WillNeed);
+
+	for (std::size_t first = 0; first < total; first += chunk) {
+		auto const n = total - first < chunk ? total - first : chunk;
+
+		/* Have the kernel read the next chunk in while this one converts. */
+		auto const next = first + n;
+		if (next < total) {
+			Range ahead[3];
+			auto const aheadCount = chunkRanges<T>(options.layout, total, next,
+							       total - next < chunk ? total - next : chunk, ahead);
+			for (auto r = 0u; r < aheadCount; ++r)
+				in.advise(ahead[r].offset, ahead[r].length, MappedFile::Advice::WillNeed);
+		}
+
+		convertChunk<T>(pool, options, in, out, total, first, n, model);
+
+		/* Done with this chunk: write it back and let go of both sides. */
+		count = chunkRanges<T>(options.layout, total, first, n, ranges);
+		for (auto r = 0u; r < count; ++r) {
+			out.flushAsync(ranges[r].offset, ranges[r].length);
+			out.advise(ranges[r].offset, ranges[r].length, MappedFile::Advice::DontNeed);
+			in.advise(ranges[r].offset, ranges[r].length, MappedFile::Advice::DontNeed);
+		}
+	}
+
+	stats->numCoords = total;
+	stats->bytes = 2*in.size();
+	stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+template<typename T>
+bool
+convertPrecision(MappedFile const &in, MappedFile const &out, Options const &options, Stats * const stats)
+{
+	switch (options.body) {
+	case Body::WGS84:
+		return convertModel<T>(in, out, options, terra::WGS84<T>(), stats);
+	case Body::GRS80:
+		return convertModel<T>(in, out, options, terra::GRS80<T>(), stats);
+	case Body::WGS72:
+		return convertModel<T>(in, out, options, terra::WGS72<T>(), stats);
+	case Body::Sphere:
+		return convertModel<T>(in, out, options, terra::Sphere<T>(T(options.radius)), stats);
+	}
+	return false;
+}
+
+bool
+littleEndian()
+{
+	std::uint16_t const one = 1;
+	return *reinterpret_cast<unsigned char const *>(&one) == 1;
+}
+
+} // !namespace
+
+bool
+convertFile(char const * const input, char const * const output, Options const &options, Stats * const stats,
+	    std::string * const error)
+{
+	if (!littleEndian()) {
+		*error = "only little-endian hosts are supported";
+		return false;
+	}
+
+	MappedFile in;
+	if (!in.openRead(input, error))
+		return false;
+	auto const rowBytes = 3*(options.precision == Precision::Float ? sizeof(float) : sizeof(double));
+	if (in.size() % rowBytes != 0) {
+		*error = std::string(input) + ": size is not a multiple of " + std::to_string(rowBytes) + " bytes";
+		return false;
+	}
+
+	/* Creating the output would truncate the input under its mapping. */
+	if (in.sameFile(output)) {
+		*error = std::string(output) + ": is the input file";
+		return false;
+	}
+
+	MappedFile out;
+	if (!out.create(output, in.size(), error))
+		return false;
+
+	if (options.precision == Precision::Float)
+		return convertPrecision<float>(in, out, options, stats);
+	return convertPrecision<double>(in, out, options, stats);
+}
+
+} // !namespace convert
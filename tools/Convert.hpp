@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_tools_Convert_hpp
+#define terra_tools_Convert_hpp
+
+#include <cstddef>
+#include <string>
+
+namespace convert {
+
+enum class Direction { GeodToECEF, ECEFToGeod };
+enum class Layout { AoS, SoA };
+enum class Precision { Float, Double };
+enum class Body { WGS84, GRS80, WGS72, Sphere };
+
+/**
+ * @brief What to convert and how.
+ * Files hold raw little-endian float32 or float64 values, either as rows of
+ * three (AoS) or as three planes, all x values, then all y, then all z (SoA).
+ * Geodetic coordinates are longitude, latitude in radians, and altitude.
+ */
+struct Options {
+	Direction direction = Direction::GeodToECEF;
+	Layout layout = Layout::AoS;
+	Precision precision = Precision::Double;
+	Body body = Body::WGS84;
+	double radius = 6371000.0;		/**< For Body::Sphere. */
+	unsigned threads = 0;			/**< 0 for one per hardware thread. */
+	std::size_t chunkCoords = 1u << 20;	/**< Coordinates mapped in per step. */
+};
+
+/**
+ * @brief What a conversion did.
+ */
+struct Stats {
+	std::size_t numCoords = 0;
+	std::size_t bytes = 0;		/**< Bytes read plus bytes written. */
+	double seconds = 0.0;
+};
+
+/**
+ * @brief Convert the coordinates in the file input into the file output, a
+ *	chunk at a time, reading ahead one chunk while converting the current.
+ *	Both files are mapped, so the batch functions read the input and write
+ *	the output in place; nothing is copied besides. The output must be
+ *	another file than the input.
+ * @return false, with error set, on failure, including an output that is
+ *	the input.
+ */
+bool convertFile(char const *input, char const *output, Options const &options, Stats *stats, std::string *error);
+
+} // !namespace convert
+
+#endif // !terra_tools_Convert_hpp
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "Convert.hpp"
+#include <terra/Ellipsoid.hpp>
+#include <terra/Sphere.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string
+tempPath(char const * const name)
+{
+	auto const dir = std::getenv("TMPDIR");
+	return std::string(dir ? dir : "/tmp") + "/terra_convert_test_" + name;
+}
+
+template<typename T>
+void
+writeFile(std::string const &path, std::vector<T> const &values)
+{
+	auto const f = std::fopen(path.c_str(), "wb");
+	if (!f || (!values.empty() && std::fwrite(values.data(), sizeof(T), values.size(), f) != values.size())) {
+		std::fprintf(stderr, "cannot write %s\n", path.c_str());
+		exit(-1);
+	}
+	std::fclose(f);
+}
+
+template<typename T>
+std::vector<T>
+readFile(std::string const &path, std::size_t const count)
+{
+	std::vector<T> values(count + 1);
+	auto const f = std::fopen(path.c_str(), "rb");
+	if (!f || std::fread(values.data(), sizeof(T), values.size(), f) != count) {
+		std::fprintf(stderr, "cannot read %s, or it has the wrong size\n", path.c_str());
+		exit(-1);
+	}
+	std::fclose(f);
+	values.pop_back();
+	return values;
+}
+
+template<typename T>
+struct CoordSoA {
+	T* x;
+	T* y;
+	T* z;
+};
+
+template<typename T>
+struct Type {
+};
+template<>
+struct Type<float> {
+	static constexpr auto const str = "Float";
+	static constexpr auto const precision = convert::Precision::Float;
+};
+template<>
+struct Type<double> {
+	static constexpr auto const str = "Double";
+	static constexpr auto const precision = convert::Precision::Double;
+};
+
+/*
+ * Converts a file of geodetic coordinates that is not a whole number of
+ * chunks, and compares with converting the same coordinates in one call.
+ */
+template<typename T>
+void
+testConvertFile(convert::Layout const layout, unsigned const threads)
+{
+#define FUNC "testConvertFile: "
+	auto const name = layout == convert::Layout::AoS ? "AoS" : "SoA";
+	constexpr auto const numCoords = 2500u;
+	std::vector<T> geod(3*numCoords), want(3*numCoords);
+	for (auto i = 0u; i < numCoords; ++i) {
+		T const coord[3] = { T((double(i%360) - 180.0)*0.0174532925199433),
+			       T((double(i%179) - 89.0)*0.0174532925199433), T(i%1000) };
+		auto const row = layout == convert::Layout::AoS ? std::size_t(3*i) : std::size_t(i);
+		auto const stride = layout == convert::Layout::AoS ? std::size_t(1) : std::size_t(numCoords);
+		for (auto c = 0u; c < 3; ++c)
+			geod[row + c*stride] = coord[c];
+	}
+	/* The same batch kernels as the tool, which runs them a chunk at a time. */
+	if (layout == convert::Layout::AoS) {
+		auto to = reinterpret_cast<T (*)[3]>(want.data());
+		terra::geodToECEFAoS(&to, reinterpret_cast<T const (*)[3]>(geod.data()), numCoords, terra::WGS84<T>());
+	} else {
+		CoordSoA<T> const from = { &geod[0], &geod[numCoords], &geod[2*numCoords] };
+		CoordSoA<T> to = { &want[0], &want[numCoords], &want[2*numCoords] };
+		terra::geodToECEFSoA(&to, from, numCoords, terra::WGS84<T>());
+	}
+	auto const input = tempPath("geod");
+	auto const output = tempPath("ecef");
+	auto const back = tempPath("back");
+	writeFile(input, geod);
+
+	convert::Options options;
+	options.layout = layout;
+	options.precision = Type<T>::precision;
+	options.threads = threads;
+	options.chunkCoords = 1000;
+	convert::Stats stats;
+	std::string error;
+	if (!convert::convertFile(input.c_str(), output.c_str(), options, &stats, &error) || stats.numCoords != numCoords) {
+		std::fprintf(stderr, FUNC "%s: %s: FAIL: geodToECEF: %s\n", Type<T>::str, name, error.c_str());
+		exit(-1);
+	}
+	auto const ecef = readFile<T>(output, 3*numCoords);
+	for (auto i = 0u; i < 3*numCoords; ++i) {
+		if (ecef[i] != want[i]) {
+			std::fprintf(stderr, FUNC "%s: %s: FAIL: value %u: %f != %f\n",
+				     Type<T>::str, name, i, double(ecef[i]), double(want[i]));
+			exit(-1);
+		}
+	}
+
+	options.direction = convert::Direction::ECEFToGeod;
+	if (!convert::convertFile(output.c_str(), back.c_str(), options, &stats, &error)) {
+		std::fprintf(stderr, FUNC "%s: %s: FAIL: ecefToGeod: %s\n", Type<T>::str, name, error.c_str());
+		exit(-1);
+	}
+	auto const geodBack = readFile<T>(back, 3*numCoords);
+	for (auto i = 0u; i < 3*numCoords; ++i) {
+		/* Longitude is undefined at the poles, so only the other two are compared there. */
+		auto const tolerance = sizeof(T) == sizeof(float) ? T(2) : T(1e-6);
+		auto const isAltitude = layout == convert::Layout::AoS ? i%3 == 2 : i >= 2*numCoords;
+		auto const isLongitude = layout == convert::Layout::AoS ? i%3 == 0 : i < numCoords;
+		auto const coord = layout == convert::Layout::AoS ? i/3 : i%numCoords;
+		if (isLongitude && coord%179 == 0)
+			continue;
+		auto const scale = isAltitude ? T(1) : T(1)/T(6.4e6);
+		/* -180 and 180 degrees are the same longitude. */
+		auto const diff = isLongitude ? std::remainder(double(geodBack[i] - geod[i]), 6.283185307179586) :
+				  double(geodBack[i] - geod[i]);
+		if (!(std::abs(diff) <= tolerance*scale)) {
+			std::fprintf(stderr, FUNC "%s: %s: FAIL: round trip value %u: %.9f != %.9f\n",
+				     Type<T>::str, name, i, double(geodBack[i]), double(geod[i]));
+			exit(-1);
+		}
+	}
+
+	std::remove(input.c_str());
+	std::remove(output.c_str());
+	std::remove(back.c_str());
+	std::printf(FUNC "%s: %s, %u threads: SUCCESS\n", Type<T>::str, name, threads);
+#undef FUNC
+}
+
+void
+testConvertErrors()
+{
+#define FUNC "testConvertErrors: "
+	auto const input = tempPath("short");
+	auto const output = tempPath("out");
+	writeFile(input, std::vector<double>(4));
+
+	convert::Options options;
+	convert::Stats stats;
+	std::string error;
+	if (convert::convertFile(input.c_str(), output.c_str(), options, &stats, &error) || error.empty()) {
+		std::fprintf(stderr, FUNC "FAIL: accepted a partial coordinate\n");
+		exit(-1);
+	}
+	error.clear();
+	if (convert::convertFile(tempPath("missing").c_str(), output.c_str(), options, &stats, &error) || error.empty()) {
+		std::fprintf(stderr, FUNC "FAIL: accepted a missing file\n");
+		exit(-1);
+	}
+
+	/* Converting a file onto itself is refused, and leaves it as it was. */
+	std::vector<double> const rows = { 6378137.0, 0.0, 0.0, 0.0, 6378137.0, 0.0 };
+	writeFile(input, rows);
+	error.clear();
+	if (convert::convertFile(input.c_str(), input.c_str(), options, &stats, &error) || error.empty() ||
+	    readFile<double>(input, rows.size()) != rows) {
+		std::fprintf(stderr, FUNC "FAIL: converted a file onto itself\n");
+		exit(-1);
+	}
+
+	/* An empty file converts to an empty file. */
+	writeFile(input, std::vector<double>());
+	if (!convert::convertFile(input.c_str(), output.c_str(), options, &stats, &error) || stats.numCoords != 0) {
+		std::fprintf(stderr, FUNC "FAIL: empty file: %s\n", error.c_str());
+		exit(-1);
+	}
+
+	std::remove(input.c_str());
+	std::remove(output.c_str());
+	std::printf(FUNC "SUCCESS\n");
+#undef FUNC
+}
+
+} // !namespace
+
+int
+main()
+{
+	testConvertFile<float>(convert::Layout::AoS, 1);
+	testConvertFile<float>(convert::Layout::SoA, 2);
+	testConvertFile<double>(convert::Layout::AoS, 2);
+	testConvertFile<double>(convert::Layout::SoA, 1);
+	testConvertErrors();
+}
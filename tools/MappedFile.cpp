@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace convert {
+
+namespace {
+
+std::string
+failure(char const * const what, char const * const path)
+{
+	return std::string(what) + " " + path + ": " + std::strerror(errno);
+}
+
+} // !namespace
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+void
+MappedFile::close() noexcept
+{
+	if (data_)
+		::munmap(data_, size_);
+	if (fd_ >= 0)
+		::close(fd_);
+	data_ = nullptr;
+	size_ = 0;
+	fd_ = -1;
+}
+
+bool
+MappedFile::openRead(char const * const path, std::string * const error)
+{
+	close();
+	fd_ = ::open(path, O_RDONLY);
+	if (fd_ < 0) {
+		*error = failure("cannot open", path);
+		return false;
+	}
+	struct stat st;
+	if (::fstat(fd_, &st) != 0) {
+		*error = failure("cannot stat", path);
+		close();
+		return false;
+	}
+	size_ = std::size_t(st.st_size);
+	/* An empty file cannot be mapped, and needs no mapping. */
+	if (size_ == 0)
+		return true;
+	auto const p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+	if (p == MAP_FAILED) {
+		*error = failure("cannot map", path);
+		close();
+		return false;
+	}
+	data_ = static_cast<unsigned char *>(p);
+	return true;
+}
+
+bool
+MappedFile::sameFile(char const * const path) const noexcept
+{
+	struct stat open, named;
+	return fd_ >= 0 && ::fstat(fd_, &open) == 0 && ::stat(path, &named) == 0 &&
+	       open.st_dev == named.st_dev && open.st_ino == named.st_ino;
+}
+
+bool
+MappedFile::create(char const * const path, std::size_t const size, std::string * const error)
+{
+	close();
+	fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd_ < 0) {
+		*error = failure("cannot create", path);
+		return false;
+	}
+	if (::ftruncate(fd_, off_t(size)) != 0) {
+		*error = failure("cannot resize", path);
+		close();
+		return false;
+	}
+	size_ = size;
+	if (size_ == 0)
+		return true;
+	auto const p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+	if (p == MAP_FAILED) {
+		*error = failure("cannot map", path);
+		close();
+		return false;
+	}
+	data_ = static_cast<unsigned char *>(p);
+	return true;
+}
+
+void
+MappedFile::advise(std::size_t const offset, std::size_t const length, Advice const advice) const noexcept
+{
+	if (!data_ || length == 0)
+		return;
+	auto const page = std::size_t(::sysconf(_SC_PAGESIZE));
+	auto const begin = offset/page*page;
+	auto const end = offset + length < size_ ? offset + length : size_;
+	auto const flag = advice == Advice::Sequential ? MADV_SEQUENTIAL :
+			  advice == Advice::WillNeed ? MADV_WILLNEED : MADV_DONTNEED;
+	::madvise(data_ + begin, end - begin, flag);
+}
+
+void
+MappedFile::flushAsync(std::size_t const offset, std::size_t const length) const noexcept
+{
+	if (!data_ || length == 0)
+		return;
+	auto const page = std::size_t(::sysconf(_SC_PAGESIZE));
+	auto const begin = offset/page*page;
+	auto const end = offset + length < size_ ? offset + length : size_;
+	::msync(data_ + begin, end - begin, MS_ASYNC);
+}
+
+} // !namespace convert
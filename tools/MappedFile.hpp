@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef terra_tools_MappedFile_hpp
+#define terra_tools_MappedFile_hpp
+
+#include <cstddef>
+#include <string>
+
+namespace convert {
+
+/**
+ * @brief A whole file mapped into memory, read-only or, for a file created
+ *	at a given size, writable. The mapping is shared, so what is written
+ *	goes straight to the page cache and the file without another copy.
+ */
+class MappedFile {
+public:
+	/** @brief Access patterns passed on to the kernel, see advise(). */
+	enum class Advice {
+		Sequential,	/**< Read ahead aggressively. */
+		WillNeed,	/**< Start reading the range in now. */
+		DontNeed,	/**< The range is done with; drop it from the mapping. */
+	};
+
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	/**
+	 * @brief Map an existing file for reading.
+	 * @return false, with error set, on failure.
+	 */
+	bool openRead(char const *path, std::string *error);
+
+	/**
+	 * @brief Whether path names the open file, through a link or another
+	 *	spelling of the path; false if it does not exist.
+	 */
+	bool sameFile(char const *path) const noexcept;
+
+	/**
+	 * @brief Create or truncate a file of the given size and map it for writing.
+	 * @return false, with error set, on failure.
+	 */
+	bool create(char const *path, std::size_t size, std::string *error);
+
+	/**
+	 * @brief Hint how the bytes [offset, offset + length) will be used.
+	 *	The range is widened to whole pages; failures are ignored, the
+	 *	advice being only a hint.
+	 */
+	void advise(std::size_t offset, std::size_t length, Advice advice) const noexcept;
+
+	/**
+	 * @brief Start writing back the bytes [offset, offset + length) without
+	 *	waiting for it, so that dirty pages do not pile up.
+	 */
+	void flushAsync(std::size_t offset, std::size_t length) const noexcept;
+
+	unsigned char *data() const noexcept { return data_; }
+	std::size_t size() const noexcept { return size_; }
+
+private:
+	void close() noexcept;
+
+	int fd_ = -1;
+	unsigned char *data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+} // !namespace convert
+
+#endif // !terra_tools_MappedFile_hpp
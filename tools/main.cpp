@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2017-2019 Jon Olsson <jlo@wintermute.net>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "Convert.hpp"
+#include <terra/Dispatch.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+void
+usage(char const * const argv0)
+{
+	std::fprintf(stderr,
+		     "usage: %s [options] INPUT OUTPUT\n"
+		     "  --direction=geodToECEF|ecefToGeod  (default geodToECEF)\n"
+		     "  --layout=aos|soa      rows of three, or three planes x..., y..., z... (default aos)\n"
+		     "  --type=float|double   little-endian float32 or float64 values (default double)\n"
+		     "  --model=WGS84|GRS80|WGS72|sphere  reference body (default WGS84)\n"
+		     "  --radius=METERS       radius of the sphere (default 6371000)\n"
+		     "  --threads=N           threads to convert on, 0 for all (default 0)\n"
+		     "  --chunk=N             coordinates mapped in per step (default 1048576)\n"
+		     "  --simd=LEVEL          run at scalar, SSE2, SSE4.2, AVX2 or AVX-512 (default detected)\n"
+		     "Geodetic coordinates are longitude and latitude in radians, then altitude.\n",
+		     argv0);
+}
+
+char const *
+value(char const * const arg, char const * const option)
+{
+	auto const len = std::strlen(option);
+	if (std::strncmp(arg, option, len) == 0 && arg[len] == '=')
+		return arg + len + 1;
+	return nullptr;
+}
+
+} // !namespace
+
+int
+main(int argc, char **argv)
+{
+	convert::Options options;
+	char const *paths[2] = { nullptr, nullptr };
+	auto numPaths = 0;
+
+	for (auto i = 1; i < argc; ++i) {
+		char const *v;
+		if ((v = value(argv[i], "--direction")) && !std::strcmp(v, "geodToECEF")) {
+			options.direction = convert::Direction::GeodToECEF;
+		} else if (v && !std::strcmp(v, "ecefToGeod")) {
+			options.direction = convert::Direction::ECEFToGeod;
+		} else if ((v = value(argv[i], "--layout")) && (!std::strcmp(v, "aos") || !std::strcmp(v, "soa"))) {
+			options.layout = !std::strcmp(v, "aos") ? convert::Layout::AoS : convert::Layout::SoA;
+		} else if ((v = value(argv[i], "--type")) && (!std::strcmp(v, "float") || !std::strcmp(v, "double"))) {
+			options.precision = !std::strcmp(v, "float") ? convert::Precision::Float : convert::Precision::Double;
+		} else if ((v = value(argv[i], "--model")) && !std::strcmp(v, "WGS84")) {
+			options.body = convert::Body::WGS84;
+		} else if (v && !std::strcmp(v, "GRS80")) {
+			options.body = convert::Body::GRS80;
+		} else if (v && !std::strcmp(v, "WGS72")) {
+			options.body = convert::Body::WGS72;
+		} else if (v && !std::strcmp(v, "sphere")) {
+			options.body = convert::Body::Sphere;
+		} else if ((v = value(argv[i], "--radius")) && std::strtod(v, nullptr) > 0.0) {
+			options.radius = std::strtod(v, nullptr);
+		} else if ((v = value(argv[i], "--threads"))) {
+			options.threads = unsigned(std::strtoul(v, nullptr, 10));
+		} else if ((v = value(argv[i], "--chunk")) && std::strtoull(v, nullptr, 10) > 0) {
+			options.chunkCoords = std::strtoull(v, nullptr, 10);
+		} else if ((v = value(argv[i], "--simd"))) {
+			auto found = false;
+			for (auto l = 0; l <= int(terra::SimdLevel::AVX512); ++l) {
+				if (!std::strcmp(v, terra::simdLevelName(terra::SimdLevel(l)))) {
+					auto const level = terra::SimdLevel(l);
+					if (terra::setSimdLevel(level) != level) {
+						std::fprintf(stderr, "%s: %s is not supported here\n", argv[0], v);
+						return EXIT_FAILURE;
+					}
+					found = true;
+				}
+			}
+			if (!found) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (argv[i][0] != '-' && numPaths < 2) {
+			paths[numPaths++] = argv[i];
+		} else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (numPaths != 2) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	convert::Stats stats;
+	std::string error;
+	if (!convert::convertFile(paths[0], paths[1], options, &stats, &error)) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return EXIT_FAILURE;
+	}
+
+	auto const seconds = stats.seconds > 0.0 ? stats.seconds : 1e-9;
+	std::fprintf(stderr, "%s: %zu coordinates in %.3f s, %.1f Mcoords/s, %.1f MB/s read and written (%s)\n",
+		     argv[0], stats.numCoords, stats.seconds, double(stats.numCoords)/seconds*1e-6,
+		     double(stats.bytes)/seconds*1e-6, terra::simdLevelName(terra::simdLevel()));
+	return EXIT_SUCCESS;
+}